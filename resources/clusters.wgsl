@@ -0,0 +1,57 @@
+// Light culling: each invocation finds the lights whose range reaches one cluster's view-space bounds
+#include "lights.wgsl"
+
+@group(0) @binding(0) var<uniform> clusters : Clusters;
+@group(0) @binding(1) var<storage, read> lights : array<Light>;
+@group(0) @binding(2) var<storage, read_write> clusterLightCounts : array<u32>;
+@group(0) @binding(3) var<storage, read_write> clusterLightIndices : array<u32>;
+
+// A point on the near plane, from screen pixels (y down)
+fn screenToView(screen : vec2f) -> vec3f {
+    let ndc = vec2f(screen.x / clusters.screenSize.x * 2.0 - 1.0, 1.0 - screen.y / clusters.screenSize.y * 2.0);
+    let view = clusters.inverseProjection * vec4f(ndc, 0.0, 1.0);
+    return view.xyz / view.w;
+}
+
+// Along the ray from the eye through point, at a view-space distance (the view looks down -z)
+fn atDepth(point : vec3f, depth : f32) -> vec3f {
+    return point * (depth / -point.z);
+}
+
+@compute @workgroup_size(64)
+fn cs_main(@builtin(global_invocation_id) id : vec3u) {
+    let gridSize = clusters.gridSize;
+    let clusterIndex = id.x;
+    if (clusterIndex >= gridSize.x * gridSize.y * gridSize.z) {
+        return;
+    }
+
+    let x = clusterIndex % gridSize.x;
+    let y = (clusterIndex / gridSize.x) % gridSize.y;
+    let z = clusterIndex / (gridSize.x * gridSize.y);
+
+    let tileSize = clusters.screenSize / vec2f(gridSize.xy);
+    let minPoint = screenToView(vec2f(f32(x), f32(y)) * tileSize);
+    let maxPoint = screenToView(vec2f(f32(x + 1), f32(y + 1)) * tileSize);
+    let nearDepth = getSliceDepth(clusters, z);
+    let farDepth = getSliceDepth(clusters, z + 1);
+
+    let nearMin = atDepth(minPoint, nearDepth);
+    let nearMax = atDepth(maxPoint, nearDepth);
+    let farMin = atDepth(minPoint, farDepth);
+    let farMax = atDepth(maxPoint, farDepth);
+    let boundsMin = min(min(nearMin, nearMax), min(farMin, farMax));
+    let boundsMax = max(max(nearMin, nearMax), max(farMin, farMax));
+
+    var count = 0u;
+    for (var iLight = 0u; (iLight < clusters.lightCount) && (count < MAX_LIGHTS_PER_CLUSTER); iLight++) {
+        let light = lights[iLight];
+        let center = (clusters.view * vec4f(light.position, 1.0)).xyz;
+        let offset = clamp(center, boundsMin, boundsMax) - center;
+        if (dot(offset, offset) <= light.range * light.range) {
+            clusterLightIndices[clusterIndex * MAX_LIGHTS_PER_CLUSTER + count] = iLight;
+            count++;
+        }
+    }
+    clusterLightCounts[clusterIndex] = count;
+}
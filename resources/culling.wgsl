@@ -0,0 +1,46 @@
+// Instance culling, dispatched by InstanceCulling: each invocation tests one instance's bounding sphere against the
+// view frustum, and appends the survivors to their draw batch's range of the visible instance list
+struct Culling {
+  planes : array<vec4f, 6>, // inward normal and distance, normalized
+  instanceCount : u32
+};
+
+struct CullingInstance {
+  center : vec3f, // world space bounding sphere
+  radius : f32,
+  batchIndex : u32
+};
+
+// Laid out like DrawIndexedIndirect's arguments. The instance count is reset to 0 before each dispatch.
+struct DrawIndexedArgs {
+  indexCount : u32,
+  instanceCount : atomic<u32>,
+  firstIndex : u32,
+  baseVertex : i32,
+  firstInstance : u32
+};
+
+@group(0) @binding(0) var<uniform> culling : Culling;
+@group(0) @binding(1) var<storage, read> instances : array<CullingInstance>;
+@group(0) @binding(2) var<storage, read_write> drawArgs : array<DrawIndexedArgs>;
+@group(0) @binding(3) var<storage, read_write> instanceIndices : array<u32>;
+
+@compute @workgroup_size(64)
+fn cs_main(@builtin(global_invocation_id) id : vec3u) {
+    let instanceIndex = id.x;
+    if (instanceIndex >= culling.instanceCount) {
+        return;
+    }
+
+    let instance = instances[instanceIndex];
+    for (var i = 0u; i < 6u; i++) {
+        let plane = culling.planes[i];
+        if (dot(plane.xyz, instance.center) + plane.w < -instance.radius) {
+            return;
+        }
+    }
+
+    // Survivors land in any order within their batch's range, which starts at its firstInstance
+    let slot = atomicAdd(&drawArgs[instance.batchIndex].instanceCount, 1u);
+    instanceIndices[drawArgs[instance.batchIndex].firstInstance + slot] = instanceIndex;
+}
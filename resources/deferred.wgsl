@@ -0,0 +1,40 @@
+// Deferred lighting, drawn by DeferredLighting: shades every pixel of the G-buffer with the clustered lights, like the
+// forward scene shader
+#include "gbuffer.wgsl"
+
+@group(1) @binding(0) var gBuffer : texture_2d<u32>;
+@group(1) @binding(1) var gBufferDepth : texture_depth_2d;
+
+// One triangle covering the screen
+@vertex
+fn vs_main(@builtin(vertex_index) vertexIndex : u32) -> @builtin(position) vec4f {
+    let uv = vec2f(f32((vertexIndex << 1u) & 2u), f32(vertexIndex & 2u));
+    return vec4f(uv * 2.0 - 1.0, 0.0, 1.0);
+}
+
+struct FragmentOutput {
+  @location(0) color : vec4f,
+  @builtin(frag_depth) depth : f32
+};
+
+// The G-buffer's depth is copied to the pass's multisampled depth, so that the blended surfaces drawn afterwards are
+// hidden behind it
+@fragment
+fn fs_main(@builtin(position) fragCoord : vec4f) -> FragmentOutput {
+    let pixel = vec2i(fragCoord.xy);
+    let depth = textureLoad(gBufferDepth, pixel, 0);
+
+    // Nothing was drawn here, so the cleared color and depth are kept
+    if (depth >= 1.0) {
+        discard;
+    }
+
+    let ndc = vec3f(fragCoord.x / clusters.screenSize.x * 2.0 - 1.0, 1.0 - fragCoord.y / clusters.screenSize.y * 2.0, depth);
+    let world = camera.inverseViewProjection * vec4f(ndc, 1.0);
+    let surface = unpackGBuffer(textureLoad(gBuffer, pixel, 0), world.xyz / world.w);
+
+    var out : FragmentOutput;
+    out.color = clamp(vec4f(shadeSurface(surface, fragCoord.xy), 1.0), vec4f(0), vec4f(1));
+    out.depth = depth;
+    return out;
+}
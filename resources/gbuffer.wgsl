@@ -0,0 +1,62 @@
+// Deferred shading's G-buffer: a Surface packed into one rgba32uint texel, written by the scene shader's G-buffer
+// entry points and shaded by deferred.wgsl. Its position isn't stored, but rebuilt from the depth buffer.
+//   x: base color rgb, sRGB encoded like the textures it's sampled from, 8 bits each
+//   y: normal, octahedral, 16 bits snorm per component
+//   z: metallic, roughness and occlusion, 8 bits each
+//   w: emissive rgb, sRGB encoded, 8 bits each; it's added after exposure, where the output clamps it to 1 anyway
+// The quantization and that clamp make deferred output close to forward output, but not bit-identical.
+#include "shading.wgsl"
+
+// Linear color bands in the darks at 8 bits, so colors are stored with the sRGB transfer function
+fn linearToSrgb(c : vec3f) -> vec3f {
+    let low = c * 12.92;
+    let high = 1.055 * pow(c, vec3f(1.0 / 2.4)) - 0.055;
+    return select(high, low, c <= vec3f(0.0031308));
+}
+
+fn srgbToLinear(c : vec3f) -> vec3f {
+    let low = c / 12.92;
+    let high = pow((c + 0.055) / 1.055, vec3f(2.4));
+    return select(high, low, c <= vec3f(0.04045));
+}
+
+// A unit vector projected onto the octahedron and unfolded onto [-1, 1]^2, so that two components cover the sphere
+// evenly
+fn encodeOctahedral(n : vec3f) -> vec2f {
+    let p = n.xy / (abs(n.x) + abs(n.y) + abs(n.z));
+    if (n.z >= 0.0) {
+        return p;
+    }
+    return (1.0 - abs(p.yx)) * select(vec2f(-1.0), vec2f(1.0), p >= vec2f(0.0));
+}
+
+fn decodeOctahedral(e : vec2f) -> vec3f {
+    var n = vec3f(e, 1.0 - abs(e.x) - abs(e.y));
+    let t = max(-n.z, 0.0);
+    n.x += select(t, -t, n.x >= 0.0);
+    n.y += select(t, -t, n.y >= 0.0);
+    return normalize(n);
+}
+
+fn packGBuffer(surface : Surface) -> vec4u {
+    return vec4u(
+        pack4x8unorm(vec4f(linearToSrgb(saturate(surface.baseColor.rgb)), 0.0)),
+        pack2x16snorm(encodeOctahedral(surface.normal)),
+        pack4x8unorm(vec4f(surface.metallic, surface.roughness, surface.occlusion, 0.0)),
+        pack4x8unorm(vec4f(linearToSrgb(saturate(surface.emissive)), 0.0)));
+}
+
+// Opaque, since blended surfaces aren't deferred
+fn unpackGBuffer(packed : vec4u, position : vec3f) -> Surface {
+    let material = unpack4x8unorm(packed.z);
+
+    var surface : Surface;
+    surface.position = position;
+    surface.normal = decodeOctahedral(unpack2x16snorm(packed.y));
+    surface.baseColor = vec4f(srgbToLinear(unpack4x8unorm(packed.x).rgb), 1.0);
+    surface.metallic = material.x;
+    surface.roughness = material.y;
+    surface.occlusion = material.z;
+    surface.emissive = srgbToLinear(unpack4x8unorm(packed.w).rgb);
+    return surface;
+}
@@ -0,0 +1,43 @@
+// Clustered lights, shared by the scene shader and the light culling pass in clusters.wgsl. The view frustum is split
+// into a grid of clusters, tiled on screen and sliced exponentially in depth; each cluster lists the lights whose
+// range reaches it. See LightManager.
+
+// Matches LightManager::MAX_LIGHTS_PER_CLUSTER
+const MAX_LIGHTS_PER_CLUSTER = 64u;
+
+struct Light {
+  position : vec3f,
+  range : f32, // the light fades out before reaching it
+  color : vec3f,
+  intensity : f32
+};
+
+struct Clusters {
+  view : mat4x4f,
+  inverseProjection : mat4x4f,
+  gridSize : vec3u,
+  lightCount : u32,
+  screenSize : vec2f,
+  zNear : f32,
+  zFar : f32
+};
+
+// View-space distance to the near side of a depth slice
+fn getSliceDepth(clusters : Clusters, slice : u32) -> f32 {
+    return clusters.zNear * pow(clusters.zFar / clusters.zNear, f32(slice) / f32(clusters.gridSize.z));
+}
+
+fn getClusterIndex(clusters : Clusters, fragCoord : vec2f, viewDepth : f32) -> u32 {
+    let tileSize = clusters.screenSize / vec2f(clusters.gridSize.xy);
+    let tile = min(vec2u(max(fragCoord / tileSize, vec2f(0))), clusters.gridSize.xy - 1);
+    let slice = log(max(viewDepth, clusters.zNear) / clusters.zNear) / log(clusters.zFar / clusters.zNear) * f32(clusters.gridSize.z);
+    let z = min(u32(slice), clusters.gridSize.z - 1);
+    return tile.x + clusters.gridSize.x * (tile.y + clusters.gridSize.y * z);
+}
+
+// Smoothly to zero at the light's range, so that lights outside a cluster contribute nothing
+fn getRangeFalloff(distance : f32, range : f32) -> f32 {
+    let ratio = distance / range;
+    let window = clamp(1.0 - ratio * ratio * ratio * ratio, 0.0, 1.0);
+    return window * window;
+}
@@ -0,0 +1,53 @@
+// Material table and texture arrays, bound as group 1 by MaterialManager
+
+// Texture references are (texture array binding, layer), see MaterialManager. Textures are laid out per slot:
+// occlusion in R, normal xy in RG, and roughness, metallic from metallicRoughnessChannel on (RG8/BC5, or GB of ORM).
+struct Material {
+  baseColorFactor : vec4f,
+  emissiveFactor : vec3f,
+  alphaCutoff : f32,
+  metallicFactor : f32,
+  roughnessFactor : f32,
+  normalScale : f32,
+  occlusionStrength : f32,
+  baseColorTexture : vec2u,
+  metallicRoughnessTexture : vec2u,
+  emissiveTexture : vec2u,
+  occlusionTexture : vec2u,
+  normalTexture : vec2u,
+  metallicRoughnessChannel : u32
+};
+@group(1) @binding(0) var texSampler : sampler;
+@group(1) @binding(1) var<storage, read> materials : array<Material>;
+@group(1) @binding(2) var textureArray0 : texture_2d_array<f32>;
+@group(1) @binding(3) var textureArray1 : texture_2d_array<f32>;
+@group(1) @binding(4) var textureArray2 : texture_2d_array<f32>;
+@group(1) @binding(5) var textureArray3 : texture_2d_array<f32>;
+@group(1) @binding(6) var textureArray4 : texture_2d_array<f32>;
+@group(1) @binding(7) var textureArray5 : texture_2d_array<f32>;
+@group(1) @binding(8) var textureArray6 : texture_2d_array<f32>;
+@group(1) @binding(9) var textureArray7 : texture_2d_array<f32>;
+
+// Texture coordinates plus their derivatives, taken in uniform control flow so that the material texture can be
+// picked with a switch
+struct TexCoord {
+  uv : vec2f,
+  ddx : vec2f,
+  ddy : vec2f
+};
+
+fn sampleMaterialTexture(textureRef : vec2u, texCoord : TexCoord) -> vec4f {
+    let layer = textureRef.y;
+    var color : vec4f;
+    switch textureRef.x {
+        case 0u: { color = textureSampleGrad(textureArray0, texSampler, texCoord.uv, layer, texCoord.ddx, texCoord.ddy); }
+        case 1u: { color = textureSampleGrad(textureArray1, texSampler, texCoord.uv, layer, texCoord.ddx, texCoord.ddy); }
+        case 2u: { color = textureSampleGrad(textureArray2, texSampler, texCoord.uv, layer, texCoord.ddx, texCoord.ddy); }
+        case 3u: { color = textureSampleGrad(textureArray3, texSampler, texCoord.uv, layer, texCoord.ddx, texCoord.ddy); }
+        case 4u: { color = textureSampleGrad(textureArray4, texSampler, texCoord.uv, layer, texCoord.ddx, texCoord.ddy); }
+        case 5u: { color = textureSampleGrad(textureArray5, texSampler, texCoord.uv, layer, texCoord.ddx, texCoord.ddy); }
+        case 6u: { color = textureSampleGrad(textureArray6, texSampler, texCoord.uv, layer, texCoord.ddx, texCoord.ddy); }
+        default: { color = textureSampleGrad(textureArray7, texSampler, texCoord.uv, layer, texCoord.ddx, texCoord.ddy); }
+    }
+    return color;
+}
@@ -0,0 +1,36 @@
+// One mip level of a texture array: each invocation averages a 2x2 block of the previous level. The source view is
+// sRGB for sRGB arrays, so the average is taken in linear space and re-encoded before storing.
+override isSrgb : bool = false;
+
+@group(0) @binding(0) var srcTexture : texture_2d_array<f32>;
+@group(0) @binding(1) var dstTexture : texture_storage_2d_array<rgba8unorm, write>;
+
+fn linearToSrgb(c : vec3f) -> vec3f {
+    let low = c * 12.92;
+    let high = 1.055 * pow(c, vec3f(1.0 / 2.4)) - 0.055;
+    return select(high, low, c <= vec3f(0.0031308));
+}
+
+@compute @workgroup_size(8, 8, 1)
+fn cs_main(@builtin(global_invocation_id) id : vec3u) {
+    let dstSize = textureDimensions(dstTexture);
+    if (id.x >= dstSize.x || id.y >= dstSize.y) {
+        return;
+    }
+
+    // Levels are floor(size / 2), so an odd axis drops its last row/column. The clamp only matters for a 1 texel axis.
+    let srcMax = textureDimensions(srcTexture) - vec2u(1);
+    let p0 = min(id.xy * 2, srcMax);
+    let p1 = min(id.xy * 2 + vec2u(1), srcMax);
+    let layer = id.z;
+    let average = (textureLoad(srcTexture, p0, layer, 0) +
+        textureLoad(srcTexture, vec2u(p1.x, p0.y), layer, 0) +
+        textureLoad(srcTexture, vec2u(p0.x, p1.y), layer, 0) +
+        textureLoad(srcTexture, p1, layer, 0)) * 0.25;
+
+    var color = average;
+    if (isSrgb) {
+        color = vec4f(linearToSrgb(average.rgb), average.a);
+    }
+    textureStore(dstTexture, id.xy, layer, color);
+}
@@ -0,0 +1,43 @@
+// BRDF terms and photometric exposure
+
+const PI = 3.14159265359;
+
+fn D_GGX(NoH: f32, a: f32) -> f32 {
+    let a2 = a * a;
+    let f = (NoH * a2 - NoH) * NoH + 1.0;
+    return a2 / (PI * f * f);
+}
+
+fn F_Schlick(u : f32, f0 : vec3f) -> vec3f {
+    return f0 + (vec3f(1.0) - f0) * pow(1.0 - u, 5.0);
+}
+
+fn V_SmithGGXCorrelated(NoV : f32, NoL : f32, a : f32) -> f32 {
+    let a2 = a * a;
+    let GGXL = NoV * sqrt((-NoL * a2 + NoL) * NoL + a2);
+    let GGXV = NoL * sqrt((-NoV * a2 + NoV) * NoV + a2);
+    return 0.5 / (GGXV + GGXL);
+}
+
+fn Fd_Lambert() -> f32 {
+    return 1.0 / PI;
+}
+
+fn F_Schlick_Scalar(u : f32, f0 : f32, f90 : f32) -> f32 {
+    return f0 + (f90 - f0) * pow(1.0 - u, 5.0);
+}
+
+fn Fd_Burley(NoV : f32, NoL : f32, LoH : f32, roughness : f32) -> f32 {
+    let f90 = 0.5 + 2.0 * roughness * LoH * LoH;
+    let lightScatter = F_Schlick_Scalar(NoL, 1.0, f90);
+    let viewScatter = F_Schlick_Scalar(NoV, 1.0, f90);
+    return lightScatter * viewScatter * (1.0 / PI);
+}
+
+fn exposureSettings(aperture : f32, shutterSpeed : f32, sensitivity : f32) -> f32 {
+    return log2((aperture * aperture) / shutterSpeed * 100 / sensitivity);
+}
+
+fn exposure(ev100 : f32) -> f32 {
+    return 1.0 / (pow(2.0, ev100) * 1.2);
+}
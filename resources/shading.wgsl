@@ -0,0 +1,81 @@
+// Lighting shared by the forward scene shader and the deferred lighting pass: the frame group, bound as group 0 by
+// RenderManager, and the shading of one surface with the clustered lights
+#include "pbr.wgsl"
+#include "lights.wgsl"
+
+struct Camera {
+  projection : mat4x4f,
+  view : mat4x4f,
+  inverseViewProjection : mat4x4f,
+  position : vec3f,
+  time : f32
+};
+@group(0) @binding(0) var<uniform> camera : Camera;
+@group(0) @binding(1) var<uniform> clusters : Clusters;
+@group(0) @binding(2) var<storage, read> lights : array<Light>;
+@group(0) @binding(3) var<storage, read> clusterLightCounts : array<u32>;
+@group(0) @binding(4) var<storage, read> clusterLightIndices : array<u32>;
+
+// Pipeline-overridable, so that exposure can change without another permutation
+override exposureAperture : f32 = 1.4;
+override exposureShutterSpeed : f32 = 0.2;
+override exposureSensitivity : f32 = 1200.0;
+override ambientStrength : f32 = 0.03;
+
+// Material inputs at one fragment, sampled once and shared by all lights
+struct Surface {
+  position : vec3f,
+  normal : vec3f,
+  baseColor : vec4f,
+  metallic : f32,
+  roughness : f32,
+  occlusion : f32,
+  emissive : vec3f
+};
+
+fn light(surface : Surface, lightPos : vec3f, intensity : f32) -> vec3f {
+    let v = normalize(camera.position - surface.position); // view unit vector
+    let l = normalize(lightPos - surface.position); // light unit vector
+    let h = normalize(v + l);
+    let n = surface.normal;
+
+    let NoV = abs(dot(n, v)) + 1e-5;
+    let NoL = clamp(dot(n, l), 0.0, 1.0) + 1e-5; // Added to prevent NaN
+    let NoH = clamp(dot(n, h), 0.0, 1.0);
+    let LoH = clamp(dot(l, h), 0.0, 1.0);
+
+    let reflectance = 0.04;
+    let baseColor = surface.baseColor.rgb;
+    let diffuseColor = (1.0 - surface.metallic) * baseColor;
+    let f0 = 0.16 * reflectance * reflectance * (1.0 - surface.metallic) + baseColor * surface.metallic;
+
+    let D = D_GGX(NoH, surface.roughness);
+    let F = F_Schlick(LoH, f0);
+    let V = V_SmithGGXCorrelated(NoV, NoL, surface.roughness);
+
+    let Fr = (D * V) * F;
+    let Fd = diffuseColor * Fd_Burley(NoV, NoL, LoH, surface.roughness);
+
+    return vec3f(Fr + Fd) * NoL * intensity;
+}
+
+// Exposed, display color of the surface at fragCoord, unclamped. Only the lights binned into the fragment's cluster
+// are evaluated.
+fn shadeSurface(surface : Surface, fragCoord : vec2f) -> vec3f {
+    let viewDepth = -(camera.view * vec4f(surface.position, 1)).z;
+    let clusterIndex = getClusterIndex(clusters, fragCoord, viewDepth);
+    var color = vec3f(0);
+    for (var i = 0u; i < clusterLightCounts[clusterIndex]; i++) {
+        let clusterLight = lights[clusterLightIndices[clusterIndex * MAX_LIGHTS_PER_CLUSTER + i]];
+        let falloff = getRangeFalloff(distance(clusterLight.position, surface.position), clusterLight.range);
+        color += clusterLight.color * light(surface, clusterLight.position, clusterLight.intensity * falloff);
+    }
+    color += ambientStrength * surface.baseColor.rgb * surface.occlusion;
+
+    let gammaColor = pow(color / (color + vec3f(1)), vec3f(1.0 / 2.2)); // convert linear -> srgb
+
+    let ev100 = exposureSettings(exposureAperture, exposureShutterSpeed, exposureSensitivity);
+    let exposure = exposure(ev100);
+
+    return gammaColor * exposure + surface.emissive;
+}
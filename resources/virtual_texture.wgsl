@@ -0,0 +1,62 @@
+// Virtual texture sampling and feedback, for shaders that bind a VirtualTexture's bind group as group 3. Feedback and
+// page ids are packed as in PageId::pack(): bit 31 set, then 7 bits of mip level and 12 bits each of page y and x.
+struct VirtualTextureInfo {
+  virtualSize : vec2f,
+  physicalSize : vec2f,
+  pageSize : f32,
+  borderSize : f32,
+  mipLevelCount : u32,
+  feedbackWidth : u32,
+  feedbackHeight : u32,
+  feedbackScale : u32
+};
+@group(3) @binding(0) var<uniform> vtInfo : VirtualTextureInfo;
+@group(3) @binding(1) var vtPageTable : texture_2d<u32>;
+@group(3) @binding(2) var vtPhysicalPages : texture_2d<f32>;
+@group(3) @binding(3) var vtSampler : sampler;
+@group(3) @binding(4) var<storage, read_write> vtFeedback : array<u32>;
+
+// Call from uniform control flow, for the derivatives
+fn vtMipLevel(uv : vec2f) -> u32 {
+  let texel = uv * vtInfo.virtualSize;
+  let dx = dpdx(texel);
+  let dy = dpdy(texel);
+  let lod = 0.5 * log2(max(max(dot(dx, dx), dot(dy, dy)), 1.0));
+  return min(u32(lod), vtInfo.mipLevelCount - 1u);
+}
+
+fn vtPage(uv : vec2f, mipLevel : u32) -> vec2u {
+  let levelSize = max(vtInfo.virtualSize / f32(1u << mipLevel), vec2f(1.0));
+  let pageCount = ceil(levelSize / vtInfo.pageSize);
+  return vec2u(clamp(floor(fract(uv) * levelSize / vtInfo.pageSize), vec2f(0.0), pageCount - 1.0));
+}
+
+// Only one fragment in feedbackScale x feedbackScale writes, which makes the feedback a low resolution pass
+fn vtWriteFeedback(uv : vec2f, fragCoord : vec2f, mipLevel : u32) {
+  let pixel = vec2u(fragCoord.xy);
+  if (any(pixel % vtInfo.feedbackScale != vec2u(0u))) {
+    return;
+  }
+  let feedbackTexel = pixel / vtInfo.feedbackScale;
+  if (feedbackTexel.x >= vtInfo.feedbackWidth || feedbackTexel.y >= vtInfo.feedbackHeight) {
+    return;
+  }
+  let page = vtPage(uv, mipLevel);
+  vtFeedback[feedbackTexel.y * vtInfo.feedbackWidth + feedbackTexel.x] = (1u << 31u) | (mipLevel << 24u) | (page.y << 12u) | page.x;
+}
+
+// Samples the finest resident page covering uv at mipLevel; magenta until the coarsest page has loaded
+fn vtSample(uv : vec2f, mipLevel : u32) -> vec4f {
+  let page = vtPage(uv, mipLevel);
+  let entry = textureLoad(vtPageTable, page, i32(mipLevel));
+  if (entry.a == 0u) {
+    return vec4f(1.0, 0.0, 1.0, 1.0);
+  }
+
+  // The entry may be a coarser page than the one asked for
+  let residentLevelSize = max(vtInfo.virtualSize / f32(1u << entry.b), vec2f(1.0));
+  let inPage = fract(uv) * residentLevelSize / vtInfo.pageSize - floor(fract(uv) * residentLevelSize / vtInfo.pageSize);
+  let tileSize = vtInfo.pageSize + 2.0 * vtInfo.borderSize;
+  let physicalTexel = vec2f(entry.rg) * tileSize + vtInfo.borderSize + inPage * vtInfo.pageSize;
+  return textureSampleLevel(vtPhysicalPages, vtSampler, physicalTexel / vtInfo.physicalSize, 0.0);
+}
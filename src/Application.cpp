@@ -7,6 +7,7 @@
 #include "webgpu/Window.h"
 #include "event/EventManager.h"
 #include "input/Controller.h"
+#include "job/JobSystem.h"
 #include "resource/Loader.h"
 #include "webgpu/Surface.h"
 #include "physics/Player.h"
@@ -55,6 +56,7 @@ int Application::run()
 
     m_resourceLoader = std::make_unique<resource::Loader>(std::filesystem::absolute("resources"));
     m_settings = std::make_unique<resource::Settings>();
+    m_jobSystem = std::make_unique<job::JobSystem>(m_settings->getInt("job.threadCount").value_or(0));
     m_webGpuInstance = std::make_unique<webgpu::WebGpuInstance>();
     m_eventManager = std::make_unique<event::EventManager>();
     m_controller = std::make_unique<input::Controller>();
@@ -73,13 +75,16 @@ int Application::run()
     m_tickNanos = m_settings->getInt("physics.tickNanos").value_or(10000000);
     m_lastFrameTimestamp = m_lastTickTimestamp = SDL_GetTicksNS();
 
+    // Before the managers whose bind group layouts are reflected from its shaders
+    m_renderManager = std::make_unique<webgpu::RenderManager>();
+
     m_materialManager = std::make_unique<webgpu::MaterialManager>();
 
     m_modelManager = std::make_unique<webgpu::ModelManager>();
     m_modelManager->loadModels();
+    m_materialManager->createMaterialTable();
     m_modelManager->createBindGroups(); // TODO - move?
 
-    m_renderManager = std::make_unique<webgpu::RenderManager>();
     m_renderManager->createRenderPasses();
 
 #ifdef __EMSCRIPTEN__
@@ -136,6 +141,7 @@ bool Application::mainLoop()
         m_inputManager->processPartialInputTick(m_lastTickTimestamp, m_tickNanos, static_cast<int>(accumulator));
     }
 
+    m_materialManager->update();
     m_renderManager->run();
 
     m_lastFrameTimestamp = now;
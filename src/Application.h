@@ -32,6 +32,11 @@ namespace resource
     class Loader;
 }
 
+namespace job
+{
+    class JobSystem;
+}
+
 namespace input
 {
     class InputManager;
@@ -67,6 +72,7 @@ return *m_theAppInstance->var;\
 }
     COMPONENT_GETTER(resource::Loader, m_resourceLoader, getResourceLoader);
     COMPONENT_GETTER(resource::Settings, m_settings, getSettings);
+    COMPONENT_GETTER(job::JobSystem, m_jobSystem, getJobSystem);
     COMPONENT_GETTER(webgpu::WebGpuInstance, m_webGpuInstance, getWebGpuInstance);
     COMPONENT_GETTER(event::EventManager, m_eventManager, getEventManager);
     COMPONENT_GETTER(input::InputManager, m_inputManager, getInputManager);
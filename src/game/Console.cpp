@@ -2,11 +2,15 @@
 
 #include <imgui_impl_sdl3.h>
 #include <imgui_impl_wgpu.h>
+#include <string>
 #include <vector>
 #include <magic_enum/magic_enum.hpp>
 #include <spdlog/spdlog.h>
 
 #include "../webgpu/Device.h"
+#include "../webgpu/MaterialManager.h"
+#include "../webgpu/ModelManager.h"
+#include "../webgpu/RenderManager.h"
 #include "../webgpu/Window.h"
 #include "input/Controller.h"
 #include "input/InputManager.h"
@@ -14,10 +18,10 @@
 
 namespace game
 {
-    Console::Console(const webgpu::RenderTargetTextureView& m_canvasTextureView, const webgpu::RenderTargetTextureView& m_depthTextureView)
+    Console::Console(WGPUTextureFormat colorFormat, WGPUTextureFormat depthFormat)
     : EventConsumer{0},
     InputConsumer(0),
-    RenderPass{"Console", webgpu::RenderPassStage::CONSOLE, m_canvasTextureView, m_depthTextureView},
+    RenderPass{"Console", webgpu::RenderPassStage::CONSOLE, colorFormat, depthFormat},
     m_keyMap{Application::getInputManager().getKeyMap().getPlayerKeyMap(0)}, m_isOpen{false}, m_commandInput{}
     {
         IMGUI_CHECKVERSION();
@@ -29,9 +33,9 @@ namespace game
         ImGui_ImplWGPU_InitInfo info;
         info.Device = Application::getDevice().get();
         info.NumFramesInFlight = 3;
-        info.RenderTargetFormat = m_canvasTextureView.getTextureFormat();
-        info.DepthStencilFormat = m_depthTextureView.getTextureFormat();
-        info.PipelineMultisampleState.count = 4;
+        info.RenderTargetFormat = colorFormat;
+        info.DepthStencilFormat = depthFormat;
+        info.PipelineMultisampleState.count = webgpu::Pipeline::SAMPLE_COUNT;
 
         ImGui_ImplSDL3_InitForOther(Application::getWindow().get());
         ImGui_ImplWGPU_Init(&info);
@@ -91,6 +95,68 @@ namespace game
 
             ImGui::Text("Application average %.3f ms/frame (%.1f FPS)", 1000.0f / io.Framerate, io.Framerate);
 
+            const auto textureCacheStats = Application::getMaterialManager().getTextureCacheStats();
+            const float textureCacheHitRate = textureCacheStats.lookups > 0 ? 100.0f * textureCacheStats.hits / textureCacheStats.lookups : 0.0f;
+            ImGui::Text("Texture cache: %d/%d hits (%.1f%%), %.2f MiB saved", textureCacheStats.hits, textureCacheStats.lookups, textureCacheHitRate, textureCacheStats.bytesSaved / (1024.0 * 1024.0));
+
+            const auto residencyStats = Application::getMaterialManager().getTextureResidencyStats();
+            if (residencyStats.budgetBytes > 0)
+            {
+                const float budgetUsage = 100.0f * residencyStats.residentBytes / residencyStats.budgetBytes;
+                ImGui::Text("Texture streaming: %.2f/%.2f MiB (%.1f%%), %.2f MiB requested, %d mips pending", residencyStats.residentBytes / (1024.0 * 1024.0),
+                    residencyStats.budgetBytes / (1024.0 * 1024.0), budgetUsage, residencyStats.requestedBytes / (1024.0 * 1024.0), residencyStats.pendingLevelCount);
+            }
+            else
+            {
+                ImGui::Text("Texture streaming: off, %.2f MiB resident", residencyStats.residentBytes / (1024.0 * 1024.0));
+            }
+
+            const auto pipelineStats = Application::getRenderManager().getPipelineCache().getStats();
+            ImGui::Text("Pipelines: %d ready, %d compiling, %d failed, %d shader modules from %d permutations, %d bind group layouts", pipelineStats.readyCount,
+                pipelineStats.pendingCount, pipelineStats.failedCount, pipelineStats.shaderModuleCount, Application::getRenderManager().getShaderPreprocessor().getCachedCount(),
+                webgpu::BindGroupLayout::getCachedCount());
+
+            auto& renderManager = Application::getRenderManager();
+            ImGui::Text("Uploads: %.1f KiB uniforms, %.1f KiB per-frame data last frame", renderManager.getUniformBytesWritten() / 1024.0,
+                renderManager.getFrameAllocatorBytesUsed() / 1024.0);
+            ImGui::Text("Render targets: %d, %d created since startup", renderManager.getRenderTargetPool().getCount(),
+                renderManager.getRenderTargetPool().getCreatedCount());
+
+            if (renderManager.getGpuTimer().isEnabled())
+            {
+                std::string gpuTimings;
+                double totalMilliseconds = 0.0;
+                for (const auto& timing : renderManager.getGpuTimer().getTimings())
+                {
+                    gpuTimings += fmt::format(", {} {:.2f} ms", timing.name, timing.milliseconds);
+                    totalMilliseconds += timing.milliseconds;
+                }
+                ImGui::Text("GPU: %.2f ms%s", totalMilliseconds, gpuTimings.c_str());
+            }
+            else
+            {
+                ImGui::Text("GPU: no timestamp queries");
+            }
+
+            bool isDepthPrePassEnabled = renderManager.isDepthPrePassEnabled();
+            if (ImGui::Checkbox("Depth pre-pass", &isDepthPrePassEnabled))
+            {
+                renderManager.setDepthPrePassEnabled(isDepthPrePassEnabled);
+            }
+
+            auto& modelManager = Application::getModelManager();
+            bool isGpuCullingEnabled = modelManager.isGpuCullingEnabled();
+            if (ImGui::Checkbox("GPU culling", &isGpuCullingEnabled))
+            {
+                modelManager.setGpuCullingEnabled(isGpuCullingEnabled);
+            }
+
+            bool isDeferred = renderManager.getShadingPath() == webgpu::ShadingPath::DEFERRED;
+            if (ImGui::Checkbox("Deferred shading", &isDeferred))
+            {
+                renderManager.setShadingPath(isDeferred ? webgpu::ShadingPath::DEFERRED : webgpu::ShadingPath::FORWARD);
+            }
+
             const float footer_height_to_reserve = ImGui::GetStyle().ItemSpacing.y + ImGui::GetFrameHeightWithSpacing();
             static bool scroll_to_bottom = false;
             if (ImGui::BeginChild("ScrollingRegion", ImVec2(0, -footer_height_to_reserve), ImGuiChildFlags_None, ImGuiWindowFlags_HorizontalScrollbar))
@@ -3,7 +3,6 @@
 #include <SDL3/SDL_events.h>
 
 #include "input/InputConsumer.h"
-#include "webgpu/RenderTargetTextureView.h"
 #include "input/KeyMap.h"
 #include "webgpu/RenderPass.h"
 
@@ -22,7 +21,7 @@ namespace game
     class Console : public event::EventConsumer, public input::InputConsumer, public webgpu::RenderPass
     {
     public:
-        Console(const webgpu::RenderTargetTextureView& m_canvasTextureView, const webgpu::RenderTargetTextureView& m_depthTextureView);
+        Console(WGPUTextureFormat colorFormat, WGPUTextureFormat depthFormat);
         ~Console() override;
 
         bool processEvent(const SDL_Event& event) override;
@@ -0,0 +1,133 @@
+#include "JobSystem.h"
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <spdlog/spdlog.h>
+
+namespace job
+{
+    JobSystem::JobSystem(int threadCount) : m_runningJobCount{0}, m_isStopping{false}
+    {
+#ifndef __EMSCRIPTEN__
+        if (threadCount <= 0)
+        {
+            threadCount = std::max(1, static_cast<int>(std::thread::hardware_concurrency()) - 1);
+        }
+
+        for (int iThread = 0; iThread < threadCount; iThread++)
+        {
+            m_threads.emplace_back(&JobSystem::workerLoop, this);
+        }
+        spdlog::info("Job system started with {} worker threads", threadCount);
+#endif
+    }
+
+    JobSystem::~JobSystem()
+    {
+        {
+            std::lock_guard lock{m_mutex};
+            m_isStopping = true;
+        }
+        m_jobAvailable.notify_all();
+
+        for (auto& thread : m_threads)
+        {
+            thread.join();
+        }
+    }
+
+    void JobSystem::submit(std::function<void()> job)
+    {
+#ifdef __EMSCRIPTEN__
+        job();
+#else
+        {
+            std::lock_guard lock{m_mutex};
+            m_jobs.push_back(std::move(job));
+        }
+        m_jobAvailable.notify_one();
+#endif
+    }
+
+    void JobSystem::wait()
+    {
+        std::unique_lock lock{m_mutex};
+        m_jobsFinished.wait(lock, [this] { return m_jobs.empty() && m_runningJobCount == 0; });
+    }
+
+    void JobSystem::parallelFor(int count, const std::function<void(int)>& job)
+    {
+        // Shared, since helpers queued behind other jobs may only start after everything is done
+        struct Items
+        {
+            std::function<void(int)> job;
+            int count;
+            std::atomic<int> nextItem{0};
+            std::mutex mutex;
+            std::condition_variable finished;
+            int finishedCount{0};
+        };
+        auto items = std::make_shared<Items>();
+        items->job = job;
+        items->count = count;
+
+        auto runItems = [items] {
+            for (int iItem = items->nextItem++; iItem < items->count; iItem = items->nextItem++)
+            {
+                items->job(iItem);
+                std::lock_guard lock{items->mutex};
+                if (++items->finishedCount == items->count)
+                {
+                    items->finished.notify_all();
+                }
+            }
+        };
+
+        const int helperCount = std::min(count - 1, getThreadCount());
+        for (int iHelper = 0; iHelper < helperCount; iHelper++)
+        {
+            submit(runItems);
+        }
+        runItems();
+
+        std::unique_lock lock{items->mutex};
+        items->finished.wait(lock, [&items] { return items->finishedCount == items->count; });
+    }
+
+    int JobSystem::getThreadCount() const
+    {
+        return static_cast<int>(m_threads.size());
+    }
+
+    void JobSystem::workerLoop()
+    {
+        while (true)
+        {
+            std::function<void()> job;
+            {
+                std::unique_lock lock{m_mutex};
+                m_jobAvailable.wait(lock, [this] { return m_isStopping || !m_jobs.empty(); });
+                if (m_isStopping && m_jobs.empty())
+                {
+                    return;
+                }
+
+                job = std::move(m_jobs.front());
+                m_jobs.pop_front();
+                m_runningJobCount++;
+            }
+
+            job();
+
+            {
+                std::lock_guard lock{m_mutex};
+                m_runningJobCount--;
+                if (m_jobs.empty() && m_runningJobCount == 0)
+                {
+                    m_jobsFinished.notify_all();
+                }
+            }
+        }
+    }
+}
@@ -0,0 +1,46 @@
+#pragma once
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace job
+{
+    // Fixed pool of worker threads running fire-and-forget jobs. Jobs must not touch WebGPU or SDL; results are
+    // handed back to the main thread by whoever submitted the job. The exception is encoding into an object the job
+    // owns, like a render bundle encoder, on a device with implicit synchronization. Without thread support
+    // (emscripten) jobs run synchronously in submit().
+    class JobSystem
+    {
+    public:
+        explicit JobSystem(int threadCount = 0); // 0 = one per hardware thread, minus the main thread
+        ~JobSystem();
+
+        JobSystem(const JobSystem&) = delete;
+        JobSystem& operator=(const JobSystem&) = delete;
+
+        void submit(std::function<void()> job);
+
+        // Blocks until every submitted job has finished
+        void wait();
+
+        // Runs job(0) to job(count - 1) on the workers and the calling thread, and returns once they have all
+        // finished. The caller takes items too, so it never waits behind unrelated jobs for longer than one item.
+        void parallelFor(int count, const std::function<void(int)>& job);
+
+        [[nodiscard]] int getThreadCount() const;
+
+    private:
+        std::vector<std::thread> m_threads;
+        std::deque<std::function<void()>> m_jobs;
+        std::mutex m_mutex;
+        std::condition_variable m_jobAvailable;
+        std::condition_variable m_jobsFinished;
+        int m_runningJobCount;
+        bool m_isStopping;
+
+        void workerLoop();
+    };
+}
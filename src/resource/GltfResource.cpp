@@ -42,6 +42,23 @@ namespace resource
             }
         }
 
+        for (const auto& jImage : m_gltf.images)
+        {
+            if ((jImage.bufferView != -1) || jImage.uri.empty() || m_imageResources.contains(jImage.uri))
+            {
+                continue;
+            }
+
+            RawResource res = RawResource{getResourceDir(), path.parent_path().append(jImage.uri)};
+            std::string error;
+            if (!res.isOk(error))
+            {
+                spdlog::error("Unable to load image data from uri {}: {}", jImage.uri, error);
+                continue;
+            }
+            m_imageResources.insert(std::make_pair(jImage.uri, res));
+        }
+
         m_loaded = true;
         spdlog::info("Loaded {}", path.string());
     }
@@ -56,6 +73,36 @@ namespace resource
         return m_bufferResources;
     }
 
+    bool GltfResource::hasOrmImage(const JMaterial& jMaterial) const
+    {
+        const auto& occlusion = jMaterial.occlusionTexture;
+        const auto& metallicRoughness = jMaterial.pbrMetallicRoughness.metallicRoughnessTexture;
+        if ((occlusion.index == -1) || (metallicRoughness.index == -1) || (occlusion.texCoord != metallicRoughness.texCoord))
+        {
+            return false;
+        }
+
+        return m_gltf.textures.at(occlusion.index).source == m_gltf.textures.at(metallicRoughness.index).source;
+    }
+
+    std::span<const char> GltfResource::getImageBytes(const JImage& jImage) const
+    {
+        if (jImage.bufferView == -1)
+        {
+            auto it = m_imageResources.find(jImage.uri);
+            if (it == m_imageResources.end())
+            {
+                return {};
+            }
+            return {it->second.getBytes().data(), it->second.getBytes().size()};
+        }
+
+        const auto& bufferView = m_gltf.bufferViews.at(jImage.bufferView);
+        const auto& buffer = m_gltf.buffers.at(bufferView.buffer);
+        const auto& bufferRes = m_bufferResources.at(buffer.uri);
+        return {bufferRes.getBytes().data() + bufferView.byteOffset, static_cast<size_t>(bufferView.byteLength)};
+    }
+
     std::optional<std::pair<json, std::optional<RawResource>>> GltfResource::readGltf(const std::filesystem::path& path)
     {
         if (path.filename().extension() == ".glb")
@@ -1,4 +1,5 @@
 #pragma once
+#include <span>
 #include <nlohmann/json.hpp>
 
 #include "Resource.h"
@@ -15,15 +16,15 @@ namespace resource
         bool normalized{false};
         int count{-1};
         std::string type{};
-        //max
-        //min
+        std::vector<float> max{};
+        std::vector<float> min{};
         //sparse
         std::string name{};
         //extensions
         //extra
     };
     NLOHMANN_DEFINE_TYPE_NON_INTRUSIVE_WITH_DEFAULT(JAccessor, bufferView, byteOffset, componentType, normalized, count,
-        type, name);
+        type, max, min, name);
 
     struct JBuffer
     {
@@ -186,9 +187,16 @@ namespace resource
         const JGltf& getGltf() const;
         const std::unordered_map<std::string, RawResource>& getBuffers() const;
 
+        // Encoded bytes of an image, from its buffer view or its uri's file; empty when they couldn't be loaded
+        std::span<const char> getImageBytes(const JImage& jImage) const;
+
+        // Whether occlusion and metallic-roughness of the material come from one image, which is then an ORM texture
+        bool hasOrmImage(const JMaterial& jMaterial) const;
+
     private:
         JGltf m_gltf;
         std::unordered_map<std::string, RawResource> m_bufferResources;
+        std::unordered_map<std::string, RawResource> m_imageResources; // images referenced by uri
         bool m_loaded;
 
         std::optional<std::pair<nlohmann::json, std::optional<RawResource>>> readGltf(const std::filesystem::path& path);
@@ -0,0 +1,224 @@
+#include "Ktx2.h"
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <numeric>
+
+namespace resource
+{
+    namespace
+    {
+        constexpr std::array<unsigned char, 12> KTX2_IDENTIFIER{0xAB, 0x4B, 0x54, 0x58, 0x20, 0x32, 0x30, 0xBB, 0x0D, 0x0A, 0x1A, 0x0A};
+        constexpr size_t HEADER_SIZE = 80; // identifier, header and index
+        constexpr size_t LEVEL_INDEX_ENTRY_SIZE = 24;
+
+        template <typename T>
+        T read(const char* data, size_t offset)
+        {
+            T value;
+            std::memcpy(&value, data + offset, sizeof(T)); // KTX2 is little-endian, as are all targets
+            return value;
+        }
+
+        template <typename T>
+        void store(std::vector<char>& data, size_t offset, T value)
+        {
+            std::memcpy(data.data() + offset, &value, sizeof(T));
+        }
+
+        // Khronos data format descriptor values
+        constexpr uint8_t KHR_DF_MODEL_RGBSDA = 1;
+        constexpr uint8_t KHR_DF_MODEL_BC4 = 131;
+        constexpr uint8_t KHR_DF_MODEL_BC5 = 132;
+        constexpr uint8_t KHR_DF_MODEL_BC7 = 134;
+        constexpr uint8_t KHR_DF_PRIMARIES_BT709 = 1;
+        constexpr uint8_t KHR_DF_TRANSFER_LINEAR = 1;
+        constexpr uint8_t KHR_DF_TRANSFER_SRGB = 2;
+        constexpr uint8_t KHR_DF_CHANNEL_ALPHA = 15;
+        constexpr uint8_t KHR_DF_SAMPLE_DATATYPE_LINEAR = 0x10;
+
+        struct DfdSample
+        {
+            uint16_t bitOffset;
+            uint8_t bitLength; // minus one
+            uint8_t channelType;
+            uint32_t upper;
+        };
+
+        struct DfdFormat
+        {
+            uint8_t colorModel;
+            uint8_t blockSize; // in texels, square
+            uint8_t bytesPerBlock;
+            bool isSrgb;
+            std::vector<DfdSample> samples;
+        };
+
+        std::optional<DfdFormat> getDfdFormat(uint32_t vkFormat)
+        {
+            switch (vkFormat)
+            {
+                case Ktx2::VK_FORMAT_R8_UNORM:
+                    return DfdFormat{KHR_DF_MODEL_RGBSDA, 1, 1, false, {{0, 7, 0, 255}}};
+                case Ktx2::VK_FORMAT_R8G8_UNORM:
+                    return DfdFormat{KHR_DF_MODEL_RGBSDA, 1, 2, false, {{0, 7, 0, 255}, {8, 7, 1, 255}}};
+                case Ktx2::VK_FORMAT_R8G8B8A8_UNORM:
+                case Ktx2::VK_FORMAT_R8G8B8A8_SRGB:
+                {
+                    const bool isSrgb = vkFormat == Ktx2::VK_FORMAT_R8G8B8A8_SRGB;
+                    const uint8_t alphaType = KHR_DF_CHANNEL_ALPHA | (isSrgb ? KHR_DF_SAMPLE_DATATYPE_LINEAR : 0);
+                    return DfdFormat{KHR_DF_MODEL_RGBSDA, 1, 4, isSrgb, {{0, 7, 0, 255}, {8, 7, 1, 255}, {16, 7, 2, 255}, {24, 7, alphaType, 255}}};
+                }
+                case Ktx2::VK_FORMAT_BC4_UNORM_BLOCK:
+                    return DfdFormat{KHR_DF_MODEL_BC4, 4, 8, false, {{0, 63, 0, 0xFFFFFFFF}}};
+                case Ktx2::VK_FORMAT_BC5_UNORM_BLOCK:
+                    return DfdFormat{KHR_DF_MODEL_BC5, 4, 16, false, {{0, 63, 0, 0xFFFFFFFF}, {64, 63, 1, 0xFFFFFFFF}}};
+                case Ktx2::VK_FORMAT_BC7_UNORM_BLOCK:
+                case Ktx2::VK_FORMAT_BC7_SRGB_BLOCK:
+                    return DfdFormat{KHR_DF_MODEL_BC7, 4, 16, vkFormat == Ktx2::VK_FORMAT_BC7_SRGB_BLOCK, {{0, 127, 0, 0xFFFFFFFF}}};
+                default:
+                    return std::nullopt;
+            }
+        }
+
+        size_t alignUp(size_t value, size_t alignment)
+        {
+            return (value + alignment - 1) / alignment * alignment;
+        }
+    }
+
+    bool Ktx2::isKtx2(const char* data, size_t size)
+    {
+        return (size >= KTX2_IDENTIFIER.size()) && (std::memcmp(data, KTX2_IDENTIFIER.data(), KTX2_IDENTIFIER.size()) == 0);
+    }
+
+    std::optional<Ktx2> Ktx2::parse(const char* data, size_t size, std::string& error)
+    {
+        if (!isKtx2(data, size) || (size < HEADER_SIZE))
+        {
+            error = "Not a KTX2 file";
+            return std::nullopt;
+        }
+
+        Ktx2 ktx2;
+        ktx2.vkFormat = read<uint32_t>(data, 12);
+        ktx2.width = static_cast<int>(read<uint32_t>(data, 20));
+        ktx2.height = static_cast<int>(read<uint32_t>(data, 24));
+        const auto depth = read<uint32_t>(data, 28);
+        const auto layerCount = read<uint32_t>(data, 32);
+        const auto faceCount = read<uint32_t>(data, 36);
+        const auto levelCount = std::max(1u, read<uint32_t>(data, 40)); // 0 asks for runtime mip generation
+        const auto supercompressionScheme = read<uint32_t>(data, 44);
+
+        if ((ktx2.width == 0) || (ktx2.height == 0) || (depth > 1) || (layerCount > 1) || (faceCount != 1))
+        {
+            error = "Only single 2D images are supported";
+            return std::nullopt;
+        }
+        if (supercompressionScheme != 0)
+        {
+            error = "Supercompression scheme " + std::to_string(supercompressionScheme) + " is not supported";
+            return std::nullopt;
+        }
+        if (ktx2.vkFormat == VK_FORMAT_UNDEFINED)
+        {
+            error = "Basis Universal payloads are not supported";
+            return std::nullopt;
+        }
+        if (size < HEADER_SIZE + (levelCount * LEVEL_INDEX_ENTRY_SIZE))
+        {
+            error = "Truncated level index";
+            return std::nullopt;
+        }
+
+        for (uint32_t iLevel = 0; iLevel < levelCount; iLevel++)
+        {
+            const size_t entryOffset = HEADER_SIZE + (iLevel * LEVEL_INDEX_ENTRY_SIZE);
+            const auto byteOffset = read<uint64_t>(data, entryOffset);
+            const auto byteLength = read<uint64_t>(data, entryOffset + 8);
+            if ((byteOffset > size) || (byteLength > size - byteOffset))
+            {
+                error = "Level " + std::to_string(iLevel) + " is out of bounds";
+                return std::nullopt;
+            }
+
+            ktx2.levels.emplace_back(data + byteOffset, data + byteOffset + byteLength);
+        }
+
+        return ktx2;
+    }
+
+    std::optional<std::vector<char>> Ktx2::write(const Ktx2& ktx2, std::string& error)
+    {
+        const auto dfdFormat = getDfdFormat(ktx2.vkFormat);
+        if (!dfdFormat.has_value())
+        {
+            error = "No data format descriptor for VkFormat " + std::to_string(ktx2.vkFormat);
+            return std::nullopt;
+        }
+        if (ktx2.levels.empty())
+        {
+            error = "No levels";
+            return std::nullopt;
+        }
+
+        const auto levelCount = static_cast<uint32_t>(ktx2.levels.size());
+        const size_t dfdOffset = HEADER_SIZE + levelCount * LEVEL_INDEX_ENTRY_SIZE;
+        const size_t dfdBlockSize = 24 + 16 * dfdFormat->samples.size();
+        const size_t dfdSize = 4 + dfdBlockSize;
+
+        // Levels are stored smallest first, each aligned to lcm(block size, 4)
+        const size_t levelAlignment = std::lcm<size_t>(dfdFormat->bytesPerBlock, 4);
+        std::vector<size_t> levelOffsets(levelCount);
+        size_t size = dfdOffset + dfdSize;
+        for (int iLevel = static_cast<int>(levelCount) - 1; iLevel >= 0; iLevel--)
+        {
+            levelOffsets.at(iLevel) = alignUp(size, levelAlignment);
+            size = levelOffsets.at(iLevel) + ktx2.levels.at(iLevel).size();
+        }
+
+        std::vector<char> data(size, 0);
+        std::memcpy(data.data(), KTX2_IDENTIFIER.data(), KTX2_IDENTIFIER.size());
+        store<uint32_t>(data, 12, ktx2.vkFormat);
+        store<uint32_t>(data, 16, 1); // typeSize, 1 for all byte and block formats
+        store<uint32_t>(data, 20, ktx2.width);
+        store<uint32_t>(data, 24, ktx2.height);
+        store<uint32_t>(data, 36, 1); // faceCount
+        store<uint32_t>(data, 40, levelCount);
+        store<uint32_t>(data, 48, static_cast<uint32_t>(dfdOffset));
+        store<uint32_t>(data, 52, static_cast<uint32_t>(dfdSize));
+
+        for (uint32_t iLevel = 0; iLevel < levelCount; iLevel++)
+        {
+            const size_t entryOffset = HEADER_SIZE + (iLevel * LEVEL_INDEX_ENTRY_SIZE);
+            const auto& level = ktx2.levels.at(iLevel);
+            store<uint64_t>(data, entryOffset, levelOffsets.at(iLevel));
+            store<uint64_t>(data, entryOffset + 8, level.size());
+            store<uint64_t>(data, entryOffset + 16, level.size());
+            std::memcpy(data.data() + levelOffsets.at(iLevel), level.data(), level.size());
+        }
+
+        // Basic data format descriptor block
+        store<uint32_t>(data, dfdOffset, static_cast<uint32_t>(dfdSize));
+        store<uint16_t>(data, dfdOffset + 8, 2); // version
+        store<uint16_t>(data, dfdOffset + 10, static_cast<uint16_t>(dfdBlockSize));
+        store<uint8_t>(data, dfdOffset + 12, dfdFormat->colorModel);
+        store<uint8_t>(data, dfdOffset + 13, KHR_DF_PRIMARIES_BT709);
+        store<uint8_t>(data, dfdOffset + 14, dfdFormat->isSrgb ? KHR_DF_TRANSFER_SRGB : KHR_DF_TRANSFER_LINEAR);
+        store<uint8_t>(data, dfdOffset + 16, dfdFormat->blockSize - 1);
+        store<uint8_t>(data, dfdOffset + 17, dfdFormat->blockSize - 1);
+        store<uint8_t>(data, dfdOffset + 20, dfdFormat->bytesPerBlock);
+        for (size_t iSample = 0; iSample < dfdFormat->samples.size(); iSample++)
+        {
+            const auto& sample = dfdFormat->samples.at(iSample);
+            const size_t sampleOffset = dfdOffset + 28 + 16 * iSample;
+            store<uint16_t>(data, sampleOffset, sample.bitOffset);
+            store<uint8_t>(data, sampleOffset + 2, sample.bitLength);
+            store<uint8_t>(data, sampleOffset + 3, sample.channelType);
+            store<uint32_t>(data, sampleOffset + 12, sample.upper);
+        }
+
+        return data;
+    }
+}
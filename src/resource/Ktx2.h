@@ -0,0 +1,53 @@
+#pragma once
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace resource
+{
+    // The parts of a KTX2 container needed for 2D textures: format, size and the mip levels. Only containers without
+    // supercompression are supported.
+    struct Ktx2
+    {
+        // VkFormat values used by the texture pipeline
+        enum VkFormat : uint32_t
+        {
+            VK_FORMAT_UNDEFINED = 0,
+            VK_FORMAT_R8_UNORM = 9,
+            VK_FORMAT_R8G8_UNORM = 16,
+            VK_FORMAT_R8G8B8A8_UNORM = 37,
+            VK_FORMAT_R8G8B8A8_SRGB = 43,
+            VK_FORMAT_BC1_RGB_UNORM_BLOCK = 131,
+            VK_FORMAT_BC1_RGB_SRGB_BLOCK = 132,
+            VK_FORMAT_BC1_RGBA_UNORM_BLOCK = 133,
+            VK_FORMAT_BC1_RGBA_SRGB_BLOCK = 134,
+            VK_FORMAT_BC3_UNORM_BLOCK = 137,
+            VK_FORMAT_BC3_SRGB_BLOCK = 138,
+            VK_FORMAT_BC4_UNORM_BLOCK = 139,
+            VK_FORMAT_BC5_UNORM_BLOCK = 141,
+            VK_FORMAT_BC7_UNORM_BLOCK = 145,
+            VK_FORMAT_BC7_SRGB_BLOCK = 146,
+            VK_FORMAT_ETC2_R8G8B8_UNORM_BLOCK = 147,
+            VK_FORMAT_ETC2_R8G8B8_SRGB_BLOCK = 148,
+            VK_FORMAT_ETC2_R8G8B8A1_UNORM_BLOCK = 149,
+            VK_FORMAT_ETC2_R8G8B8A1_SRGB_BLOCK = 150,
+            VK_FORMAT_ETC2_R8G8B8A8_UNORM_BLOCK = 151,
+            VK_FORMAT_ETC2_R8G8B8A8_SRGB_BLOCK = 152,
+            VK_FORMAT_ASTC_4x4_UNORM_BLOCK = 157,
+            VK_FORMAT_ASTC_4x4_SRGB_BLOCK = 158,
+        };
+
+        uint32_t vkFormat{VK_FORMAT_UNDEFINED};
+        int width{0};
+        int height{0};
+        std::vector<std::vector<unsigned char>> levels; // level 0 first
+
+        static bool isKtx2(const char* data, size_t size);
+        static std::optional<Ktx2> parse(const char* data, size_t size, std::string& error);
+
+        // Writes a container without supercompression. Only the formats the texture cooker produces have a data
+        // format descriptor: RGBA8, R8, RG8, BC4, BC5 and BC7.
+        static std::optional<std::vector<char>> write(const Ktx2& ktx2, std::string& error);
+    };
+}
@@ -58,6 +58,17 @@ namespace resource
         return std::nullopt;
     }
 
+    std::optional<RawResource> Loader::getTexture(const std::string& name)
+    {
+        auto it = m_textures.find(name);
+        if (it != m_textures.end())
+        {
+            return it->second;
+        }
+
+        return std::nullopt;
+    }
+
     std::optional<StringResource> Loader::getConfig(const std::string& name)
     {
         auto it = m_configs.find(name);
@@ -114,6 +125,17 @@ namespace resource
 
                     m_bins.insert(std::make_pair(res.getName(), res));
                 }
+                else if(ext == ".ktx2")
+                {
+                    RawResource res{m_dir, dirEntry.path()};
+                    std::string error;
+                    if (!res.isOk(error))
+                    {
+                        spdlog::warn("Resource did not load: " + error);
+                    }
+
+                    m_textures.insert(std::make_pair(res.getName(), res));
+                }
                 else if(ext == ".config")
                 {
                     RawResource raw{m_dir, dirEntry.path()};
@@ -13,6 +13,7 @@ namespace resource
         std::optional<GltfResource> getGltf(const std::string& name);
         std::vector<GltfResource> getGltfs();
         std::optional<RawResource> getBin(const std::string& name);
+        std::optional<RawResource> getTexture(const std::string& name);
         std::optional<StringResource> getConfig(const std::string& name);
 
     private:
@@ -20,6 +21,7 @@ namespace resource
         std::unordered_map<std::string, StringResource> m_shaders;
         std::unordered_map<std::string, GltfResource> m_gltfs;
         std::unordered_map<std::string, RawResource> m_bins;
+        std::unordered_map<std::string, RawResource> m_textures;
         std::unordered_map<std::string, StringResource> m_configs;
 
         void loadDir(const std::filesystem::path& dir);
@@ -6,7 +6,7 @@ namespace webgpu
     {
     }
 
-    std::string_view BasePass::getName()
+    std::string_view BasePass::getName() const
     {
         return m_name;
     }
@@ -10,7 +10,7 @@ namespace webgpu
         explicit BasePass(std::string_view name);
         virtual ~BasePass() = default;
 
-        std::string_view getName();
+        [[nodiscard]] std::string_view getName() const;
 
     private:
         std::string m_name;
@@ -7,6 +7,7 @@
 #include "Sampler.h"
 #include "StringView.h"
 #include "Texture.h"
+#include "TextureArray.h"
 #include "Uniform.h"
 
 namespace webgpu
@@ -46,6 +47,28 @@ namespace webgpu
         m_bindGroupEntries.push_back(texture.getBindGroupEntry(index));
     }
 
+    void BindGroup::addTextureArray(const TextureArray& textureArray)
+    {
+        if (m_bindGroup)
+        {
+            spdlog::error("BindGroup already created");
+        }
+
+        int index = static_cast<int>(m_bindGroupEntries.size());
+        m_bindGroupEntries.push_back(textureArray.getBindGroupEntry(index));
+    }
+
+    void BindGroup::addEntry(WGPUBindGroupEntry entry)
+    {
+        if (m_bindGroup)
+        {
+            spdlog::error("BindGroup already created");
+        }
+
+        entry.binding = static_cast<int>(m_bindGroupEntries.size());
+        m_bindGroupEntries.push_back(entry);
+    }
+
     void BindGroup::create(std::string_view label, const BindGroupLayout& bindGroupLayout)
     {
         if (m_bindGroup)
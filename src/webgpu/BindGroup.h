@@ -8,6 +8,7 @@
 namespace webgpu
 {
     class Texture;
+    class TextureArray;
     class Sampler;
     class BaseUniform;
 
@@ -19,6 +20,8 @@ namespace webgpu
         void addUniform(const BaseUniform& uniform, int offset);
         void addSampler(const Sampler& sampler);
         void addTexture(const Texture& texture);
+        void addTextureArray(const TextureArray& textureArray);
+        void addEntry(WGPUBindGroupEntry entry); // binding is assigned
         void create(std::string_view label, const BindGroupLayout& bindGroupLayout);
 
         [[nodiscard]] WGPUBindGroup getBindGroup() const;
@@ -1,13 +1,93 @@
 #include "BindGroupLayout.h"
 
+#include <algorithm>
+#include <map>
+#include <type_traits>
 #include <spdlog/spdlog.h>
 
 #include "Sampler.h"
+#include "ShaderReflection.h"
 #include "StringView.h"
 #include "Texture.h"
+#include "TextureArray.h"
 
 namespace webgpu
 {
+    namespace
+    {
+        WGPUShaderStage getVisibility(uint32_t visibility)
+        {
+            WGPUShaderStage stages = WGPUShaderStage_None;
+            stages |= ((visibility & ReflectedBinding::VERTEX) != 0) ? WGPUShaderStage_Vertex : WGPUShaderStage_None;
+            stages |= ((visibility & ReflectedBinding::FRAGMENT) != 0) ? WGPUShaderStage_Fragment : WGPUShaderStage_None;
+            stages |= ((visibility & ReflectedBinding::COMPUTE) != 0) ? WGPUShaderStage_Compute : WGPUShaderStage_None;
+            return stages;
+        }
+
+        WGPUTextureViewDimension getViewDimension(TextureDimension dimension)
+        {
+            switch (dimension)
+            {
+                case TextureDimension::D1:
+                    return WGPUTextureViewDimension_1D;
+                case TextureDimension::D2_ARRAY:
+                    return WGPUTextureViewDimension_2DArray;
+                case TextureDimension::CUBE:
+                    return WGPUTextureViewDimension_Cube;
+                case TextureDimension::CUBE_ARRAY:
+                    return WGPUTextureViewDimension_CubeArray;
+                case TextureDimension::D3:
+                    return WGPUTextureViewDimension_3D;
+                default:
+                    return WGPUTextureViewDimension_2D;
+            }
+        }
+
+        WGPUTextureSampleType getSampleType(const ReflectedBinding& binding)
+        {
+            switch (binding.sampleType)
+            {
+                case TextureSampleType::SINT:
+                    return WGPUTextureSampleType_Sint;
+                case TextureSampleType::UINT:
+                    return WGPUTextureSampleType_Uint;
+                case TextureSampleType::DEPTH:
+                    return WGPUTextureSampleType_Depth;
+                default:
+                    // Multisampled textures can't be filtered
+                    return binding.isMultisampled ? WGPUTextureSampleType_UnfilterableFloat : WGPUTextureSampleType_Float;
+            }
+        }
+
+        // The storage texel formats, as spelled in WGSL
+        WGPUTextureFormat getStorageFormat(std::string_view format)
+        {
+            static const std::map<std::string_view, WGPUTextureFormat> formats{
+                {"r32float", WGPUTextureFormat_R32Float},
+                {"r32sint", WGPUTextureFormat_R32Sint},
+                {"r32uint", WGPUTextureFormat_R32Uint},
+                {"rg32float", WGPUTextureFormat_RG32Float},
+                {"rg32sint", WGPUTextureFormat_RG32Sint},
+                {"rg32uint", WGPUTextureFormat_RG32Uint},
+                {"rgba8snorm", WGPUTextureFormat_RGBA8Snorm},
+                {"rgba8sint", WGPUTextureFormat_RGBA8Sint},
+                {"rgba8uint", WGPUTextureFormat_RGBA8Uint},
+                {"rgba8unorm", WGPUTextureFormat_RGBA8Unorm},
+                {"rgba16float", WGPUTextureFormat_RGBA16Float},
+                {"rgba16sint", WGPUTextureFormat_RGBA16Sint},
+                {"rgba16uint", WGPUTextureFormat_RGBA16Uint},
+                {"rgba32float", WGPUTextureFormat_RGBA32Float},
+                {"rgba32sint", WGPUTextureFormat_RGBA32Sint},
+                {"rgba32uint", WGPUTextureFormat_RGBA32Uint},
+                {"bgra8unorm", WGPUTextureFormat_BGRA8Unorm}};
+
+            auto it = formats.find(format);
+            return (it != formats.end()) ? it->second : WGPUTextureFormat_Undefined;
+        }
+    }
+
+    std::unordered_map<uint64_t, std::weak_ptr<WGPUBindGroupLayoutImpl>> BindGroupLayout::m_cachedLayouts;
+
     BindGroupLayout::BindGroupLayout() = default;
 
     void BindGroupLayout::addUniform(const BaseUniform& uniform)
@@ -43,13 +123,90 @@ namespace webgpu
         m_bindGroupLayoutEntries.push_back(Texture::getBindGroupLayoutEntry(index));
     }
 
+    void BindGroupLayout::addTextureArray()
+    {
+        if (m_bindGroupLayout)
+        {
+            spdlog::error("BindGroupLayout already created");
+        }
+
+        int index = static_cast<int>(m_bindGroupLayoutEntries.size());
+        m_bindGroupLayoutEntries.push_back(TextureArray::getBindGroupLayoutEntry(index));
+    }
+
+    void BindGroupLayout::addEntry(WGPUBindGroupLayoutEntry entry)
+    {
+        if (m_bindGroupLayout)
+        {
+            spdlog::error("BindGroupLayout already created");
+        }
+
+        entry.binding = static_cast<int>(m_bindGroupLayoutEntries.size());
+        m_bindGroupLayoutEntries.push_back(entry);
+    }
+
+    void BindGroupLayout::addBindings(const ShaderReflection& reflection, int group, WGPUShaderStage defaultVisibility)
+    {
+        if (m_bindGroupLayout)
+        {
+            spdlog::error("BindGroupLayout already created");
+        }
+
+        for (const auto& binding : reflection.getBindings(group))
+        {
+            WGPUBindGroupLayoutEntry entry{WGPU_BIND_GROUP_LAYOUT_ENTRY_INIT};
+            entry.binding = binding.binding;
+            entry.visibility = (binding.visibility != 0) ? getVisibility(binding.visibility) : defaultVisibility;
+            switch (binding.kind)
+            {
+                case BindingKind::UNIFORM_BUFFER:
+                case BindingKind::STORAGE_BUFFER:
+                case BindingKind::READ_ONLY_STORAGE_BUFFER:
+                    entry.buffer.type = (binding.kind == BindingKind::UNIFORM_BUFFER) ? WGPUBufferBindingType_Uniform :
+                        (binding.kind == BindingKind::STORAGE_BUFFER) ? WGPUBufferBindingType_Storage : WGPUBufferBindingType_ReadOnlyStorage;
+                    entry.buffer.minBindingSize = binding.minBindingSize;
+                    break;
+                case BindingKind::SAMPLER:
+                    entry.sampler.type = WGPUSamplerBindingType_Filtering;
+                    break;
+                case BindingKind::COMPARISON_SAMPLER:
+                    entry.sampler.type = WGPUSamplerBindingType_Comparison;
+                    break;
+                case BindingKind::TEXTURE:
+                    entry.texture.sampleType = getSampleType(binding);
+                    entry.texture.viewDimension = getViewDimension(binding.textureDimension);
+                    entry.texture.multisampled = binding.isMultisampled;
+                    break;
+                case BindingKind::STORAGE_TEXTURE:
+                    entry.storageTexture.access = (binding.storageAccess == "write") ? WGPUStorageTextureAccess_WriteOnly :
+                        (binding.storageAccess == "read") ? WGPUStorageTextureAccess_ReadOnly : WGPUStorageTextureAccess_ReadWrite;
+                    entry.storageTexture.format = getStorageFormat(binding.storageFormat);
+                    entry.storageTexture.viewDimension = getViewDimension(binding.textureDimension);
+                    if (entry.storageTexture.format == WGPUTextureFormat_Undefined)
+                    {
+                        spdlog::error("Unsupported storage texture format {} for {}", binding.storageFormat, binding.name);
+                    }
+                    break;
+            }
+            m_bindGroupLayoutEntries.push_back(entry);
+        }
+    }
+
     void BindGroupLayout::create(std::string_view label)
     {
         if (m_bindGroupLayout)
         {
             spdlog::error("BindGroupLayout already created");
+            return;
         }
-        else
+
+        const uint64_t entriesHash = hashEntries();
+        if (auto it = m_cachedLayouts.find(entriesHash); it != m_cachedLayouts.end())
+        {
+            m_bindGroupLayout = it->second.lock();
+        }
+
+        if (!m_bindGroupLayout)
         {
             auto& device = Application::getDevice();
 
@@ -59,6 +216,7 @@ namespace webgpu
             bindGroupLayoutDescriptor.label = StringView(label);
             WGPUBindGroupLayout bindGroupLayout = wgpuDeviceCreateBindGroupLayout(device.get(), &bindGroupLayoutDescriptor);
             m_bindGroupLayout = std::shared_ptr<WGPUBindGroupLayoutImpl>(bindGroupLayout, [](WGPUBindGroupLayout b) { wgpuBindGroupLayoutRelease(b); });
+            m_cachedLayouts[entriesHash] = m_bindGroupLayout;
         }
     }
 
@@ -70,4 +228,37 @@ namespace webgpu
         }
         return m_bindGroupLayout.get();
     }
+
+    int BindGroupLayout::getCachedCount()
+    {
+        return static_cast<int>(std::ranges::count_if(m_cachedLayouts, [](const auto& cached) { return !cached.second.expired(); }));
+    }
+
+    uint64_t BindGroupLayout::hashEntries() const
+    {
+        // Field by field, since the entry structs have padding
+        std::vector<char> bytes;
+        auto write = [&bytes](const auto& value) {
+            static_assert(std::is_trivially_copyable_v<std::decay_t<decltype(value)>>);
+            const auto* valueBytes = reinterpret_cast<const char*>(&value);
+            bytes.insert(bytes.end(), valueBytes, valueBytes + sizeof(value));
+        };
+
+        for (const auto& entry : m_bindGroupLayoutEntries)
+        {
+            write(entry.binding);
+            write(entry.visibility);
+            write(entry.buffer.type);
+            write(entry.buffer.hasDynamicOffset);
+            write(entry.buffer.minBindingSize);
+            write(entry.sampler.type);
+            write(entry.texture.sampleType);
+            write(entry.texture.viewDimension);
+            write(entry.texture.multisampled);
+            write(entry.storageTexture.access);
+            write(entry.storageTexture.format);
+            write(entry.storageTexture.viewDimension);
+        }
+        return Util::hashBytes(bytes.data(), bytes.size());
+    }
 }
@@ -1,8 +1,14 @@
 #pragma once
+#include <unordered_map>
+
 #include "Uniform.h"
 
 namespace webgpu
 {
+    class ShaderReflection;
+
+    // Layouts are shared by content: creating one with the same entries as a live layout reuses it, so that
+    // pipelines reflecting the same groups end up with identical layout objects
     class BindGroupLayout
     {
     public:
@@ -11,12 +17,21 @@ namespace webgpu
         void addUniform(const BaseUniform& uniform);
         void addSampler(bool isFiltering);
         void addTexture();
+        void addTextureArray();
+        void addEntry(WGPUBindGroupLayoutEntry entry); // binding is assigned
+        // Bindings as declared in the shader. defaultVisibility is for bindings no entry point reaches, as in a library.
+        void addBindings(const ShaderReflection& reflection, int group, WGPUShaderStage defaultVisibility = WGPUShaderStage_None);
         void create(std::string_view label);
 
         [[nodiscard]] WGPUBindGroupLayout getBindGroupLayout() const;
+        [[nodiscard]] static int getCachedCount();
 
     private:
         std::vector<WGPUBindGroupLayoutEntry> m_bindGroupLayoutEntries;
         std::shared_ptr<WGPUBindGroupLayoutImpl> m_bindGroupLayout;
+
+        static std::unordered_map<uint64_t, std::weak_ptr<WGPUBindGroupLayoutImpl>> m_cachedLayouts; // by entries hash
+
+        [[nodiscard]] uint64_t hashEntries() const;
     };
 }
@@ -0,0 +1,445 @@
+#include "BlockDecoder.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+
+#include "TextureFormat.h"
+
+namespace webgpu
+{
+    namespace
+    {
+        void expand565(uint16_t color, unsigned char* rgb)
+        {
+            const int r = (color >> 11) & 0x1f;
+            const int g = (color >> 5) & 0x3f;
+            const int b = color & 0x1f;
+            rgb[0] = static_cast<unsigned char>((r << 3) | (r >> 2));
+            rgb[1] = static_cast<unsigned char>((g << 2) | (g >> 4));
+            rgb[2] = static_cast<unsigned char>((b << 3) | (b >> 2));
+        }
+
+        // BC7 mode layout: subsets, partition bits, rotation bits, index selection bits, color bits, alpha bits,
+        // endpoint p-bits, shared p-bits, index bits, secondary index bits
+        struct Bc7Mode
+        {
+            int subsetCount;
+            int partitionBits;
+            int rotationBits;
+            int indexSelectionBits;
+            int colorBits;
+            int alphaBits;
+            bool hasEndpointPBits;
+            bool hasSharedPBits;
+            int indexBits;
+            int secondaryIndexBits;
+        };
+
+        constexpr Bc7Mode BC7_MODES[8] = {
+            {3, 4, 0, 0, 4, 0, true, false, 3, 0},
+            {2, 6, 0, 0, 6, 0, false, true, 3, 0},
+            {3, 6, 0, 0, 5, 0, false, false, 2, 0},
+            {2, 6, 0, 0, 7, 0, true, false, 2, 0},
+            {1, 0, 2, 1, 5, 6, false, false, 2, 3},
+            {1, 0, 2, 0, 7, 8, false, false, 2, 2},
+            {1, 0, 0, 0, 7, 7, true, false, 4, 0},
+            {2, 6, 0, 0, 5, 5, true, false, 2, 0},
+        };
+
+        constexpr unsigned char BC7_PARTITIONS_2[64][16] = {
+            {0,0,1,1,0,0,1,1,0,0,1,1,0,0,1,1}, {0,0,0,1,0,0,0,1,0,0,0,1,0,0,0,1}, {0,1,1,1,0,1,1,1,0,1,1,1,0,1,1,1}, {0,0,0,1,0,0,1,1,0,0,1,1,0,1,1,1},
+            {0,0,0,0,0,0,0,1,0,0,0,1,0,0,1,1}, {0,0,1,1,0,1,1,1,0,1,1,1,1,1,1,1}, {0,0,0,1,0,0,1,1,0,1,1,1,1,1,1,1}, {0,0,0,0,0,0,0,1,0,0,1,1,0,1,1,1},
+            {0,0,0,0,0,0,0,0,0,0,0,1,0,0,1,1}, {0,0,1,1,0,1,1,1,1,1,1,1,1,1,1,1}, {0,0,0,0,0,0,0,1,0,1,1,1,1,1,1,1}, {0,0,0,0,0,0,0,0,0,0,0,1,0,1,1,1},
+            {0,0,0,1,0,1,1,1,1,1,1,1,1,1,1,1}, {0,0,0,0,0,0,0,0,1,1,1,1,1,1,1,1}, {0,0,0,0,1,1,1,1,1,1,1,1,1,1,1,1}, {0,0,0,0,0,0,0,0,0,0,0,0,1,1,1,1},
+            {0,0,0,0,1,0,0,0,1,1,1,0,1,1,1,1}, {0,1,1,1,0,0,0,1,0,0,0,0,0,0,0,0}, {0,0,0,0,0,0,0,0,1,0,0,0,1,1,1,0}, {0,1,1,1,0,0,1,1,0,0,0,1,0,0,0,0},
+            {0,0,1,1,0,0,0,1,0,0,0,0,0,0,0,0}, {0,0,0,0,1,0,0,0,1,1,0,0,1,1,1,0}, {0,0,0,0,0,0,0,0,1,0,0,0,1,1,0,0}, {0,1,1,1,0,0,1,1,0,0,1,1,0,0,0,1},
+            {0,0,1,1,0,0,0,1,0,0,0,1,0,0,0,0}, {0,0,0,0,1,0,0,0,1,0,0,0,1,1,0,0}, {0,1,1,0,0,1,1,0,0,1,1,0,0,1,1,0}, {0,0,1,1,0,1,1,0,0,1,1,0,1,1,0,0},
+            {0,0,0,1,0,1,1,1,1,1,1,0,1,0,0,0}, {0,0,0,0,1,1,1,1,1,1,1,1,0,0,0,0}, {0,1,1,1,0,0,0,1,1,0,0,0,1,1,1,0}, {0,0,1,1,1,0,0,1,1,0,0,1,1,1,0,0},
+            {0,1,0,1,0,1,0,1,0,1,0,1,0,1,0,1}, {0,0,0,0,1,1,1,1,0,0,0,0,1,1,1,1}, {0,1,0,1,1,0,1,0,0,1,0,1,1,0,1,0}, {0,0,1,1,0,0,1,1,1,1,0,0,1,1,0,0},
+            {0,0,1,1,1,1,0,0,0,0,1,1,1,1,0,0}, {0,1,0,1,0,1,0,1,1,0,1,0,1,0,1,0}, {0,1,1,0,1,0,0,1,0,1,1,0,1,0,0,1}, {0,1,0,1,1,0,1,0,1,0,1,0,0,1,0,1},
+            {0,1,1,1,0,0,1,1,1,1,0,0,1,1,1,0}, {0,0,0,1,0,0,1,1,1,1,0,0,1,0,0,0}, {0,0,1,1,0,0,1,0,0,1,0,0,1,1,0,0}, {0,0,1,1,1,0,1,1,1,1,0,1,1,1,0,0},
+            {0,1,1,0,1,0,0,1,1,0,0,1,0,1,1,0}, {0,0,1,1,1,1,0,0,1,1,0,0,0,0,1,1}, {0,1,1,0,0,1,1,0,1,0,0,1,1,0,0,1}, {0,0,0,0,0,1,1,0,0,1,1,0,0,0,0,0},
+            {0,1,0,0,1,1,1,0,0,1,0,0,0,0,0,0}, {0,0,1,0,0,1,1,1,0,0,1,0,0,0,0,0}, {0,0,0,0,0,0,1,0,0,1,1,1,0,0,1,0}, {0,0,0,0,0,1,0,0,1,1,1,0,0,1,0,0},
+            {0,1,1,0,1,1,0,0,1,0,0,1,0,0,1,1}, {0,0,1,1,0,1,1,0,1,1,0,0,1,0,0,1}, {0,1,1,0,0,0,1,1,1,0,0,1,1,1,0,0}, {0,0,1,1,1,0,0,1,1,1,0,0,0,1,1,0},
+            {0,1,1,0,1,1,0,0,1,1,0,0,1,0,0,1}, {0,1,1,0,0,0,1,1,0,0,1,1,1,0,0,1}, {0,1,1,1,1,1,1,0,1,0,0,0,0,0,0,1}, {0,0,0,1,1,0,0,0,1,1,1,0,0,1,1,1},
+            {0,0,0,0,1,1,1,1,0,0,1,1,0,0,1,1}, {0,0,1,1,0,0,1,1,1,1,1,1,0,0,0,0}, {0,0,1,0,0,0,1,0,1,1,1,0,1,1,1,0}, {0,1,0,0,0,1,0,0,0,1,1,1,0,1,1,1},
+        };
+
+        constexpr unsigned char BC7_PARTITIONS_3[64][16] = {
+            {0,0,1,1,0,0,1,1,0,2,2,1,2,2,2,2}, {0,0,0,1,0,0,1,1,2,2,1,1,2,2,2,1}, {0,0,0,0,2,0,0,1,2,2,1,1,2,2,1,1}, {0,2,2,2,0,0,2,2,0,0,1,1,0,1,1,1},
+            {0,0,0,0,0,0,0,0,1,1,2,2,1,1,2,2}, {0,0,1,1,0,0,1,1,0,0,2,2,0,0,2,2}, {0,0,2,2,0,0,2,2,1,1,1,1,1,1,1,1}, {0,0,1,1,0,0,1,1,2,2,1,1,2,2,1,1},
+            {0,0,0,0,0,0,0,0,1,1,1,1,2,2,2,2}, {0,0,0,0,1,1,1,1,1,1,1,1,2,2,2,2}, {0,0,0,0,1,1,1,1,2,2,2,2,2,2,2,2}, {0,0,1,2,0,0,1,2,0,0,1,2,0,0,1,2},
+            {0,1,1,2,0,1,1,2,0,1,1,2,0,1,1,2}, {0,1,2,2,0,1,2,2,0,1,2,2,0,1,2,2}, {0,0,1,1,0,1,1,2,1,1,2,2,1,2,2,2}, {0,0,1,1,2,0,0,1,2,2,0,0,2,2,2,0},
+            {0,0,0,1,0,0,1,1,0,1,1,2,1,1,2,2}, {0,1,1,1,0,0,1,1,2,0,0,1,2,2,0,0}, {0,0,0,0,1,1,2,2,1,1,2,2,1,1,2,2}, {0,0,2,2,0,0,2,2,0,0,2,2,1,1,1,1},
+            {0,1,1,1,0,1,1,1,0,2,2,2,0,2,2,2}, {0,0,0,1,0,0,0,1,2,2,2,1,2,2,2,1}, {0,0,0,0,0,0,1,1,0,1,2,2,0,1,2,2}, {0,0,0,0,1,1,0,0,2,2,1,0,2,2,1,0},
+            {0,1,2,2,0,1,2,2,0,0,1,1,0,0,0,0}, {0,0,1,2,0,0,1,2,1,1,2,2,2,2,2,2}, {0,1,1,0,1,2,2,1,1,2,2,1,0,1,1,0}, {0,0,0,0,0,1,1,0,1,2,2,1,1,2,2,1},
+            {0,0,2,2,1,1,0,2,1,1,0,2,0,0,2,2}, {0,1,1,0,0,1,1,0,2,0,0,2,2,2,2,2}, {0,0,1,1,0,1,2,2,0,1,2,2,0,0,1,1}, {0,0,0,0,2,0,0,0,2,2,1,1,2,2,2,1},
+            {0,0,0,0,0,0,0,2,1,1,2,2,1,2,2,2}, {0,2,2,2,0,0,2,2,0,0,1,2,0,0,1,1}, {0,0,1,1,0,0,1,2,0,0,2,2,0,2,2,2}, {0,1,2,0,0,1,2,0,0,1,2,0,0,1,2,0},
+            {0,0,0,0,1,1,1,1,2,2,2,2,0,0,0,0}, {0,1,2,0,1,2,0,1,2,0,1,2,0,1,2,0}, {0,1,2,0,2,0,1,2,1,2,0,1,0,1,2,0}, {0,0,1,1,2,2,0,0,1,1,2,2,0,0,1,1},
+            {0,0,1,1,1,1,2,2,2,2,0,0,0,0,1,1}, {0,1,0,1,0,1,0,1,2,2,2,2,2,2,2,2}, {0,0,0,0,0,0,0,0,2,1,2,1,2,1,2,1}, {0,0,2,2,1,1,2,2,0,0,2,2,1,1,2,2},
+            {0,0,2,2,0,0,1,1,0,0,2,2,0,0,1,1}, {0,2,2,0,1,2,2,1,0,2,2,0,1,2,2,1}, {0,1,0,1,2,2,2,2,2,2,2,2,0,1,0,1}, {0,0,0,0,2,1,2,1,2,1,2,1,2,1,2,1},
+            {0,1,0,1,0,1,0,1,0,1,0,1,2,2,2,2}, {0,2,2,2,0,1,1,1,0,2,2,2,0,1,1,1}, {0,0,0,2,1,1,1,2,0,0,0,2,1,1,1,2}, {0,0,0,0,2,1,1,2,2,1,1,2,2,1,1,2},
+            {0,2,2,2,0,1,1,1,0,1,1,1,0,2,2,2}, {0,0,0,2,1,1,1,2,1,1,1,2,0,0,0,2}, {0,1,1,0,0,1,1,0,0,1,1,0,2,2,2,2}, {0,0,0,0,0,0,0,0,2,1,1,2,2,1,1,2},
+            {0,1,1,0,0,1,1,0,2,2,2,2,2,2,2,2}, {0,0,2,2,0,0,1,1,0,0,1,1,0,0,2,2}, {0,0,2,2,1,1,2,2,1,1,2,2,0,0,2,2}, {0,0,0,0,0,0,0,0,0,0,0,0,2,1,1,2},
+            {0,0,0,2,0,0,0,1,0,0,0,2,0,0,0,1}, {0,2,2,2,1,2,2,2,0,2,2,2,1,2,2,2}, {0,1,0,1,2,2,2,2,2,2,2,2,2,2,2,2}, {0,1,1,1,2,0,1,1,2,2,0,1,2,2,2,0},
+        };
+
+        // Pixel index of the anchor of subset 1 (2 subsets), and subsets 1 and 2 (3 subsets); subset 0 is always 0
+        constexpr unsigned char BC7_ANCHORS_2[64] = {
+            15,15,15,15,15,15,15,15, 15,15,15,15,15,15,15,15, 15, 2, 8, 2, 2, 8, 8,15,  2, 8, 2, 2, 8, 8, 2, 2,
+            15,15, 6, 8, 2, 8,15,15,  2, 8, 2, 2, 2,15,15, 6,  6, 2, 6, 8,15,15, 2, 2, 15,15,15,15,15, 2, 2,15,
+        };
+        constexpr unsigned char BC7_ANCHORS_3_SUBSET_1[64] = {
+             3, 3,15,15, 8, 3,15,15,  8, 8, 6, 6, 6, 5, 3, 3,  3, 3, 8,15, 3, 3, 6,10,  5, 8, 8, 6, 8, 5,15,15,
+             8,15, 3, 5, 6,10, 8,15, 15, 3,15, 5,15,15,15,15,  3,15, 5, 5, 5, 8, 5,10,  5,10, 8,13,15,12, 3, 3,
+        };
+        constexpr unsigned char BC7_ANCHORS_3_SUBSET_2[64] = {
+            15, 8, 8, 3,15,15, 3, 8, 15,15,15,15,15,15,15, 8, 15, 8,15, 3,15, 8,15, 8,  3,15, 6,10,15,15,10, 8,
+            15, 3,15,10,10, 8, 9,10,  6,15, 8,15, 3, 6, 6, 8, 15, 3,15,15,15,15,15,15, 15,15,15,15, 3,15,15, 8,
+        };
+
+        constexpr int BC7_WEIGHTS_2[4] = {0, 21, 43, 64};
+        constexpr int BC7_WEIGHTS_3[8] = {0, 9, 18, 27, 37, 46, 55, 64};
+        constexpr int BC7_WEIGHTS_4[16] = {0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64};
+
+        class BitReader
+        {
+        public:
+            explicit BitReader(const unsigned char* data) : m_data{data}, m_position{0}
+            {
+            }
+
+            int read(int bitCount)
+            {
+                int value = 0;
+                for (int iBit = 0; iBit < bitCount; iBit++, m_position++)
+                {
+                    value |= ((m_data[m_position >> 3] >> (m_position & 7)) & 1) << iBit;
+                }
+                return value;
+            }
+
+        private:
+            const unsigned char* m_data;
+            int m_position;
+        };
+
+        int bc7Interpolate(int e0, int e1, int index, int indexBits)
+        {
+            const int* weights = (indexBits == 2) ? BC7_WEIGHTS_2 : (indexBits == 3) ? BC7_WEIGHTS_3 : BC7_WEIGHTS_4;
+            return ((64 - weights[index]) * e0 + weights[index] * e1 + 32) >> 6;
+        }
+
+        bool isBc7Anchor(const Bc7Mode& mode, int partition, int pixel)
+        {
+            if (pixel == 0)
+            {
+                return true;
+            }
+            if (mode.subsetCount == 2)
+            {
+                return pixel == BC7_ANCHORS_2[partition];
+            }
+            if (mode.subsetCount == 3)
+            {
+                return (pixel == BC7_ANCHORS_3_SUBSET_1[partition]) || (pixel == BC7_ANCHORS_3_SUBSET_2[partition]);
+            }
+            return false;
+        }
+    }
+
+    bool BlockDecoder::canDecode(WGPUTextureFormat format)
+    {
+        switch (format)
+        {
+            case WGPUTextureFormat_BC1RGBAUnorm:
+            case WGPUTextureFormat_BC1RGBAUnormSrgb:
+            case WGPUTextureFormat_BC3RGBAUnorm:
+            case WGPUTextureFormat_BC3RGBAUnormSrgb:
+            case WGPUTextureFormat_BC4RUnorm:
+            case WGPUTextureFormat_BC5RGUnorm:
+            case WGPUTextureFormat_BC7RGBAUnorm:
+            case WGPUTextureFormat_BC7RGBAUnormSrgb:
+                return true;
+            default:
+                return false;
+        }
+    }
+
+    std::vector<unsigned char> BlockDecoder::decode(WGPUTextureFormat format, const std::vector<unsigned char>& blocks, int width, int height)
+    {
+        const auto formatInfo = TextureFormat::getInfo(format);
+        const int blocksWide = (width + 3) / 4;
+        const int blocksHigh = (height + 3) / 4;
+        std::vector<unsigned char> pixels(static_cast<size_t>(width) * height * 4);
+        if (blocks.size() < static_cast<size_t>(blocksWide) * blocksHigh * formatInfo.bytesPerBlock)
+        {
+            return pixels;
+        }
+
+        unsigned char blockPixels[16 * 4];
+        for (int blockY = 0; blockY < blocksHigh; blockY++)
+        {
+            for (int blockX = 0; blockX < blocksWide; blockX++)
+            {
+                const unsigned char* block = blocks.data() + (static_cast<size_t>(blockY) * blocksWide + blockX) * formatInfo.bytesPerBlock;
+                switch (format)
+                {
+                    case WGPUTextureFormat_BC1RGBAUnorm:
+                    case WGPUTextureFormat_BC1RGBAUnormSrgb:
+                        decodeBC1(block, blockPixels);
+                        break;
+                    case WGPUTextureFormat_BC3RGBAUnorm:
+                    case WGPUTextureFormat_BC3RGBAUnormSrgb:
+                        decodeBC3(block, blockPixels);
+                        break;
+                    case WGPUTextureFormat_BC4RUnorm:
+                        std::memset(blockPixels, 0, sizeof(blockPixels));
+                        decodeBC4(block, blockPixels, 0);
+                        for (int iPixel = 0; iPixel < 16; iPixel++)
+                        {
+                            blockPixels[iPixel * 4 + 3] = 255;
+                        }
+                        break;
+                    case WGPUTextureFormat_BC5RGUnorm:
+                        decodeBC5(block, blockPixels);
+                        break;
+                    default:
+                        decodeBC7(block, blockPixels);
+                        break;
+                }
+
+                // Blocks on the right and bottom edges can hang over the image
+                for (int y = 0; (y < 4) && (blockY * 4 + y < height); y++)
+                {
+                    const int rowWidth = std::min(4, width - blockX * 4);
+                    std::memcpy(pixels.data() + ((static_cast<size_t>(blockY) * 4 + y) * width + blockX * 4) * 4, blockPixels + y * 16, rowWidth * 4);
+                }
+            }
+        }
+
+        return pixels;
+    }
+
+    void BlockDecoder::decodeBC1(const unsigned char* block, unsigned char* pixels, bool isColorOnly)
+    {
+        const uint16_t color0 = block[0] | (block[1] << 8);
+        const uint16_t color1 = block[2] | (block[3] << 8);
+
+        unsigned char palette[4][4];
+        expand565(color0, palette[0]);
+        expand565(color1, palette[1]);
+        palette[0][3] = palette[1][3] = palette[2][3] = palette[3][3] = 255;
+
+        // BC2/BC3 color blocks always use the four color mode
+        if ((color0 > color1) || isColorOnly)
+        {
+            for (int iChannel = 0; iChannel < 3; iChannel++)
+            {
+                palette[2][iChannel] = static_cast<unsigned char>((2 * palette[0][iChannel] + palette[1][iChannel] + 1) / 3);
+                palette[3][iChannel] = static_cast<unsigned char>((palette[0][iChannel] + 2 * palette[1][iChannel] + 1) / 3);
+            }
+        }
+        else
+        {
+            for (int iChannel = 0; iChannel < 3; iChannel++)
+            {
+                palette[2][iChannel] = static_cast<unsigned char>((palette[0][iChannel] + palette[1][iChannel] + 1) / 2);
+                palette[3][iChannel] = 0;
+            }
+            palette[3][3] = 0;
+        }
+
+        const uint32_t indices = block[4] | (block[5] << 8) | (block[6] << 16) | (static_cast<uint32_t>(block[7]) << 24);
+        for (int iPixel = 0; iPixel < 16; iPixel++)
+        {
+            std::memcpy(pixels + iPixel * 4, palette[(indices >> (iPixel * 2)) & 3], 4);
+        }
+    }
+
+    void BlockDecoder::decodeBC3(const unsigned char* block, unsigned char* pixels)
+    {
+        decodeBC1(block + 8, pixels, true);
+        decodeBC4(block, pixels, 3);
+    }
+
+    void BlockDecoder::decodeBC4(const unsigned char* block, unsigned char* pixels, int channel)
+    {
+        const int value0 = block[0];
+        const int value1 = block[1];
+
+        int palette[8];
+        palette[0] = value0;
+        palette[1] = value1;
+        if (value0 > value1)
+        {
+            for (int i = 1; i < 7; i++)
+            {
+                palette[i + 1] = ((7 - i) * value0 + i * value1 + 3) / 7;
+            }
+        }
+        else
+        {
+            for (int i = 1; i < 5; i++)
+            {
+                palette[i + 1] = ((5 - i) * value0 + i * value1 + 2) / 5;
+            }
+            palette[6] = 0;
+            palette[7] = 255;
+        }
+
+        uint64_t indices = 0;
+        for (int iByte = 0; iByte < 6; iByte++)
+        {
+            indices |= static_cast<uint64_t>(block[2 + iByte]) << (iByte * 8);
+        }
+        for (int iPixel = 0; iPixel < 16; iPixel++)
+        {
+            pixels[iPixel * 4 + channel] = static_cast<unsigned char>(palette[(indices >> (iPixel * 3)) & 7]);
+        }
+    }
+
+    void BlockDecoder::decodeBC5(const unsigned char* block, unsigned char* pixels)
+    {
+        decodeBC4(block, pixels, 0);
+        decodeBC4(block + 8, pixels, 1);
+        for (int iPixel = 0; iPixel < 16; iPixel++)
+        {
+            pixels[iPixel * 4 + 2] = 0;
+            pixels[iPixel * 4 + 3] = 255;
+        }
+    }
+
+    void BlockDecoder::decodeBC7(const unsigned char* block, unsigned char* pixels)
+    {
+        int modeIndex = 0;
+        while ((modeIndex < 8) && ((block[0] & (1 << modeIndex)) == 0))
+        {
+            modeIndex++;
+        }
+        if (modeIndex == 8)
+        {
+            std::memset(pixels, 0, 16 * 4); // reserved mode
+            return;
+        }
+
+        const Bc7Mode& mode = BC7_MODES[modeIndex];
+        BitReader bits{block};
+        bits.read(modeIndex + 1);
+
+        const int partition = bits.read(mode.partitionBits);
+        const int rotation = bits.read(mode.rotationBits);
+        const int indexSelection = bits.read(mode.indexSelectionBits);
+
+        // endpoints[subset * 2 + endpoint][channel]
+        int endpoints[6][4]{};
+        const int endpointCount = mode.subsetCount * 2;
+        for (int iChannel = 0; iChannel < 3; iChannel++)
+        {
+            for (int iEndpoint = 0; iEndpoint < endpointCount; iEndpoint++)
+            {
+                endpoints[iEndpoint][iChannel] = bits.read(mode.colorBits);
+            }
+        }
+        for (int iEndpoint = 0; iEndpoint < endpointCount; iEndpoint++)
+        {
+            endpoints[iEndpoint][3] = (mode.alphaBits > 0) ? bits.read(mode.alphaBits) : 255;
+        }
+
+        int pBits[6]{};
+        if (mode.hasEndpointPBits)
+        {
+            for (int iEndpoint = 0; iEndpoint < endpointCount; iEndpoint++)
+            {
+                pBits[iEndpoint] = bits.read(1);
+            }
+        }
+        else if (mode.hasSharedPBits)
+        {
+            for (int iSubset = 0; iSubset < mode.subsetCount; iSubset++)
+            {
+                pBits[iSubset * 2] = pBits[iSubset * 2 + 1] = bits.read(1);
+            }
+        }
+
+        const bool hasPBits = mode.hasEndpointPBits || mode.hasSharedPBits;
+        for (int iEndpoint = 0; iEndpoint < endpointCount; iEndpoint++)
+        {
+            for (int iChannel = 0; iChannel < 4; iChannel++)
+            {
+                int channelBits = (iChannel < 3) ? mode.colorBits : mode.alphaBits;
+                if (channelBits == 0)
+                {
+                    continue; // alpha is already 255
+                }
+
+                int value = endpoints[iEndpoint][iChannel];
+                if (hasPBits)
+                {
+                    value = (value << 1) | pBits[iEndpoint];
+                    channelBits++;
+                }
+                value <<= (8 - channelBits);
+                endpoints[iEndpoint][iChannel] = value | (value >> channelBits);
+            }
+        }
+
+        int indices[16];
+        for (int iPixel = 0; iPixel < 16; iPixel++)
+        {
+            indices[iPixel] = bits.read(isBc7Anchor(mode, partition, iPixel) ? mode.indexBits - 1 : mode.indexBits);
+        }
+        int secondaryIndices[16]{};
+        if (mode.secondaryIndexBits > 0)
+        {
+            for (int iPixel = 0; iPixel < 16; iPixel++)
+            {
+                secondaryIndices[iPixel] = bits.read((iPixel == 0) ? mode.secondaryIndexBits - 1 : mode.secondaryIndexBits);
+            }
+        }
+
+        for (int iPixel = 0; iPixel < 16; iPixel++)
+        {
+            const int subset = (mode.subsetCount == 2) ? BC7_PARTITIONS_2[partition][iPixel] :
+                (mode.subsetCount == 3) ? BC7_PARTITIONS_3[partition][iPixel] : 0;
+            const int* e0 = endpoints[subset * 2];
+            const int* e1 = endpoints[subset * 2 + 1];
+
+            int colorIndex = indices[iPixel];
+            int colorIndexBits = mode.indexBits;
+            int alphaIndex = indices[iPixel];
+            int alphaIndexBits = mode.indexBits;
+            if (mode.secondaryIndexBits > 0)
+            {
+                if (indexSelection == 0)
+                {
+                    alphaIndex = secondaryIndices[iPixel];
+                    alphaIndexBits = mode.secondaryIndexBits;
+                }
+                else
+                {
+                    colorIndex = secondaryIndices[iPixel];
+                    colorIndexBits = mode.secondaryIndexBits;
+                }
+            }
+
+            int rgba[4];
+            for (int iChannel = 0; iChannel < 3; iChannel++)
+            {
+                rgba[iChannel] = bc7Interpolate(e0[iChannel], e1[iChannel], colorIndex, colorIndexBits);
+            }
+            rgba[3] = bc7Interpolate(e0[3], e1[3], alphaIndex, alphaIndexBits);
+
+            if (rotation > 0)
+            {
+                std::swap(rgba[3], rgba[rotation - 1]);
+            }
+
+            for (int iChannel = 0; iChannel < 4; iChannel++)
+            {
+                pixels[iPixel * 4 + iChannel] = static_cast<unsigned char>(rgba[iChannel]);
+            }
+        }
+    }
+}
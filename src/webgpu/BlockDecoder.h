@@ -0,0 +1,22 @@
+#pragma once
+#include <vector>
+#include <webgpu/webgpu.h>
+
+namespace webgpu
+{
+    // CPU fallback for block-compressed textures when the adapter lacks the matching feature. Decodes to RGBA8;
+    // BC4 and BC5 fill the missing channels with 0 and alpha with 255, as the GPU would sample them.
+    class BlockDecoder
+    {
+    public:
+        static bool canDecode(WGPUTextureFormat format);
+        static std::vector<unsigned char> decode(WGPUTextureFormat format, const std::vector<unsigned char>& blocks, int width, int height);
+
+        // Single 4x4 blocks, written as 16 RGBA8 pixels in row order
+        static void decodeBC1(const unsigned char* block, unsigned char* pixels, bool isColorOnly = false);
+        static void decodeBC3(const unsigned char* block, unsigned char* pixels);
+        static void decodeBC4(const unsigned char* block, unsigned char* pixels, int channel);
+        static void decodeBC5(const unsigned char* block, unsigned char* pixels);
+        static void decodeBC7(const unsigned char* block, unsigned char* pixels);
+    };
+}
@@ -0,0 +1,362 @@
+#include "BlockEncoder.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <utility>
+
+#include "TextureFormat.h"
+
+namespace webgpu
+{
+    namespace
+    {
+        constexpr int BC7_WEIGHTS_4[16] = {0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64};
+
+        class BitWriter
+        {
+        public:
+            explicit BitWriter(unsigned char* data) : m_data{data}, m_position{0}
+            {
+                std::memset(m_data, 0, 16);
+            }
+
+            void write(int value, int bitCount)
+            {
+                for (int iBit = 0; iBit < bitCount; iBit++, m_position++)
+                {
+                    m_data[m_position >> 3] |= ((value >> iBit) & 1) << (m_position & 7);
+                }
+            }
+
+        private:
+            unsigned char* m_data;
+            int m_position;
+        };
+
+        // Quantized mode 6 block: 8-bit endpoints, whose lowest bit is the p-bit
+        struct Bc7Mode6Block
+        {
+            int endpoints[2][4];
+            int indices[16];
+            float error;
+        };
+
+        void quantizeEndpoint(const float* endpoint, int* quantized)
+        {
+            float bestError = std::numeric_limits<float>::max();
+            for (int pBit = 0; pBit < 2; pBit++)
+            {
+                int candidate[4];
+                float error = 0;
+                for (int c = 0; c < 4; c++)
+                {
+                    const int value = std::clamp(static_cast<int>(std::lround((endpoint[c] - pBit) / 2.0f)), 0, 127);
+                    candidate[c] = (value << 1) | pBit;
+                    error += (candidate[c] - endpoint[c]) * (candidate[c] - endpoint[c]);
+                }
+                if (error < bestError)
+                {
+                    bestError = error;
+                    std::copy_n(candidate, 4, quantized);
+                }
+            }
+        }
+
+        Bc7Mode6Block fitIndices(const unsigned char* pixels, const float (&endpoints)[2][4])
+        {
+            Bc7Mode6Block block{};
+            quantizeEndpoint(endpoints[0], block.endpoints[0]);
+            quantizeEndpoint(endpoints[1], block.endpoints[1]);
+
+            int palette[16][4];
+            for (int i = 0; i < 16; i++)
+            {
+                for (int c = 0; c < 4; c++)
+                {
+                    palette[i][c] = ((64 - BC7_WEIGHTS_4[i]) * block.endpoints[0][c] + BC7_WEIGHTS_4[i] * block.endpoints[1][c] + 32) >> 6;
+                }
+            }
+
+            for (int iPixel = 0; iPixel < 16; iPixel++)
+            {
+                int bestError = std::numeric_limits<int>::max();
+                for (int i = 0; i < 16; i++)
+                {
+                    int error = 0;
+                    for (int c = 0; c < 4; c++)
+                    {
+                        const int diff = palette[i][c] - pixels[iPixel * 4 + c];
+                        error += diff * diff;
+                    }
+                    if (error < bestError)
+                    {
+                        bestError = error;
+                        block.indices[iPixel] = i;
+                    }
+                }
+                block.error += static_cast<float>(bestError);
+            }
+            return block;
+        }
+
+        // Endpoints at the extremes of the pixels' projection on their principal axis
+        void fitPrincipalAxis(const unsigned char* pixels, float (&endpoints)[2][4])
+        {
+            float mean[4]{};
+            float axis[4]{};
+            for (int c = 0; c < 4; c++)
+            {
+                int minValue = 255;
+                int maxValue = 0;
+                for (int iPixel = 0; iPixel < 16; iPixel++)
+                {
+                    mean[c] += pixels[iPixel * 4 + c] / 16.0f;
+                    minValue = std::min<int>(minValue, pixels[iPixel * 4 + c]);
+                    maxValue = std::max<int>(maxValue, pixels[iPixel * 4 + c]);
+                }
+                axis[c] = static_cast<float>(maxValue - minValue);
+            }
+
+            float covariance[4][4]{};
+            for (int iPixel = 0; iPixel < 16; iPixel++)
+            {
+                for (int i = 0; i < 4; i++)
+                {
+                    for (int j = 0; j < 4; j++)
+                    {
+                        covariance[i][j] += (pixels[iPixel * 4 + i] - mean[i]) * (pixels[iPixel * 4 + j] - mean[j]);
+                    }
+                }
+            }
+
+            // Power iteration, starting from the bounding box diagonal
+            for (int iteration = 0; iteration < 8; iteration++)
+            {
+                float next[4]{};
+                float length = 0;
+                for (int i = 0; i < 4; i++)
+                {
+                    for (int j = 0; j < 4; j++)
+                    {
+                        next[i] += covariance[i][j] * axis[j];
+                    }
+                    length += next[i] * next[i];
+                }
+                if (length < 1e-6f)
+                {
+                    break;
+                }
+                length = std::sqrt(length);
+                for (int i = 0; i < 4; i++)
+                {
+                    axis[i] = next[i] / length;
+                }
+            }
+
+            float minProjection = 0;
+            float maxProjection = 0;
+            for (int iPixel = 0; iPixel < 16; iPixel++)
+            {
+                float projection = 0;
+                for (int c = 0; c < 4; c++)
+                {
+                    projection += (pixels[iPixel * 4 + c] - mean[c]) * axis[c];
+                }
+                minProjection = std::min(minProjection, projection);
+                maxProjection = std::max(maxProjection, projection);
+            }
+
+            for (int c = 0; c < 4; c++)
+            {
+                endpoints[0][c] = std::clamp(mean[c] + minProjection * axis[c], 0.0f, 255.0f);
+                endpoints[1][c] = std::clamp(mean[c] + maxProjection * axis[c], 0.0f, 255.0f);
+            }
+        }
+
+        // Least squares endpoints for the chosen indices
+        bool refineEndpoints(const unsigned char* pixels, const Bc7Mode6Block& block, float (&endpoints)[2][4])
+        {
+            float a = 0;
+            float b = 0;
+            float c = 0;
+            float d0[4]{};
+            float d1[4]{};
+            for (int iPixel = 0; iPixel < 16; iPixel++)
+            {
+                const float t = BC7_WEIGHTS_4[block.indices[iPixel]] / 64.0f;
+                a += (1 - t) * (1 - t);
+                b += (1 - t) * t;
+                c += t * t;
+                for (int iChannel = 0; iChannel < 4; iChannel++)
+                {
+                    d0[iChannel] += (1 - t) * pixels[iPixel * 4 + iChannel];
+                    d1[iChannel] += t * pixels[iPixel * 4 + iChannel];
+                }
+            }
+
+            const float determinant = a * c - b * b;
+            if (std::abs(determinant) < 1e-6f)
+            {
+                return false;
+            }
+            for (int iChannel = 0; iChannel < 4; iChannel++)
+            {
+                endpoints[0][iChannel] = std::clamp((c * d0[iChannel] - b * d1[iChannel]) / determinant, 0.0f, 255.0f);
+                endpoints[1][iChannel] = std::clamp((a * d1[iChannel] - b * d0[iChannel]) / determinant, 0.0f, 255.0f);
+            }
+            return true;
+        }
+    }
+
+    bool BlockEncoder::canEncode(WGPUTextureFormat format)
+    {
+        switch (format)
+        {
+            case WGPUTextureFormat_BC4RUnorm:
+            case WGPUTextureFormat_BC5RGUnorm:
+            case WGPUTextureFormat_BC7RGBAUnorm:
+            case WGPUTextureFormat_BC7RGBAUnormSrgb:
+                return true;
+            default:
+                return false;
+        }
+    }
+
+    void BlockEncoder::encode(WGPUTextureFormat format, const std::vector<unsigned char>& pixels, int width, int height, int firstBlockRow, int blockRowCount, std::vector<unsigned char>& blocks)
+    {
+        const auto formatInfo = TextureFormat::getInfo(format);
+        const int blockCountX = (width + 3) / 4;
+        const int lastBlockRow = std::min<int>(firstBlockRow + blockRowCount, formatInfo.rowCount(height));
+
+        unsigned char blockPixels[16 * 4];
+        for (int blockY = firstBlockRow; blockY < lastBlockRow; blockY++)
+        {
+            for (int blockX = 0; blockX < blockCountX; blockX++)
+            {
+                for (int y = 0; y < 4; y++)
+                {
+                    const int pixelY = std::min(blockY * 4 + y, height - 1);
+                    for (int x = 0; x < 4; x++)
+                    {
+                        const int pixelX = std::min(blockX * 4 + x, width - 1);
+                        std::memcpy(blockPixels + (y * 4 + x) * 4, pixels.data() + (static_cast<size_t>(pixelY) * width + pixelX) * 4, 4);
+                    }
+                }
+
+                unsigned char* block = blocks.data() + (static_cast<size_t>(blockY) * blockCountX + blockX) * formatInfo.bytesPerBlock;
+                switch (format)
+                {
+                    case WGPUTextureFormat_BC4RUnorm:
+                        encodeBC4(blockPixels, block, 0);
+                        break;
+                    case WGPUTextureFormat_BC5RGUnorm:
+                        encodeBC5(blockPixels, block);
+                        break;
+                    default:
+                        encodeBC7(blockPixels, block);
+                        break;
+                }
+            }
+        }
+    }
+
+    void BlockEncoder::encodeBC4(const unsigned char* pixels, unsigned char* block, int channel)
+    {
+        int minValue = 255;
+        int maxValue = 0;
+        for (int iPixel = 0; iPixel < 16; iPixel++)
+        {
+            minValue = std::min<int>(minValue, pixels[iPixel * 4 + channel]);
+            maxValue = std::max<int>(maxValue, pixels[iPixel * 4 + channel]);
+        }
+
+        // value0 > value1 selects the 8 value palette
+        block[0] = static_cast<unsigned char>(maxValue);
+        block[1] = static_cast<unsigned char>(minValue);
+        std::memset(block + 2, 0, 6);
+        if (maxValue == minValue)
+        {
+            return;
+        }
+
+        int palette[8];
+        palette[0] = maxValue;
+        palette[1] = minValue;
+        for (int i = 1; i < 7; i++)
+        {
+            palette[i + 1] = ((7 - i) * maxValue + i * minValue + 3) / 7;
+        }
+
+        uint64_t indices = 0;
+        for (int iPixel = 0; iPixel < 16; iPixel++)
+        {
+            const int value = pixels[iPixel * 4 + channel];
+            int bestIndex = 0;
+            for (int i = 1; i < 8; i++)
+            {
+                if (std::abs(palette[i] - value) < std::abs(palette[bestIndex] - value))
+                {
+                    bestIndex = i;
+                }
+            }
+            indices |= static_cast<uint64_t>(bestIndex) << (iPixel * 3);
+        }
+        for (int iByte = 0; iByte < 6; iByte++)
+        {
+            block[2 + iByte] = static_cast<unsigned char>(indices >> (iByte * 8));
+        }
+    }
+
+    void BlockEncoder::encodeBC5(const unsigned char* pixels, unsigned char* block)
+    {
+        encodeBC4(pixels, block, 0);
+        encodeBC4(pixels, block + 8, 1);
+    }
+
+    void BlockEncoder::encodeBC7(const unsigned char* pixels, unsigned char* block)
+    {
+        float endpoints[2][4];
+        fitPrincipalAxis(pixels, endpoints);
+        auto best = fitIndices(pixels, endpoints);
+        for (int iteration = 0; (iteration < 2) && (best.error > 0); iteration++)
+        {
+            if (!refineEndpoints(pixels, best, endpoints))
+            {
+                break;
+            }
+            auto refined = fitIndices(pixels, endpoints);
+            if (refined.error >= best.error)
+            {
+                break;
+            }
+            best = refined;
+        }
+
+        // The first index is stored without its top bit, so it must be < 8
+        if (best.indices[0] & 8)
+        {
+            std::swap(best.endpoints[0], best.endpoints[1]);
+            for (int& index : best.indices)
+            {
+                index = 15 - index;
+            }
+        }
+
+        BitWriter writer{block};
+        writer.write(1 << 6, 7); // mode 6
+        for (int c = 0; c < 4; c++)
+        {
+            writer.write(best.endpoints[0][c] >> 1, 7);
+            writer.write(best.endpoints[1][c] >> 1, 7);
+        }
+        writer.write(best.endpoints[0][0] & 1, 1);
+        writer.write(best.endpoints[1][0] & 1, 1);
+        for (int iPixel = 0; iPixel < 16; iPixel++)
+        {
+            writer.write(best.indices[iPixel], (iPixel == 0) ? 3 : 4);
+        }
+    }
+}
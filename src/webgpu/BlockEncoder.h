@@ -0,0 +1,24 @@
+#pragma once
+#include <vector>
+#include <webgpu/webgpu.h>
+
+namespace webgpu
+{
+    // Block compression for the texture cooker. BC7 uses mode 6 only (one subset, RGBA endpoints), which is fast and
+    // good enough for material textures; BC5 stores the first two channels, for normal maps.
+    class BlockEncoder
+    {
+    public:
+        static bool canEncode(WGPUTextureFormat format);
+
+        // Encodes rows of blocks [firstBlockRow, firstBlockRow + blockRowCount) of RGBA8 pixels into blocks, which
+        // must hold the whole image. Blocks over the right and bottom edges repeat the edge pixels. Separate row
+        // ranges may be encoded in parallel.
+        static void encode(WGPUTextureFormat format, const std::vector<unsigned char>& pixels, int width, int height, int firstBlockRow, int blockRowCount, std::vector<unsigned char>& blocks);
+
+        // Single 4x4 blocks from 16 RGBA8 pixels in row order
+        static void encodeBC4(const unsigned char* pixels, unsigned char* block, int channel);
+        static void encodeBC5(const unsigned char* pixels, unsigned char* block);
+        static void encodeBC7(const unsigned char* pixels, unsigned char* block);
+    };
+}
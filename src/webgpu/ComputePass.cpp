@@ -1,5 +1,64 @@
 #include "ComputePass.h"
 
+#include "Application.h"
+#include "Device.h"
+#include "StringView.h"
+
 namespace webgpu
 {
+    ComputePass::ComputePass(const std::string_view name, const std::string_view shaderSource, const std::string_view entryPoint,
+        const std::vector<WGPUBindGroupLayout>& bindGroupLayouts, const std::vector<WGPUConstantEntry>& constants)
+    : BasePass{name}
+    {
+        auto& device = Application::getDevice();
+
+        WGPUShaderSourceWGSL wgslDesc{WGPU_SHADER_SOURCE_WGSL_INIT};
+        wgslDesc.code = StringView(shaderSource);
+        WGPUShaderModuleDescriptor shaderDesc{WGPU_SHADER_MODULE_DESCRIPTOR_INIT};
+        shaderDesc.nextInChain = &wgslDesc.chain;
+        shaderDesc.label = StringView(name);
+        WGPUShaderModule shaderModule = wgpuDeviceCreateShaderModule(device.get(), &shaderDesc);
+
+        WGPUPipelineLayoutDescriptor pipelineLayoutDescriptor = WGPU_PIPELINE_LAYOUT_DESCRIPTOR_INIT;
+        pipelineLayoutDescriptor.bindGroupLayoutCount = bindGroupLayouts.size();
+        pipelineLayoutDescriptor.bindGroupLayouts = bindGroupLayouts.data();
+        WGPUPipelineLayout pipelineLayout = wgpuDeviceCreatePipelineLayout(device.get(), &pipelineLayoutDescriptor);
+
+        WGPUComputePipelineDescriptor pipelineDesc{WGPU_COMPUTE_PIPELINE_DESCRIPTOR_INIT};
+        pipelineDesc.label = StringView(name);
+        pipelineDesc.layout = pipelineLayout;
+        pipelineDesc.compute.module = shaderModule;
+        pipelineDesc.compute.entryPoint = StringView(entryPoint);
+        pipelineDesc.compute.constantCount = constants.size();
+        pipelineDesc.compute.constants = constants.data();
+
+        WGPUComputePipeline computePipeline = wgpuDeviceCreateComputePipeline(device.get(), &pipelineDesc);
+        m_computePipeline = std::shared_ptr<WGPUComputePipelineImpl>(computePipeline, [](WGPUComputePipeline p) { wgpuComputePipelineRelease(p); });
+
+        wgpuPipelineLayoutRelease(pipelineLayout);
+        wgpuShaderModuleRelease(shaderModule);
+    }
+
+    WGPUComputePipeline ComputePass::get() const
+    {
+        return m_computePipeline.get();
+    }
+
+    void ComputePass::dispatch(WGPUCommandEncoder commandEncoder, const std::vector<WGPUBindGroup>& bindGroups, uint32_t workgroupCountX, uint32_t workgroupCountY, uint32_t workgroupCountZ,
+        const WGPUPassTimestampWrites* timestampWrites) const
+    {
+        WGPUComputePassDescriptor computePassDesc{WGPU_COMPUTE_PASS_DESCRIPTOR_INIT};
+        computePassDesc.label = StringView(getName());
+        computePassDesc.timestampWrites = timestampWrites;
+
+        WGPUComputePassEncoder computePassEncoder = wgpuCommandEncoderBeginComputePass(commandEncoder, &computePassDesc);
+        wgpuComputePassEncoderSetPipeline(computePassEncoder, m_computePipeline.get());
+        for (int iBindGroup = 0; iBindGroup < bindGroups.size(); iBindGroup++)
+        {
+            wgpuComputePassEncoderSetBindGroup(computePassEncoder, iBindGroup, bindGroups.at(iBindGroup), 0, nullptr);
+        }
+        wgpuComputePassEncoderDispatchWorkgroups(computePassEncoder, workgroupCountX, workgroupCountY, workgroupCountZ);
+        wgpuComputePassEncoderEnd(computePassEncoder);
+        wgpuComputePassEncoderRelease(computePassEncoder);
+    }
 }
@@ -1,6 +1,25 @@
 #pragma once
+#include <memory>
+#include <vector>
+#include <webgpu/webgpu.h>
+
 #include "BasePass.h"
 
 namespace webgpu
 {
+    // A compute pipeline for a single entry point, dispatched into a caller-supplied command encoder
+    class ComputePass : public BasePass
+    {
+    public:
+        ComputePass(std::string_view name, std::string_view shaderSource, std::string_view entryPoint,
+            const std::vector<WGPUBindGroupLayout>& bindGroupLayouts, const std::vector<WGPUConstantEntry>& constants = {});
+
+        [[nodiscard]] WGPUComputePipeline get() const;
+
+        void dispatch(WGPUCommandEncoder commandEncoder, const std::vector<WGPUBindGroup>& bindGroups, uint32_t workgroupCountX, uint32_t workgroupCountY, uint32_t workgroupCountZ,
+            const WGPUPassTimestampWrites* timestampWrites = nullptr) const;
+
+    private:
+        std::shared_ptr<WGPUComputePipelineImpl> m_computePipeline;
+    };
 }
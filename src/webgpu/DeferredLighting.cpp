@@ -0,0 +1,81 @@
+#include "DeferredLighting.h"
+
+#include <vector>
+#include <spdlog/spdlog.h>
+
+#include "Application.h"
+#include "Device.h"
+#include "Pipeline.h"
+#include "RenderManager.h"
+
+namespace webgpu
+{
+    DeferredLighting::DeferredLighting(WGPUTextureFormat colorFormat)
+    {
+        auto& renderManager = Application::getRenderManager();
+
+        std::string error;
+        const auto shaderSource = renderManager.getShaderPreprocessor().process(SHADER, {}, error);
+        const auto* reflection = renderManager.getShaderReflection(SHADER, {});
+        if (!shaderSource.has_value() || (reflection == nullptr))
+        {
+            spdlog::error("Unable to load the deferred lighting shader");
+            return;
+        }
+
+        // Group 0 is the frame group, bound as for the scene shader
+        m_gBufferBindGroupLayout.addBindings(*reflection, 1);
+        m_gBufferBindGroupLayout.create("G-buffer BindGroupLayout");
+
+        std::vector layouts{renderManager.getFrameBindGroupLayout().getBindGroupLayout(), m_gBufferBindGroupLayout.getBindGroupLayout()};
+        WGPUPipelineLayoutDescriptor pipelineLayoutDescriptor = WGPU_PIPELINE_LAYOUT_DESCRIPTOR_INIT;
+        pipelineLayoutDescriptor.bindGroupLayoutCount = layouts.size();
+        pipelineLayoutDescriptor.bindGroupLayouts = layouts.data();
+        WGPUPipelineLayout pipelineLayout = wgpuDeviceCreatePipelineLayout(Application::getDevice().get(), &pipelineLayoutDescriptor);
+        m_pipelineLayout = std::shared_ptr<WGPUPipelineLayoutImpl>(pipelineLayout, [](WGPUPipelineLayout l) { wgpuPipelineLayoutRelease(l); });
+
+        // Every covered sample gets the pixel's color and depth
+        RenderPipelineState state;
+        state.label = "Deferred lighting";
+        state.shaderHash = renderManager.getPipelineCache().addShaderModule(shaderSource.value(), SHADER);
+        state.layout = m_pipelineLayout.get();
+        state.colorFormat = colorFormat;
+        state.depthFormat = Pipeline::DEPTH_FORMAT;
+        state.depthCompare = WGPUCompareFunction_Always;
+        state.cullMode = WGPUCullMode_None;
+        state.sampleCount = Pipeline::SAMPLE_COUNT;
+        m_pipelineHash = renderManager.getPipelineCache().request(state);
+    }
+
+    void DeferredLighting::run(WGPURenderPassEncoder renderPassEncoder, WGPUTextureView gBuffer, WGPUTextureView gBufferDepth)
+    {
+        auto& renderManager = Application::getRenderManager();
+        WGPURenderPipeline pipeline = renderManager.getPipelineCache().get(m_pipelineHash);
+        if (pipeline == nullptr)
+        {
+            return;
+        }
+
+        // The render graph's textures come from its pool, so they're usually the same from frame to frame
+        if (m_gBufferViews != std::pair{gBuffer, gBufferDepth})
+        {
+            m_gBufferBindGroup = BindGroup{};
+
+            WGPUBindGroupEntry gBufferEntry{WGPU_BIND_GROUP_ENTRY_INIT};
+            gBufferEntry.textureView = gBuffer;
+            m_gBufferBindGroup.addEntry(gBufferEntry);
+
+            WGPUBindGroupEntry depthEntry{WGPU_BIND_GROUP_ENTRY_INIT};
+            depthEntry.textureView = gBufferDepth;
+            m_gBufferBindGroup.addEntry(depthEntry);
+
+            m_gBufferBindGroup.create("G-buffer BindGroup", m_gBufferBindGroupLayout);
+            m_gBufferViews = {gBuffer, gBufferDepth};
+        }
+
+        wgpuRenderPassEncoderSetPipeline(renderPassEncoder, pipeline);
+        wgpuRenderPassEncoderSetBindGroup(renderPassEncoder, 0, renderManager.getFrameBindGroup().getBindGroup(), 0, nullptr);
+        wgpuRenderPassEncoderSetBindGroup(renderPassEncoder, 1, m_gBufferBindGroup.getBindGroup(), 0, nullptr);
+        wgpuRenderPassEncoderDraw(renderPassEncoder, 3, 1, 0, 0);
+    }
+}
@@ -0,0 +1,37 @@
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <string_view>
+#include <utility>
+#include <webgpu/webgpu.h>
+
+#include "BindGroup.h"
+#include "BindGroupLayout.h"
+
+namespace webgpu
+{
+    // The lighting pass of deferred shading (see deferred.wgsl). Opaque and masked surfaces are first drawn into a
+    // single-sampled G-buffer by a RenderPassStage::G_BUFFER pass, and then shaded here once per pixel with the
+    // clustered lights, so the lighting cost doesn't grow with overdraw. The result and the G-buffer's depth are drawn
+    // into the main pass's multisampled targets, where blended surfaces are then drawn forward.
+    class DeferredLighting
+    {
+    public:
+        static constexpr std::string_view SHADER = "deferred.wgsl";
+        static constexpr WGPUTextureFormat G_BUFFER_FORMAT = WGPUTextureFormat_RGBA32Uint; // packed, see gbuffer.wgsl
+
+        explicit DeferredLighting(WGPUTextureFormat colorFormat);
+
+        // Into a pass with the main pass's color and depth formats. Does nothing while the pipeline is compiling.
+        void run(WGPURenderPassEncoder renderPassEncoder, WGPUTextureView gBuffer, WGPUTextureView gBufferDepth);
+
+    private:
+        BindGroupLayout m_gBufferBindGroupLayout;
+        std::shared_ptr<WGPUPipelineLayoutImpl> m_pipelineLayout;
+        uint64_t m_pipelineHash{0};
+        BindGroup m_gBufferBindGroup;
+
+        // What m_gBufferBindGroup binds. The bind group keeps them alive, so new views can't reuse their handles.
+        std::pair<WGPUTextureView, WGPUTextureView> m_gBufferViews{nullptr, nullptr};
+    };
+}
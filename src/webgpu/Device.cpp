@@ -1,5 +1,7 @@
 #include "Device.h"
 
+#include <algorithm>
+#include <magic_enum/magic_enum.hpp>
 #include <spdlog/spdlog.h>
 
 #include "Adapter.h"
@@ -33,6 +35,11 @@ namespace webgpu
 		return {wgpuDeviceCreateCommandEncoder(m_device.get(), &commandEncoderDesc), [](WGPUCommandEncoder e) { wgpuCommandEncoderRelease(e); }};
 	}
 
+	bool Device::hasFeature(WGPUFeatureName feature) const
+	{
+		return std::find(m_requiredFeatures.begin(), m_requiredFeatures.end(), feature) != m_requiredFeatures.end();
+	}
+
 	WGPUDevice Device::requestDevice()
 	{
 		WebGpuInstance& instance = Application::getWebGpuInstance();
@@ -94,11 +101,40 @@ namespace webgpu
 		WGPUDeviceDescriptor deviceDesc = WGPU_DEVICE_DESCRIPTOR_INIT;
 		// Any name works here, that's your call
 		deviceDesc.label = StringView("My Device");
-		std::vector<WGPUFeatureName> features;
-		// No required feature for now
-		deviceDesc.requiredFeatureCount = features.size();
-		deviceDesc.requiredFeatures = features.data();
-		// Make sure 'features' lives until the call to wgpuAdapterRequestDevice!
+		// Texture compression is optional; textures are transcoded on the CPU when it's missing
+		m_requiredFeatures.clear();
+		const WGPUAdapter adapter = Application::getAdapter().get();
+		for (const auto feature : {WGPUFeatureName_TextureCompressionBC, WGPUFeatureName_TextureCompressionETC2, WGPUFeatureName_TextureCompressionASTC})
+		{
+			if (wgpuAdapterHasFeature(adapter, feature))
+			{
+				m_requiredFeatures.push_back(feature);
+				spdlog::info("Requesting feature {}", magic_enum::enum_name(feature));
+			}
+		}
+		// For culling instances on the GPU, see InstanceCulling
+		if (wgpuAdapterHasFeature(adapter, WGPUFeatureName_IndirectFirstInstance))
+		{
+			m_requiredFeatures.push_back(WGPUFeatureName_IndirectFirstInstance);
+			spdlog::info("Requesting feature {}", magic_enum::enum_name(WGPUFeatureName_IndirectFirstInstance));
+		}
+		// For GPU timings, see GpuTimer
+		if (wgpuAdapterHasFeature(adapter, WGPUFeatureName_TimestampQuery))
+		{
+			m_requiredFeatures.push_back(WGPUFeatureName_TimestampQuery);
+			spdlog::info("Requesting feature {}", magic_enum::enum_name(WGPUFeatureName_TimestampQuery));
+		}
+#ifndef __EMSCRIPTEN__
+		// Lets worker threads record render bundles, see Pipeline
+		if (wgpuAdapterHasFeature(adapter, WGPUFeatureName_ImplicitDeviceSynchronization))
+		{
+			m_requiredFeatures.push_back(WGPUFeatureName_ImplicitDeviceSynchronization);
+			spdlog::info("Requesting feature {}", magic_enum::enum_name(WGPUFeatureName_ImplicitDeviceSynchronization));
+		}
+#endif
+		deviceDesc.requiredFeatureCount = m_requiredFeatures.size();
+		deviceDesc.requiredFeatures = m_requiredFeatures.data();
+		// Make sure 'm_requiredFeatures' lives until the call to wgpuAdapterRequestDevice!
 		deviceDesc.requiredLimits = &requiredLimits;
 		// Make sure that the 'requiredLimits' variable lives until the call to wgpuAdapterRequestDevice!
 		deviceDesc.defaultQueue.label = StringView("The Default Queue");
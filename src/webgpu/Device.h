@@ -1,5 +1,6 @@
 #pragma once
 #include <memory>
+#include <vector>
 #include <webgpu/webgpu.h>
 
 namespace webgpu
@@ -17,11 +18,15 @@ namespace webgpu
         [[nodiscard]] WGPUQueue getQueue() const;
         [[nodiscard]] std::shared_ptr<WGPUCommandEncoderImpl> createCommandEncoder() const;
 
+        // Features requested at creation; safe to call from any thread
+        [[nodiscard]] bool hasFeature(WGPUFeatureName feature) const;
+
         void print() const;
 
     private:
         std::shared_ptr<WGPUDeviceImpl> m_device;
         std::shared_ptr<WGPUQueueImpl> m_queue;
+        std::vector<WGPUFeatureName> m_requiredFeatures; // must outlive wgpuAdapterRequestDevice
 
         WGPUDevice requestDevice();
         WGPUDeviceDescriptor createDeviceDescriptor(const WGPULimits &requiredLimits);
@@ -0,0 +1,60 @@
+#include "DirtyRanges.h"
+
+#include <algorithm>
+
+namespace webgpu
+{
+    void DirtyRanges::mark(int index)
+    {
+        mark(index, 1);
+    }
+
+    void DirtyRanges::mark(int first, int count)
+    {
+        if ((first < 0) || (count <= 0))
+        {
+            return;
+        }
+
+        const int end = first + count;
+        if (end > m_isDirty.size())
+        {
+            m_isDirty.resize(end, false);
+        }
+        std::fill(m_isDirty.begin() + first, m_isDirty.begin() + end, true);
+
+        m_first = isEmpty() ? first : std::min(m_first, first);
+        m_end = std::max(m_end, end);
+    }
+
+    bool DirtyRanges::isEmpty() const
+    {
+        return m_first == m_end;
+    }
+
+    std::vector<DirtyRange> DirtyRanges::take(int mergeGap)
+    {
+        std::vector<DirtyRange> ranges;
+        for (int i = m_first; i < m_end; i++)
+        {
+            if (!m_isDirty.at(i))
+            {
+                continue;
+            }
+
+            m_isDirty.at(i) = false;
+            if (!ranges.empty() && (i - (ranges.back().first + ranges.back().count) <= mergeGap))
+            {
+                ranges.back().count = i + 1 - ranges.back().first;
+            }
+            else
+            {
+                ranges.push_back({i, 1});
+            }
+        }
+
+        m_first = 0;
+        m_end = 0;
+        return ranges;
+    }
+}
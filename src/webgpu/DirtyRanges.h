@@ -0,0 +1,32 @@
+#pragma once
+#include <vector>
+
+namespace webgpu
+{
+    struct DirtyRange
+    {
+        int first;
+        int count;
+
+        bool operator==(const DirtyRange&) const = default;
+    };
+
+    // Which elements of an array changed since it was last uploaded, as contiguous ranges to write
+    class DirtyRanges
+    {
+    public:
+        void mark(int index);
+        void mark(int first, int count);
+
+        [[nodiscard]] bool isEmpty() const;
+
+        // The dirty elements in order, clearing them. Ranges separated by at most mergeGap clean elements are
+        // merged, since one larger write costs less than several small ones.
+        std::vector<DirtyRange> take(int mergeGap);
+
+    private:
+        std::vector<bool> m_isDirty;
+        int m_first{0}; // bounds of the dirty elements, so that take() only scans those
+        int m_end{0};
+    };
+}
@@ -0,0 +1,116 @@
+#include "FrameAllocator.h"
+
+#include <thread>
+#include <spdlog/spdlog.h>
+
+#include "Application.h"
+#include "Device.h"
+#include "StringView.h"
+#include "Util.h"
+#include "WebGpuInstance.h"
+
+namespace webgpu
+{
+    FrameAllocator::FrameAllocator(int frameCount, uint64_t capacity)
+        : m_capacity{Util::nextPow2Multiple(capacity, 4)},
+          m_inFlight{std::make_shared<InFlight>(frameCount, false)},
+          m_staging(m_capacity),
+          m_frameIndex{0},
+          m_usedSize{0}
+    {
+        auto& device = Application::getDevice();
+        for (int iFrame = 0; iFrame < frameCount; iFrame++)
+        {
+            WGPUBufferDescriptor bufferDesc{WGPU_BUFFER_DESCRIPTOR_INIT};
+            const std::string label = fmt::format("Frame allocator buffer {}", iFrame);
+            bufferDesc.label = StringView(label);
+            bufferDesc.size = m_capacity;
+            bufferDesc.usage = WGPUBufferUsage_CopyDst | WGPUBufferUsage_Uniform | WGPUBufferUsage_Storage | WGPUBufferUsage_Vertex | WGPUBufferUsage_Index;
+            WGPUBuffer buffer = wgpuDeviceCreateBuffer(device.get(), &bufferDesc);
+            m_buffers.emplace_back(buffer, [](WGPUBuffer b) { wgpuBufferDestroy(b); wgpuBufferRelease(b); });
+        }
+    }
+
+    void FrameAllocator::beginFrame()
+    {
+        m_frameIndex = (m_frameIndex + 1) % getFrameCount();
+
+#ifndef __EMSCRIPTEN__
+        // In the browser, callbacks only run when control returns to the event loop, so this can't wait there. The
+        // uploads are ordered on the queue either way; waiting is what keeps the CPU from running further ahead.
+        while (m_inFlight->at(m_frameIndex))
+        {
+            Application::getWebGpuInstance().processEvents();
+            std::this_thread::yield();
+        }
+#endif
+
+        m_usedSize = 0;
+    }
+
+    std::optional<FrameAllocation> FrameAllocator::allocate(uint64_t size, uint64_t alignment)
+    {
+        const uint64_t offset = Util::nextPow2Multiple(m_usedSize, static_cast<int>(alignment));
+        if (offset + size > m_capacity)
+        {
+            spdlog::error("Frame allocator is out of space: {} bytes requested with {} of {} used", size, m_usedSize, m_capacity);
+            return std::nullopt;
+        }
+
+        m_usedSize = offset + size;
+        return FrameAllocation{m_buffers.at(m_frameIndex).get(), offset, std::span{m_staging}.subspan(offset, size)};
+    }
+
+    void FrameAllocator::flush(WGPUQueue queue)
+    {
+        if (m_usedSize > 0)
+        {
+            wgpuQueueWriteBuffer(queue, m_buffers.at(m_frameIndex).get(), 0, m_staging.data(), Util::nextPow2Multiple(m_usedSize, 4));
+        }
+    }
+
+    void FrameAllocator::endFrame(WGPUQueue queue)
+    {
+        m_inFlight->at(m_frameIndex) = true;
+
+        WGPUQueueWorkDoneCallbackInfo callbackInfo{WGPU_QUEUE_WORK_DONE_CALLBACK_INFO_INIT};
+        callbackInfo.mode = WGPUCallbackMode_AllowProcessEvents;
+        callbackInfo.callback = [](WGPUQueueWorkDoneStatus status, WGPUStringView message, void* userdata1, void* userdata2) {
+            std::unique_ptr<std::weak_ptr<InFlight>> weakInFlight{static_cast<std::weak_ptr<InFlight>*>(userdata1)};
+            std::unique_ptr<int> frameIndex{static_cast<int*>(userdata2)};
+            if (status != WGPUQueueWorkDoneStatus_Success)
+            {
+                spdlog::error("Frame {} didn't complete: {}", *frameIndex, StringView(message).toString());
+            }
+
+            // Released on failure too, since the device is gone and nothing is reading the buffer
+            if (auto inFlight = weakInFlight->lock())
+            {
+                inFlight->at(*frameIndex) = false;
+            }
+        };
+        callbackInfo.userdata1 = new std::weak_ptr<InFlight>(m_inFlight);
+        callbackInfo.userdata2 = new int(m_frameIndex);
+        wgpuQueueOnSubmittedWorkDone(queue, callbackInfo);
+    }
+
+    int FrameAllocator::getFrameCount() const
+    {
+        return static_cast<int>(m_buffers.size());
+    }
+
+    int FrameAllocator::getFrameIndex() const
+    {
+        return m_frameIndex;
+    }
+
+    WGPUBuffer FrameAllocator::getBuffer(int frameIndex) const
+    {
+        return m_buffers.at(frameIndex).get();
+    }
+
+    uint64_t FrameAllocator::getUsedSize() const
+    {
+        return m_usedSize;
+    }
+}
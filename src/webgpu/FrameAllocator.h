@@ -0,0 +1,70 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <optional>
+#include <span>
+#include <vector>
+#include <webgpu/webgpu.h>
+
+namespace webgpu
+{
+    // A slice of the current frame's buffer. The bytes are uploaded by flush(), so they're only written until then.
+    struct FrameAllocation
+    {
+        WGPUBuffer buffer;
+        uint64_t offset;
+        std::span<std::byte> data;
+    };
+
+    // Transient GPU memory for data that is rewritten every frame. Each of the frames in flight has its own buffer,
+    // bump-allocated from the start each frame and uploaded in one write. A frame's buffer isn't reused until the
+    // queue reports the work submitted with it done, so the CPU runs at most frameCount frames ahead of the GPU.
+    class FrameAllocator
+    {
+    public:
+        static constexpr uint64_t DEFAULT_ALIGNMENT = 256; // minUniformBufferOffsetAlignment and minStorageBufferOffsetAlignment
+
+        FrameAllocator(int frameCount, uint64_t capacity);
+
+        // Moves to the next frame's buffer, waiting for the GPU to be done with it
+        void beginFrame();
+
+        // nullopt, with an error logged, when the frame's buffer is full
+        std::optional<FrameAllocation> allocate(uint64_t size, uint64_t alignment = DEFAULT_ALIGNMENT);
+
+        template <typename T>
+        std::optional<FrameAllocation> write(const T& value, uint64_t alignment = DEFAULT_ALIGNMENT)
+        {
+            auto allocation = allocate(sizeof(T), alignment);
+            if (allocation.has_value())
+            {
+                std::memcpy(allocation->data.data(), &value, sizeof(T));
+            }
+            return allocation;
+        }
+
+        // Uploads this frame's allocations; before submitting the work that reads them
+        void flush(WGPUQueue queue);
+
+        // Marks the frame's buffer in flight until the work submitted so far is done; after submitting
+        void endFrame(WGPUQueue queue);
+
+        [[nodiscard]] int getFrameCount() const;
+        [[nodiscard]] int getFrameIndex() const;
+        [[nodiscard]] WGPUBuffer getBuffer(int frameIndex) const;
+        [[nodiscard]] uint64_t getUsedSize() const;
+
+    private:
+        // Shared with work done callbacks, which may run after the allocator is gone
+        using InFlight = std::vector<bool>;
+
+        uint64_t m_capacity;
+        std::vector<std::shared_ptr<WGPUBufferImpl>> m_buffers;
+        std::shared_ptr<InFlight> m_inFlight;
+        std::vector<std::byte> m_staging;
+        int m_frameIndex;
+        uint64_t m_usedSize;
+    };
+}
@@ -0,0 +1,143 @@
+#include "GpuTimer.h"
+
+#include <spdlog/spdlog.h>
+
+#include "Application.h"
+#include "Device.h"
+#include "StringView.h"
+
+namespace webgpu
+{
+    GpuTimer::GpuTimer() : m_readback{std::make_shared<Readback>()}, m_timestampWrites{}
+    {
+        auto& device = Application::getDevice();
+        if (!device.hasFeature(WGPUFeatureName_TimestampQuery))
+        {
+            spdlog::info("Timestamp queries aren't supported, so GPU timings are off");
+            return;
+        }
+
+        // A timestamp at the start and end of each pass
+        constexpr uint32_t queryCount = 2 * MAX_PASSES;
+        constexpr uint64_t bufferSize = queryCount * sizeof(uint64_t);
+
+        WGPUQuerySetDescriptor querySetDesc{WGPU_QUERY_SET_DESCRIPTOR_INIT};
+        querySetDesc.label = StringView("GPU timer queries");
+        querySetDesc.type = WGPUQueryType_Timestamp;
+        querySetDesc.count = queryCount;
+        WGPUQuerySet querySet = wgpuDeviceCreateQuerySet(device.get(), &querySetDesc);
+        m_querySet = std::shared_ptr<WGPUQuerySetImpl>(querySet, [](WGPUQuerySet q) { wgpuQuerySetDestroy(q); wgpuQuerySetRelease(q); });
+
+        WGPUBufferDescriptor resolveBufferDesc{WGPU_BUFFER_DESCRIPTOR_INIT};
+        resolveBufferDesc.label = StringView("GPU timer resolve buffer");
+        resolveBufferDesc.size = bufferSize;
+        resolveBufferDesc.usage = WGPUBufferUsage_QueryResolve | WGPUBufferUsage_CopySrc;
+        WGPUBuffer resolveBuffer = wgpuDeviceCreateBuffer(device.get(), &resolveBufferDesc);
+        m_resolveBuffer = std::shared_ptr<WGPUBufferImpl>(resolveBuffer, [](WGPUBuffer b) { wgpuBufferDestroy(b); wgpuBufferRelease(b); });
+
+        WGPUBufferDescriptor readbackBufferDesc{WGPU_BUFFER_DESCRIPTOR_INIT};
+        readbackBufferDesc.label = StringView("GPU timer readback buffer");
+        readbackBufferDesc.size = bufferSize;
+        readbackBufferDesc.usage = WGPUBufferUsage_MapRead | WGPUBufferUsage_CopyDst;
+        WGPUBuffer readbackBuffer = wgpuDeviceCreateBuffer(device.get(), &readbackBufferDesc);
+        m_readbackBuffer = std::shared_ptr<WGPUBufferImpl>(readbackBuffer, [](WGPUBuffer b) { wgpuBufferDestroy(b); wgpuBufferRelease(b); });
+
+        for (int iPass = 0; iPass < MAX_PASSES; iPass++)
+        {
+            auto& timestampWrites = m_timestampWrites.at(iPass);
+            timestampWrites = WGPU_PASS_TIMESTAMP_WRITES_INIT;
+            timestampWrites.querySet = querySet;
+            timestampWrites.beginningOfPassWriteIndex = 2 * iPass;
+            timestampWrites.endOfPassWriteIndex = 2 * iPass + 1;
+        }
+    }
+
+    GpuTimer::~GpuTimer()
+    {
+        // The map callback only holds the shared state
+        if (m_readback->state == ReadbackState::MAPPED)
+        {
+            wgpuBufferUnmap(m_readbackBuffer.get());
+        }
+    }
+
+    bool GpuTimer::isEnabled() const
+    {
+        return m_querySet != nullptr;
+    }
+
+    void GpuTimer::beginFrame()
+    {
+        m_passNames.clear();
+
+        if (m_readback->state == ReadbackState::MAPPED)
+        {
+            const auto* timestamps = static_cast<const uint64_t*>(wgpuBufferGetConstMappedRange(m_readbackBuffer.get(), 0, 2 * m_readbackPassNames.size() * sizeof(uint64_t)));
+            m_timings.clear();
+            for (int iPass = 0; iPass < m_readbackPassNames.size(); iPass++)
+            {
+                // In nanoseconds. Timestamps may go backwards, e.g. when the GPU changes clocks mid-pass.
+                const uint64_t begin = timestamps[2 * iPass];
+                const uint64_t end = timestamps[2 * iPass + 1];
+                m_timings.push_back({m_readbackPassNames.at(iPass), (end > begin) ? (end - begin) / 1.0e6 : 0.0});
+            }
+            wgpuBufferUnmap(m_readbackBuffer.get());
+            m_readback->state = ReadbackState::IDLE;
+        }
+    }
+
+    const WGPUPassTimestampWrites* GpuTimer::addPass(std::string_view name)
+    {
+        if (!isEnabled() || (m_readback->state != ReadbackState::IDLE) || (m_passNames.size() >= MAX_PASSES))
+        {
+            return nullptr;
+        }
+
+        m_passNames.emplace_back(name);
+        return &m_timestampWrites.at(m_passNames.size() - 1);
+    }
+
+    void GpuTimer::resolve(WGPUCommandEncoder commandEncoder)
+    {
+        if (m_passNames.empty() || (m_readback->state != ReadbackState::IDLE))
+        {
+            return;
+        }
+
+        const auto queryCount = static_cast<uint32_t>(2 * m_passNames.size());
+        wgpuCommandEncoderResolveQuerySet(commandEncoder, m_querySet.get(), 0, queryCount, m_resolveBuffer.get(), 0);
+        wgpuCommandEncoderCopyBufferToBuffer(commandEncoder, m_resolveBuffer.get(), 0, m_readbackBuffer.get(), 0, queryCount * sizeof(uint64_t));
+        m_readbackPassNames = m_passNames;
+        m_readback->state = ReadbackState::COPIED;
+    }
+
+    void GpuTimer::readTimings()
+    {
+        if (m_readback->state != ReadbackState::COPIED)
+        {
+            return;
+        }
+
+        m_readback->state = ReadbackState::MAPPING;
+        WGPUBufferMapCallbackInfo callbackInfo{WGPU_BUFFER_MAP_CALLBACK_INFO_INIT};
+        callbackInfo.mode = WGPUCallbackMode_AllowProcessEvents;
+        callbackInfo.callback = [](WGPUMapAsyncStatus status, WGPUStringView message, void* userdata1, void*) {
+            std::unique_ptr<std::weak_ptr<Readback>> weakReadback{static_cast<std::weak_ptr<Readback>*>(userdata1)};
+            if (auto readback = weakReadback->lock())
+            {
+                if (status != WGPUMapAsyncStatus_Success)
+                {
+                    spdlog::error("Unable to read GPU timings: {}", StringView(message).toString());
+                }
+                readback->state = (status == WGPUMapAsyncStatus_Success) ? ReadbackState::MAPPED : ReadbackState::IDLE;
+            }
+        };
+        callbackInfo.userdata1 = new std::weak_ptr<Readback>(m_readback);
+        wgpuBufferMapAsync(m_readbackBuffer.get(), WGPUMapMode_Read, 0, 2 * m_readbackPassNames.size() * sizeof(uint64_t), callbackInfo);
+    }
+
+    const std::vector<GpuPassTiming>& GpuTimer::getTimings() const
+    {
+        return m_timings;
+    }
+}
@@ -0,0 +1,72 @@
+#pragma once
+#include <array>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <webgpu/webgpu.h>
+
+namespace webgpu
+{
+    struct GpuPassTiming
+    {
+        std::string name;
+        double milliseconds;
+    };
+
+    // GPU time per render or compute pass, from timestamp queries written at the start and end of each pass and read
+    // back asynchronously. Only one frame's queries are read back at a time, so frames that start while a read back is
+    // in flight aren't timed. Does nothing on devices without WGPUFeatureName_TimestampQuery.
+    class GpuTimer
+    {
+    public:
+        static constexpr int MAX_PASSES = 16; // per frame
+
+        GpuTimer();
+        ~GpuTimer();
+
+        GpuTimer(const GpuTimer&) = delete;
+        GpuTimer& operator=(const GpuTimer&) = delete;
+
+        [[nodiscard]] bool isEnabled() const;
+
+        // Call once per frame, before adding passes. Picks up the timings of a frame that has been read back.
+        void beginFrame();
+
+        // For the pass's descriptor; nullptr if this frame isn't timed or has run out of queries
+        [[nodiscard]] const WGPUPassTimestampWrites* addPass(std::string_view name);
+
+        // After the timed passes: copies their timestamps for reading back
+        void resolve(WGPUCommandEncoder commandEncoder);
+
+        // After the commands from resolve() were submitted
+        void readTimings();
+
+        // Of the most recent frame read back, in the order the passes ran
+        [[nodiscard]] const std::vector<GpuPassTiming>& getTimings() const;
+
+    private:
+        enum class ReadbackState
+        {
+            IDLE,
+            COPIED,
+            MAPPING,
+            MAPPED,
+        };
+
+        // Shared with the map callback, which may outlive this
+        struct Readback
+        {
+            ReadbackState state{ReadbackState::IDLE};
+        };
+
+        std::shared_ptr<WGPUQuerySetImpl> m_querySet;
+        std::shared_ptr<WGPUBufferImpl> m_resolveBuffer;
+        std::shared_ptr<WGPUBufferImpl> m_readbackBuffer;
+        std::shared_ptr<Readback> m_readback;
+        std::array<WGPUPassTimestampWrites, MAX_PASSES> m_timestampWrites;
+        std::vector<std::string> m_passNames; // of the frame being recorded
+        std::vector<std::string> m_readbackPassNames; // of the frame being read back
+        std::vector<GpuPassTiming> m_timings;
+    };
+}
@@ -0,0 +1,135 @@
+#include "InstanceCulling.h"
+
+#include <algorithm>
+#include <bit>
+#include <iterator>
+#include <spdlog/spdlog.h>
+
+#include "Application.h"
+#include "Device.h"
+#include "ModelManager.h"
+#include "ShaderPreprocessor.h"
+#include "ShaderReflection.h"
+#include "StringView.h"
+
+namespace webgpu
+{
+    bool InstanceCulling::isSupported()
+    {
+        return Application::getDevice().hasFeature(WGPUFeatureName_IndirectFirstInstance);
+    }
+
+    InstanceCulling::InstanceCulling(ShaderPreprocessor& shaderPreprocessor, const std::vector<DrawBatch>& batches, const std::vector<MeshBounds>& bounds)
+        : m_instances{std::max(static_cast<int>(bounds.size()), 1), WGPUBufferBindingType_ReadOnlyStorage}
+    {
+        const WGPUQueue queue = Application::getDevice().getQueue();
+
+        // Each batch's survivors are written from its first instance on, so the list is as long as the instances
+        std::vector<uint32_t> initialDrawArgs;
+        for (int iBatch = 0; iBatch < batches.size(); iBatch++)
+        {
+            const auto& batch = batches.at(iBatch);
+            initialDrawArgs.insert(initialDrawArgs.end(), {batch.indexCount, 0, batch.firstIndex, std::bit_cast<uint32_t>(batch.baseVertex), batch.firstInstance});
+            for (uint32_t iInstance = batch.firstInstance; iInstance < batch.firstInstance + batch.instanceCount; iInstance++)
+            {
+                const auto& instanceBounds = bounds.at(iInstance);
+                m_instances.getInstance(m_instances.nextInstanceIndex()) = {instanceBounds.center, instanceBounds.radius, static_cast<uint32_t>(iBatch)};
+            }
+        }
+        m_instances.write(queue);
+
+        // Only the batches' instances, since slots past them would be culled into batch 0
+        m_instanceCount = m_instances.size();
+
+        const uint64_t drawArgsSize = std::max<uint64_t>(initialDrawArgs.size() * sizeof(uint32_t), DRAW_ARGS_SIZE);
+        m_drawArgs = createBuffer("Culled draw arguments", drawArgsSize, WGPUBufferUsage_Storage | WGPUBufferUsage_Indirect | WGPUBufferUsage_CopyDst);
+        m_initialDrawArgs = createBuffer("Initial draw arguments", drawArgsSize, WGPUBufferUsage_CopySrc | WGPUBufferUsage_CopyDst);
+        wgpuQueueWriteBuffer(queue, m_initialDrawArgs.get(), 0, initialDrawArgs.data(), initialDrawArgs.size() * sizeof(uint32_t));
+        m_instanceIndices = createBuffer("Visible instances", std::max(m_instanceCount, 1) * sizeof(uint32_t), WGPUBufferUsage_Storage);
+
+        std::string error;
+        const auto shaderSource = shaderPreprocessor.process("culling.wgsl", {}, error);
+        const auto reflection = shaderSource.has_value() ? ShaderReflection::reflect(shaderSource.value(), error) : std::nullopt;
+        if (!reflection.has_value())
+        {
+            spdlog::error("Unable to load the instance culling shader: {}", error);
+            return;
+        }
+
+        m_cullingUniform.validate(reflection.value(), 0, 0);
+        m_instances.validate(reflection.value(), 0, 1);
+        m_bindGroupLayout.addBindings(reflection.value(), 0);
+        m_bindGroupLayout.create("Instance culling BindGroupLayout");
+
+        m_bindGroup.addUniform(m_cullingUniform, 0);
+        m_bindGroup.addUniform(m_instances, 0);
+
+        WGPUBindGroupEntry drawArgsEntry{WGPU_BIND_GROUP_ENTRY_INIT};
+        drawArgsEntry.buffer = m_drawArgs.get();
+        drawArgsEntry.size = drawArgsSize;
+        m_bindGroup.addEntry(drawArgsEntry);
+
+        WGPUBindGroupEntry instanceIndicesEntry{WGPU_BIND_GROUP_ENTRY_INIT};
+        instanceIndicesEntry.buffer = m_instanceIndices.get();
+        instanceIndicesEntry.size = wgpuBufferGetSize(m_instanceIndices.get());
+        m_bindGroup.addEntry(instanceIndicesEntry);
+
+        m_bindGroup.create("Instance culling BindGroup", m_bindGroupLayout);
+
+        m_cullingPass.emplace("Instance culling", shaderSource.value(), "cs_main", std::vector{m_bindGroupLayout.getBindGroupLayout()});
+    }
+
+    void InstanceCulling::update(const glm::mat4x4& viewProjection)
+    {
+        const auto planes = getFrustumPlanes(viewProjection);
+
+        auto& cullingUniform = m_cullingUniform.getInstance();
+        std::copy(planes.begin(), planes.end(), std::begin(cullingUniform.planes));
+        cullingUniform.instanceCount = m_instanceCount;
+        m_cullingUniform.write(Application::getDevice().getQueue());
+    }
+
+    std::array<glm::vec4, 6> InstanceCulling::getFrustumPlanes(const glm::mat4x4& viewProjection)
+    {
+        // The planes are sums of the clip space matrix's rows (Gribb and Hartmann)
+        const glm::mat4x4 rows = glm::transpose(viewProjection);
+        std::array planes{rows[3] + rows[0], rows[3] - rows[0], rows[3] + rows[1], rows[3] - rows[1], rows[2], rows[3] - rows[2]};
+        for (auto& plane : planes)
+        {
+            plane /= glm::length(glm::vec3{plane});
+        }
+        return planes;
+    }
+
+    void InstanceCulling::cull(WGPUCommandEncoder commandEncoder, const WGPUPassTimestampWrites* timestampWrites) const
+    {
+        if (!m_cullingPass.has_value())
+        {
+            return;
+        }
+
+        wgpuCommandEncoderCopyBufferToBuffer(commandEncoder, m_initialDrawArgs.get(), 0, m_drawArgs.get(), 0, wgpuBufferGetSize(m_drawArgs.get()));
+        const uint32_t workgroupCount = (m_instanceCount + WORKGROUP_SIZE - 1) / WORKGROUP_SIZE;
+        m_cullingPass->dispatch(commandEncoder, {m_bindGroup.getBindGroup()}, workgroupCount, 1, 1, timestampWrites);
+    }
+
+    WGPUBuffer InstanceCulling::getIndirectBuffer() const
+    {
+        return m_drawArgs.get();
+    }
+
+    WGPUBuffer InstanceCulling::getInstanceIndexBuffer() const
+    {
+        return m_instanceIndices.get();
+    }
+
+    std::shared_ptr<WGPUBufferImpl> InstanceCulling::createBuffer(std::string_view label, uint64_t size, WGPUBufferUsage usage)
+    {
+        WGPUBufferDescriptor bufferDesc{WGPU_BUFFER_DESCRIPTOR_INIT};
+        bufferDesc.label = StringView(label);
+        bufferDesc.size = size;
+        bufferDesc.usage = usage;
+        WGPUBuffer buffer = wgpuDeviceCreateBuffer(Application::getDevice().get(), &bufferDesc);
+        return std::shared_ptr<WGPUBufferImpl>(buffer, [](WGPUBuffer b) { wgpuBufferDestroy(b); wgpuBufferRelease(b); });
+    }
+}
@@ -0,0 +1,66 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string_view>
+#include <vector>
+#include <glm/glm.hpp>
+#include <webgpu/webgpu.h>
+
+#include "BindGroup.h"
+#include "BindGroupLayout.h"
+#include "ComputePass.h"
+#include "Uniform.h"
+#include "UniformsAndAttributes.h"
+
+namespace webgpu
+{
+    class ShaderPreprocessor;
+    struct DrawBatch;
+    struct MeshBounds;
+
+    // GPU-driven frustum culling (see culling.wgsl). Every instance's bounding sphere is uploaded once, when the draw
+    // batches are built. Each frame a compute pass tests them against the view frustum, appends the survivors to their
+    // batch's range of a visible instance list, and counts them into the batch's DrawIndexedIndirect arguments. The
+    // scene shader reads its model through that list, so the CPU records one indirect draw per batch, however many
+    // instances it has.
+    class InstanceCulling
+    {
+    public:
+        static constexpr uint64_t DRAW_ARGS_SIZE = 5 * sizeof(uint32_t); // per batch, DrawIndexedIndirect's arguments
+
+        // Each batch's indirect draw starts at its own instance, which needs WGPUFeatureName_IndirectFirstInstance
+        static bool isSupported();
+
+        // bounds are per instance, in model uniform order
+        InstanceCulling(ShaderPreprocessor& shaderPreprocessor, const std::vector<DrawBatch>& batches, const std::vector<MeshBounds>& bounds);
+
+        // Uploads this frame's view frustum
+        void update(const glm::mat4x4& viewProjection);
+
+        // Left, right, bottom, top, near and far, as inward unit normals and distances, for depth from 0 to w
+        [[nodiscard]] static std::array<glm::vec4, 6> getFrustumPlanes(const glm::mat4x4& viewProjection);
+
+        // Fills the indirect arguments and the visible instance list; before the passes that draw with them
+        void cull(WGPUCommandEncoder commandEncoder, const WGPUPassTimestampWrites* timestampWrites = nullptr) const;
+
+        [[nodiscard]] WGPUBuffer getIndirectBuffer() const; // DRAW_ARGS_SIZE per batch, in order
+        [[nodiscard]] WGPUBuffer getInstanceIndexBuffer() const; // the scene shader's instanceIndices
+
+    private:
+        static constexpr int WORKGROUP_SIZE = 64; // culling.wgsl
+
+        int m_instanceCount{0};
+        Uniform<CullingUniform> m_cullingUniform;
+        Uniform<CullingInstanceUniform> m_instances;
+        std::shared_ptr<WGPUBufferImpl> m_drawArgs;
+        std::shared_ptr<WGPUBufferImpl> m_initialDrawArgs; // no instances yet, copied over m_drawArgs before culling
+        std::shared_ptr<WGPUBufferImpl> m_instanceIndices;
+        BindGroupLayout m_bindGroupLayout;
+        BindGroup m_bindGroup;
+        std::optional<ComputePass> m_cullingPass;
+
+        static std::shared_ptr<WGPUBufferImpl> createBuffer(std::string_view label, uint64_t size, WGPUBufferUsage usage);
+    };
+}
@@ -0,0 +1,59 @@
+#include "LayerAllocator.h"
+
+#include <algorithm>
+#include <spdlog/spdlog.h>
+
+namespace webgpu
+{
+    LayerAllocator::LayerAllocator(int capacity) : m_isUsed(capacity, false), m_usedCount{0}
+    {
+    }
+
+    std::optional<int> LayerAllocator::allocate()
+    {
+        auto it = std::ranges::find(m_isUsed, false);
+        if (it == m_isUsed.end())
+        {
+            return std::nullopt;
+        }
+
+        *it = true;
+        m_usedCount++;
+        return static_cast<int>(it - m_isUsed.begin());
+    }
+
+    void LayerAllocator::free(int layer)
+    {
+        if ((layer < 0) || (layer >= m_isUsed.size()) || !m_isUsed.at(layer))
+        {
+            spdlog::error("Layer {} is not allocated", layer);
+            return;
+        }
+
+        m_isUsed.at(layer) = false;
+        m_usedCount--;
+    }
+
+    void LayerAllocator::grow(int capacity)
+    {
+        if (capacity > m_isUsed.size())
+        {
+            m_isUsed.resize(capacity, false);
+        }
+    }
+
+    int LayerAllocator::getCapacity() const
+    {
+        return static_cast<int>(m_isUsed.size());
+    }
+
+    int LayerAllocator::getUsedCount() const
+    {
+        return m_usedCount;
+    }
+
+    bool LayerAllocator::isUsed(int layer) const
+    {
+        return (layer >= 0) && (layer < m_isUsed.size()) && m_isUsed.at(layer);
+    }
+}
@@ -0,0 +1,26 @@
+#pragma once
+#include <optional>
+#include <vector>
+
+namespace webgpu
+{
+    // Hands out the layers of a texture array. Freed layers are reused, lowest first, before the array has to grow.
+    class LayerAllocator
+    {
+    public:
+        explicit LayerAllocator(int capacity);
+
+        // nullopt when every layer is in use; grow() and try again
+        std::optional<int> allocate();
+        void free(int layer);
+        void grow(int capacity);
+
+        [[nodiscard]] int getCapacity() const;
+        [[nodiscard]] int getUsedCount() const;
+        [[nodiscard]] bool isUsed(int layer) const;
+
+    private:
+        std::vector<bool> m_isUsed;
+        int m_usedCount;
+    };
+}
@@ -0,0 +1,117 @@
+#include "LightManager.h"
+
+#include <vector>
+#include <spdlog/spdlog.h>
+
+#include "Application.h"
+#include "Device.h"
+#include "ShaderPreprocessor.h"
+#include "ShaderReflection.h"
+#include "StringView.h"
+
+namespace webgpu
+{
+    LightManager::LightManager(ShaderPreprocessor& shaderPreprocessor) : m_lights{MAX_LIGHTS, WGPUBufferBindingType_ReadOnlyStorage}
+    {
+        m_clusterLightCounts = createClusterBuffer("Cluster light counts", CLUSTER_COUNT * sizeof(uint32_t));
+        m_clusterLightIndices = createClusterBuffer("Cluster light indices", CLUSTER_COUNT * MAX_LIGHTS_PER_CLUSTER * sizeof(uint32_t));
+
+        std::string error;
+        const auto shaderSource = shaderPreprocessor.process("clusters.wgsl", {}, error);
+        const auto reflection = shaderSource.has_value() ? ShaderReflection::reflect(shaderSource.value(), error) : std::nullopt;
+        if (!reflection.has_value())
+        {
+            spdlog::error("Unable to load the light culling shader: {}", error);
+            return;
+        }
+
+        m_clusterUniform.validate(reflection.value(), 0, 0);
+        m_lights.validate(reflection.value(), 0, 1);
+        m_cullingBindGroupLayout.addBindings(reflection.value(), 0);
+        m_cullingBindGroupLayout.create("Light culling BindGroupLayout");
+
+        addBindGroupEntries(m_cullingBindGroup);
+        m_cullingBindGroup.create("Light culling BindGroup", m_cullingBindGroupLayout);
+
+        m_cullingPass.emplace("Light culling", shaderSource.value(), "cs_main", std::vector{m_cullingBindGroupLayout.getBindGroupLayout()});
+    }
+
+    std::optional<int> LightManager::addLight(const LightUniform& light)
+    {
+        if (m_lights.size() >= MAX_LIGHTS)
+        {
+            spdlog::error("Unable to add a light: there are {} already", MAX_LIGHTS);
+            return std::nullopt;
+        }
+
+        const int index = m_lights.nextInstanceIndex();
+        m_lights.getInstance(index) = light;
+        return index;
+    }
+
+    LightUniform& LightManager::getLight(int index)
+    {
+        return m_lights.getInstance(index);
+    }
+
+    int LightManager::getLightCount() const
+    {
+        return m_lights.size();
+    }
+
+    bool LightManager::validate(const ShaderReflection& reflection, int group) const
+    {
+        return m_clusterUniform.validate(reflection, group, 1) && m_lights.validate(reflection, group, 2);
+    }
+
+    void LightManager::update(const glm::mat4x4& projection, const glm::mat4x4& view, int width, int height, float zNear, float zFar)
+    {
+        auto& clusterUniform = m_clusterUniform.getInstance();
+        clusterUniform.view = view;
+        clusterUniform.inverseProjection = glm::inverse(projection);
+        clusterUniform.gridSize = {CLUSTER_COUNT_X, CLUSTER_COUNT_Y, CLUSTER_COUNT_Z};
+        clusterUniform.lightCount = m_lights.size();
+        clusterUniform.screenSize = {static_cast<float>(width), static_cast<float>(height)};
+        clusterUniform.zNear = zNear;
+        clusterUniform.zFar = zFar;
+
+        const WGPUQueue queue = Application::getDevice().getQueue();
+        m_clusterUniform.write(queue);
+        m_lights.write(queue);
+    }
+
+    void LightManager::cullLights(WGPUCommandEncoder commandEncoder, const WGPUPassTimestampWrites* timestampWrites) const
+    {
+        if (m_cullingPass.has_value())
+        {
+            const uint32_t workgroupCount = (CLUSTER_COUNT + CULLING_WORKGROUP_SIZE - 1) / CULLING_WORKGROUP_SIZE;
+            m_cullingPass->dispatch(commandEncoder, {m_cullingBindGroup.getBindGroup()}, workgroupCount, 1, 1, timestampWrites);
+        }
+    }
+
+    std::shared_ptr<WGPUBufferImpl> LightManager::createClusterBuffer(std::string_view label, uint64_t size)
+    {
+        WGPUBufferDescriptor bufferDesc{WGPU_BUFFER_DESCRIPTOR_INIT};
+        bufferDesc.label = StringView(label);
+        bufferDesc.size = size;
+        bufferDesc.usage = WGPUBufferUsage_Storage;
+        WGPUBuffer buffer = wgpuDeviceCreateBuffer(Application::getDevice().get(), &bufferDesc);
+        return std::shared_ptr<WGPUBufferImpl>(buffer, [](WGPUBuffer b) { wgpuBufferDestroy(b); wgpuBufferRelease(b); });
+    }
+
+    void LightManager::addBindGroupEntries(BindGroup& bindGroup) const
+    {
+        bindGroup.addUniform(m_clusterUniform, 0);
+        bindGroup.addUniform(m_lights, 0);
+
+        WGPUBindGroupEntry countsEntry{WGPU_BIND_GROUP_ENTRY_INIT};
+        countsEntry.buffer = m_clusterLightCounts.get();
+        countsEntry.size = wgpuBufferGetSize(m_clusterLightCounts.get());
+        bindGroup.addEntry(countsEntry);
+
+        WGPUBindGroupEntry indicesEntry{WGPU_BIND_GROUP_ENTRY_INIT};
+        indicesEntry.buffer = m_clusterLightIndices.get();
+        indicesEntry.size = wgpuBufferGetSize(m_clusterLightIndices.get());
+        bindGroup.addEntry(indicesEntry);
+    }
+}
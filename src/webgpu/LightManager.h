@@ -0,0 +1,65 @@
+#pragma once
+#include <memory>
+#include <optional>
+#include <glm/glm.hpp>
+#include <webgpu/webgpu.h>
+
+#include "BindGroup.h"
+#include "BindGroupLayout.h"
+#include "ComputePass.h"
+#include "Uniform.h"
+#include "UniformsAndAttributes.h"
+
+namespace webgpu
+{
+    class ShaderPreprocessor;
+    class ShaderReflection;
+
+    // Dynamic point lights for clustered forward shading (see lights.wgsl). The lights are kept in a storage buffer,
+    // and each frame a compute pass bins them into a grid of view-space clusters, so that fragments only evaluate the
+    // lights that reach their cluster. The buffers are bound in the scene shader's frame group, after the frame
+    // uniform.
+    class LightManager
+    {
+    public:
+        static constexpr int MAX_LIGHTS = 1024;
+        static constexpr int MAX_LIGHTS_PER_CLUSTER = 64; // must match lights.wgsl; further lights are dropped
+        static constexpr int CLUSTER_COUNT_X = 16;
+        static constexpr int CLUSTER_COUNT_Y = 9;
+        static constexpr int CLUSTER_COUNT_Z = 24; // depth slices, exponentially spaced
+
+        explicit LightManager(ShaderPreprocessor& shaderPreprocessor);
+
+        // nullopt, with an error logged, when there are MAX_LIGHTS already
+        std::optional<int> addLight(const LightUniform& light);
+        LightUniform& getLight(int index);
+        [[nodiscard]] int getLightCount() const;
+
+        // Logs an error if the scene shader's frame group doesn't declare the light bindings like the host
+        bool validate(const ShaderReflection& reflection, int group) const;
+
+        // The light bindings, in the same order in the scene shader's frame group and the light culling shader:
+        // cluster uniform, lights, then the clusters' light counts and indices
+        void addBindGroupEntries(BindGroup& bindGroup) const;
+
+        // Uploads the lights that changed and the clusters' bounds for this frame's view
+        void update(const glm::mat4x4& projection, const glm::mat4x4& view, int width, int height, float zNear, float zFar);
+
+        // Bins the lights into clusters; before the passes that shade with them
+        void cullLights(WGPUCommandEncoder commandEncoder, const WGPUPassTimestampWrites* timestampWrites = nullptr) const;
+
+    private:
+        static constexpr int CLUSTER_COUNT = CLUSTER_COUNT_X * CLUSTER_COUNT_Y * CLUSTER_COUNT_Z;
+        static constexpr int CULLING_WORKGROUP_SIZE = 64; // clusters.wgsl
+
+        Uniform<LightUniform> m_lights;
+        Uniform<ClusterUniform> m_clusterUniform;
+        std::shared_ptr<WGPUBufferImpl> m_clusterLightCounts;
+        std::shared_ptr<WGPUBufferImpl> m_clusterLightIndices;
+        BindGroupLayout m_cullingBindGroupLayout;
+        BindGroup m_cullingBindGroup;
+        std::optional<ComputePass> m_cullingPass;
+
+        static std::shared_ptr<WGPUBufferImpl> createClusterBuffer(std::string_view label, uint64_t size);
+    };
+}
@@ -3,61 +3,48 @@
 
 #include <magic_enum/magic_enum.hpp>
 
-template <>
-struct std::hash<resource::JMaterial>
+namespace webgpu
 {
-    std::size_t operator()(const resource::JMaterial& k) const noexcept
+    std::unordered_map<MaterialFeatureKey, Material> Material::m_materials;
+
+    uint32_t MaterialFeatureKey::pack() const
     {
-        // TODO
-        return hash<bool>()(k.doubleSided);
-        //^ hash<int>()(magic_enum::enum_integer(k.magFilter))
-        //^ hash<int>()(magic_enum::enum_integer(k.wrapS))
-        //^ hash<int>()(magic_enum::enum_integer(k.wrapT));
+        return (magic_enum::enum_integer(alphaMode) << 12) | ((isDoubleSided ? 1 : 0) << 11) | ((vertexAttributes & 0x7) << 8) | (textureSlots & 0xff);
     }
-};
 
-template <>
-struct std::equal_to<resource::JMaterial>
-{
-    bool operator()(const resource::JMaterial& a, const resource::JMaterial& b) const
+    Material::Material(const MaterialFeatureKey& featureKey) : m_featureKey{featureKey}
     {
-        // TODO
-        return (a.doubleSided == b.doubleSided); // &&
-            //(a.magFilter == b.magFilter) &&
-            //(a.wrapS == b.wrapS) &&
-            //(a.wrapT == b.wrapT);
+        // Textures and factors are bound through MaterialManager's material table
     }
-};
 
-namespace webgpu
-{
-    std::unordered_map<resource::JMaterial, Material> Material::m_materials;
-
-    Material::Material(const resource::JMaterial& jMaterial)
+    MaterialFeatureKey Material::getFeatureKey(const resource::JMaterial& jMaterial)
     {
-        m_bindGroupLayout.addSampler(true); // TODO
-        m_bindGroupLayout.addTexture(); // albedo
-        m_bindGroupLayout.addTexture(); // metallicRoughness
-        m_bindGroupLayout.addTexture(); // emissive
-        m_bindGroupLayout.addTexture(); // occlusion
-        m_bindGroupLayout.addTexture(); // normal
-        m_bindGroupLayout.create("Material BindGroupLayout");
+        MaterialFeatureKey key;
+        key.alphaMode = magic_enum::enum_cast<GLAlphaMode>(jMaterial.alphaMode).value_or(GLAlphaMode::OPAQUE);
+        key.isDoubleSided = jMaterial.doubleSided;
+
+        const auto& pbr = jMaterial.pbrMetallicRoughness;
+        key.textureSlots |= (pbr.baseColorTexture.index != -1) ? MaterialFeatureKey::ALBEDO_TEXTURE : 0;
+        key.textureSlots |= (pbr.metallicRoughnessTexture.index != -1) ? MaterialFeatureKey::METALLIC_ROUGHNESS_TEXTURE : 0;
+        key.textureSlots |= (jMaterial.normalTexture.index != -1) ? MaterialFeatureKey::NORMAL_TEXTURE : 0;
+        key.textureSlots |= (jMaterial.occlusionTexture.index != -1) ? MaterialFeatureKey::OCCLUSION_TEXTURE : 0;
+        key.textureSlots |= (jMaterial.emissiveTexture.index != -1) ? MaterialFeatureKey::EMISSIVE_TEXTURE : 0;
+        return key;
     }
 
     Material& Material::get(const resource::JMaterial& jMaterial)
     {
-        auto it = m_materials.find(jMaterial);
+        const auto key = getFeatureKey(jMaterial);
+        auto it = m_materials.find(key);
         if (it == m_materials.end())
         {
-            Material material{jMaterial};
-            m_materials.insert(std::make_pair(jMaterial, material));
-            it = m_materials.find(jMaterial);
+            it = m_materials.emplace(key, Material{key}).first;
         }
         return it->second;
     }
 
-    const BindGroupLayout& Material::getBindGroupLayout() const
+    const MaterialFeatureKey& Material::getFeatureKey() const
     {
-        return m_bindGroupLayout;
+        return m_featureKey;
     }
 }
@@ -1,10 +1,10 @@
 #pragma once
-#include <optional>
+#include <compare>
+#include <cstdint>
+#include <functional>
 #include <unordered_map>
-#include <glm/vec4.hpp>
 
-#include "BindGroupLayout.h"
-#include "Texture.h"
+#include "GLTypes.h"
 
 namespace resource
 {
@@ -13,30 +13,58 @@ namespace resource
 
 namespace webgpu
 {
-    class Material
+    // Everything that selects a render pipeline variant. Factors and the textures themselves live in MaterialManager's
+    // material table, so materials that differ only in those share a variant.
+    struct MaterialFeatureKey
     {
-    public:
-        explicit Material(const resource::JMaterial& jMaterial);
+        // textureSlots bits
+        static constexpr uint32_t ALBEDO_TEXTURE = 1 << 0;
+        static constexpr uint32_t METALLIC_ROUGHNESS_TEXTURE = 1 << 1;
+        static constexpr uint32_t NORMAL_TEXTURE = 1 << 2;
+        static constexpr uint32_t OCCLUSION_TEXTURE = 1 << 3;
+        static constexpr uint32_t EMISSIVE_TEXTURE = 1 << 4;
 
-        static Material& get(const resource::JMaterial& jMaterial);
+        // vertexAttributes bits, the glTF attributes a primitive supplies beyond POSITION
+        static constexpr uint32_t VERTEX_NORMAL = 1 << 0;
+        static constexpr uint32_t VERTEX_TANGENT = 1 << 1;
+        static constexpr uint32_t VERTEX_TEXCOORD = 1 << 2;
 
-        [[nodiscard]] const BindGroupLayout& getBindGroupLayout() const;
+        GLAlphaMode alphaMode{GLAlphaMode::OPAQUE};
+        bool isDoubleSided{false};
+        uint32_t textureSlots{0};
+        uint32_t vertexAttributes{0};
 
-    private:
-        static std::unordered_map<resource::JMaterial, Material> m_materials;
+        // Ordered by alpha mode first, so that sorting draws by key puts blended ones after opaque ones
+        auto operator<=>(const MaterialFeatureKey&) const = default;
 
-        WGPUBlendState m_blendState;
-        WGPUColorTargetState m_colorTargetState;
-        WGPUDepthStencilState m_depthStencilState;
-        WGPUPrimitiveState m_primitiveState;
+        // alphaMode << 12 | isDoubleSided << 11 | vertexAttributes << 8 | textureSlots
+        [[nodiscard]] uint32_t pack() const;
+    };
 
-        std::string m_vertexShader; // TODO - different type?
-        std::string m_fragmentShader;
+    class Material
+    {
+    public:
+        explicit Material(const MaterialFeatureKey& featureKey);
 
-        bool m_isMultiSample;
+        static MaterialFeatureKey getFeatureKey(const resource::JMaterial& jMaterial);
 
-        bool m_isDoubleSided;
+        // Materials with the same features are shared
+        static Material& get(const resource::JMaterial& jMaterial);
+
+        [[nodiscard]] const MaterialFeatureKey& getFeatureKey() const;
+
+    private:
+        static std::unordered_map<MaterialFeatureKey, Material> m_materials;
 
-        BindGroupLayout m_bindGroupLayout;
+        MaterialFeatureKey m_featureKey;
     };
 }
+
+template <>
+struct std::hash<webgpu::MaterialFeatureKey>
+{
+    std::size_t operator()(const webgpu::MaterialFeatureKey& k) const noexcept
+    {
+        return hash<uint32_t>()(k.pack());
+    }
+};
@@ -1,13 +1,37 @@
 #include "MaterialInstance.h"
 
+#include <magic_enum/magic_enum.hpp>
+
 #include "MaterialManager.h"
+#include "resource/GltfResource.h"
 
 namespace webgpu
 {
-    MaterialInstance::MaterialInstance(const Material& material) : m_material{material}
+    MaterialInstance::MaterialInstance(const Material& material)
+    : m_material{material}, m_baseColorFactor{1.0}, m_metallicFactor{1.0}, m_roughnessFactor{1.0}, m_normalScale{1.0},
+    m_occlusionStrength{1.0}, m_emissiveFactor{0.0}, m_alphaCutoff{0.5}, m_alphaMode{GLAlphaMode::OPAQUE}
     {
     }
 
+    void MaterialInstance::setFactors(const resource::JMaterial& jMaterial)
+    {
+        const auto& pbr = jMaterial.pbrMetallicRoughness;
+        if (pbr.baseColorFactor.size() == 4)
+        {
+            m_baseColorFactor = {pbr.baseColorFactor.at(0), pbr.baseColorFactor.at(1), pbr.baseColorFactor.at(2), pbr.baseColorFactor.at(3)};
+        }
+        m_metallicFactor = pbr.metallicFactor;
+        m_roughnessFactor = pbr.roughnessFactor;
+        m_normalScale = jMaterial.normalTexture.scale;
+        m_occlusionStrength = jMaterial.occlusionTexture.strength;
+        if (jMaterial.emissiveFactor.size() == 3)
+        {
+            m_emissiveFactor = {jMaterial.emissiveFactor.at(0), jMaterial.emissiveFactor.at(1), jMaterial.emissiveFactor.at(2)};
+        }
+        m_alphaCutoff = jMaterial.alphaCutoff;
+        m_alphaMode = magic_enum::enum_cast<GLAlphaMode>(jMaterial.alphaMode).value_or(GLAlphaMode::OPAQUE);
+    }
+
     void MaterialInstance::setSampler(const Sampler& sampler)
     {
         m_sampler = sampler;
@@ -38,31 +62,49 @@ namespace webgpu
         m_emissiveTextureId = textureId;
     }
 
-    void MaterialInstance::create()
+    const Material& MaterialInstance::getMaterial() const
     {
-        auto& materialManager = Application::getMaterialManager();
+        return m_material;
+    }
 
-        std::vector<WGPUBindGroupEntry> bindGroupEntries;
+    const std::optional<Sampler>& MaterialInstance::getSampler() const
+    {
+        return m_sampler;
+    }
 
-        m_bindGroup.addSampler(m_sampler.value()); // TODO
+    std::optional<int> MaterialInstance::getAlbedoTextureId() const
+    {
+        return m_albedoTextureId;
+    }
 
-        // TODO - optionals
-        m_bindGroup.addTexture(materialManager.getTexture(m_albedoTextureId.value()));
-        m_bindGroup.addTexture(materialManager.getTexture(m_metallicRoughnessTextureId.value()));
-        m_bindGroup.addTexture(materialManager.getTexture(m_emissiveTextureId.value()));
-        m_bindGroup.addTexture(materialManager.getTexture(m_occlusionTextureId.value()));
-        m_bindGroup.addTexture(materialManager.getTexture(m_normalTextureId.value()));
+    std::optional<int> MaterialInstance::getMetallicRoughnessTextureId() const
+    {
+        return m_metallicRoughnessTextureId;
+    }
 
-        m_bindGroup.create("TODO material bind group", m_material.getBindGroupLayout()); // TODO
+    std::optional<int> MaterialInstance::getNormalTextureId() const
+    {
+        return m_normalTextureId;
     }
 
-    const Material& MaterialInstance::getMaterial() const
+    std::optional<int> MaterialInstance::getOcclusionTextureId() const
     {
-        return m_material;
+        return m_occlusionTextureId;
+    }
+
+    std::optional<int> MaterialInstance::getEmissiveTextureId() const
+    {
+        return m_emissiveTextureId;
     }
 
-    const BindGroup& MaterialInstance::getBindGroup() const
+    void MaterialInstance::fillMaterialUniform(MaterialUniform& materialUniform) const
     {
-        return m_bindGroup;
+        materialUniform.baseColorFactor = m_baseColorFactor;
+        materialUniform.emissiveFactor = m_emissiveFactor;
+        materialUniform.alphaCutoff = m_alphaCutoff;
+        materialUniform.metallicFactor = m_metallicFactor;
+        materialUniform.roughnessFactor = m_roughnessFactor;
+        materialUniform.normalScale = m_normalScale;
+        materialUniform.occlusionStrength = m_occlusionStrength;
     }
 }
@@ -1,8 +1,12 @@
 #pragma once
-#include "BindGroup.h"
+#include <optional>
+#include <glm/vec3.hpp>
+#include <glm/vec4.hpp>
+
 #include "GLTypes.h"
 #include "Material.h"
 #include "Sampler.h"
+#include "UniformsAndAttributes.h"
 
 namespace resource
 {
@@ -16,6 +20,7 @@ namespace webgpu
     public:
         explicit MaterialInstance(const Material& material);
 
+        void setFactors(const resource::JMaterial& jMaterial);
         void setSampler(const Sampler& sampler);
         void setAlbedoTextureId(std::optional<int> textureId);
         void setMetallicRoughnessTextureId(std::optional<int> textureId);
@@ -23,22 +28,27 @@ namespace webgpu
         void setOcclusionTextureId(std::optional<int> textureId);
         void setEmissiveTextureId(std::optional<int> textureId);
 
-        void create();
-
         [[nodiscard]] const Material& getMaterial() const;
-        [[nodiscard]] const BindGroup& getBindGroup() const;
+        [[nodiscard]] const std::optional<Sampler>& getSampler() const;
+        [[nodiscard]] std::optional<int> getAlbedoTextureId() const;
+        [[nodiscard]] std::optional<int> getMetallicRoughnessTextureId() const;
+        [[nodiscard]] std::optional<int> getNormalTextureId() const;
+        [[nodiscard]] std::optional<int> getOcclusionTextureId() const;
+        [[nodiscard]] std::optional<int> getEmissiveTextureId() const;
+
+        // Fills in the factors. Texture references are filled in by MaterialManager once texture arrays are built.
+        void fillMaterialUniform(MaterialUniform& materialUniform) const;
 
     private:
         const Material& m_material;
 
-        // TODO - probably don't need. Warn if present
-        //glm::vec4 m_baseColorFactor; // Can be used for solid color
-        //float m_metallicFactor;
-        //float m_roughnessFactor;
-        //float m_normalScale;
-        //float m_occlusionStrength;
-        //glm::vec3 m_emissiveFactor;
-        //float alphaCutoff;
+        glm::vec4 m_baseColorFactor;
+        float m_metallicFactor;
+        float m_roughnessFactor;
+        float m_normalScale;
+        float m_occlusionStrength;
+        glm::vec3 m_emissiveFactor;
+        float m_alphaCutoff;
 
         std::optional<Sampler> m_sampler;
 
@@ -50,7 +60,5 @@ namespace webgpu
         std::optional<int> m_emissiveTextureId; // 0.0 texture when not present
 
         GLAlphaMode m_alphaMode; // TODO - warn if MASK
-
-        BindGroup m_bindGroup;
     };
 }
@@ -1,8 +1,54 @@
 #include "MaterialManager.h"
 
+#include <algorithm>
+#include <cmath>
+#include <tuple>
+#include <magic_enum/magic_enum.hpp>
+#include <spdlog/spdlog.h>
+
+#include "RenderManager.h"
+#include "TextureFormat.h"
+#include "job/JobSystem.h"
+#include "resource/GltfResource.h"
+#include "resource/Settings.h"
+
 namespace webgpu
 {
-    MaterialManager::MaterialManager() = default;
+    MaterialManager::MaterialManager()
+    : m_materialUniforms{MAX_MATERIALS, WGPUBufferBindingType_ReadOnlyStorage},
+    m_mipGeneration{MipGenerator::getMipGeneration()}
+    {
+        if (m_mipGeneration == MipGeneration::COMPUTE)
+        {
+            m_mipGenerator.emplace();
+        }
+        spdlog::info("Mip generation: {}", magic_enum::enum_name(m_mipGeneration));
+
+        m_textureBudget = static_cast<uint64_t>(std::max(0, Application::getSettings().getInt("render.textureBudgetMiB").value_or(256))) * 1024 * 1024;
+        if (isStreaming())
+        {
+            spdlog::info("Texture streaming: {} MiB budget", m_textureBudget / (1024 * 1024));
+        }
+
+        // Group 1 of the scene shader: the sampler, the material table, then the texture arrays
+        if (const auto* reflection = Application::getRenderManager().getSceneReflection())
+        {
+            m_materialUniforms.validate(*reflection, 1, 1);
+            const int bindingCount = static_cast<int>(reflection->getBindings(1).size());
+            if (bindingCount != MAX_TEXTURE_ARRAYS + 2)
+            {
+                spdlog::error("{} declares {} material bindings, expected {}", RenderManager::SCENE_SHADER, bindingCount, MAX_TEXTURE_ARRAYS + 2);
+            }
+            m_bindGroupLayout.addBindings(*reflection, 1);
+        }
+        m_bindGroupLayout.create("Material BindGroupLayout");
+    }
+
+    MaterialManager::~MaterialManager()
+    {
+        // Decode jobs reference m_textures
+        Application::getJobSystem().wait();
+    }
 
     int MaterialManager::addMaterialInstance(const MaterialInstance& materialInstance)
     {
@@ -15,14 +61,457 @@ namespace webgpu
         return m_materialInstances.at(index);
     }
 
-    int MaterialManager::addTexture(const Texture& texture) // TODO
+    int MaterialManager::getDefaultMaterialInstanceIndex()
+    {
+        // White, fully metallic and rough, without textures, which is what a default JMaterial holds
+        if (!m_defaultMaterialInstanceIndex.has_value())
+        {
+            const resource::JMaterial jMaterial{};
+            MaterialInstance materialInstance{Material::get(jMaterial)};
+            materialInstance.setFactors(jMaterial);
+            m_defaultMaterialInstanceIndex = addMaterialInstance(materialInstance);
+        }
+        return m_defaultMaterialInstanceIndex.value();
+    }
+
+    int MaterialManager::addTexture(const Texture& texture)
+    {
+        int textureId = static_cast<int>(m_textures.size());
+        Texture& addedTexture = m_textures.emplace_back(texture);
+        m_textureCacheHits.push_back(0);
+        m_isTextureDecoded.push_back(!addedTexture.getPixels().empty());
+        m_textureResidency.emplace_back();
+
+        if (m_isTextureDecoded.back())
+        {
+            initTextureResidency(textureId);
+        }
+        else
+        {
+            m_pendingTextureCount++;
+            // One and two channel formats can't be storage textures, so their mips are always made on the CPU. So are
+            // those of streamed textures, whose CPU side mips are the source of the levels made resident later.
+            const bool isStorageCapable = TextureFormat::getChannelCount(TextureFormat::getUncompressedFormat(addedTexture.getUsage())) == 4;
+            const bool isGeneratingMips = (m_mipGeneration == MipGeneration::CPU) || ((m_mipGeneration == MipGeneration::COMPUTE) && (!isStorageCapable || isStreaming()));
+            Application::getJobSystem().submit([this, &addedTexture, textureId, isGeneratingMips] {
+                addedTexture.decode();
+                if (isGeneratingMips)
+                {
+                    addedTexture.generateMips();
+                }
+                addedTexture.convertChannels();
+                std::lock_guard lock{m_decodedMutex};
+                m_decodedTextureIds.push_back(textureId);
+            });
+        }
+
+        return textureId;
+    }
+
+    std::optional<int> MaterialManager::findTexture(uint64_t contentHash, TextureUsage usage)
+    {
+        m_textureCacheLookups++;
+        auto it = m_textureCache.find({contentHash, usage});
+        if (it == m_textureCache.end())
+        {
+            return std::nullopt;
+        }
+
+        m_textureCacheHits.at(it->second)++;
+        return it->second;
+    }
+
+    int MaterialManager::addTexture(const Texture& texture, uint64_t contentHash, TextureUsage usage)
+    {
+        int textureId = addTexture(texture);
+        m_textureCache[{contentHash, usage}] = textureId;
+        return textureId;
+    }
+
+    TextureCacheStats MaterialManager::getTextureCacheStats() const
+    {
+        TextureCacheStats stats{};
+        stats.lookups = m_textureCacheLookups;
+        for (int iTexture = 0; iTexture < m_textures.size(); iTexture++)
+        {
+            stats.hits += m_textureCacheHits.at(iTexture);
+            if (m_isTextureDecoded.at(iTexture)) // size is unknown until then
+            {
+                const auto& texture = m_textures.at(iTexture);
+                stats.bytesSaved += m_textureCacheHits.at(iTexture) * TextureFormat::getInfo(texture.getFormat()).byteSize(texture.getWidth(), texture.getHeight());
+            }
+        }
+        return stats;
+    }
+
+    void MaterialManager::requestTextureSize(int materialIndex, float screenPixels)
+    {
+        if (!isStreaming() || (materialIndex >= m_materialTextureIds.size()))
+        {
+            return;
+        }
+
+        const auto& ids = m_materialTextureIds.at(materialIndex);
+        for (const int textureId : {ids.albedo, ids.metallicRoughness, ids.emissive, ids.occlusion, ids.normal})
+        {
+            if (!m_isTextureDecoded.at(textureId))
+            {
+                continue;
+            }
+
+            // Assumes the texture is mapped once across the mesh, as is usual for uniquely textured glTF assets
+            const auto& texture = m_textures.at(textureId);
+            const float texelsPerPixel = static_cast<float>(std::max(texture.getWidth(), texture.getHeight())) / std::max(screenPixels, 1.0f);
+            const int level = std::clamp(static_cast<int>(std::floor(std::log2(std::max(texelsPerPixel, 1.0f)))), 0, getMaxResidentLevel(textureId));
+
+            // The finest level any material asks for this frame
+            auto& residency = m_textureResidency.at(textureId);
+            residency.requestedLevel = (residency.lastRequestFrame == m_frame) ? std::min(residency.requestedLevel, level) : level;
+            residency.lastRequestFrame = m_frame;
+        }
+    }
+
+    TextureResidencyStats MaterialManager::getTextureResidencyStats() const
     {
-        m_textures.push_back(texture);
-        return static_cast<int>(m_textures.size()) - 1;
+        TextureResidencyStats stats{};
+        stats.budgetBytes = isStreaming() ? m_textureBudget : 0;
+        for (int iTexture = 0; iTexture < m_textures.size(); iTexture++)
+        {
+            if (m_isTextureDecoded.at(iTexture))
+            {
+                const auto& residency = m_textureResidency.at(iTexture);
+                stats.residentBytes += getResidentBytes(iTexture, residency.residentLevel);
+                stats.requestedBytes += getResidentBytes(iTexture, residency.requestedLevel);
+                stats.pendingLevelCount += std::max(0, residency.residentLevel - residency.requestedLevel);
+            }
+        }
+        return stats;
     }
 
     Texture& MaterialManager::getTexture(int index)
     {
         return m_textures.at(index);
     }
+
+    void MaterialManager::createMaterialTable()
+    {
+        if (m_materialInstances.size() > m_materialUniforms.capacity())
+        {
+            spdlog::error("Too many materials: {} (max {})", m_materialInstances.size(), MAX_MATERIALS);
+            return;
+        }
+
+        m_materialTextureIds.clear();
+        for (const auto& materialInstance : m_materialInstances)
+        {
+            MaterialTextureIds ids{};
+            ids.albedo = materialInstance.getAlbedoTextureId().has_value() ? materialInstance.getAlbedoTextureId().value() : getSolidTextureId(m_whiteSrgbTextureId, "White sRGB", true, 255, 255, 255);
+            ids.metallicRoughness = materialInstance.getMetallicRoughnessTextureId().has_value() ? materialInstance.getMetallicRoughnessTextureId().value() : getSolidTextureId(m_whiteLinearTextureId, "White linear", false, 255, 255, 255);
+            ids.emissive = materialInstance.getEmissiveTextureId().has_value() ? materialInstance.getEmissiveTextureId().value() : getSolidTextureId(m_whiteSrgbTextureId, "White sRGB", true, 255, 255, 255);
+            ids.occlusion = materialInstance.getOcclusionTextureId().has_value() ? materialInstance.getOcclusionTextureId().value() : getSolidTextureId(m_whiteLinearTextureId, "White linear", false, 255, 255, 255);
+            ids.normal = materialInstance.getNormalTextureId().has_value() ? materialInstance.getNormalTextureId().value() : getSolidTextureId(m_flatNormalTextureId, "Flat normal", false, 128, 128, 255);
+            m_materialTextureIds.push_back(ids);
+        }
+
+        // Placeholders are the solid textures, so they're needed even when every material has all of its textures
+        getSolidTextureId(m_whiteSrgbTextureId, "White sRGB", true, 255, 255, 255);
+        getSolidTextureId(m_whiteLinearTextureId, "White linear", false, 255, 255, 255);
+        getSolidTextureId(m_flatNormalTextureId, "Flat normal", false, 128, 128, 255);
+
+        m_emptyTextureArray.emplace("Empty texture array", WGPUTextureFormat_RGBA8Unorm, 1, 1, 1);
+        m_textureAtlas.emplace(MAX_TEXTURE_ARRAYS, m_mipGenerator.has_value() ? &m_mipGenerator.value() : nullptr);
+
+        drainDecodedTextures();
+        buildMaterialTable();
+    }
+
+    void MaterialManager::update()
+    {
+        m_frame++;
+
+        // Textures join the atlas as they're decoded, and move between its arrays as their resident size changes
+        bool isChanged = drainDecodedTextures();
+        if (isStreaming() && (m_frame % STREAMING_INTERVAL == 0))
+        {
+            isChanged = updateResidency() || isChanged;
+        }
+        if (isChanged && !m_materialTextureIds.empty())
+        {
+            buildMaterialTable();
+        }
+    }
+
+    int MaterialManager::getPendingTextureCount() const
+    {
+        return m_pendingTextureCount;
+    }
+
+    const BindGroupLayout& MaterialManager::getBindGroupLayout() const
+    {
+        return m_bindGroupLayout;
+    }
+
+    const BindGroup& MaterialManager::getBindGroup() const
+    {
+        return m_bindGroup;
+    }
+
+    bool MaterialManager::drainDecodedTextures()
+    {
+        std::vector<int> decodedTextureIds;
+        {
+            std::lock_guard lock{m_decodedMutex};
+            decodedTextureIds.swap(m_decodedTextureIds);
+        }
+
+        for (int textureId : decodedTextureIds)
+        {
+            m_isTextureDecoded.at(textureId) = true;
+            initTextureResidency(textureId);
+        }
+        m_pendingTextureCount -= static_cast<int>(decodedTextureIds.size());
+        if (!decodedTextureIds.empty() && (m_pendingTextureCount == 0))
+        {
+            const auto stats = getTextureCacheStats();
+            spdlog::info("Texture cache: {} of {} lookups hit, {} bytes saved", stats.hits, stats.lookups, stats.bytesSaved);
+        }
+        return !decodedTextureIds.empty();
+    }
+
+    int MaterialManager::getSolidTextureId(std::optional<int>& textureId, std::string_view name, bool isSrgb, unsigned char r, unsigned char g, unsigned char b)
+    {
+        if (!textureId.has_value())
+        {
+            textureId = addTexture(Texture{name, isSrgb, 1, 1, {r, g, b, 255}});
+        }
+        return textureId.value();
+    }
+
+    glm::uvec2 MaterialManager::getTextureReference(int textureId, int placeholderTextureId) const
+    {
+        const auto& location = m_textureLocations.at(textureId).has_value() ? m_textureLocations.at(textureId) : m_textureLocations.at(placeholderTextureId);
+        return {location->arrayIndex, location->layer};
+    }
+
+    void MaterialManager::buildMaterialTable()
+    {
+        updateTextureArrays();
+
+        for (int iMaterial = 0; iMaterial < m_materialInstances.size(); iMaterial++)
+        {
+            const auto& ids = m_materialTextureIds.at(iMaterial);
+            int uniformIndex = iMaterial < m_materialUniforms.size() ? iMaterial : m_materialUniforms.nextInstanceIndex();
+            MaterialUniform& materialUniform = m_materialUniforms.getInstance(uniformIndex);
+            m_materialInstances.at(iMaterial).fillMaterialUniform(materialUniform);
+            materialUniform.baseColorTexture = getTextureReference(ids.albedo, m_whiteSrgbTextureId.value());
+            materialUniform.metallicRoughnessTexture = getTextureReference(ids.metallicRoughness, m_whiteLinearTextureId.value());
+            materialUniform.emissiveTexture = getTextureReference(ids.emissive, m_whiteSrgbTextureId.value());
+            materialUniform.occlusionTexture = getTextureReference(ids.occlusion, m_whiteLinearTextureId.value());
+            materialUniform.normalTexture = getTextureReference(ids.normal, m_flatNormalTextureId.value());
+
+            // Roughness is the first channel of RG8/BC5 textures, the second of ORM and RGBA placeholders
+            const bool isTwoChannel = m_textureLocations.at(ids.metallicRoughness).has_value() && (TextureFormat::getChannelCount(m_textures.at(ids.metallicRoughness).getFormat()) == 2);
+            materialUniform.metallicRoughnessChannel = isTwoChannel ? 0 : 1;
+        }
+        m_materialUniforms.write(Application::getDevice().getQueue());
+
+        // A single sampler is shared by all materials (previously only the first material's bind group was ever used)
+        const Sampler& sampler = (!m_materialInstances.empty() && m_materialInstances.at(0).getSampler().has_value()) ?
+            m_materialInstances.at(0).getSampler().value() : Sampler::get(resource::JSampler{});
+        for (const auto& materialInstance : m_materialInstances)
+        {
+            if (materialInstance.getSampler().has_value() && (materialInstance.getSampler()->get() != sampler.get()))
+            {
+                spdlog::warn("Materials use different samplers, only the first one is used");
+                break;
+            }
+        }
+
+        m_bindGroup = BindGroup{};
+        m_bindGroup.addSampler(sampler);
+        m_bindGroup.addUniform(m_materialUniforms, 0);
+        for (int iArray = 0; iArray < MAX_TEXTURE_ARRAYS; iArray++)
+        {
+            m_bindGroup.addTextureArray(iArray < m_textureAtlas->getArrayCount() ? m_textureAtlas->getArray(iArray) : m_emptyTextureArray.value());
+        }
+        m_bindGroup.create("Material BindGroup", m_bindGroupLayout);
+    }
+
+    void MaterialManager::updateTextureArrays()
+    {
+        m_textureLocations.resize(m_textures.size());
+        for (int iTexture = 0; iTexture < m_textures.size(); iTexture++)
+        {
+            auto& location = m_textureLocations.at(iTexture);
+            const int residentLevel = m_textureResidency.at(iTexture).residentLevel;
+            if (!m_isTextureDecoded.at(iTexture) || (location.has_value() && (location->residentLevel == residentLevel)))
+            {
+                continue;
+            }
+
+            if (location.has_value())
+            {
+                m_textureAtlas->remove({location->arrayIndex, location->layer});
+                location.reset();
+            }
+
+            auto& texture = m_textures.at(iTexture);
+            if (const auto atlasLocation = m_textureAtlas->add(texture, residentLevel, getArrayMipLevelCount(iTexture)))
+            {
+                location = TextureLocation{atlasLocation->arrayIndex, atlasLocation->layer, residentLevel};
+
+                // The atlas copies layers on the GPU when it grows, so pixels are only needed again to stream levels in
+                if (!isStreaming())
+                {
+                    texture.releasePixels();
+                }
+            }
+        }
+        m_textureAtlas->flush();
+    }
+
+    int MaterialManager::getArrayMipLevelCount(int textureId) const
+    {
+        const auto& texture = m_textures.at(textureId);
+        const int residentLevel = m_textureResidency.at(textureId).residentLevel;
+        if (m_mipGeneration == MipGeneration::NONE)
+        {
+            return 1;
+        }
+
+        // Storage capable arrays can have their mips computed; others only use the mips the textures carry: from
+        // KTX2 files, or generated on the CPU
+        const int mipLevelCount = MipGenerator::getMipLevelCount(std::max(1, texture.getWidth() >> residentLevel), std::max(1, texture.getHeight() >> residentLevel));
+        const bool isStorageCapable = m_mipGenerator.has_value() && !TextureFormat::getInfo(texture.getFormat()).isCompressed() && (TextureFormat::getChannelCount(texture.getFormat()) == 4);
+        return isStorageCapable ? mipLevelCount : std::min(mipLevelCount, texture.getMipLevelCount() - residentLevel);
+    }
+
+    bool MaterialManager::isStreaming() const
+    {
+        // Streaming swaps in mip levels, so without mips everything stays resident
+        return (m_textureBudget > 0) && (m_mipGeneration != MipGeneration::NONE);
+    }
+
+    void MaterialManager::initTextureResidency(int textureId)
+    {
+        const auto& texture = m_textures.at(textureId);
+        const int maxResidentLevel = getMaxResidentLevel(textureId);
+        int level = 0;
+        while ((level < maxResidentLevel) && (std::max(texture.getWidth(), texture.getHeight()) >> level) > INITIAL_RESIDENT_SIZE)
+        {
+            level++;
+        }
+
+        auto& residency = m_textureResidency.at(textureId);
+        residency.residentLevel = level;
+        residency.requestedLevel = level;
+    }
+
+    int MaterialManager::getMaxResidentLevel(int textureId) const
+    {
+        if (!isStreaming())
+        {
+            return 0;
+        }
+
+        // A resident level is level 0 of an array, which must be whole blocks for compressed formats
+        const auto& texture = m_textures.at(textureId);
+        const auto formatInfo = TextureFormat::getInfo(texture.getFormat());
+        int level = 0;
+        while ((level + 1 < texture.getMipLevelCount()) &&
+            (std::max(1, texture.getWidth() >> (level + 1)) % formatInfo.blockWidth == 0) &&
+            (std::max(1, texture.getHeight() >> (level + 1)) % formatInfo.blockHeight == 0))
+        {
+            level++;
+        }
+        return level;
+    }
+
+    uint64_t MaterialManager::getResidentBytes(int textureId, int residentLevel) const
+    {
+        const auto& texture = m_textures.at(textureId);
+        const auto formatInfo = TextureFormat::getInfo(texture.getFormat());
+        uint64_t bytes = 0;
+        for (int level = residentLevel; level < texture.getMipLevelCount(); level++)
+        {
+            bytes += formatInfo.byteSize(std::max(1, texture.getWidth() >> level), std::max(1, texture.getHeight() >> level));
+        }
+        return bytes;
+    }
+
+    bool MaterialManager::updateResidency()
+    {
+        uint64_t residentBytes = 0;
+        std::vector<int> requestedTextureIds;
+        for (int iTexture = 0; iTexture < m_textures.size(); iTexture++)
+        {
+            if (m_isTextureDecoded.at(iTexture))
+            {
+                const auto& residency = m_textureResidency.at(iTexture);
+                residentBytes += getResidentBytes(iTexture, residency.residentLevel);
+                if (residency.requestedLevel < residency.residentLevel)
+                {
+                    requestedTextureIds.push_back(iTexture);
+                }
+            }
+        }
+
+        // Textures seen most recently first, then those furthest from what they need
+        std::ranges::sort(requestedTextureIds, [this](int a, int b) {
+            const auto& residencyA = m_textureResidency.at(a);
+            const auto& residencyB = m_textureResidency.at(b);
+            return std::make_tuple(residencyA.lastRequestFrame, residencyA.residentLevel - residencyA.requestedLevel) >
+                std::make_tuple(residencyB.lastRequestFrame, residencyB.residentLevel - residencyB.requestedLevel);
+        });
+
+        int loadedLevelCount = 0;
+        int evictedLevelCount = 0;
+        for (const int textureId : requestedTextureIds)
+        {
+            auto& residency = m_textureResidency.at(textureId);
+            while ((residency.residentLevel > residency.requestedLevel) && (loadedLevelCount < MAX_LEVELS_PER_UPDATE))
+            {
+                const uint64_t levelBytes = getResidentBytes(textureId, residency.residentLevel - 1) - getResidentBytes(textureId, residency.residentLevel);
+
+                // Evict top mips of the least recently requested textures, or of those finer than they need, to fit
+                while (residentBytes + levelBytes > m_textureBudget)
+                {
+                    std::optional<int> victimId;
+                    for (int iTexture = 0; iTexture < m_textures.size(); iTexture++)
+                    {
+                        const auto& victim = m_textureResidency.at(iTexture);
+                        const bool isEvictable = (iTexture != textureId) && m_isTextureDecoded.at(iTexture) && (victim.residentLevel < getMaxResidentLevel(iTexture)) &&
+                            ((victim.lastRequestFrame < residency.lastRequestFrame) || (victim.residentLevel < victim.requestedLevel));
+                        if (isEvictable && (!victimId.has_value() || (victim.lastRequestFrame < m_textureResidency.at(victimId.value()).lastRequestFrame)))
+                        {
+                            victimId = iTexture;
+                        }
+                    }
+                    if (!victimId.has_value())
+                    {
+                        break;
+                    }
+
+                    auto& victim = m_textureResidency.at(victimId.value());
+                    residentBytes -= getResidentBytes(victimId.value(), victim.residentLevel) - getResidentBytes(victimId.value(), victim.residentLevel + 1);
+                    victim.residentLevel++;
+                    evictedLevelCount++;
+                }
+
+                if (residentBytes + levelBytes > m_textureBudget)
+                {
+                    break;
+                }
+                residency.residentLevel--;
+                residentBytes += levelBytes;
+                loadedLevelCount++;
+            }
+        }
+
+        if (loadedLevelCount + evictedLevelCount > 0)
+        {
+            spdlog::debug("Texture streaming: {} levels loaded, {} evicted, {:.1f} of {} MiB resident", loadedLevelCount, evictedLevelCount, residentBytes / (1024.0 * 1024.0), m_textureBudget / (1024 * 1024));
+        }
+        return loadedLevelCount + evictedLevelCount > 0;
+    }
 }
@@ -1,21 +1,152 @@
 #pragma once
+#include <deque>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <utility>
+
+#include "BindGroup.h"
 #include "MaterialInstance.h"
+#include "MipGenerator.h"
+#include "Texture.h"
+#include "TextureArray.h"
+#include "TextureAtlas.h"
+#include "Uniform.h"
+#include "UniformsAndAttributes.h"
 
 namespace webgpu
 {
+    struct TextureCacheStats
+    {
+        int lookups{0};
+        int hits{0};
+        uint64_t bytesSaved{0}; // texture bytes not uploaded again
+    };
+
+    struct TextureResidencyStats
+    {
+        uint64_t budgetBytes{0}; // 0 when streaming is off
+        uint64_t residentBytes{0};
+        uint64_t requestedBytes{0}; // if every request were served
+        int pendingLevelCount{0}; // mip levels requested but not resident
+    };
+
     class MaterialManager
     {
     public:
+        // Bounded by maxSampledTexturesPerShaderStage; must match the textureArrayN bindings in shader.wgsl
+        static constexpr int MAX_TEXTURE_ARRAYS = 8;
+        static constexpr int MAX_MATERIALS = 256; // the material table's size
+
         MaterialManager();
+        ~MaterialManager();
 
         int addMaterialInstance(const MaterialInstance& materialInstance);
         MaterialInstance& getMaterialInstance(int index);
 
+        // glTF's default material, for primitives without one; added on first use
+        int getDefaultMaterialInstanceIndex();
+
+        // Textures with encoded data are decoded on the job system; until then materials use a placeholder
         int addTexture(const Texture& texture);
         Texture& getTexture(int index);
 
+        // Texture cache keyed by content hash of the encoded image plus usage, so that images shared between
+        // materials or models are decoded and uploaded once
+        std::optional<int> findTexture(uint64_t contentHash, TextureUsage usage);
+        int addTexture(const Texture& texture, uint64_t contentHash, TextureUsage usage);
+        [[nodiscard]] TextureCacheStats getTextureCacheStats() const;
+
+        // Texture streaming: textures start with their low mips resident, and higher mips are made resident as
+        // materials are seen larger on screen, within render.textureBudgetMiB. Call every frame for each visible
+        // material, with the size it covers in pixels.
+        void requestTextureSize(int materialIndex, float screenPixels);
+        [[nodiscard]] TextureResidencyStats getTextureResidencyStats() const;
+
+        // Writes the material table, with placeholders for textures still being decoded. Call once all models are
+        // loaded.
+        void createMaterialTable();
+
+        // Call once per frame. Uploads decoded textures and textures whose residency changed, and rewrites the material
+        // table for them.
+        void update();
+
+        [[nodiscard]] int getPendingTextureCount() const;
+        [[nodiscard]] const BindGroupLayout& getBindGroupLayout() const;
+        [[nodiscard]] const BindGroup& getBindGroup() const;
+
     private:
+        // Largest side resident when a texture is first uploaded
+        static constexpr int INITIAL_RESIDENT_SIZE = 64;
+        // Frames between residency updates
+        static constexpr int STREAMING_INTERVAL = 30;
+        // Mip levels made resident per update, so that a camera cut is spread over several updates
+        static constexpr int MAX_LEVELS_PER_UPDATE = 8;
+
+        struct TextureResidency
+        {
+            int residentLevel{0}; // finest resident mip level
+            int requestedLevel{0};
+            uint64_t lastRequestFrame{0};
+        };
+
+        struct TextureLocation
+        {
+            int arrayIndex{0};
+            int layer{0};
+            int residentLevel{0}; // when it was added to the atlas
+        };
+
+        // Texture ids per material slot; missing textures are replaced by solid 1x1 textures, so that the shader
+        // never has to branch on a slot
+        struct MaterialTextureIds
+        {
+            int albedo;
+            int metallicRoughness;
+            int emissive;
+            int occlusion;
+            int normal;
+        };
+
         std::vector<MaterialInstance> m_materialInstances;
-        std::vector<Texture> m_textures;
+        std::optional<int> m_defaultMaterialInstanceIndex;
+        std::deque<Texture> m_textures; // deque, so decode jobs can hold references while textures are added
+        std::vector<bool> m_isTextureDecoded;
+        std::vector<TextureResidency> m_textureResidency;
+        uint64_t m_textureBudget{0}; // bytes, 0 when streaming is off
+        uint64_t m_frame{0};
+        std::vector<std::optional<TextureLocation>> m_textureLocations;
+        std::map<std::pair<uint64_t, TextureUsage>, int> m_textureCache;
+        std::vector<int> m_textureCacheHits; // per texture id
+        int m_textureCacheLookups{0};
+        std::optional<TextureAtlas> m_textureAtlas;
+        std::optional<TextureArray> m_emptyTextureArray;
+        std::vector<MaterialTextureIds> m_materialTextureIds;
+        Uniform<MaterialUniform> m_materialUniforms;
+        BindGroupLayout m_bindGroupLayout;
+        BindGroup m_bindGroup;
+        MipGeneration m_mipGeneration;
+        std::optional<MipGenerator> m_mipGenerator; // compute mip generation only
+
+        std::mutex m_decodedMutex;
+        std::vector<int> m_decodedTextureIds; // filled by decode jobs, drained by update()
+        int m_pendingTextureCount{0};
+
+        std::optional<int> m_whiteSrgbTextureId;
+        std::optional<int> m_whiteLinearTextureId;
+        std::optional<int> m_flatNormalTextureId;
+
+        bool drainDecodedTextures();
+        int getSolidTextureId(std::optional<int>& textureId, std::string_view name, bool isSrgb, unsigned char r, unsigned char g, unsigned char b);
+        glm::uvec2 getTextureReference(int textureId, int placeholderTextureId) const;
+        void buildMaterialTable();
+        void updateTextureArrays();
+        [[nodiscard]] int getArrayMipLevelCount(int textureId) const;
+
+        [[nodiscard]] bool isStreaming() const;
+        void initTextureResidency(int textureId);
+        [[nodiscard]] int getMaxResidentLevel(int textureId) const;
+        [[nodiscard]] uint64_t getResidentBytes(int textureId, int residentLevel) const;
+        bool updateResidency();
     };
 }
@@ -0,0 +1,266 @@
+#include "MipGenerator.h"
+
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <cmath>
+#include <magic_enum/magic_enum.hpp>
+#include <spdlog/spdlog.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#include "Application.h"
+#include "BindGroup.h"
+#include "Device.h"
+#include "StringView.h"
+#include "TextureArray.h"
+#include "resource/Loader.h"
+#include "resource/Settings.h"
+
+namespace webgpu
+{
+    namespace
+    {
+        const std::array<float, 256>& srgbToLinearTable()
+        {
+            static const auto table = [] {
+                std::array<float, 256> t{};
+                for (int i = 0; i < 256; i++)
+                {
+                    float c = static_cast<float>(i) / 255.0f;
+                    t[i] = (c <= 0.04045f) ? (c / 12.92f) : std::pow((c + 0.055f) / 1.055f, 2.4f);
+                }
+                return t;
+            }();
+            return table;
+        }
+
+        // Indexed by linear * LINEAR_STEPS
+        constexpr int LINEAR_STEPS = 4095;
+
+        const std::array<unsigned char, LINEAR_STEPS + 1>& linearToSrgbTable()
+        {
+            static const auto table = [] {
+                std::array<unsigned char, LINEAR_STEPS + 1> t{};
+                for (int i = 0; i <= LINEAR_STEPS; i++)
+                {
+                    float c = static_cast<float>(i) / LINEAR_STEPS;
+                    float s = (c <= 0.0031308f) ? (c * 12.92f) : (1.055f * std::pow(c, 1.0f / 2.4f) - 0.055f);
+                    t[i] = static_cast<unsigned char>(std::clamp(s * 255.0f + 0.5f, 0.0f, 255.0f));
+                }
+                return t;
+            }();
+            return table;
+        }
+
+        void downsampleLinearPixel(const unsigned char* a, const unsigned char* b, const unsigned char* c, const unsigned char* d, unsigned char* dst)
+        {
+            for (int iChannel = 0; iChannel < 4; iChannel++)
+            {
+                dst[iChannel] = static_cast<unsigned char>((a[iChannel] + b[iChannel] + c[iChannel] + d[iChannel] + 2) >> 2);
+            }
+        }
+
+        void downsampleSrgbPixel(const unsigned char* a, const unsigned char* b, const unsigned char* c, const unsigned char* d, unsigned char* dst)
+        {
+            const auto& toLinear = srgbToLinearTable();
+            const auto& toSrgb = linearToSrgbTable();
+#if defined(__SSE2__)
+            __m128 sum = _mm_setr_ps(toLinear[a[0]], toLinear[a[1]], toLinear[a[2]], a[3] / 255.0f);
+            sum = _mm_add_ps(sum, _mm_setr_ps(toLinear[b[0]], toLinear[b[1]], toLinear[b[2]], b[3] / 255.0f));
+            sum = _mm_add_ps(sum, _mm_setr_ps(toLinear[c[0]], toLinear[c[1]], toLinear[c[2]], c[3] / 255.0f));
+            sum = _mm_add_ps(sum, _mm_setr_ps(toLinear[d[0]], toLinear[d[1]], toLinear[d[2]], d[3] / 255.0f));
+            __m128 scaled = _mm_mul_ps(sum, _mm_setr_ps(0.25f * LINEAR_STEPS, 0.25f * LINEAR_STEPS, 0.25f * LINEAR_STEPS, 0.25f * 255.0f));
+            alignas(16) int32_t rounded[4];
+            _mm_store_si128(reinterpret_cast<__m128i*>(rounded), _mm_cvtps_epi32(scaled));
+            for (int iChannel = 0; iChannel < 3; iChannel++)
+            {
+                dst[iChannel] = toSrgb[std::clamp(rounded[iChannel], 0, LINEAR_STEPS)];
+            }
+            dst[3] = static_cast<unsigned char>(std::clamp(rounded[3], 0, 255));
+#else
+            for (int iChannel = 0; iChannel < 3; iChannel++)
+            {
+                float linear = (toLinear[a[iChannel]] + toLinear[b[iChannel]] + toLinear[c[iChannel]] + toLinear[d[iChannel]]) * 0.25f;
+                dst[iChannel] = toSrgb[std::clamp(static_cast<int>(linear * LINEAR_STEPS + 0.5f), 0, LINEAR_STEPS)];
+            }
+            dst[3] = static_cast<unsigned char>((a[3] + b[3] + c[3] + d[3] + 2) >> 2);
+#endif
+        }
+
+#if defined(__SSE2__)
+        // Two destination pixels from 4x2 source pixels
+        void downsampleLinearPixelPair(const unsigned char* row0, const unsigned char* row1, unsigned char* dst)
+        {
+            const __m128i zero = _mm_setzero_si128();
+            __m128i top = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row0));
+            __m128i bottom = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row1));
+
+            // Vertical sums as 16 bit: source pixels 0,1 and 2,3
+            __m128i sum01 = _mm_add_epi16(_mm_unpacklo_epi8(top, zero), _mm_unpacklo_epi8(bottom, zero));
+            __m128i sum23 = _mm_add_epi16(_mm_unpackhi_epi8(top, zero), _mm_unpackhi_epi8(bottom, zero));
+
+            // Horizontal sums land in the low 4 lanes of each
+            sum01 = _mm_add_epi16(sum01, _mm_srli_si128(sum01, 8));
+            sum23 = _mm_add_epi16(sum23, _mm_srli_si128(sum23, 8));
+
+            __m128i sum = _mm_unpacklo_epi64(sum01, sum23);
+            sum = _mm_srli_epi16(_mm_add_epi16(sum, _mm_set1_epi16(2)), 2);
+            _mm_storel_epi64(reinterpret_cast<__m128i*>(dst), _mm_packus_epi16(sum, zero));
+        }
+#endif
+    }
+
+    MipGenerator::MipGenerator()
+    {
+        WGPUBindGroupLayoutEntry srcEntry{WGPU_BIND_GROUP_LAYOUT_ENTRY_INIT};
+        srcEntry.visibility = WGPUShaderStage_Compute;
+        srcEntry.texture.sampleType = WGPUTextureSampleType_Float;
+        srcEntry.texture.viewDimension = WGPUTextureViewDimension_2DArray;
+        m_bindGroupLayout.addEntry(srcEntry);
+
+        WGPUBindGroupLayoutEntry dstEntry{WGPU_BIND_GROUP_LAYOUT_ENTRY_INIT};
+        dstEntry.visibility = WGPUShaderStage_Compute;
+        dstEntry.storageTexture.access = WGPUStorageTextureAccess_WriteOnly;
+        dstEntry.storageTexture.format = WGPUTextureFormat_RGBA8Unorm;
+        dstEntry.storageTexture.viewDimension = WGPUTextureViewDimension_2DArray;
+        m_bindGroupLayout.addEntry(dstEntry);
+        m_bindGroupLayout.create("Mip BindGroupLayout");
+
+        auto shaderSource = Application::getResourceLoader().getShader("mipmap.wgsl");
+        if (!shaderSource.has_value())
+        {
+            spdlog::error("Mipmap shader not loaded");
+            return;
+        }
+
+        std::vector layouts{m_bindGroupLayout.getBindGroupLayout()};
+        WGPUConstantEntry srgbConstant{WGPU_CONSTANT_ENTRY_INIT};
+        srgbConstant.key = StringView("isSrgb");
+        srgbConstant.value = 1.0;
+        m_linearPass.emplace("Mip generation (linear)", shaderSource->getString(), "cs_main", layouts);
+        m_srgbPass.emplace("Mip generation (sRGB)", shaderSource->getString(), "cs_main", layouts, std::vector{srgbConstant});
+    }
+
+    MipGeneration MipGenerator::getMipGeneration()
+    {
+        auto setting = Application::getSettings().getString("render.mipGeneration").value_or("CPU");
+        std::transform(setting.begin(), setting.end(), setting.begin(), [](unsigned char c) { return std::toupper(c); });
+        return magic_enum::enum_cast<MipGeneration>(setting).value_or(MipGeneration::CPU);
+    }
+
+    int MipGenerator::getMipLevelCount(int width, int height)
+    {
+        int levelCount = 1;
+        for (int size = std::max(width, height); size > 1; size /= 2)
+        {
+            levelCount++;
+        }
+        return levelCount;
+    }
+
+    std::vector<unsigned char> MipGenerator::downsample(const std::vector<unsigned char>& pixels, int width, int height, bool isSrgb)
+    {
+        const int dstWidth = std::max(1, width / 2);
+        const int dstHeight = std::max(1, height / 2);
+        std::vector<unsigned char> dstPixels(static_cast<size_t>(dstWidth) * dstHeight * 4);
+
+        for (int y = 0; y < dstHeight; y++)
+        {
+            // Levels are floor(size / 2), so an odd axis drops its last row/column. The clamp only matters for a 1 texel axis.
+            const unsigned char* row0 = pixels.data() + static_cast<size_t>(std::min(y * 2, height - 1)) * width * 4;
+            const unsigned char* row1 = pixels.data() + static_cast<size_t>(std::min(y * 2 + 1, height - 1)) * width * 4;
+            unsigned char* dst = dstPixels.data() + static_cast<size_t>(y) * dstWidth * 4;
+
+            int x = 0;
+#if defined(__SSE2__)
+            if (!isSrgb)
+            {
+                for (; (x * 2) + 3 < width; x += 2)
+                {
+                    downsampleLinearPixelPair(row0 + x * 8, row1 + x * 8, dst + x * 4);
+                }
+            }
+#endif
+            for (; x < dstWidth; x++)
+            {
+                const int x0 = std::min(x * 2, width - 1) * 4;
+                const int x1 = std::min(x * 2 + 1, width - 1) * 4;
+                if (isSrgb)
+                {
+                    downsampleSrgbPixel(row0 + x0, row0 + x1, row1 + x0, row1 + x1, dst + x * 4);
+                }
+                else
+                {
+                    downsampleLinearPixel(row0 + x0, row0 + x1, row1 + x0, row1 + x1, dst + x * 4);
+                }
+            }
+        }
+
+        return dstPixels;
+    }
+
+    void MipGenerator::generate(const TextureArray& textureArray) const
+    {
+        const bool isSrgb = textureArray.getFormat() == WGPUTextureFormat_RGBA8UnormSrgb;
+        const auto& computePass = isSrgb ? m_srgbPass : m_linearPass;
+        if (!computePass.has_value() || !textureArray.isStorageTarget())
+        {
+            spdlog::error("Cannot generate mips for {}", textureArray.getName());
+            return;
+        }
+
+        auto& device = Application::getDevice();
+        auto commandEncoder = device.createCommandEncoder();
+        std::vector<BindGroup> bindGroups; // kept alive until submit
+
+        auto createView = [&](WGPUTextureFormat format, int mipLevel) {
+            WGPUTextureViewDescriptor textureViewDesc{WGPU_TEXTURE_VIEW_DESCRIPTOR_INIT};
+            textureViewDesc.aspect = WGPUTextureAspect_All;
+            textureViewDesc.baseArrayLayer = 0;
+            textureViewDesc.arrayLayerCount = textureArray.getLayerCount();
+            textureViewDesc.baseMipLevel = mipLevel;
+            textureViewDesc.mipLevelCount = 1;
+            textureViewDesc.dimension = WGPUTextureViewDimension_2DArray;
+            textureViewDesc.format = format;
+            return wgpuTextureCreateView(textureArray.getTexture(), &textureViewDesc);
+        };
+
+        std::vector<WGPUTextureView> views;
+        for (int mipLevel = 1; mipLevel < textureArray.getMipLevelCount(); mipLevel++)
+        {
+            // Reading through the array's own (possibly sRGB) format decodes to linear; writes are always unorm
+            WGPUTextureView srcView = createView(textureArray.getFormat(), mipLevel - 1);
+            WGPUTextureView dstView = createView(WGPUTextureFormat_RGBA8Unorm, mipLevel);
+            views.push_back(srcView);
+            views.push_back(dstView);
+
+            WGPUBindGroupEntry srcEntry{WGPU_BIND_GROUP_ENTRY_INIT};
+            srcEntry.textureView = srcView;
+            WGPUBindGroupEntry dstEntry{WGPU_BIND_GROUP_ENTRY_INIT};
+            dstEntry.textureView = dstView;
+
+            auto& bindGroup = bindGroups.emplace_back();
+            bindGroup.addEntry(srcEntry);
+            bindGroup.addEntry(dstEntry);
+            bindGroup.create("Mip BindGroup", m_bindGroupLayout);
+
+            const uint32_t width = std::max(1, textureArray.getWidth() >> mipLevel);
+            const uint32_t height = std::max(1, textureArray.getHeight() >> mipLevel);
+            computePass->dispatch(commandEncoder.get(), {bindGroup.getBindGroup()}, (width + 7) / 8, (height + 7) / 8, textureArray.getLayerCount());
+        }
+
+        WGPUCommandBufferDescriptor cmdBufferDescriptor{WGPU_COMMAND_BUFFER_DESCRIPTOR_INIT};
+        cmdBufferDescriptor.label = StringView("Mip generation");
+        WGPUCommandBuffer command = wgpuCommandEncoderFinish(commandEncoder.get(), &cmdBufferDescriptor);
+        wgpuQueueSubmit(device.getQueue(), 1, &command);
+        wgpuCommandBufferRelease(command);
+
+        for (auto view : views)
+        {
+            wgpuTextureViewRelease(view);
+        }
+    }
+}
@@ -0,0 +1,40 @@
+#pragma once
+#include <optional>
+#include <vector>
+
+#include "BindGroupLayout.h"
+#include "ComputePass.h"
+
+namespace webgpu
+{
+    class TextureArray;
+
+    enum class MipGeneration
+    {
+        NONE,
+        CPU,     // downsampled on the job system after decode, uploaded with level 0
+        COMPUTE, // downsampled on the GPU after level 0 is uploaded
+    };
+
+    class MipGenerator
+    {
+    public:
+        // Loads the compute shader; only needed for MipGeneration::COMPUTE
+        MipGenerator();
+
+        static MipGeneration getMipGeneration();
+        static int getMipLevelCount(int width, int height);
+
+        // 2x2 box filter of RGBA8 pixels to max(1, width / 2) x max(1, height / 2). sRGB color is averaged in linear
+        // space; alpha is always linear.
+        static std::vector<unsigned char> downsample(const std::vector<unsigned char>& pixels, int width, int height, bool isSrgb);
+
+        // Fills levels 1+ of every layer from level 0
+        void generate(const TextureArray& textureArray) const;
+
+    private:
+        BindGroupLayout m_bindGroupLayout;
+        std::optional<ComputePass> m_linearPass;
+        std::optional<ComputePass> m_srgbPass;
+    };
+}
@@ -3,6 +3,7 @@
 #include <glm/ext/matrix_transform.hpp>
 #include <glm/gtc/quaternion.hpp>
 #include <magic_enum/magic_enum.hpp>
+#include <spdlog/spdlog.h>
 
 #include "Application.h"
 #include "Device.h"
@@ -10,13 +11,17 @@
 #include "ModelManager.h"
 #include "Sampler.h"
 #include "Texture.h"
+#include "TextureCooker.h"
 #include "UniformsAndAttributes.h"
+#include "Util.h"
+#include "resource/Loader.h"
 #include "resource/RawResource.h"
 #include "resource/GltfResource.h"
+#include "resource/Settings.h"
 
 namespace webgpu
 {
-    Model::Model(const resource::GltfResource& res) : m_gltfRes{res}, m_gltf{res.getGltf()}
+    Model::Model(const resource::GltfResource& res) : m_gltfRes{res}, m_gltf{res.getGltf()}, m_firstMaterialInstanceIndex{-1}
     {
         const auto& mainScene = m_gltf.scenes.at(m_gltf.scene);
 
@@ -25,6 +30,7 @@ namespace webgpu
         m_vertexBuffer = std::make_shared<GpuBuffer>(m_name + " vertex buffer", WGPUBufferUsage_Vertex | WGPUBufferUsage_CopyDst);
         m_attributeBuffer = std::make_shared<GpuBuffer>(m_name + " attribute buffer", WGPUBufferUsage_Vertex | WGPUBufferUsage_CopyDst);
 
+        const bool isPackingOrm = Application::getSettings().getBool("render.packOrm").value_or(true);
         for (const auto& jMaterial : res.getGltf().materials)
         {
             Material& material = Material::get(jMaterial);
@@ -33,16 +39,29 @@ namespace webgpu
             // TODO
             const Sampler& sampler = Sampler::get(res.getGltf().samplers.at(res.getGltf().textures.at(jMaterial.pbrMetallicRoughness.baseColorTexture.index).sampler));
 
+            materialInstance.setFactors(jMaterial);
             materialInstance.setSampler(sampler);
-            materialInstance.setAlbedoTextureId(getTextureId(res, jMaterial.pbrMetallicRoughness.baseColorTexture, true));
-            materialInstance.setMetallicRoughnessTextureId(getTextureId(res, jMaterial.pbrMetallicRoughness.metallicRoughnessTexture, false));
-            materialInstance.setEmissiveTextureId(getTextureId(res, jMaterial.emissiveTexture, true));
-            materialInstance.setOcclusionTextureId(getTextureId(res, jMaterial.occlusionTexture, false));
-            materialInstance.setNormalTextureId(getTextureId(res, jMaterial.normalTexture, false));
-            materialInstance.create();
+            materialInstance.setAlbedoTextureId(getTextureId(res, jMaterial.pbrMetallicRoughness.baseColorTexture, TextureUsage::COLOR));
+            materialInstance.setEmissiveTextureId(getTextureId(res, jMaterial.emissiveTexture, TextureUsage::COLOR));
+            if (isPackingOrm && res.hasOrmImage(jMaterial))
+            {
+                const auto ormTextureId = getTextureId(res, jMaterial.occlusionTexture, TextureUsage::ORM);
+                materialInstance.setMetallicRoughnessTextureId(ormTextureId);
+                materialInstance.setOcclusionTextureId(ormTextureId);
+            }
+            else
+            {
+                materialInstance.setMetallicRoughnessTextureId(getTextureId(res, jMaterial.pbrMetallicRoughness.metallicRoughnessTexture, TextureUsage::METALLIC_ROUGHNESS));
+                materialInstance.setOcclusionTextureId(getTextureId(res, jMaterial.occlusionTexture, TextureUsage::OCCLUSION));
+            }
+            materialInstance.setNormalTextureId(getTextureId(res, jMaterial.normalTexture, TextureUsage::NORMAL));
 
             // TODO
-            Application::getMaterialManager().addMaterialInstance(materialInstance);
+            int materialInstanceIndex = Application::getMaterialManager().addMaterialInstance(materialInstance);
+            if (m_firstMaterialInstanceIndex == -1)
+            {
+                m_firstMaterialInstanceIndex = materialInstanceIndex;
+            }
         }
 
 
@@ -103,7 +122,7 @@ namespace webgpu
         }
     }
 
-    std::optional<int> Model::getTextureId(const resource::GltfResource& gltfRes, const resource::JTextureInfo& textureInfo, bool isSrgb)
+    std::optional<int> Model::getTextureId(const resource::GltfResource& gltfRes, const resource::JTextureInfo& textureInfo, TextureUsage usage)
     {
         if (textureInfo.index == -1)
         {
@@ -117,6 +136,21 @@ namespace webgpu
         auto& sampler = Sampler::get(jSampler); // TODO
         auto& jImage = gltf.images.at(jTexture.source);
 
+        const auto imageBytes = gltfRes.getImageBytes(jImage);
+        if (imageBytes.empty())
+        {
+            // Not hashed, since every missing image would share the empty hash; the material gets a placeholder
+            spdlog::error("{}: no data for image {}", gltfRes.getName(), jImage.name.empty() ? jImage.uri : jImage.name);
+            return std::nullopt;
+        }
+
+        auto& materialManager = Application::getMaterialManager();
+        uint64_t contentHash = Util::hashBytes(imageBytes.data(), imageBytes.size());
+        if (auto cachedTextureId = materialManager.findTexture(contentHash, usage))
+        {
+            return cachedTextureId;
+        }
+
         std::string textureName;
         if (!jTexture.name.empty())
         {
@@ -131,16 +165,19 @@ namespace webgpu
             textureName = "Texture: " + std::to_string(jTexture.source);
         }
 
-        auto texture = Texture{textureName, isSrgb};
-
-        const auto& bufferView = gltf.bufferViews.at(jImage.bufferView);
-        const auto& buffer = gltf.buffers.at(bufferView.buffer);
-        const auto& bufferRes = gltfRes.getBuffers().at(buffer.uri);
-
-        texture.addData(bufferRes, 1, bufferView.byteLength, bufferView.byteOffset, bufferView.byteStride);
-        texture.load();
+        // Decoded and uploaded by MaterialManager when the material table is created. Prefer the output of
+        // texture-cook, which is already compressed and mip-mapped.
+        auto texture = Texture{textureName, usage};
+        if (auto cookedRes = Application::getResourceLoader().getTexture(TextureCooker::getCookedName(contentHash, usage)))
+        {
+            texture.addData(cookedRes.value(), 1, static_cast<int>(cookedRes->getBytes().size()), 0, 0);
+        }
+        else
+        {
+            texture.addData(imageBytes.data(), 1, static_cast<int>(imageBytes.size()), 0, 0);
+        }
 
-        int textureId = Application::getMaterialManager().addTexture(texture);
+        int textureId = materialManager.addTexture(texture, contentHash, usage);
         return std::make_optional(textureId);
     }
 
@@ -171,7 +208,7 @@ namespace webgpu
         attr1->bitangent = B;
     }
 
-    Mesh::Mesh(const Model* model, const resource::JGltf& gltf, const resource::JMeshPrimitive& primitive)
+    Mesh::Mesh(const Model* model, const resource::JGltf& gltf, const resource::JMeshPrimitive& primitive) : m_modelUniformIndex{-1}, m_boundsMin{0}, m_boundsMax{0}
     {
         const auto& indexAccessor = gltf.accessors.at(primitive.indices);
         const auto& positionAccessor = gltf.accessors.at(primitive.attributes.at("POSITION"));
@@ -181,6 +218,18 @@ namespace webgpu
         m_indexCount = indexAccessor.count;
         m_indexOffset = model->m_indexBuffer->currentElementOffset();
         m_vertexOffset = model->m_vertexBuffer->currentElementOffset();
+        auto& materialManager = Application::getMaterialManager();
+        m_materialInstanceIndex = (primitive.material >= 0) ? model->m_firstMaterialInstanceIndex + primitive.material : materialManager.getDefaultMaterialInstanceIndex();
+        if ((positionAccessor.min.size() == 3) && (positionAccessor.max.size() == 3)) // required by glTF for POSITION
+        {
+            m_boundsMin = {positionAccessor.min.at(0), positionAccessor.min.at(1), positionAccessor.min.at(2)};
+            m_boundsMax = {positionAccessor.max.at(0), positionAccessor.max.at(1), positionAccessor.max.at(2)};
+        }
+
+        m_featureKey = materialManager.getMaterialInstance(m_materialInstanceIndex).getMaterial().getFeatureKey();
+        m_featureKey.vertexAttributes |= primitive.attributes.contains("NORMAL") ? MaterialFeatureKey::VERTEX_NORMAL : 0;
+        m_featureKey.vertexAttributes |= primitive.attributes.contains("TANGENT") ? MaterialFeatureKey::VERTEX_TANGENT : 0;
+        m_featureKey.vertexAttributes |= primitive.attributes.contains("TEXCOORD_0") ? MaterialFeatureKey::VERTEX_TEXCOORD : 0;
 
         loadBuffer(model, model->m_indexBuffer, gltf, indexAccessor);
         loadBuffer(model, model->m_vertexBuffer, gltf, positionAccessor);
@@ -215,11 +264,7 @@ namespace webgpu
 
     Node::Node(const Model* model, const resource::JGltf& gltf, const resource::JNode& jNode, const glm::mat4& parentModelMatrix)
     {
-        auto& uniforms = Application::getModelManager().getModelUniforms();
-        m_modelUniformIndex = uniforms.nextInstanceIndex();
-        glm::mat4x4 modelMatrix = parentModelMatrix * loadModelMatrix(jNode);
-        uniforms.getInstance(m_modelUniformIndex).matrix = modelMatrix;
-        uniforms.getInstance(m_modelUniformIndex).normalMatrix = Util::modelToNormalMatrix(modelMatrix);
+        m_modelMatrix = parentModelMatrix * loadModelMatrix(jNode);
 
         if (jNode.mesh != -1)
         {
@@ -234,7 +279,7 @@ namespace webgpu
         for (int iNode : jNode.children)
         {
             const auto& childJNode = gltf.nodes.at(iNode);
-            Node child(model, gltf, childJNode, modelMatrix);
+            Node child(model, gltf, childJNode, m_modelMatrix);
             m_children.push_back(child);
         }
     }
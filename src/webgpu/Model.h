@@ -4,6 +4,8 @@
 #include <glm/glm.hpp>
 #include <glm/ext/matrix_transform.hpp>
 
+#include "Material.h"
+#include "TextureCooker.h"
 #include "resource/GltfResource.h"
 
 struct VertexAttributes;
@@ -34,6 +36,11 @@ namespace webgpu
         uint32_t m_indexCount;
         uint64_t m_indexOffset;
         uint64_t m_vertexOffset;
+        int m_materialInstanceIndex;
+        int m_modelUniformIndex; // assigned by ModelManager when draw batches are built
+        MaterialFeatureKey m_featureKey; // the material's features plus this primitive's vertex attributes
+        glm::vec3 m_boundsMin; // model space, from the POSITION accessor
+        glm::vec3 m_boundsMax;
 
         static void loadBuffer(const Model* model, const std::shared_ptr<GpuBuffer>& gpuBuffer, const resource::JGltf& gltf, const resource::JAccessor& accessor);
         static void loadAttributeBuffer(const Model* model, const std::shared_ptr<GpuBuffer>& gpuBuffer, const resource::JGltf& gltf, const resource::JAccessor& accessor, uint64_t elementIndex, int elementSize, int attributeOffset, int attributeSize);
@@ -45,7 +52,7 @@ namespace webgpu
         Node(const Model* model, const resource::JGltf& gltf, const resource::JNode& jNode, const glm::mat4& parentModelMatrix);
 
     //private: // TODO
-        int m_modelUniformIndex;
+        glm::mat4 m_modelMatrix;
         std::vector<Mesh> m_meshes;
         std::vector<Node> m_children;
 
@@ -68,10 +75,11 @@ namespace webgpu
         std::shared_ptr<GpuBuffer> m_indexBuffer;
         std::shared_ptr<GpuBuffer> m_vertexBuffer;
         std::shared_ptr<GpuBuffer> m_attributeBuffer;
+        int m_firstMaterialInstanceIndex;
 
         std::map<int, int> m_gltfTextureToTextureId;
 
-        std::optional<int> getTextureId(const resource::GltfResource& gltfRes, const resource::JTextureInfo& textureInfo, bool isSrgb);
+        std::optional<int> getTextureId(const resource::GltfResource& gltfRes, const resource::JTextureInfo& textureInfo, TextureUsage usage);
         static void calcTangents(glm::f32vec3* pos1, glm::f32vec3* pos2, glm::f32vec3* pos3, VertexAttributes* attr1, VertexAttributes* attr2, VertexAttributes* attr3);
     };
 }
@@ -1,13 +1,32 @@
 #include "ModelManager.h"
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <map>
+#include <tuple>
 #include <spdlog/spdlog.h>
+#include "MaterialManager.h"
+#include "RenderManager.h"
 #include "resource/Loader.h"
+#include "resource/Settings.h"
 
 namespace webgpu
 {
-    ModelManager::ModelManager() : m_modelUniforms{1000} // TODO
+    ModelManager::ModelManager()
+        : m_modelUniforms{1, WGPUBufferBindingType_ReadOnlyStorage}, // sized for the scene by buildDrawBatches()
+          m_instanceIndices{1, WGPUBufferBindingType_ReadOnlyStorage}
     {
-        m_modelBindGroupLayout.addUniform(m_modelUniforms);
+        // Group 2 of the scene shader
+        if (const auto* reflection = Application::getRenderManager().getSceneReflection())
+        {
+            m_modelUniforms.validate(*reflection, 2, 0);
+            m_instanceIndices.validate(*reflection, 2, 1);
+            m_modelBindGroupLayout.addBindings(*reflection, 2);
+        }
         m_modelBindGroupLayout.create("Model BindGroupLayout");
+
+        m_isMergingDraws = Application::getSettings().getBool("render.mergeDraws").value_or(true);
+        m_isGpuCullingEnabled = Application::getSettings().getBool("render.gpuCulling").value_or(true);
     }
 
     void ModelManager::loadModels()
@@ -35,25 +54,168 @@ namespace webgpu
 
     void ModelManager::createBindGroups()
     {
+        buildDrawBatches();
+
         const auto& device = Application::getDevice();
         m_modelUniforms.write(device.getQueue()); // TODO - move?
+        m_instanceIndices.write(device.getQueue());
 
-        for (int iUniform = 0; iUniform < m_modelUniforms.size(); iUniform++)
+        m_modelBindGroup.addUniform(m_modelUniforms, 0);
+        m_modelBindGroup.addUniform(m_instanceIndices, 0);
+        m_modelBindGroup.create("Model uniforms", m_modelBindGroupLayout);
+
+        if (!InstanceCulling::isSupported())
         {
-            BindGroup bindGroup;
-            bindGroup.addUniform(m_modelUniforms, iUniform);
-            bindGroup.create("Model uniform: " + std::to_string(iUniform), m_modelBindGroupLayout);
-            m_modelBindGroups.push_back(bindGroup);
+            spdlog::info("GPU culling isn't supported");
+            return;
         }
+
+        m_instanceCulling.emplace(Application::getRenderManager().getShaderPreprocessor(), m_drawBatches, m_meshBounds);
+
+        WGPUBindGroupEntry instanceIndicesEntry{WGPU_BIND_GROUP_ENTRY_INIT};
+        instanceIndicesEntry.buffer = m_instanceCulling->getInstanceIndexBuffer();
+        instanceIndicesEntry.size = wgpuBufferGetSize(instanceIndicesEntry.buffer);
+        m_culledModelBindGroup.addUniform(m_modelUniforms, 0);
+        m_culledModelBindGroup.addEntry(instanceIndicesEntry);
+        m_culledModelBindGroup.create("Culled model uniforms", m_modelBindGroupLayout);
     }
 
-    BindGroup& ModelManager::getBindGroup(int index)
+    void ModelManager::buildDrawBatches()
     {
-        return m_modelBindGroups.at(index);
+        // Meshes that share an index/vertex range can be drawn with one instanced DrawIndexed, as long as their model
+        // uniforms are contiguous. Group them here, then hand out uniform slots batch by batch. The feature key comes
+        // first, so that batches sharing a pipeline variant are adjacent and opaque ones are drawn before blended ones.
+        using BatchKey = std::tuple<MaterialFeatureKey, int, uint64_t, uint64_t, uint32_t>;
+        std::map<BatchKey, std::vector<std::pair<Mesh*, glm::mat4>>> batches;
+
+        std::function<void(int, Node&)> collectNode = [&](int modelIndex, Node& node)
+        {
+            for (auto& mesh : node.m_meshes)
+            {
+                BatchKey key{mesh.m_featureKey, modelIndex, mesh.m_indexOffset, mesh.m_vertexOffset, mesh.m_indexCount};
+                batches[key].emplace_back(&mesh, node.m_modelMatrix);
+            }
+            for (auto& child : node.m_children)
+            {
+                collectNode(modelIndex, child);
+            }
+        };
+
+        for (int iModel = 0; iModel < m_models.size(); iModel++)
+        {
+            for (auto& node : m_models.at(iModel).m_nodes)
+            {
+                collectNode(iModel, node);
+            }
+        }
+
+        int instanceCount = 0;
+        for (const auto& [key, meshes] : batches)
+        {
+            instanceCount += static_cast<int>(meshes.size());
+        }
+        if (instanceCount > MAX_INSTANCES)
+        {
+            spdlog::error("{} instances, but only {} fit in the model uniforms", instanceCount, MAX_INSTANCES);
+        }
+
+        // The instance culling buffers are sized from these too
+        m_modelUniforms = Uniform<ModelUniform>{std::clamp(instanceCount, 1, MAX_INSTANCES), WGPUBufferBindingType_ReadOnlyStorage};
+        m_instanceIndices = Uniform<uint32_t>{m_modelUniforms.capacity(), WGPUBufferBindingType_ReadOnlyStorage};
+
+        m_drawBatches.clear();
+        m_drawBatchesVersion++;
+        m_meshBounds.clear();
+        for (const auto& [key, meshes] : batches)
+        {
+            const auto& [featureKey, modelIndex, indexOffset, vertexOffset, indexCount] = key;
+
+            // Checked before any of the batch is written, so that the bounds and uniforms only hold whole batches
+            if (m_modelUniforms.size() + static_cast<int>(meshes.size()) > m_modelUniforms.capacity())
+            {
+                spdlog::error("Out of model uniforms ({})", m_modelUniforms.capacity());
+                return;
+            }
+
+            DrawBatch batch{};
+            batch.featureKey = featureKey;
+            batch.modelIndex = modelIndex;
+            batch.indexCount = indexCount;
+            batch.firstIndex = static_cast<uint32_t>(indexOffset);
+            batch.baseVertex = static_cast<int32_t>(vertexOffset);
+            batch.firstInstance = m_modelUniforms.size();
+            batch.instanceCount = meshes.size();
+
+            for (const auto& [mesh, modelMatrix] : meshes)
+            {
+                mesh->m_modelUniformIndex = m_modelUniforms.nextInstanceIndex();
+                m_instanceIndices.getInstance(m_instanceIndices.nextInstanceIndex()) = mesh->m_modelUniformIndex;
+                ModelUniform& modelUniform = m_modelUniforms.getInstance(mesh->m_modelUniformIndex);
+                modelUniform.matrix = modelMatrix;
+                modelUniform.normalMatrix = Util::modelToNormalMatrix(modelMatrix);
+                modelUniform.materialIndex = mesh->m_materialInstanceIndex;
+
+                // Scaled by the longest axis, so that the sphere still encloses the mesh
+                const glm::vec3 localCenter = (mesh->m_boundsMin + mesh->m_boundsMax) * 0.5f;
+                const float maxScale = std::max({glm::length(glm::vec3{modelMatrix[0]}), glm::length(glm::vec3{modelMatrix[1]}), glm::length(glm::vec3{modelMatrix[2]})});
+                m_meshBounds.push_back({glm::vec3{modelMatrix * glm::vec4{localCenter, 1.0f}}, glm::length(mesh->m_boundsMax - localCenter) * maxScale, mesh->m_materialInstanceIndex});
+            }
+
+            m_drawBatches.push_back(batch);
+        }
+
+        spdlog::info("{} instances in {} draw batches (merging {})", m_modelUniforms.size(), m_drawBatches.size(), m_isMergingDraws ? "on" : "off");
+    }
+
+    BindGroup& ModelManager::getBindGroup()
+    {
+        return (getInstanceCulling() != nullptr) ? m_culledModelBindGroup : m_modelBindGroup;
     }
 
     Model& ModelManager::getModel(int index) // TODO - remove?
     {
         return m_models.at(index);
     }
+
+    const std::vector<DrawBatch>& ModelManager::getDrawBatches() const
+    {
+        return m_drawBatches;
+    }
+
+    uint64_t ModelManager::getDrawBatchesVersion() const
+    {
+        return m_drawBatchesVersion;
+    }
+
+    bool ModelManager::isMergingDraws() const
+    {
+        return m_isMergingDraws;
+    }
+
+    bool ModelManager::isGpuCullingEnabled() const
+    {
+        return m_isGpuCullingEnabled;
+    }
+
+    void ModelManager::setGpuCullingEnabled(bool isEnabled)
+    {
+        m_isGpuCullingEnabled = isEnabled;
+    }
+
+    InstanceCulling* ModelManager::getInstanceCulling()
+    {
+        return (m_isGpuCullingEnabled && m_instanceCulling.has_value()) ? &m_instanceCulling.value() : nullptr;
+    }
+
+    void ModelManager::requestTextureMips(const glm::vec3& cameraPosition, float fieldOfView, int screenHeight) const
+    {
+        auto& materialManager = Application::getMaterialManager();
+        const float pixelsPerUnit = static_cast<float>(screenHeight) / (2.0f * std::tan(fieldOfView / 2.0f));
+        for (const auto& bounds : m_meshBounds)
+        {
+            // Inside the sphere the mesh can fill the screen
+            const float distance = std::max(glm::length(bounds.center - cameraPosition), bounds.radius);
+            materialManager.requestTextureSize(bounds.materialInstanceIndex, 2.0f * bounds.radius * pixelsPerUnit / distance);
+        }
+    }
 }
@@ -1,14 +1,41 @@
 #pragma once
+#include <optional>
 #include "BindGroup.h"
+#include "InstanceCulling.h"
 #include "Uniform.h"
 #include "UniformsAndAttributes.h"
 #include "Model.h"
 
 namespace webgpu
 {
+    // One DrawIndexed worth of work: the same mesh range drawn for a contiguous range of model uniforms. Each model
+    // uniform carries its own material index, so instances in a batch may use different materials, but they share the
+    // feature key that selects the pipeline variant. Batches are ordered by feature key, so blended ones come last.
+    struct DrawBatch
+    {
+        MaterialFeatureKey featureKey;
+        int modelIndex;
+        uint32_t indexCount;
+        uint32_t firstIndex;
+        int32_t baseVertex;
+        uint32_t firstInstance;
+        uint32_t instanceCount;
+    };
+
+    // World space bounding sphere of a mesh instance, for texture streaming
+    struct MeshBounds
+    {
+        glm::vec3 center;
+        float radius;
+        int materialInstanceIndex;
+    };
+
     class ModelManager
     {
     public:
+        // As many model uniforms as WebGPU's default maxStorageBufferBindingSize holds
+        static constexpr int MAX_INSTANCES = static_cast<int>((128 << 20) / sizeof(ModelUniform));
+
         ModelManager();
 
         void loadModels();
@@ -18,13 +45,37 @@ namespace webgpu
 
         void createBindGroups();
 
-        BindGroup& getBindGroup(int index);
+        BindGroup& getBindGroup(); // for the culling in use
         Model& getModel(int index);
 
+        [[nodiscard]] const std::vector<DrawBatch>& getDrawBatches() const;
+        [[nodiscard]] uint64_t getDrawBatchesVersion() const; // changes whenever the batches are rebuilt
+        [[nodiscard]] bool isMergingDraws() const;
+
+        // Takes effect from the next frame. Without GPU support, instances aren't culled.
+        [[nodiscard]] bool isGpuCullingEnabled() const;
+        void setGpuCullingEnabled(bool isEnabled);
+
+        // nullptr unless culling on the GPU
+        InstanceCulling* getInstanceCulling();
+
+        // Requests the texture mips each visible material needs, from its meshes' projected size on screen
+        void requestTextureMips(const glm::vec3& cameraPosition, float fieldOfView, int screenHeight) const;
+
     private:
         std::vector<Model> m_models;
         Uniform<ModelUniform> m_modelUniforms;
+        Uniform<uint32_t> m_instanceIndices; // every model uniform in order, for drawing without GPU culling
         BindGroupLayout m_modelBindGroupLayout;
-        std::vector<BindGroup> m_modelBindGroups;
+        BindGroup m_modelBindGroup;
+        BindGroup m_culledModelBindGroup; // with the visible instances instead
+        std::vector<DrawBatch> m_drawBatches;
+        uint64_t m_drawBatchesVersion{0};
+        std::vector<MeshBounds> m_meshBounds;
+        bool m_isMergingDraws;
+        bool m_isGpuCullingEnabled;
+        std::optional<InstanceCulling> m_instanceCulling;
+
+        void buildDrawBatches();
     };
 }
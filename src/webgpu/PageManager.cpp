@@ -0,0 +1,173 @@
+#include "PageManager.h"
+
+#include <algorithm>
+#include <utility>
+
+namespace webgpu
+{
+    PageManager::PageManager(const VirtualTextureLayout& layout, int physicalPageCountX, int physicalPageCountY)
+    : m_layout{layout}, m_physicalPageCountX{physicalPageCountX}, m_physicalPages(static_cast<size_t>(physicalPageCountX) * physicalPageCountY)
+    {
+    }
+
+    std::vector<PageRequest> PageManager::analyzeFeedback(std::span<const uint32_t> feedback, const VirtualTextureLayout& layout)
+    {
+        std::map<PageId, int> sampleCounts;
+        for (const uint32_t packed : feedback)
+        {
+            const auto page = PageId::unpack(packed);
+            if (page.has_value() && layout.isValid(page.value()))
+            {
+                sampleCounts[page.value()]++;
+            }
+        }
+
+        // Ancestors count the samples of all of their descendants, so levels are added finest first
+        const int mipLevelCount = layout.getMipLevelCount();
+        for (int mipLevel = 0; mipLevel + 1 < mipLevelCount; mipLevel++)
+        {
+            std::vector<std::pair<PageId, int>> levelCounts;
+            for (const auto& [page, sampleCount] : sampleCounts)
+            {
+                if (page.mipLevel == mipLevel)
+                {
+                    levelCounts.emplace_back(page, sampleCount);
+                }
+            }
+            for (const auto& [page, sampleCount] : levelCounts)
+            {
+                sampleCounts[page.getParent()] += sampleCount;
+            }
+        }
+
+        std::vector<PageRequest> requests;
+        requests.reserve(sampleCounts.size());
+        for (const auto& [page, sampleCount] : sampleCounts)
+        {
+            requests.push_back({page, sampleCount});
+        }
+        std::ranges::stable_sort(requests, [](const PageRequest& a, const PageRequest& b) {
+            return (a.page.mipLevel != b.page.mipLevel) ? (a.page.mipLevel > b.page.mipLevel) : (a.sampleCount > b.sampleCount);
+        });
+        return requests;
+    }
+
+    std::vector<PageId> PageManager::update(std::span<const PageRequest> requests, int maxLoadCount)
+    {
+        m_frame++;
+
+        std::vector<PageId> loads;
+        for (const auto& request : requests)
+        {
+            if (auto it = m_residentPages.find(request.page); it != m_residentPages.end())
+            {
+                m_physicalPages.at(it->second).lastUsedFrame = m_frame;
+            }
+            else if ((loads.size() < maxLoadCount) && m_loadingPages.insert(request.page).second)
+            {
+                loads.push_back(request.page);
+            }
+        }
+        return loads;
+    }
+
+    std::optional<int> PageManager::makeResident(const PageId& page)
+    {
+        m_loadingPages.erase(page);
+        if (auto it = m_residentPages.find(page); it != m_residentPages.end())
+        {
+            return it->second;
+        }
+
+        // A free physical page, else the least recently used one that is neither in use this frame nor pinned
+        std::optional<int> physicalPage;
+        for (int iPage = 0; iPage < m_physicalPages.size(); iPage++)
+        {
+            const auto& candidate = m_physicalPages.at(iPage);
+            if (!candidate.page.has_value())
+            {
+                physicalPage = iPage;
+                break;
+            }
+            if ((candidate.lastUsedFrame < m_frame) && !isPinned(candidate.page.value()) &&
+                (!physicalPage.has_value() || (candidate.lastUsedFrame < m_physicalPages.at(physicalPage.value()).lastUsedFrame)))
+            {
+                physicalPage = iPage;
+            }
+        }
+        if (!physicalPage.has_value())
+        {
+            return std::nullopt;
+        }
+
+        auto& target = m_physicalPages.at(physicalPage.value());
+        if (target.page.has_value())
+        {
+            m_residentPages.erase(target.page.value());
+            m_evictionCount++;
+        }
+        target.page = page;
+        target.lastUsedFrame = m_frame;
+        m_residentPages[page] = physicalPage.value();
+        return physicalPage;
+    }
+
+    void PageManager::cancelLoad(const PageId& page)
+    {
+        m_loadingPages.erase(page);
+    }
+
+    std::optional<int> PageManager::getPhysicalPage(const PageId& page) const
+    {
+        if (auto it = m_residentPages.find(page); it != m_residentPages.end())
+        {
+            return it->second;
+        }
+        return std::nullopt;
+    }
+
+    int PageManager::getPhysicalPageCountX() const
+    {
+        return m_physicalPageCountX;
+    }
+
+    std::vector<uint32_t> PageManager::buildPageTable(int mipLevel) const
+    {
+        const int pageCountX = m_layout.getPageCountX(mipLevel);
+        const int pageCountY = m_layout.getPageCountY(mipLevel);
+        std::vector<uint32_t> pageTable(static_cast<size_t>(pageCountX) * pageCountY, 0);
+        for (int y = 0; y < pageCountY; y++)
+        {
+            for (int x = 0; x < pageCountX; x++)
+            {
+                for (PageId page{static_cast<uint32_t>(x), static_cast<uint32_t>(y), static_cast<uint32_t>(mipLevel)}; m_layout.isValid(page); page = page.getParent())
+                {
+                    if (auto physicalPage = getPhysicalPage(page))
+                    {
+                        const uint32_t physicalX = physicalPage.value() % m_physicalPageCountX;
+                        const uint32_t physicalY = physicalPage.value() / m_physicalPageCountX;
+                        pageTable.at(static_cast<size_t>(y) * pageCountX + x) = physicalX | (physicalY << 8) | (page.mipLevel << 16) | (255u << 24);
+                        break;
+                    }
+                }
+            }
+        }
+        return pageTable;
+    }
+
+    PageManagerStats PageManager::getStats() const
+    {
+        PageManagerStats stats{};
+        stats.residentPageCount = static_cast<int>(m_residentPages.size());
+        stats.physicalPageCount = static_cast<int>(m_physicalPages.size());
+        stats.loadingPageCount = static_cast<int>(m_loadingPages.size());
+        stats.evictionCount = m_evictionCount;
+        return stats;
+    }
+
+    bool PageManager::isPinned(const PageId& page) const
+    {
+        // The single page of the coarsest level is the fallback of last resort
+        return page.mipLevel + 1 == m_layout.getMipLevelCount();
+    }
+}
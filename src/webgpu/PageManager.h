@@ -0,0 +1,72 @@
+#pragma once
+#include <cstdint>
+#include <map>
+#include <optional>
+#include <set>
+#include <span>
+#include <vector>
+
+#include "VirtualTextureLayout.h"
+
+namespace webgpu
+{
+    struct PageRequest
+    {
+        PageId page;
+        int sampleCount{0};
+    };
+
+    struct PageManagerStats
+    {
+        int residentPageCount{0};
+        int physicalPageCount{0};
+        int loadingPageCount{0};
+        int evictionCount{0};
+    };
+
+    // CPU side residency of a virtual texture's pages in a cache of physical pages. Knows nothing of the GPU, so that
+    // it can be driven by synthetic feedback in tests.
+    class PageManager
+    {
+    public:
+        PageManager(const VirtualTextureLayout& layout, int physicalPageCountX, int physicalPageCountY);
+
+        // Counts the pages in a feedback buffer of packed PageIds and adds their ancestors, so that a coarser page is
+        // always there to fall back to. Sorted coarsest first, then by sample count.
+        static std::vector<PageRequest> analyzeFeedback(std::span<const uint32_t> feedback, const VirtualTextureLayout& layout);
+
+        // Marks resident pages as used this frame and returns up to maxLoadCount pages to load, in request order
+        std::vector<PageId> update(std::span<const PageRequest> requests, int maxLoadCount);
+
+        // Once a page has loaded: assigns a physical page, evicting the least recently used page that wasn't used this
+        // frame. nullopt when every physical page is in use, in which case the page is requested again later.
+        std::optional<int> makeResident(const PageId& page);
+        void cancelLoad(const PageId& page);
+
+        [[nodiscard]] std::optional<int> getPhysicalPage(const PageId& page) const;
+        [[nodiscard]] int getPhysicalPageCountX() const;
+
+        // One entry per page of the level, for the page table texture: RGBA8 of the physical page x and y, the mip
+        // level of the finest resident page covering it, and 255 when there is one.
+        [[nodiscard]] std::vector<uint32_t> buildPageTable(int mipLevel) const;
+
+        [[nodiscard]] PageManagerStats getStats() const;
+
+    private:
+        struct PhysicalPage
+        {
+            std::optional<PageId> page;
+            uint64_t lastUsedFrame{0};
+        };
+
+        VirtualTextureLayout m_layout;
+        int m_physicalPageCountX;
+        std::vector<PhysicalPage> m_physicalPages;
+        std::map<PageId, int> m_residentPages;
+        std::set<PageId> m_loadingPages;
+        uint64_t m_frame{0};
+        int m_evictionCount{0};
+
+        [[nodiscard]] bool isPinned(const PageId& page) const;
+    };
+}
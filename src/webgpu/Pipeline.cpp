@@ -1,6 +1,9 @@
 #include "Pipeline.h"
 
+#include <algorithm>
+#include <optional>
 #include <vector>
+#include <spdlog/spdlog.h>
 
 #include "Application.h"
 #include "Device.h"
@@ -10,109 +13,209 @@
 #include "RenderManager.h"
 #include "StringView.h"
 #include "UniformsAndAttributes.h"
+#include "job/JobSystem.h"
+#include "resource/Settings.h"
 
 namespace webgpu
 {
-    Pipeline::Pipeline(const RenderPass& renderPass, WGPUTextureFormat colorTextureFormat, std::string_view shaderSource) : m_renderPass{renderPass}
+    namespace
     {
-    	auto& device = Application::getDevice();
-
-        WGPUBlendState blendState{WGPU_BLEND_STATE_INIT};
-		blendState.color = { WGPUBlendOperation_Add, WGPUBlendFactor_One, WGPUBlendFactor_OneMinusSrcAlpha };
-		blendState.alpha = { WGPUBlendOperation_Add, WGPUBlendFactor_One, WGPUBlendFactor_OneMinusSrcAlpha };
-
-		WGPUColorTargetState colorTarget{WGPU_COLOR_TARGET_STATE_INIT};
-		colorTarget.format = colorTextureFormat;
-		colorTarget.blend = &blendState;
-
-		WGPUDepthStencilState depthStencilState{WGPU_DEPTH_STENCIL_STATE_INIT};
-		depthStencilState.depthCompare = WGPUCompareFunction_Less;
-		depthStencilState.depthWriteEnabled = WGPUOptionalBool_True;
-		depthStencilState.format = WGPUTextureFormat_Depth24Plus;
-
-		WGPUShaderSourceWGSL wgslDesc{WGPU_SHADER_SOURCE_WGSL_INIT};
-		wgslDesc.code = StringView(shaderSource);
-		WGPUShaderModuleDescriptor shaderDesc{WGPU_SHADER_MODULE_DESCRIPTOR_INIT};
-		shaderDesc.nextInChain = &wgslDesc.chain; // connect the chained extension
-		shaderDesc.label = StringView("shader");
-		WGPUShaderModule shaderModule = wgpuDeviceCreateShaderModule(device.get(), &shaderDesc);
-
-		WGPUVertexAttribute positionAttribute{WGPU_VERTEX_ATTRIBUTE_INIT};
-		positionAttribute.shaderLocation = 0;
-		positionAttribute.format = WGPUVertexFormat_Float32x3;
-		positionAttribute.offset = 0;
-
-		auto positionAttributes = std::vector { positionAttribute };
+        std::string_view getFragmentEntryPoint(GLAlphaMode alphaMode, bool isGBuffer)
+        {
+            if (isGBuffer)
+            {
+                return (alphaMode == GLAlphaMode::MASK) ? "fs_gbuffer_mask" : "fs_gbuffer";
+            }
+
+            switch (alphaMode)
+            {
+                case GLAlphaMode::MASK:
+                    return "fs_mask";
+                case GLAlphaMode::BLEND:
+                    return "fs_blend";
+                default:
+                    return "fs_main";
+            }
+        }
+
+        // Render passes and render bundles record the same commands through different entry points
+        void setPipeline(WGPURenderPassEncoder encoder, WGPURenderPipeline pipeline)
+        {
+            wgpuRenderPassEncoderSetPipeline(encoder, pipeline);
+        }
+
+        void setPipeline(WGPURenderBundleEncoder encoder, WGPURenderPipeline pipeline)
+        {
+            wgpuRenderBundleEncoderSetPipeline(encoder, pipeline);
+        }
+
+        void setBindGroup(WGPURenderPassEncoder encoder, uint32_t groupIndex, WGPUBindGroup bindGroup)
+        {
+            wgpuRenderPassEncoderSetBindGroup(encoder, groupIndex, bindGroup, 0, nullptr);
+        }
+
+        void setBindGroup(WGPURenderBundleEncoder encoder, uint32_t groupIndex, WGPUBindGroup bindGroup)
+        {
+            wgpuRenderBundleEncoderSetBindGroup(encoder, groupIndex, bindGroup, 0, nullptr);
+        }
+
+        void setVertexBuffer(WGPURenderPassEncoder encoder, uint32_t slot, WGPUBuffer buffer)
+        {
+            wgpuRenderPassEncoderSetVertexBuffer(encoder, slot, buffer, 0, wgpuBufferGetSize(buffer));
+        }
+
+        void setVertexBuffer(WGPURenderBundleEncoder encoder, uint32_t slot, WGPUBuffer buffer)
+        {
+            wgpuRenderBundleEncoderSetVertexBuffer(encoder, slot, buffer, 0, wgpuBufferGetSize(buffer));
+        }
+
+        void setIndexBuffer(WGPURenderPassEncoder encoder, WGPUBuffer buffer, WGPUIndexFormat format)
+        {
+            wgpuRenderPassEncoderSetIndexBuffer(encoder, buffer, format, 0, wgpuBufferGetSize(buffer));
+        }
+
+        void setIndexBuffer(WGPURenderBundleEncoder encoder, WGPUBuffer buffer, WGPUIndexFormat format)
+        {
+            wgpuRenderBundleEncoderSetIndexBuffer(encoder, buffer, format, 0, wgpuBufferGetSize(buffer));
+        }
+
+        void drawIndexed(WGPURenderPassEncoder encoder, uint32_t indexCount, uint32_t instanceCount, uint32_t firstIndex, int32_t baseVertex, uint32_t firstInstance)
+        {
+            wgpuRenderPassEncoderDrawIndexed(encoder, indexCount, instanceCount, firstIndex, baseVertex, firstInstance);
+        }
+
+        void drawIndexed(WGPURenderBundleEncoder encoder, uint32_t indexCount, uint32_t instanceCount, uint32_t firstIndex, int32_t baseVertex, uint32_t firstInstance)
+        {
+            wgpuRenderBundleEncoderDrawIndexed(encoder, indexCount, instanceCount, firstIndex, baseVertex, firstInstance);
+        }
+
+        void drawIndexedIndirect(WGPURenderPassEncoder encoder, WGPUBuffer indirectBuffer, uint64_t indirectOffset)
+        {
+            wgpuRenderPassEncoderDrawIndexedIndirect(encoder, indirectBuffer, indirectOffset);
+        }
+
+        void drawIndexedIndirect(WGPURenderBundleEncoder encoder, WGPUBuffer indirectBuffer, uint64_t indirectOffset)
+        {
+            wgpuRenderBundleEncoderDrawIndexedIndirect(encoder, indirectBuffer, indirectOffset);
+        }
+    }
 
-		WGPUVertexBufferLayout vertexBufferLayout{WGPU_VERTEX_BUFFER_LAYOUT_INIT};
-		vertexBufferLayout.attributeCount = positionAttributes.size();
-		vertexBufferLayout.attributes = positionAttributes.data();
-		vertexBufferLayout.arrayStride = 3 * sizeof(float);
-		vertexBufferLayout.stepMode = WGPUVertexStepMode_Vertex;
+    Pipeline::Pipeline(const RenderPass& renderPass, WGPUTextureFormat colorTextureFormat, std::string_view shaderName)
+    : m_renderPass{renderPass}, m_colorTextureFormat{colorTextureFormat}, m_shaderName{shaderName}
+    {
+    	auto& device = Application::getDevice();
 
-		WGPUVertexAttribute normalAttribute{WGPU_VERTEX_ATTRIBUTE_INIT};
-		normalAttribute.shaderLocation = 1;
-		normalAttribute.format = WGPUVertexFormat_Float32x3;
-		normalAttribute.offset = offsetof(VertexAttributes, normal);
+    	m_isUsingRenderBundles = Application::getSettings().getBool("render.renderBundles").value_or(true);
+#ifdef __EMSCRIPTEN__
+    	m_isEncodingInParallel = false;
+#else
+    	m_isEncodingInParallel = Application::getSettings().getBool("render.parallelEncoding").value_or(true) &&
+    		device.hasFeature(WGPUFeatureName_ImplicitDeviceSynchronization) && (Application::getJobSystem().getThreadCount() > 0);
+#endif
 
-		WGPUVertexAttribute tangentAttribute{WGPU_VERTEX_ATTRIBUTE_INIT};
-		tangentAttribute.shaderLocation = 2;
-		tangentAttribute.format = WGPUVertexFormat_Float32x3;
-		tangentAttribute.offset = offsetof(VertexAttributes, tangent);
+    	WGPUPipelineLayout pipelineLayout = createPipelineLayout(device);
+    	m_pipelineLayout = std::shared_ptr<WGPUPipelineLayoutImpl>(pipelineLayout, [](WGPUPipelineLayout l) { wgpuPipelineLayoutRelease(l); });
 
-		WGPUVertexAttribute bitangentAttribute{WGPU_VERTEX_ATTRIBUTE_INIT};
-		bitangentAttribute.shaderLocation = 3;
-		bitangentAttribute.format = WGPUVertexFormat_Float32x3;
-		bitangentAttribute.offset = offsetof(VertexAttributes, bitangent);
+    	// Start compiling what the scene needs now, rather than when it's first drawn. The depth pre-pass and
+    	// G-buffer variants too, so that turning them on doesn't wait for them.
+    	for (const auto& batch : Application::getModelManager().getDrawBatches())
+    	{
+    		if (isGBufferPipeline())
+    		{
+    			if (isDeferrable(batch.featureKey))
+    			{
+    				requestVariant(batch.featureKey);
+    				requestVariant(getFallbackKey(batch.featureKey));
+    			}
+    			continue;
+    		}
+
+    		requestVariant(batch.featureKey);
+    		requestVariant(getFallbackKey(batch.featureKey));
+    		if (isDepthPrePassed(batch.featureKey))
+    		{
+    			requestVariant(batch.featureKey, VariantKind::SHADED_DEPTH_EQUAL);
+    			requestVariant(getFallbackKey(batch.featureKey), VariantKind::SHADED_DEPTH_EQUAL);
+    			requestVariant(batch.featureKey, VariantKind::DEPTH_ONLY);
+    		}
+    	}
+    }
 
-		WGPUVertexAttribute texCoordAttribute{WGPU_VERTEX_ATTRIBUTE_INIT};
-		texCoordAttribute.shaderLocation = 4;
-		texCoordAttribute.format = WGPUVertexFormat_Float32x2;
-		texCoordAttribute.offset = offsetof(VertexAttributes, texCoord);
+    WGPURenderPipeline Pipeline::getVariant(const MaterialFeatureKey& featureKey)
+    {
+    	return getVariant(featureKey, VariantKind::SHADED);
+    }
 
-		auto vertexAttributes = std::vector { normalAttribute, tangentAttribute, bitangentAttribute, texCoordAttribute };
+    WGPURenderPipeline Pipeline::getVariant(const MaterialFeatureKey& featureKey, VariantKind kind)
+    {
+    	const auto& pipelineCache = Application::getRenderManager().getPipelineCache();
+    	if (WGPURenderPipeline pipeline = pipelineCache.get(requestVariant(featureKey, kind)))
+    	{
+    		return pipeline;
+    	}
 
-		WGPUVertexBufferLayout vertexAttributeBufferLayout{WGPU_VERTEX_BUFFER_LAYOUT_INIT};
-		vertexAttributeBufferLayout.attributeCount = vertexAttributes.size();
-		vertexAttributeBufferLayout.attributes = vertexAttributes.data();
-		vertexAttributeBufferLayout.arrayStride = sizeof(VertexAttributes);
-		vertexAttributeBufferLayout.stepMode = WGPUVertexStepMode_Vertex;
+    	// Depth-only variants don't depend on the texture slots, so they have no fallback
+    	return (kind != VariantKind::DEPTH_ONLY) ? pipelineCache.get(requestVariant(getFallbackKey(featureKey), kind)) : nullptr;
+    }
 
-		std::vector bufferLayouts{vertexBufferLayout, vertexAttributeBufferLayout};
+    ShaderDefines Pipeline::getShaderDefines(const MaterialFeatureKey& featureKey)
+    {
+    	auto hasSlot = [&featureKey](uint32_t slot) { return ((featureKey.textureSlots & slot) != 0) ? "1" : "0"; };
+    	return {
+    		{"HAS_ALBEDO_TEXTURE", hasSlot(MaterialFeatureKey::ALBEDO_TEXTURE)},
+    		{"HAS_METALLIC_ROUGHNESS_TEXTURE", hasSlot(MaterialFeatureKey::METALLIC_ROUGHNESS_TEXTURE)},
+    		{"HAS_NORMAL_TEXTURE", hasSlot(MaterialFeatureKey::NORMAL_TEXTURE)},
+    		{"HAS_OCCLUSION_TEXTURE", hasSlot(MaterialFeatureKey::OCCLUSION_TEXTURE)},
+    		{"HAS_EMISSIVE_TEXTURE", hasSlot(MaterialFeatureKey::EMISSIVE_TEXTURE)}};
+    }
 
-    	WGPUVertexState vertexState{WGPU_VERTEX_STATE_INIT};
-    	vertexState.module = shaderModule;
-    	vertexState.entryPoint = StringView("vs_main");
-    	vertexState.bufferCount = bufferLayouts.size();
-    	vertexState.buffers = bufferLayouts.data();
+    ShaderDefines Pipeline::getLayoutDefines()
+    {
+    	return getShaderDefines(getFallbackKey(MaterialFeatureKey{}));
+    }
 
-    	WGPUFragmentState fragmentState{WGPU_FRAGMENT_STATE_INIT};
-    	fragmentState.module = shaderModule;
-    	fragmentState.entryPoint = StringView("fs_main");
-    	fragmentState.targetCount = 1;
-    	fragmentState.targets = &colorTarget;
+    MaterialFeatureKey Pipeline::getFallbackKey(const MaterialFeatureKey& featureKey)
+    {
+    	// Every texture slot sampled, with placeholders standing in for missing textures, gives the same image
+    	auto fallbackKey = featureKey;
+    	fallbackKey.textureSlots = MaterialFeatureKey::ALBEDO_TEXTURE | MaterialFeatureKey::METALLIC_ROUGHNESS_TEXTURE |
+    		MaterialFeatureKey::NORMAL_TEXTURE | MaterialFeatureKey::OCCLUSION_TEXTURE | MaterialFeatureKey::EMISSIVE_TEXTURE;
+    	return fallbackKey;
+    }
 
-    	WGPUPipelineLayout pipelineLayout = createPipelineLayout(device);
+    bool Pipeline::isDepthPrePassed(const MaterialFeatureKey& featureKey)
+    {
+    	// Masked materials would need their alpha test in the pre-pass, and blended ones don't write depth
+    	return featureKey.alphaMode == GLAlphaMode::OPAQUE;
+    }
 
-    	WGPURenderPipelineDescriptor pipelineDesc{WGPU_RENDER_PIPELINE_DESCRIPTOR_INIT};
-    	pipelineDesc.vertex = vertexState;
-    	pipelineDesc.fragment = &fragmentState;
-    	pipelineDesc.depthStencil = &depthStencilState;
-    	pipelineDesc.primitive.frontFace = WGPUFrontFace_CCW;
-    	pipelineDesc.primitive.cullMode = WGPUCullMode_Back;
-    	pipelineDesc.multisample.count = 4;
-    	pipelineDesc.layout = pipelineLayout;
+    bool Pipeline::isDeferrable(const MaterialFeatureKey& featureKey)
+    {
+    	// Blended surfaces need what's behind them, which the G-buffer only holds one of
+    	return featureKey.alphaMode != GLAlphaMode::BLEND;
+    }
 
-    	WGPURenderPipeline pipeline = wgpuDeviceCreateRenderPipeline(device.get(), &pipelineDesc);
-    	m_renderPipeline = std::shared_ptr<WGPURenderPipelineImpl>(pipeline, [](WGPURenderPipeline p) { wgpuRenderPipelineRelease(p); });
+    bool Pipeline::isGBufferPipeline() const
+    {
+    	return m_renderPass.getStage() == RenderPassStage::G_BUFFER;
+    }
 
-    	wgpuPipelineLayoutRelease(pipelineLayout);
-    	wgpuShaderModuleRelease(shaderModule);
+    uint32_t Pipeline::getSampleCount() const
+    {
+    	// Deferred lighting reads the G-buffer per pixel
+    	return isGBufferPipeline() ? 1 : SAMPLE_COUNT;
     }
 
-    WGPURenderPipeline Pipeline::get() const
+    uint64_t Pipeline::requestVariant(const MaterialFeatureKey& featureKey, VariantKind kind)
     {
-	    return m_renderPipeline.get();
+    	auto& variantHashes = m_variantHashes.at(static_cast<int>(kind));
+    	auto it = variantHashes.find(featureKey);
+    	if (it == variantHashes.end())
+    	{
+    		const uint64_t pipelineHash = Application::getRenderManager().getPipelineCache().request(createVariantState(featureKey, kind));
+    		it = variantHashes.emplace(featureKey, pipelineHash).first;
+    	}
+    	return it->second;
     }
 
     const RenderPass& Pipeline::getRenderPass() const
@@ -122,46 +225,340 @@ namespace webgpu
 
     void Pipeline::run(WGPURenderPassEncoder renderPassEncoder)
     {
-    	auto& model = Application::getModelManager().getModel(0); // TODO
-    	wgpuRenderPassEncoderSetVertexBuffer(renderPassEncoder, 0, model.m_vertexBuffer->getGpuBuffer(), 0, wgpuBufferGetSize(model.m_vertexBuffer->getGpuBuffer()));
-    	wgpuRenderPassEncoderSetVertexBuffer(renderPassEncoder, 1, model.m_attributeBuffer->getGpuBuffer(), 0, wgpuBufferGetSize(model.m_attributeBuffer->getGpuBuffer()));
-    	wgpuRenderPassEncoderSetIndexBuffer(renderPassEncoder, model.m_indexBuffer->getGpuBuffer(), model.m_indexBuffer->getIndexFormat(), 0, wgpuBufferGetSize(model.m_indexBuffer->getGpuBuffer()));
+    	// The pre-pass's bundles are only replaced when it draws, so they're released here once it's off. It doesn't
+    	// run with deferred shading, whose G-buffer pass writes the depth.
+    	const auto& renderManager = Application::getRenderManager();
+    	if (!renderManager.isDepthPrePassEnabled() || (renderManager.getShadingPath() == ShadingPath::DEFERRED))
+    	{
+    		std::erase_if(m_bundleSets, [](const BundleSet& set) { return set.inputs.isDepthPrePass; });
+    	}
+    	draw(renderPassEncoder, getDrawInputs(false));
+    }
 
-    	for (const auto& node : model.m_nodes)
+    void Pipeline::runDepthPrePass(WGPURenderPassEncoder renderPassEncoder)
+    {
+    	draw(renderPassEncoder, getDrawInputs(true));
+    }
+
+    void Pipeline::draw(WGPURenderPassEncoder renderPassEncoder, DrawInputs inputs)
+    {
+    	if (!m_isUsingRenderBundles)
+    	{
+    		encode(renderPassEncoder, Application::getModelManager().getDrawBatches(), inputs);
+    		return;
+    	}
+
+    	auto bundleSet = std::ranges::find(m_bundleSets, inputs, &BundleSet::inputs);
+    	if (bundleSet == m_bundleSets.end())
     	{
-    		drawNode(renderPassEncoder, node);
+    		// The other frames' sets stay valid if they only differ in the frame bind group, and the other pass's are
+    		// checked when it draws
+    		std::erase_if(m_bundleSets, [&](const BundleSet& set) {
+    			auto setInputs = set.inputs;
+    			setInputs.frameBindGroup = inputs.frameBindGroup;
+    			return (setInputs.isDepthPrePass == inputs.isDepthPrePass) && (setInputs != inputs);
+    		});
+    		m_bundleSets.push_back(recordRenderBundles(std::move(inputs)));
+    		bundleSet = std::prev(m_bundleSets.end());
     	}
+
+    	std::vector<WGPURenderBundle> renderBundles;
+    	for (const auto& renderBundle : bundleSet->renderBundles)
+    	{
+    		renderBundles.push_back(renderBundle.get());
+    	}
+    	wgpuRenderPassEncoderExecuteBundles(renderPassEncoder, renderBundles.size(), renderBundles.data());
     }
 
-    void Pipeline::drawNode(const WGPURenderPassEncoder& renderPassEncoder, const Node& node)
+    Pipeline::DrawInputs Pipeline::getDrawInputs(bool isDepthPrePass)
     {
-    	auto& materialBindGroup = Application::getMaterialManager().getMaterialInstance(0).getBindGroup(); // TODO
-    	auto& modelBindGroup = Application::getModelManager().getBindGroup(node.m_modelUniformIndex);
+    	auto& modelManager = Application::getModelManager();
 
-    	wgpuRenderPassEncoderSetBindGroup(renderPassEncoder, 1, materialBindGroup.getBindGroup(), 0, nullptr);
-    	wgpuRenderPassEncoderSetBindGroup(renderPassEncoder, 2, modelBindGroup.getBindGroup(), 0, nullptr);
+    	// Only the distinct feature keys are resolved each frame, so checking the bundles doesn't cost per draw
+    	if (modelManager.getDrawBatchesVersion() != m_drawFeatureKeysVersion)
+    	{
+    		m_drawFeatureKeysVersion = modelManager.getDrawBatchesVersion();
+    		m_drawFeatureKeys.clear();
+    		for (const auto& batch : modelManager.getDrawBatches())
+    		{
+    			if (m_drawFeatureKeys.empty() || (m_drawFeatureKeys.back() != batch.featureKey))
+    			{
+    				m_drawFeatureKeys.push_back(batch.featureKey);
+    			}
+    		}
+    	}
 
-    	for (const auto& mesh : node.m_meshes)
+    	DrawInputs inputs;
+    	inputs.frameBindGroup = Application::getRenderManager().getFrameBindGroup().getBindGroup();
+    	inputs.materialBindGroup = Application::getMaterialManager().getBindGroup().getBindGroup();
+    	inputs.modelBindGroup = modelManager.getBindGroup().getBindGroup();
+    	inputs.indirectBuffer = (modelManager.getInstanceCulling() != nullptr) ? modelManager.getInstanceCulling()->getIndirectBuffer() : nullptr;
+    	inputs.drawBatchesVersion = modelManager.getDrawBatchesVersion();
+    	inputs.isDepthPrePass = isDepthPrePass;
+
+    	// Both passes resolve the same way within a frame, since pipelines only become ready between frames
+    	const bool isDepthPrePassEnabled = Application::getRenderManager().isDepthPrePassEnabled();
+    	const bool isDeferred = Application::getRenderManager().getShadingPath() == ShadingPath::DEFERRED;
+    	for (const auto& featureKey : m_drawFeatureKeys)
     	{
-    		wgpuRenderPassEncoderDrawIndexed(renderPassEncoder, mesh.m_indexCount, 1, mesh.m_indexOffset, static_cast<int32_t>(mesh.m_vertexOffset), 0);
+    		// With deferred shading, the surfaces drawn into the G-buffer are lit by DeferredLighting instead of the
+    		// main pass
+    		if (isGBufferPipeline() || (isDeferred && isDeferrable(featureKey)))
+    		{
+    			const bool isDrawn = isGBufferPipeline() && isDeferrable(featureKey);
+    			inputs.pipelines.push_back(isDrawn ? getVariant(featureKey, VariantKind::SHADED) : nullptr);
+    			continue;
+    		}
+
+    		WGPURenderPipeline depthPipeline = nullptr;
+    		WGPURenderPipeline depthEqualPipeline = nullptr;
+    		if (isDepthPrePassEnabled && isDepthPrePassed(featureKey))
+    		{
+    			depthPipeline = getVariant(featureKey, VariantKind::DEPTH_ONLY);
+    			depthEqualPipeline = getVariant(featureKey, VariantKind::SHADED_DEPTH_EQUAL);
+    		}
+
+    		const bool isPrePassed = (depthPipeline != nullptr) && (depthEqualPipeline != nullptr);
+    		if (isDepthPrePass)
+    		{
+    			inputs.pipelines.push_back(isPrePassed ? depthPipeline : nullptr);
+    		}
+    		else
+    		{
+    			inputs.pipelines.push_back(isPrePassed ? depthEqualPipeline : getVariant(featureKey, VariantKind::SHADED));
+    		}
     	}
+    	return inputs;
+    }
+
+    Pipeline::BundleSet Pipeline::recordRenderBundles(DrawInputs inputs) const
+    {
+    	const auto& batches = Application::getModelManager().getDrawBatches();
+    	int bundleCount = 1;
+    	if (m_isEncodingInParallel)
+    	{
+    		bundleCount = std::clamp(static_cast<int>(batches.size()) / MIN_BATCHES_PER_BUNDLE, 1, Application::getJobSystem().getThreadCount() + 1);
+    	}
+
+    	WGPURenderBundleEncoderDescriptor encoderDesc{WGPU_RENDER_BUNDLE_ENCODER_DESCRIPTOR_INIT};
+    	encoderDesc.label = StringView("Scene render bundle encoder");
+    	encoderDesc.colorFormatCount = inputs.isDepthPrePass ? 0 : 1;
+    	encoderDesc.colorFormats = inputs.isDepthPrePass ? nullptr : &m_colorTextureFormat;
+    	encoderDesc.depthStencilFormat = DEPTH_FORMAT;
+    	encoderDesc.sampleCount = getSampleCount();
+
+    	// Contiguous ranges, so that executing the bundles in order draws the batches in order
+    	BundleSet bundleSet;
+    	bundleSet.renderBundles.assign(bundleCount, nullptr);
+    	auto recordRange = [&](int iBundle) {
+    		const size_t first = batches.size() * iBundle / bundleCount;
+    		const size_t last = batches.size() * (iBundle + 1) / bundleCount;
+
+    		WGPURenderBundleEncoder bundleEncoder = wgpuDeviceCreateRenderBundleEncoder(Application::getDevice().get(), &encoderDesc);
+    		encode(bundleEncoder, std::span{batches}.subspan(first, last - first), inputs);
+
+    		WGPURenderBundleDescriptor bundleDesc{WGPU_RENDER_BUNDLE_DESCRIPTOR_INIT};
+    		bundleDesc.label = StringView("Scene render bundle");
+    		WGPURenderBundle renderBundle = wgpuRenderBundleEncoderFinish(bundleEncoder, &bundleDesc);
+    		wgpuRenderBundleEncoderRelease(bundleEncoder);
+    		bundleSet.renderBundles.at(iBundle) = std::shared_ptr<WGPURenderBundleImpl>(renderBundle, [](WGPURenderBundle b) { wgpuRenderBundleRelease(b); });
+    	};
+
+    	if (bundleCount > 1)
+    	{
+    		Application::getJobSystem().parallelFor(bundleCount, recordRange);
+    	}
+    	else
+    	{
+    		recordRange(0);
+    	}
+
+    	bundleSet.inputs = std::move(inputs);
+    	spdlog::debug("Recorded {} draw batches into {} render bundles", batches.size(), bundleCount);
+    	return bundleSet;
+    }
+
+    // Only reads what it's given and the batches' models, so that workers can record bundles in parallel
+    template <typename Encoder>
+    void Pipeline::encode(Encoder encoder, std::span<const DrawBatch> batches, const DrawInputs& inputs) const
+    {
+    	auto& modelManager = Application::getModelManager();
 
-    	for (const auto& child : node.m_children)
+    	// Bundles don't inherit bind groups from the pass that executes them, so every group is set here
+    	setBindGroup(encoder, 0, inputs.frameBindGroup);
+    	setBindGroup(encoder, 1, inputs.materialBindGroup);
+    	setBindGroup(encoder, 2, inputs.modelBindGroup);
+
+    	int currentModelIndex = -1;
+    	std::optional<MaterialFeatureKey> currentFeatureKey;
+    	WGPURenderPipeline currentPipeline = nullptr;
+    	for (const auto& batch : batches)
     	{
-    		drawNode(renderPassEncoder, child);
+    		if (batch.featureKey != currentFeatureKey)
+    		{
+    			const auto keyIt = std::ranges::find(m_drawFeatureKeys, batch.featureKey);
+    			currentPipeline = (keyIt != m_drawFeatureKeys.end()) ? inputs.pipelines.at(keyIt - m_drawFeatureKeys.begin()) : nullptr;
+    			if (currentPipeline != nullptr)
+    			{
+    				setPipeline(encoder, currentPipeline);
+    			}
+    			currentFeatureKey = batch.featureKey;
+    		}
+
+    		// Neither the variant nor its fallback has finished compiling
+    		if (currentPipeline == nullptr)
+    		{
+    			continue;
+    		}
+
+    		if (batch.modelIndex != currentModelIndex)
+    		{
+    			auto& model = modelManager.getModel(batch.modelIndex);
+    			setVertexBuffer(encoder, 0, model.m_vertexBuffer->getGpuBuffer());
+    			if (!inputs.isDepthPrePass)
+    			{
+    				setVertexBuffer(encoder, 1, model.m_attributeBuffer->getGpuBuffer());
+    			}
+    			setIndexBuffer(encoder, model.m_indexBuffer->getGpuBuffer(), model.m_indexBuffer->getIndexFormat());
+    			currentModelIndex = batch.modelIndex;
+    		}
+
+    		// The instance count is only known on the GPU
+    		if (inputs.indirectBuffer != nullptr)
+    		{
+    			const uint64_t batchIndex = &batch - modelManager.getDrawBatches().data();
+    			drawIndexedIndirect(encoder, inputs.indirectBuffer, batchIndex * InstanceCulling::DRAW_ARGS_SIZE);
+    		}
+    		else if (modelManager.isMergingDraws())
+    		{
+    			drawIndexed(encoder, batch.indexCount, batch.instanceCount, batch.firstIndex, batch.baseVertex, batch.firstInstance);
+    		}
+    		else
+    		{
+    			for (uint32_t iInstance = 0; iInstance < batch.instanceCount; iInstance++)
+    			{
+    				drawIndexed(encoder, batch.indexCount, 1, batch.firstIndex, batch.baseVertex, batch.firstInstance + iInstance);
+    			}
+    		}
     	}
     }
 
-    WGPUPipelineLayout Pipeline::createPipelineLayout(const Device& device) const
+    WGPUPipelineLayout Pipeline::createPipelineLayout(const Device& device)
     {
-    	const BindGroupLayout& frameBindGroupLayout = Application::getRenderManager().getFrameBindGroupLayout();
-    	const BindGroupLayout& materialBindGroupLayout = Application::getMaterialManager().getMaterialInstance(0).getMaterial().getBindGroupLayout();
-    	const BindGroupLayout& modelBindGroupLayout = Application::getModelManager().getBindGroupLayout();
-		std::vector layouts{frameBindGroupLayout.getBindGroupLayout(), materialBindGroupLayout.getBindGroupLayout(), modelBindGroupLayout.getBindGroupLayout()};
+    	// Layouts are shared by content, so the groups that RenderManager, MaterialManager and ModelManager reflected
+    	// from the same shader come back as their layout objects, and their bind groups are compatible
+    	const auto* reflection = Application::getRenderManager().getShaderReflection(m_shaderName, getLayoutDefines());
+    	int groupCount = 0;
+    	if (reflection != nullptr)
+    	{
+    		for (const auto& binding : reflection->getBindings())
+    		{
+    			groupCount = std::max(groupCount, binding.group + 1);
+    		}
+    	}
+
+		std::vector<WGPUBindGroupLayout> layouts;
+    	for (int iGroup = 0; iGroup < groupCount; iGroup++)
+    	{
+    		BindGroupLayout& bindGroupLayout = m_bindGroupLayouts.emplace_back();
+    		bindGroupLayout.addBindings(*reflection, iGroup);
+    		bindGroupLayout.create(fmt::format("{} group {}", m_shaderName, iGroup));
+    		layouts.push_back(bindGroupLayout.getBindGroupLayout());
+    	}
 
 		WGPUPipelineLayoutDescriptor pipelineLayoutDescriptor = WGPU_PIPELINE_LAYOUT_DESCRIPTOR_INIT;
 		pipelineLayoutDescriptor.bindGroupLayoutCount = layouts.size();
 		pipelineLayoutDescriptor.bindGroupLayouts = layouts.data();
 		return wgpuDeviceCreatePipelineLayout(device.get(), &pipelineLayoutDescriptor);
     }
+
+    RenderPipelineState Pipeline::createVariantState(const MaterialFeatureKey& featureKey, VariantKind kind) const
+    {
+    	auto& renderManager = Application::getRenderManager();
+
+    	RenderPipelineState state;
+    	state.label = fmt::format("Pipeline variant {:04x}{}", featureKey.pack(), (kind == VariantKind::DEPTH_ONLY) ? " depth only" :
+    		(kind == VariantKind::SHADED_DEPTH_EQUAL) ? " depth equal" : isGBufferPipeline() ? " G-buffer" : "");
+
+    	// Variants whose defines match share the preprocessed source, and so the shader module. The depth-only
+    	// variants' vertex stage doesn't depend on the texture slots, so they share one.
+    	std::string error;
+    	const auto shaderDefines = (kind == VariantKind::DEPTH_ONLY) ? getLayoutDefines() : getShaderDefines(featureKey);
+    	const auto shaderSource = renderManager.getShaderPreprocessor().process(m_shaderName, shaderDefines, error);
+    	if (shaderSource.has_value())
+    	{
+    		state.shaderHash = renderManager.getPipelineCache().addShaderModule(shaderSource.value(), m_shaderName);
+    	}
+    	else
+    	{
+    		spdlog::error("Unable to preprocess {}: {}", m_shaderName, error);
+    	}
+    	state.layout = m_pipelineLayout.get();
+    	state.sampleCount = getSampleCount();
+    	state.frontFace = WGPUFrontFace_CCW;
+    	state.cullMode = featureKey.isDoubleSided ? WGPUCullMode_None : WGPUCullMode_Back;
+    	state.depthFormat = DEPTH_FORMAT;
+    	state.depthCompare = WGPUCompareFunction_Less;
+
+		WGPUVertexAttribute positionAttribute{WGPU_VERTEX_ATTRIBUTE_INIT};
+		positionAttribute.shaderLocation = 0;
+		positionAttribute.format = WGPUVertexFormat_Float32x3;
+		positionAttribute.offset = 0;
+    	state.vertexBuffers.push_back({3 * sizeof(float), {positionAttribute}});
+
+    	if (kind == VariantKind::DEPTH_ONLY)
+    	{
+    		state.vertexEntryPoint = "vs_depth";
+    		state.fragmentEntryPoint.clear();
+    		return state;
+    	}
+
+    	state.vertexEntryPoint = "vs_main";
+    	state.fragmentEntryPoint = getFragmentEntryPoint(featureKey.alphaMode, isGBufferPipeline());
+    	state.colorFormat = m_colorTextureFormat;
+
+    	// Opaque and masked materials leave blending off, so that they only write what passes the depth test. Blended
+    	// surfaces are drawn after opaque ones and test against their depth, but don't hide each other.
+    	if (featureKey.alphaMode == GLAlphaMode::BLEND)
+    	{
+    		WGPUBlendState blendState{WGPU_BLEND_STATE_INIT};
+    		blendState.color = { WGPUBlendOperation_Add, WGPUBlendFactor_SrcAlpha, WGPUBlendFactor_OneMinusSrcAlpha };
+    		blendState.alpha = { WGPUBlendOperation_Add, WGPUBlendFactor_One, WGPUBlendFactor_OneMinusSrcAlpha };
+    		state.blend = blendState;
+    		state.isDepthWriteEnabled = false;
+    	}
+
+    	// The pre-pass already wrote the nearest depth, which only the same surface's samples match
+    	if (kind == VariantKind::SHADED_DEPTH_EQUAL)
+    	{
+    		state.depthCompare = WGPUCompareFunction_Equal;
+    		state.isDepthWriteEnabled = false;
+    	}
+
+    	// Model fills every VertexAttributes field, generating tangents when the primitive has none, so all vertex
+    	// attribute combinations share this layout
+		WGPUVertexAttribute normalAttribute{WGPU_VERTEX_ATTRIBUTE_INIT};
+		normalAttribute.shaderLocation = 1;
+		normalAttribute.format = WGPUVertexFormat_Float32x3;
+		normalAttribute.offset = offsetof(VertexAttributes, normal);
+
+		WGPUVertexAttribute tangentAttribute{WGPU_VERTEX_ATTRIBUTE_INIT};
+		tangentAttribute.shaderLocation = 2;
+		tangentAttribute.format = WGPUVertexFormat_Float32x3;
+		tangentAttribute.offset = offsetof(VertexAttributes, tangent);
+
+		WGPUVertexAttribute bitangentAttribute{WGPU_VERTEX_ATTRIBUTE_INIT};
+		bitangentAttribute.shaderLocation = 3;
+		bitangentAttribute.format = WGPUVertexFormat_Float32x3;
+		bitangentAttribute.offset = offsetof(VertexAttributes, bitangent);
+
+		WGPUVertexAttribute texCoordAttribute{WGPU_VERTEX_ATTRIBUTE_INIT};
+		texCoordAttribute.shaderLocation = 4;
+		texCoordAttribute.format = WGPUVertexFormat_Float32x2;
+		texCoordAttribute.offset = offsetof(VertexAttributes, texCoord);
+
+    	state.vertexBuffers.push_back({sizeof(VertexAttributes), {normalAttribute, tangentAttribute, bitangentAttribute, texCoordAttribute}});
+
+    	return state;
+    }
 }
@@ -1,43 +1,118 @@
 #pragma once
+#include <array>
+#include <memory>
+#include <span>
+#include <unordered_map>
+#include <vector>
 #include <webgpu/webgpu.h>
 
+#include "BindGroupLayout.h"
+#include "Material.h"
+#include "PipelineCache.h"
+#include "ShaderPreprocessor.h"
 #include "Uniform.h"
 
 namespace webgpu
 {
-    class Node;
     class RenderPass;
+    struct DrawBatch;
 
+    // The render pipeline for the scene's materials. Variants differ in blending, culling and fragment entry point,
+    // selected by each draw batch's MaterialFeatureKey, and are compiled asynchronously by the PipelineCache. Each
+    // variant's shader is preprocessed with the key's texture slots defined, so that missing ones compile out. Draws
+    // whose variant isn't ready use the fallback variant that samples every texture slot, or are skipped. The
+    // pipeline layout is reflected from the fallback permutation, which declares every binding any variant uses.
+    // The draws are recorded once into render bundles and replayed each frame, until something they bind changes.
+    // Each frame in flight binds its own frame bind group, so there's a set of bundles per frame bind group.
+    // Large scenes are split into contiguous ranges of batches recorded on the job system's workers, one bundle
+    // each, and executed in order.
+    // With the depth pre-pass on, opaque batches are first drawn with a position-only variant that has no fragment
+    // stage, and then shaded with an Equal depth test and depth writes off, so each sample is shaded once. A batch is
+    // only pre-passed once both of its variants are ready; until then it's drawn as usual in the main pass.
+    // A pipeline in a RenderPassStage::G_BUFFER pass instead draws the opaque and masked batches, single-sampled, into
+    // the G-buffer that DeferredLighting shades; colorTextureFormat is then the G-buffer's. With deferred shading on,
+    // the main pass's pipeline only draws the blended batches.
+    // With InstanceCulling, each batch is one indirect draw of its visible instances, whose count the bundles don't
+    // depend on.
     class Pipeline
     {
     public:
-        Pipeline(const RenderPass& renderPass, WGPUTextureFormat colorTextureFormat, std::string_view shaderSource);
+        static constexpr uint32_t SAMPLE_COUNT = 4;
+        static constexpr WGPUTextureFormat DEPTH_FORMAT = WGPUTextureFormat_Depth24Plus;
 
-        [[nodiscard]] WGPURenderPipeline get() const;
+        Pipeline(const RenderPass& renderPass, WGPUTextureFormat colorTextureFormat, std::string_view shaderName);
+
+        // nullptr while neither the variant nor its fallback is ready
+        [[nodiscard]] WGPURenderPipeline getVariant(const MaterialFeatureKey& featureKey);
         [[nodiscard]] const RenderPass& getRenderPass() const;
 
+        // Every feature on, for the permutation whose bindings cover all variants
+        static ShaderDefines getLayoutDefines();
+
         void run(WGPURenderPassEncoder renderPassEncoder);
 
+        // Into a depth-only pass, before run() in a pass that loads its depth
+        void runDepthPrePass(WGPURenderPassEncoder renderPassEncoder);
+
     private:
-        const RenderPass& m_renderPass;
-        std::shared_ptr<WGPURenderPipelineImpl> m_renderPipeline;
+        static constexpr int MIN_BATCHES_PER_BUNDLE = 64; // below this, a worker costs more than it saves
+
+        enum class VariantKind
+        {
+            SHADED,
+            SHADED_DEPTH_EQUAL, // after the depth pre-pass
+            DEPTH_ONLY, // the depth pre-pass
+        };
+        static constexpr int VARIANT_KIND_COUNT = 3;
 
-        //WGPUBlendState m_blendState;
-        //WGPUColorTargetState m_colorTargetState;
-        //WGPUDepthStencilState m_depthStencilState;
-        //WGPUPrimitiveState m_primitiveState;
+        // Everything the draws depend on, resolved on the main thread so that workers can encode from it. A bundle
+        // holds references to what it binds, so these handles can't be reused by new objects while it's alive.
+        struct DrawInputs
+        {
+            WGPUBindGroup frameBindGroup{nullptr};
+            WGPUBindGroup materialBindGroup{nullptr};
+            WGPUBindGroup modelBindGroup{nullptr};
+            WGPUBuffer indirectBuffer{nullptr}; // InstanceCulling's, when culling on the GPU
+            uint64_t drawBatchesVersion{0};
+            bool isDepthPrePass{false};
+            std::vector<WGPURenderPipeline> pipelines; // resolved variant per key in m_drawFeatureKeys, nullptr to skip
 
-        //std::string m_vertexShader; // TODO - different type?
-        //std::string m_fragmentShader;
+            bool operator==(const DrawInputs&) const = default;
+        };
 
-        // TODO - different buffer layouts?
+        struct BundleSet
+        {
+            DrawInputs inputs;
+            std::vector<std::shared_ptr<WGPURenderBundleImpl>> renderBundles;
+        };
 
-        //bool m_isMultiSample;
+        const RenderPass& m_renderPass;
+        WGPUTextureFormat m_colorTextureFormat;
+        std::string m_shaderName;
+        std::vector<BindGroupLayout> m_bindGroupLayouts; // by group
+        std::shared_ptr<WGPUPipelineLayoutImpl> m_pipelineLayout;
+        std::array<std::unordered_map<MaterialFeatureKey, uint64_t>, VARIANT_KIND_COUNT> m_variantHashes; // PipelineCache hashes, by VariantKind
+        bool m_isUsingRenderBundles;
+        bool m_isEncodingInParallel;
+        std::vector<MaterialFeatureKey> m_drawFeatureKeys; // distinct keys of the draw batches, in order
+        uint64_t m_drawFeatureKeysVersion{0}; // the draw batches version they were collected from
+        std::vector<BundleSet> m_bundleSets; // at most one per frame in flight and pass
 
-        //bool m_isDoubleSided;
+        static ShaderDefines getShaderDefines(const MaterialFeatureKey& featureKey);
+        static MaterialFeatureKey getFallbackKey(const MaterialFeatureKey& featureKey);
+        static bool isDepthPrePassed(const MaterialFeatureKey& featureKey);
+        static bool isDeferrable(const MaterialFeatureKey& featureKey);
+        [[nodiscard]] bool isGBufferPipeline() const;
+        [[nodiscard]] uint32_t getSampleCount() const;
+        uint64_t requestVariant(const MaterialFeatureKey& featureKey, VariantKind kind = VariantKind::SHADED);
+        [[nodiscard]] WGPURenderPipeline getVariant(const MaterialFeatureKey& featureKey, VariantKind kind);
 
-        [[nodiscard]] WGPUPipelineLayout createPipelineLayout(const Device& device) const;
+        void draw(WGPURenderPassEncoder renderPassEncoder, DrawInputs inputs);
+        DrawInputs getDrawInputs(bool isDepthPrePass);
+        [[nodiscard]] BundleSet recordRenderBundles(DrawInputs inputs) const;
+        template <typename Encoder> void encode(Encoder encoder, std::span<const DrawBatch> batches, const DrawInputs& inputs) const;
 
-        void drawNode(const WGPURenderPassEncoder& renderPassEncoder, const Node& node);
+        [[nodiscard]] WGPUPipelineLayout createPipelineLayout(const Device& device);
+        [[nodiscard]] RenderPipelineState createVariantState(const MaterialFeatureKey& featureKey, VariantKind kind) const;
     };
 }
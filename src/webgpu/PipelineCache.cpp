@@ -0,0 +1,259 @@
+#include "PipelineCache.h"
+
+#include <ranges>
+#include <type_traits>
+#include <spdlog/spdlog.h>
+
+#include "Application.h"
+#include "Device.h"
+#include "StringView.h"
+#include "Util.h"
+
+namespace webgpu
+{
+    namespace
+    {
+        class StateWriter
+        {
+        public:
+            template <typename T>
+            void write(const T& value)
+            {
+                static_assert(std::is_trivially_copyable_v<T>);
+                const auto* bytes = reinterpret_cast<const char*>(&value);
+                m_bytes.insert(m_bytes.end(), bytes, bytes + sizeof(T));
+            }
+
+            void write(std::string_view value)
+            {
+                write(value.size());
+                m_bytes.insert(m_bytes.end(), value.begin(), value.end());
+            }
+
+            void write(const WGPUBlendComponent& component)
+            {
+                write(component.operation);
+                write(component.srcFactor);
+                write(component.dstFactor);
+            }
+
+            [[nodiscard]] uint64_t hash() const
+            {
+                return Util::hashBytes(m_bytes.data(), m_bytes.size());
+            }
+
+        private:
+            std::vector<char> m_bytes;
+        };
+    }
+
+    uint64_t RenderPipelineState::hash() const
+    {
+        // Field by field, since descriptor structs have padding
+        StateWriter writer;
+        writer.write(shaderHash);
+        writer.write(std::string_view{vertexEntryPoint});
+        writer.write(std::string_view{fragmentEntryPoint});
+        writer.write(fragmentConstants.size());
+        for (const auto& [key, value] : fragmentConstants)
+        {
+            writer.write(std::string_view{key});
+            writer.write(value);
+        }
+        writer.write(layout);
+        writer.write(vertexBuffers.size());
+        for (const auto& vertexBuffer : vertexBuffers)
+        {
+            writer.write(vertexBuffer.arrayStride);
+            writer.write(vertexBuffer.attributes.size());
+            for (const auto& attribute : vertexBuffer.attributes)
+            {
+                writer.write(attribute.format);
+                writer.write(attribute.offset);
+                writer.write(attribute.shaderLocation);
+            }
+        }
+        writer.write(colorFormat);
+        writer.write(blend.has_value());
+        if (blend.has_value())
+        {
+            writer.write(blend->color);
+            writer.write(blend->alpha);
+        }
+        writer.write(depthFormat);
+        writer.write(isDepthWriteEnabled);
+        writer.write(depthCompare);
+        writer.write(cullMode);
+        writer.write(frontFace);
+        writer.write(sampleCount);
+        return writer.hash();
+    }
+
+    PipelineCache::PipelineCache() : m_pipelines{std::make_shared<Pipelines>()}
+    {
+    }
+
+    uint64_t PipelineCache::addShaderModule(std::string_view source, std::string_view label)
+    {
+        const uint64_t shaderHash = Util::hashBytes(source.data(), source.size());
+        if (m_shaderModules.contains(shaderHash))
+        {
+            return shaderHash;
+        }
+
+        WGPUShaderSourceWGSL wgslDesc{WGPU_SHADER_SOURCE_WGSL_INIT};
+        wgslDesc.code = StringView(source);
+        WGPUShaderModuleDescriptor shaderDesc{WGPU_SHADER_MODULE_DESCRIPTOR_INIT};
+        shaderDesc.nextInChain = &wgslDesc.chain;
+        shaderDesc.label = StringView(label);
+        WGPUShaderModule shaderModule = wgpuDeviceCreateShaderModule(Application::getDevice().get(), &shaderDesc);
+        m_shaderModules.emplace(shaderHash, std::shared_ptr<WGPUShaderModuleImpl>(shaderModule, [](WGPUShaderModule m) { wgpuShaderModuleRelease(m); }));
+        return shaderHash;
+    }
+
+    uint64_t PipelineCache::request(const RenderPipelineState& state)
+    {
+        const uint64_t pipelineHash = state.hash();
+        if (m_pipelines->contains(pipelineHash))
+        {
+            return pipelineHash;
+        }
+
+        std::shared_ptr<WGPUPipelineLayoutImpl> layout;
+        if (state.layout != nullptr)
+        {
+            wgpuPipelineLayoutAddRef(state.layout);
+            layout = std::shared_ptr<WGPUPipelineLayoutImpl>(state.layout, [](WGPUPipelineLayout l) { wgpuPipelineLayoutRelease(l); });
+        }
+
+        auto shaderIt = m_shaderModules.find(state.shaderHash);
+        if (shaderIt == m_shaderModules.end())
+        {
+            spdlog::error("No shader module {:016x} for pipeline {}", state.shaderHash, state.label);
+            m_pipelines->emplace(pipelineHash, CachedPipeline{state.label, PipelineStatus::FAILED, nullptr, {}, layout});
+            return pipelineHash;
+        }
+
+        std::vector<WGPUVertexBufferLayout> bufferLayouts;
+        for (const auto& vertexBuffer : state.vertexBuffers)
+        {
+            WGPUVertexBufferLayout bufferLayout{WGPU_VERTEX_BUFFER_LAYOUT_INIT};
+            bufferLayout.attributeCount = vertexBuffer.attributes.size();
+            bufferLayout.attributes = vertexBuffer.attributes.data();
+            bufferLayout.arrayStride = vertexBuffer.arrayStride;
+            bufferLayout.stepMode = WGPUVertexStepMode_Vertex;
+            bufferLayouts.push_back(bufferLayout);
+        }
+
+        WGPUVertexState vertexState{WGPU_VERTEX_STATE_INIT};
+        vertexState.module = shaderIt->second.get();
+        vertexState.entryPoint = StringView(state.vertexEntryPoint);
+        vertexState.bufferCount = bufferLayouts.size();
+        vertexState.buffers = bufferLayouts.data();
+
+        WGPUBlendState blendState{WGPU_BLEND_STATE_INIT};
+        if (state.blend.has_value())
+        {
+            blendState = state.blend.value();
+        }
+
+        WGPUColorTargetState colorTarget{WGPU_COLOR_TARGET_STATE_INIT};
+        colorTarget.format = state.colorFormat;
+        colorTarget.blend = state.blend.has_value() ? &blendState : nullptr;
+
+        std::vector<WGPUConstantEntry> constants;
+        for (const auto& [key, value] : state.fragmentConstants)
+        {
+            WGPUConstantEntry constant{WGPU_CONSTANT_ENTRY_INIT};
+            constant.key = StringView(key);
+            constant.value = value;
+            constants.push_back(constant);
+        }
+
+        WGPUFragmentState fragmentState{WGPU_FRAGMENT_STATE_INIT};
+        fragmentState.module = shaderIt->second.get();
+        fragmentState.entryPoint = StringView(state.fragmentEntryPoint);
+        fragmentState.constantCount = constants.size();
+        fragmentState.constants = constants.data();
+        fragmentState.targetCount = 1;
+        fragmentState.targets = &colorTarget;
+
+        WGPUDepthStencilState depthStencilState{WGPU_DEPTH_STENCIL_STATE_INIT};
+        depthStencilState.depthCompare = state.depthCompare;
+        depthStencilState.depthWriteEnabled = state.isDepthWriteEnabled ? WGPUOptionalBool_True : WGPUOptionalBool_False;
+        depthStencilState.format = state.depthFormat;
+
+        WGPURenderPipelineDescriptor pipelineDesc{WGPU_RENDER_PIPELINE_DESCRIPTOR_INIT};
+        pipelineDesc.label = StringView(state.label);
+        pipelineDesc.vertex = vertexState;
+        pipelineDesc.fragment = state.fragmentEntryPoint.empty() ? nullptr : &fragmentState;
+        pipelineDesc.depthStencil = &depthStencilState;
+        pipelineDesc.primitive.frontFace = state.frontFace;
+        pipelineDesc.primitive.cullMode = state.cullMode;
+        pipelineDesc.multisample.count = state.sampleCount;
+        pipelineDesc.layout = state.layout;
+
+        m_pipelines->emplace(pipelineHash, CachedPipeline{state.label, PipelineStatus::PENDING, nullptr, std::chrono::steady_clock::now(), layout});
+
+        WGPUCreateRenderPipelineAsyncCallbackInfo callbackInfo{WGPU_CREATE_RENDER_PIPELINE_ASYNC_CALLBACK_INFO_INIT};
+        callbackInfo.mode = WGPUCallbackMode_AllowProcessEvents;
+        callbackInfo.callback = [](WGPUCreatePipelineAsyncStatus status, WGPURenderPipeline pipeline, WGPUStringView message, void* userdata1, void* userdata2) {
+            std::unique_ptr<std::weak_ptr<Pipelines>> weakPipelines{static_cast<std::weak_ptr<Pipelines>*>(userdata1)};
+            std::unique_ptr<uint64_t> pipelineHash{static_cast<uint64_t*>(userdata2)};
+            auto pipelines = weakPipelines->lock();
+            if (!pipelines || !pipelines->contains(*pipelineHash))
+            {
+                if (pipeline != nullptr)
+                {
+                    wgpuRenderPipelineRelease(pipeline);
+                }
+                return;
+            }
+
+            auto& cached = pipelines->at(*pipelineHash);
+            if ((status != WGPUCreatePipelineAsyncStatus_Success) || (pipeline == nullptr))
+            {
+                spdlog::error("Unable to create pipeline {}: {}", cached.label, StringView(message).toString());
+                cached.status = PipelineStatus::FAILED;
+                return;
+            }
+
+            cached.pipeline = std::shared_ptr<WGPURenderPipelineImpl>(pipeline, [](WGPURenderPipeline p) { wgpuRenderPipelineRelease(p); });
+            cached.status = PipelineStatus::READY;
+            const auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - cached.requestTime);
+            spdlog::info("Pipeline {} ready after {} ms", cached.label, elapsed.count());
+        };
+        callbackInfo.userdata1 = new std::weak_ptr<Pipelines>(m_pipelines);
+        callbackInfo.userdata2 = new uint64_t(pipelineHash);
+        wgpuDeviceCreateRenderPipelineAsync(Application::getDevice().get(), &pipelineDesc, callbackInfo);
+
+        return pipelineHash;
+    }
+
+    WGPURenderPipeline PipelineCache::get(uint64_t pipelineHash) const
+    {
+        auto it = m_pipelines->find(pipelineHash);
+        return ((it != m_pipelines->end()) && (it->second.status == PipelineStatus::READY)) ? it->second.pipeline.get() : nullptr;
+    }
+
+    PipelineCacheStats PipelineCache::getStats() const
+    {
+        PipelineCacheStats stats{static_cast<int>(m_shaderModules.size()), 0, 0, 0};
+        for (const auto& cached : *m_pipelines | std::views::values)
+        {
+            switch (cached.status)
+            {
+                case PipelineStatus::READY:
+                    stats.readyCount++;
+                    break;
+                case PipelineStatus::PENDING:
+                    stats.pendingCount++;
+                    break;
+                case PipelineStatus::FAILED:
+                    stats.failedCount++;
+                    break;
+            }
+        }
+        return stats;
+    }
+}
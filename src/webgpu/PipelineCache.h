@@ -0,0 +1,96 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include <webgpu/webgpu.h>
+
+namespace webgpu
+{
+    struct VertexBufferState
+    {
+        uint64_t arrayStride{0};
+        std::vector<WGPUVertexAttribute> attributes;
+    };
+
+    // Everything a render pipeline is built from, as plain values so that it can be hashed. The shader module is
+    // referred to by the hash of its source; the pipeline layout by identity, which the cache keeps alive so that its
+    // address can't be reused by another layout.
+    struct RenderPipelineState
+    {
+        std::string label;
+        uint64_t shaderHash{0};
+        std::string vertexEntryPoint{"vs_main"};
+        std::string fragmentEntryPoint{"fs_main"}; // empty for depth-only pipelines, which have no fragment stage
+        std::map<std::string, double> fragmentConstants; // values for the shader's override declarations
+        WGPUPipelineLayout layout{nullptr};
+        std::vector<VertexBufferState> vertexBuffers;
+        WGPUTextureFormat colorFormat{WGPUTextureFormat_Undefined};
+        std::optional<WGPUBlendState> blend;
+        WGPUTextureFormat depthFormat{WGPUTextureFormat_Depth24Plus};
+        bool isDepthWriteEnabled{true};
+        WGPUCompareFunction depthCompare{WGPUCompareFunction_Less};
+        WGPUCullMode cullMode{WGPUCullMode_Back};
+        WGPUFrontFace frontFace{WGPUFrontFace_CCW};
+        uint32_t sampleCount{1};
+
+        // Of every field but the label
+        [[nodiscard]] uint64_t hash() const;
+    };
+
+    struct PipelineCacheStats
+    {
+        int shaderModuleCount;
+        int readyCount;
+        int pendingCount;
+        int failedCount;
+    };
+
+    // Shader modules by source hash and render pipelines by state hash. Pipelines are compiled with
+    // CreateRenderPipelineAsync, so a new variant never stalls the frame: until it's ready, get() returns nullptr and
+    // the caller skips the draw or falls back to a variant that is.
+    class PipelineCache
+    {
+    public:
+        PipelineCache();
+
+        // Returns the hash to put in RenderPipelineState::shaderHash. Modules are only compiled once per source.
+        uint64_t addShaderModule(std::string_view source, std::string_view label);
+
+        // Starts creating the pipeline if it isn't cached yet, and returns its hash
+        uint64_t request(const RenderPipelineState& state);
+
+        // nullptr until the pipeline is ready, or if it failed
+        [[nodiscard]] WGPURenderPipeline get(uint64_t pipelineHash) const;
+
+        [[nodiscard]] PipelineCacheStats getStats() const;
+
+    private:
+        enum class PipelineStatus
+        {
+            PENDING,
+            READY,
+            FAILED
+        };
+
+        struct CachedPipeline
+        {
+            std::string label;
+            PipelineStatus status{PipelineStatus::PENDING};
+            std::shared_ptr<WGPURenderPipelineImpl> pipeline;
+            std::chrono::steady_clock::time_point requestTime;
+            std::shared_ptr<WGPUPipelineLayoutImpl> layout; // a reference, since the layout is part of the hash
+        };
+
+        // Shared with creation callbacks, which may run after the cache is gone
+        using Pipelines = std::unordered_map<uint64_t, CachedPipeline>;
+        std::shared_ptr<Pipelines> m_pipelines;
+
+        std::unordered_map<uint64_t, std::shared_ptr<WGPUShaderModuleImpl>> m_shaderModules;
+    };
+}
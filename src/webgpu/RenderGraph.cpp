@@ -0,0 +1,492 @@
+#include "RenderGraph.h"
+
+#include <algorithm>
+#include <fmt/format.h>
+
+#include "GpuTimer.h"
+#include "StringView.h"
+
+namespace webgpu
+{
+    namespace
+    {
+        bool contains(const std::vector<RenderGraphResource>& resources, RenderGraphResource resource)
+        {
+            return std::ranges::find(resources, resource) != resources.end();
+        }
+    }
+
+    RenderGraphResource RenderGraph::createTexture(const RenderGraphTextureDesc& desc)
+    {
+        m_resources.push_back({desc, desc.label});
+        return static_cast<RenderGraphResource>(m_resources.size()) - 1;
+    }
+
+    RenderGraphResource RenderGraph::importTexture(std::string_view label, WGPUTextureView textureView)
+    {
+        m_resources.push_back({std::nullopt, std::string{label}, textureView});
+        return static_cast<RenderGraphResource>(m_resources.size()) - 1;
+    }
+
+    void RenderGraph::addPass(RenderGraphPass pass)
+    {
+        m_passes.push_back(std::move(pass));
+    }
+
+    bool RenderGraph::compile(std::string& error)
+    {
+        m_compiledPasses.clear();
+        m_physicalTextures.clear();
+
+        for (const auto& pass : m_passes)
+        {
+            for (const auto resource : getReads(pass))
+            {
+                if (!isValid(resource))
+                {
+                    error = fmt::format("{} reads resource {}, which doesn't exist", pass.name, resource);
+                    return false;
+                }
+            }
+            for (const auto resource : getWrites(pass))
+            {
+                if (!isValid(resource))
+                {
+                    error = fmt::format("{} writes resource {}, which doesn't exist", pass.name, resource);
+                    return false;
+                }
+            }
+        }
+
+        const auto optDependencies = getDependencies(error);
+        if (!optDependencies.has_value())
+        {
+            return false;
+        }
+        const auto& dependencies = optDependencies.value();
+
+        // Keep what the outputs and the passes with side effects depend on
+        std::vector<bool> isKept(m_passes.size(), false);
+        std::vector<int> stack;
+        for (int iPass = 0; iPass < m_passes.size(); iPass++)
+        {
+            const auto writes = getWrites(m_passes.at(iPass));
+            const bool isWritingOutput = std::ranges::any_of(writes, [&](RenderGraphResource resource) { return !m_resources.at(resource).desc.has_value(); });
+            if (m_passes.at(iPass).hasSideEffects || isWritingOutput)
+            {
+                isKept.at(iPass) = true;
+                stack.push_back(iPass);
+            }
+        }
+        while (!stack.empty())
+        {
+            const int pass = stack.back();
+            stack.pop_back();
+            for (const int dependency : dependencies.at(pass))
+            {
+                if (!isKept.at(dependency))
+                {
+                    isKept.at(dependency) = true;
+                    stack.push_back(dependency);
+                }
+            }
+        }
+
+        // Dependencies first, and otherwise in the order added
+        std::vector<int> order;
+        std::vector<bool> isOrdered(m_passes.size(), false);
+        const auto keptCount = std::ranges::count(isKept, true);
+        while (order.size() < keptCount)
+        {
+            int next = -1;
+            for (int iPass = 0; (iPass < m_passes.size()) && (next < 0); iPass++)
+            {
+                const bool isReady = std::ranges::all_of(dependencies.at(iPass), [&](int dependency) { return isOrdered.at(dependency); });
+                if (isKept.at(iPass) && !isOrdered.at(iPass) && isReady)
+                {
+                    next = iPass;
+                }
+            }
+            if (next < 0)
+            {
+                error = "The passes' dependencies form a cycle";
+                return false;
+            }
+
+            order.push_back(next);
+            isOrdered.at(next) = true;
+        }
+
+        auto isUsedBy = [&](int pass, RenderGraphResource resource) {
+            return contains(getReads(m_passes.at(pass)), resource) || contains(getWrites(m_passes.at(pass)), resource);
+        };
+        auto getOps = [&](int iOrder, RenderGraphResource resource) {
+            const bool isWrittenBefore = std::ranges::any_of(order.begin(), order.begin() + iOrder, [&](int pass) {
+                return contains(getWrites(m_passes.at(pass)), resource);
+            });
+            const bool isUsedAfter = !m_resources.at(resource).desc.has_value() ||
+                std::ranges::any_of(order.begin() + iOrder + 1, order.end(), [&](int pass) { return isUsedBy(pass, resource); });
+            return RenderGraphAttachmentOps{isWrittenBefore ? WGPULoadOp_Load : WGPULoadOp_Clear, isUsedAfter ? WGPUStoreOp_Store : WGPUStoreOp_Discard};
+        };
+
+        for (int iOrder = 0; iOrder < order.size(); iOrder++)
+        {
+            const auto& pass = m_passes.at(order.at(iOrder));
+            RenderGraphCompiledPass compiledPass{order.at(iOrder)};
+            for (const auto& colorAttachment : pass.colorAttachments)
+            {
+                compiledPass.colorOps.push_back(getOps(iOrder, colorAttachment.resource));
+            }
+            if (pass.depthAttachment.has_value())
+            {
+                compiledPass.depthOps = pass.isDepthReadOnly ? RenderGraphAttachmentOps{} : getOps(iOrder, pass.depthAttachment.value());
+            }
+            m_compiledPasses.push_back(std::move(compiledPass));
+        }
+
+        allocatePhysicalTextures();
+        return true;
+    }
+
+    void RenderGraph::execute(WGPUCommandEncoder commandEncoder, RenderTargetPool& pool, int width, int height, GpuTimer* timer)
+    {
+        m_width = width;
+        m_height = height;
+        m_acquiredViews.clear();
+        for (const auto& physicalTexture : m_physicalTextures)
+        {
+            m_acquiredViews.push_back(pool.acquire(physicalTexture, width, height));
+        }
+
+        m_textureViews.assign(m_resources.size(), nullptr);
+        for (int iResource = 0; iResource < m_resources.size(); iResource++)
+        {
+            const auto& resource = m_resources.at(iResource);
+            if (!resource.desc.has_value())
+            {
+                m_textureViews.at(iResource) = resource.importedView;
+            }
+            else if (resource.physicalTexture >= 0)
+            {
+                m_textureViews.at(iResource) = m_acquiredViews.at(resource.physicalTexture).get();
+            }
+        }
+
+        for (const auto& compiledPass : m_compiledPasses)
+        {
+            const auto& pass = m_passes.at(compiledPass.pass);
+            if (!pass.colorAttachments.empty() || pass.depthAttachment.has_value())
+            {
+                executeRenderPass(commandEncoder, compiledPass, timer);
+            }
+            else if (pass.executeCommands)
+            {
+                pass.executeCommands(commandEncoder, (timer != nullptr) ? timer->addPass(pass.name) : nullptr);
+            }
+        }
+    }
+
+    WGPUTextureView RenderGraph::getTextureView(RenderGraphResource resource) const
+    {
+        return m_textureViews.at(resource);
+    }
+
+    std::pair<int, int> RenderGraph::getTextureSize(RenderGraphResource resource) const
+    {
+        const int physicalTexture = m_resources.at(resource).physicalTexture;
+        if (physicalTexture < 0)
+        {
+            return {m_width, m_height};
+        }
+        const auto& view = m_acquiredViews.at(physicalTexture);
+        return {view.getWidth(), view.getHeight()};
+    }
+
+    const RenderGraphPass& RenderGraph::getPass(int pass) const
+    {
+        return m_passes.at(pass);
+    }
+
+    const std::vector<RenderGraphCompiledPass>& RenderGraph::getCompiledPasses() const
+    {
+        return m_compiledPasses;
+    }
+
+    std::optional<int> RenderGraph::getPhysicalTexture(RenderGraphResource resource) const
+    {
+        const int physicalTexture = m_resources.at(resource).physicalTexture;
+        return (physicalTexture >= 0) ? std::optional{physicalTexture} : std::nullopt;
+    }
+
+    int RenderGraph::getPhysicalTextureCount() const
+    {
+        return static_cast<int>(m_physicalTextures.size());
+    }
+
+    const RenderTargetDesc& RenderGraph::getPhysicalTextureDesc(int physicalTexture) const
+    {
+        return m_physicalTextures.at(physicalTexture);
+    }
+
+    bool RenderGraph::isValid(RenderGraphResource resource) const
+    {
+        return (resource >= 0) && (resource < m_resources.size());
+    }
+
+    std::vector<RenderGraphResource> RenderGraph::getReads(const RenderGraphPass& pass)
+    {
+        std::vector<RenderGraphResource> reads = pass.reads;
+        if (pass.depthAttachment.has_value() && pass.isDepthReadOnly)
+        {
+            reads.push_back(pass.depthAttachment.value());
+        }
+        return reads;
+    }
+
+    std::vector<RenderGraphResource> RenderGraph::getWrites(const RenderGraphPass& pass)
+    {
+        std::vector<RenderGraphResource> writes = pass.writes;
+        for (const auto& colorAttachment : pass.colorAttachments)
+        {
+            writes.push_back(colorAttachment.resource);
+            if (colorAttachment.resolveTarget.has_value())
+            {
+                writes.push_back(colorAttachment.resolveTarget.value());
+            }
+        }
+        if (pass.depthAttachment.has_value() && !pass.isDepthReadOnly)
+        {
+            writes.push_back(pass.depthAttachment.value());
+        }
+        return writes;
+    }
+
+    std::optional<std::vector<std::vector<int>>> RenderGraph::getDependencies(std::string& error) const
+    {
+        std::vector<std::vector<RenderGraphResource>> reads;
+        std::vector<std::vector<RenderGraphResource>> writes;
+        for (const auto& pass : m_passes)
+        {
+            reads.push_back(getReads(pass));
+            writes.push_back(getWrites(pass));
+        }
+
+        auto isWrittenBy = [&](int pass, RenderGraphResource resource) { return contains(writes.at(pass), resource); };
+        auto hasWriterBefore = [&](int pass, RenderGraphResource resource) {
+            for (int iWriter = 0; iWriter < pass; iWriter++)
+            {
+                if (isWrittenBy(iWriter, resource))
+                {
+                    return true;
+                }
+            }
+            return false;
+        };
+
+        std::vector<std::vector<int>> dependencies(m_passes.size());
+        for (int iPass = 0; iPass < m_passes.size(); iPass++)
+        {
+            auto& passDependencies = dependencies.at(iPass);
+            for (const auto resource : reads.at(iPass))
+            {
+                const bool isReadingEarlierWrite = hasWriterBefore(iPass, resource);
+                bool hasWriter = false;
+                for (int iWriter = 0; iWriter < m_passes.size(); iWriter++)
+                {
+                    if ((iWriter != iPass) && ((iWriter < iPass) == isReadingEarlierWrite) && isWrittenBy(iWriter, resource))
+                    {
+                        passDependencies.push_back(iWriter);
+                        hasWriter = true;
+                    }
+                }
+                if (!hasWriter && m_resources.at(resource).desc.has_value())
+                {
+                    error = fmt::format("{} reads {}, which no pass writes", m_passes.at(iPass).name, m_resources.at(resource).label);
+                    return std::nullopt;
+                }
+            }
+
+            for (const auto resource : writes.at(iPass))
+            {
+                for (int iOther = 0; iOther < iPass; iOther++)
+                {
+                    // After earlier writes, and after earlier reads of them
+                    const bool isReadingEarlierWrite = contains(reads.at(iOther), resource) && hasWriterBefore(iOther, resource);
+                    if (isWrittenBy(iOther, resource) || isReadingEarlierWrite)
+                    {
+                        passDependencies.push_back(iOther);
+                    }
+                }
+            }
+
+            std::ranges::sort(passDependencies);
+            const auto duplicates = std::ranges::unique(passDependencies);
+            passDependencies.erase(duplicates.begin(), duplicates.end());
+        }
+        return dependencies;
+    }
+
+    // A render pass's attachments all have the same size, so those of passes that render to an imported texture
+    // can't be rounded up to a bucket, and neither can those of passes that share attachments with them
+    void RenderGraph::markExactSizes()
+    {
+        for (auto& resource : m_resources)
+        {
+            resource.isExactSize = !resource.desc.has_value();
+        }
+
+        bool isChanged = true;
+        while (isChanged)
+        {
+            isChanged = false;
+            for (const auto& compiledPass : m_compiledPasses)
+            {
+                std::vector<RenderGraphResource> attachments;
+                for (const auto& colorAttachment : m_passes.at(compiledPass.pass).colorAttachments)
+                {
+                    attachments.push_back(colorAttachment.resource);
+                    if (colorAttachment.resolveTarget.has_value())
+                    {
+                        attachments.push_back(colorAttachment.resolveTarget.value());
+                    }
+                }
+                if (m_passes.at(compiledPass.pass).depthAttachment.has_value())
+                {
+                    attachments.push_back(m_passes.at(compiledPass.pass).depthAttachment.value());
+                }
+
+                const bool isExactSize = std::ranges::any_of(attachments, [&](RenderGraphResource resource) { return m_resources.at(resource).isExactSize; });
+                for (const auto resource : attachments)
+                {
+                    isChanged = isChanged || (isExactSize && !m_resources.at(resource).isExactSize);
+                    m_resources.at(resource).isExactSize = m_resources.at(resource).isExactSize || isExactSize;
+                }
+            }
+        }
+    }
+
+    void RenderGraph::allocatePhysicalTextures()
+    {
+        markExactSizes();
+
+        struct Lifetime
+        {
+            int first{-1};
+            int last{-1};
+        };
+        std::vector<Lifetime> lifetimes(m_resources.size());
+        for (auto& resource : m_resources)
+        {
+            resource.usage = WGPUTextureUsage_None;
+            resource.physicalTexture = -1;
+        }
+
+        auto use = [&](RenderGraphResource resource, int iOrder, WGPUTextureUsage usage) {
+            auto& lifetime = lifetimes.at(resource);
+            lifetime.first = (lifetime.first < 0) ? iOrder : lifetime.first;
+            lifetime.last = iOrder;
+            m_resources.at(resource).usage |= usage;
+        };
+        for (int iOrder = 0; iOrder < m_compiledPasses.size(); iOrder++)
+        {
+            const auto& pass = m_passes.at(m_compiledPasses.at(iOrder).pass);
+            for (const auto& colorAttachment : pass.colorAttachments)
+            {
+                use(colorAttachment.resource, iOrder, WGPUTextureUsage_RenderAttachment);
+                if (colorAttachment.resolveTarget.has_value())
+                {
+                    use(colorAttachment.resolveTarget.value(), iOrder, WGPUTextureUsage_RenderAttachment);
+                }
+            }
+            if (pass.depthAttachment.has_value())
+            {
+                use(pass.depthAttachment.value(), iOrder, WGPUTextureUsage_RenderAttachment);
+            }
+            for (const auto resource : pass.reads)
+            {
+                use(resource, iOrder, WGPUTextureUsage_TextureBinding);
+            }
+            for (const auto resource : pass.writes)
+            {
+                use(resource, iOrder, WGPUTextureUsage_StorageBinding);
+            }
+        }
+
+        // In order of first use, each takes the first texture of its kind that's free by then
+        std::vector<RenderGraphResource> transients;
+        for (int iResource = 0; iResource < m_resources.size(); iResource++)
+        {
+            if (m_resources.at(iResource).desc.has_value() && (lifetimes.at(iResource).first >= 0))
+            {
+                transients.push_back(iResource);
+            }
+        }
+        std::ranges::stable_sort(transients, {}, [&](RenderGraphResource resource) { return lifetimes.at(resource).first; });
+
+        std::vector<int> physicalLastUses;
+        for (const auto iResource : transients)
+        {
+            auto& resource = m_resources.at(iResource);
+            const RenderTargetDesc desc{resource.desc->format, resource.desc->sampleCount, resource.usage, resource.isExactSize};
+            for (int iPhysical = 0; (iPhysical < m_physicalTextures.size()) && (resource.physicalTexture < 0); iPhysical++)
+            {
+                if ((m_physicalTextures.at(iPhysical) == desc) && (physicalLastUses.at(iPhysical) < lifetimes.at(iResource).first))
+                {
+                    resource.physicalTexture = iPhysical;
+                }
+            }
+            if (resource.physicalTexture < 0)
+            {
+                resource.physicalTexture = static_cast<int>(m_physicalTextures.size());
+                m_physicalTextures.push_back(desc);
+                physicalLastUses.push_back(-1);
+            }
+            physicalLastUses.at(resource.physicalTexture) = lifetimes.at(iResource).last;
+        }
+    }
+
+    void RenderGraph::executeRenderPass(WGPUCommandEncoder commandEncoder, const RenderGraphCompiledPass& compiledPass, GpuTimer* timer) const
+    {
+        const auto& pass = m_passes.at(compiledPass.pass);
+
+        std::vector<WGPURenderPassColorAttachment> colorAttachments;
+        for (int iAttachment = 0; iAttachment < pass.colorAttachments.size(); iAttachment++)
+        {
+            const auto& attachment = pass.colorAttachments.at(iAttachment);
+            auto colorAttachment = WGPU_RENDER_PASS_COLOR_ATTACHMENT_INIT;
+            colorAttachment.view = getTextureView(attachment.resource);
+            colorAttachment.resolveTarget = attachment.resolveTarget.has_value() ? getTextureView(attachment.resolveTarget.value()) : nullptr;
+            colorAttachment.loadOp = compiledPass.colorOps.at(iAttachment).loadOp;
+            colorAttachment.storeOp = compiledPass.colorOps.at(iAttachment).storeOp;
+            colorAttachment.clearValue = attachment.clearValue;
+            colorAttachments.push_back(colorAttachment);
+        }
+
+        WGPURenderPassDepthStencilAttachment depthStencilAttachment = WGPU_RENDER_PASS_DEPTH_STENCIL_ATTACHMENT_INIT;
+        if (pass.depthAttachment.has_value())
+        {
+            depthStencilAttachment.view = getTextureView(pass.depthAttachment.value());
+            depthStencilAttachment.depthReadOnly = pass.isDepthReadOnly;
+            depthStencilAttachment.depthLoadOp = compiledPass.depthOps->loadOp;
+            depthStencilAttachment.depthStoreOp = compiledPass.depthOps->storeOp;
+            depthStencilAttachment.depthClearValue = pass.depthClearValue;
+        }
+
+        auto renderPassDesc = WGPU_RENDER_PASS_DESCRIPTOR_INIT;
+        renderPassDesc.label = StringView(pass.name);
+        renderPassDesc.colorAttachmentCount = colorAttachments.size();
+        renderPassDesc.colorAttachments = colorAttachments.data();
+        renderPassDesc.depthStencilAttachment = pass.depthAttachment.has_value() ? &depthStencilAttachment : nullptr;
+        renderPassDesc.timestampWrites = (timer != nullptr) ? timer->addPass(pass.name) : nullptr;
+
+        WGPURenderPassEncoder renderPassEncoder = wgpuCommandEncoderBeginRenderPass(commandEncoder, &renderPassDesc);
+        wgpuRenderPassEncoderSetViewport(renderPassEncoder, 0.0f, 0.0f, static_cast<float>(m_width), static_cast<float>(m_height), 0.0f, 1.0f);
+        wgpuRenderPassEncoderSetScissorRect(renderPassEncoder, 0, 0, m_width, m_height);
+        if (pass.execute)
+        {
+            pass.execute(renderPassEncoder);
+        }
+        wgpuRenderPassEncoderEnd(renderPassEncoder);
+        wgpuRenderPassEncoderRelease(renderPassEncoder);
+    }
+}
@@ -0,0 +1,130 @@
+#pragma once
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+#include <webgpu/webgpu.h>
+
+#include "RenderTargetPool.h"
+
+namespace webgpu
+{
+    class GpuTimer;
+
+    using RenderGraphResource = int;
+
+    struct RenderGraphTextureDesc
+    {
+        std::string label;
+        WGPUTextureFormat format{WGPUTextureFormat_Undefined};
+        uint32_t sampleCount{1};
+    };
+
+    struct RenderGraphColorAttachment
+    {
+        RenderGraphResource resource;
+        std::optional<RenderGraphResource> resolveTarget;
+        WGPUColor clearValue{0, 0, 0, 0};
+    };
+
+    // What a pass uses, declared up front so that the graph can order, cull and allocate for it. Passes with
+    // attachments are render passes and run in their own WGPURenderPassEncoder; the others, e.g. compute, get the
+    // command encoder, and the timestamp writes for one pass they begin if they're timed.
+    struct RenderGraphPass
+    {
+        std::string name;
+        std::vector<RenderGraphColorAttachment> colorAttachments;
+        std::optional<RenderGraphResource> depthAttachment;
+        bool isDepthReadOnly{false};
+        float depthClearValue{1.0f};
+        std::vector<RenderGraphResource> reads; // sampled or read as storage
+        std::vector<RenderGraphResource> writes; // written as storage
+        bool hasSideEffects{false}; // kept even if nothing uses what it writes
+        std::function<void(WGPURenderPassEncoder)> execute;
+        std::function<void(WGPUCommandEncoder, const WGPUPassTimestampWrites*)> executeCommands;
+    };
+
+    struct RenderGraphAttachmentOps
+    {
+        WGPULoadOp loadOp{WGPULoadOp_Undefined};
+        WGPUStoreOp storeOp{WGPUStoreOp_Undefined};
+
+        bool operator==(const RenderGraphAttachmentOps&) const = default;
+    };
+
+    struct RenderGraphCompiledPass
+    {
+        int pass; // index in the order added
+        std::vector<RenderGraphAttachmentOps> colorOps;
+        std::optional<RenderGraphAttachmentOps> depthOps; // undefined ops for read-only depth
+    };
+
+    // A frame's passes and the textures they use, built each frame. compile() culls the passes whose results nothing
+    // uses, orders the rest by their dependencies, and derives load and store ops: attachments are cleared by their
+    // first writer and only stored when a later pass or the caller uses them. Transient textures whose lifetimes
+    // don't overlap share a texture from the RenderTargetPool. Those textures may be larger than the frame, so render
+    // passes are given a viewport of the frame's size, and passes sampling them scale by getTextureSize().
+    //
+    // A read depends on the passes added before it that write the resource, or on all of its writers if they were
+    // all added after it. Writes of a resource happen in the order added.
+    class RenderGraph
+    {
+    public:
+        RenderGraphResource createTexture(const RenderGraphTextureDesc& desc);
+
+        // A texture owned outside the graph, such as the surface's. What the graph writes to it is its output, so
+        // the passes writing it are never culled.
+        RenderGraphResource importTexture(std::string_view label, WGPUTextureView textureView);
+
+        void addPass(RenderGraphPass pass);
+
+        bool compile(std::string& error);
+
+        // Runs the compiled passes, with transient textures acquired from pool at the given size. Passes are timed by
+        // timer, if given.
+        void execute(WGPUCommandEncoder commandEncoder, RenderTargetPool& pool, int width, int height, GpuTimer* timer = nullptr);
+
+        // During execute(), for passes that bind the textures they read
+        [[nodiscard]] WGPUTextureView getTextureView(RenderGraphResource resource) const;
+        [[nodiscard]] std::pair<int, int> getTextureSize(RenderGraphResource resource) const; // transient textures
+
+        [[nodiscard]] const RenderGraphPass& getPass(int pass) const;
+        [[nodiscard]] const std::vector<RenderGraphCompiledPass>& getCompiledPasses() const;
+
+        // Index of the shared texture a transient resource was assigned, if a compiled pass uses it
+        [[nodiscard]] std::optional<int> getPhysicalTexture(RenderGraphResource resource) const;
+        [[nodiscard]] int getPhysicalTextureCount() const;
+        [[nodiscard]] const RenderTargetDesc& getPhysicalTextureDesc(int physicalTexture) const;
+
+    private:
+        struct Resource
+        {
+            std::optional<RenderGraphTextureDesc> desc; // transient textures
+            std::string label;
+            WGPUTextureView importedView{nullptr};
+            WGPUTextureUsage usage{WGPUTextureUsage_RenderAttachment};
+            bool isExactSize{false};
+            int physicalTexture{-1};
+        };
+
+        std::vector<Resource> m_resources;
+        std::vector<RenderGraphPass> m_passes;
+        std::vector<RenderGraphCompiledPass> m_compiledPasses;
+        std::vector<RenderTargetDesc> m_physicalTextures;
+        std::vector<WGPUTextureView> m_textureViews; // by resource, during execute()
+        std::vector<RenderTargetTextureView> m_acquiredViews;
+        int m_width{0};
+        int m_height{0};
+
+        [[nodiscard]] bool isValid(RenderGraphResource resource) const;
+        [[nodiscard]] static std::vector<RenderGraphResource> getReads(const RenderGraphPass& pass);
+        [[nodiscard]] static std::vector<RenderGraphResource> getWrites(const RenderGraphPass& pass);
+        [[nodiscard]] std::optional<std::vector<std::vector<int>>> getDependencies(std::string& error) const; // by pass
+        void markExactSizes();
+        void allocatePhysicalTextures();
+        void executeRenderPass(WGPUCommandEncoder commandEncoder, const RenderGraphCompiledPass& compiledPass, GpuTimer* timer) const;
+    };
+}
@@ -1,64 +1,164 @@
 #include "RenderManager.h"
 
+#include <algorithm>
+#include <cctype>
+#include <magic_enum/magic_enum.hpp>
 #include <spdlog/spdlog.h>
 
 #include "Application.h"
 #include "Model.h"
+#include "ModelManager.h"
 #include "Surface.h"
 #include "UniformsAndAttributes.h"
 #include "game/Console.h"
 #include "physics/Player.h"
 #include "resource/Loader.h"
+#include "resource/Settings.h"
 
 namespace webgpu
 {
     RenderManager::RenderManager()
-        : m_msaaTextureView{createMsaaTextureView()},
-          m_depthTextureView{createDepthTextureView()}
+        : m_frameAllocator{getFramesInFlight(), FRAME_ALLOCATOR_CAPACITY},
+          m_shaderPreprocessor{[](std::string_view name) -> std::optional<std::string> {
+              auto shader = Application::getResourceLoader().getShader(std::string{name});
+              return shader.has_value() ? std::optional{shader->getString()} : std::nullopt;
+          }},
+          m_lightManager{m_shaderPreprocessor},
+          m_isDepthPrePassEnabled{Application::getSettings().getBool("render.depthPrePass").value_or(true)},
+          m_shadingPath{getShadingPathSetting()}
     {
-        m_frameBindGroupLayout.addUniform(m_frameUniform);
+        // Group 0 of the scene shader
+        if (const auto* reflection = getSceneReflection())
+        {
+            std::string error;
+            if (!reflection->validateBuffer(0, 0, sizeof(FrameUniform), false, error))
+            {
+                spdlog::error("FrameUniform doesn't match the shader: {}", error);
+            }
+            m_lightManager.validate(*reflection, 0);
+            m_frameBindGroupLayout.addBindings(*reflection, 0);
+        }
         m_frameBindGroupLayout.create("Frame BindGroupLayout");
 
-        m_frameBindGroup.addUniform(m_frameUniform, 0);
-        m_frameBindGroup.create("Frame BindGroup", m_frameBindGroupLayout);
+        // The frame uniform is the first allocation of every frame, so it's always at the start of the buffer. Bind
+        // groups can't vary in their buffer, so each frame in flight has its own.
+        for (int iFrame = 0; iFrame < m_frameAllocator.getFrameCount(); iFrame++)
+        {
+            WGPUBindGroupEntry entry = WGPU_BIND_GROUP_ENTRY_INIT;
+            entry.buffer = m_frameAllocator.getBuffer(iFrame);
+            entry.offset = 0;
+            entry.size = sizeof(FrameUniform);
+
+            auto& frameBindGroup = m_frameBindGroups.emplace_back();
+            frameBindGroup.addEntry(entry);
+            m_lightManager.addBindGroupEntries(frameBindGroup);
+            frameBindGroup.create("Frame BindGroup", m_frameBindGroupLayout);
+        }
+
+        // The scene's lights. Their range is the far plane's distance, so that they light the whole view.
+        m_cameraLight = m_lightManager.addLight({.range = Z_FAR, .intensity = 10.0f});
+        m_lightManager.addLight({.position = {10.0f, 10.0f, 0.0f}, .range = Z_FAR});
+        m_lightManager.addLight({.position = {-10.0f, 5.0f, 10.0f}, .range = Z_FAR});
+        m_lightManager.addLight({.position = {2.0f, -5.0f, -10.0f}, .range = Z_FAR});
     }
 
     void RenderManager::createRenderPasses()
     {
-        // TODO
-        auto shaderSource = Application::getResourceLoader().getShader("shader.wgsl");
-        if (!shaderSource.has_value())
-        {
-            spdlog::error("Shader not loaded");
-            return;
-        }
+        const WGPUTextureFormat colorFormat = Application::getSurface().getTextureFormat();
+        m_gBufferRenderPass = std::make_shared<RenderPass>("G-buffer", RenderPassStage::G_BUFFER, DeferredLighting::G_BUFFER_FORMAT, Pipeline::DEPTH_FORMAT);
+        m_mainRenderPass = std::make_shared<RenderPass>("main", RenderPassStage::RENDER, colorFormat, Pipeline::DEPTH_FORMAT);
+        m_consoleRenderPass = std::make_shared<game::Console>(colorFormat, Pipeline::DEPTH_FORMAT);
 
-        m_mainRenderPass = std::make_shared<RenderPass>("main", RenderPassStage::RENDER, m_msaaTextureView, m_depthTextureView);
-        m_consoleRenderPass = std::make_shared<game::Console>(m_msaaTextureView, m_depthTextureView);
+        Pipeline gBufferPipeline{*m_gBufferRenderPass.get(), DeferredLighting::G_BUFFER_FORMAT, SCENE_SHADER};
+        m_gBufferRenderPass->addPipeline(gBufferPipeline);
+        m_deferredLighting.emplace(colorFormat);
 
-        Pipeline pipeline{*m_mainRenderPass.get(), m_msaaTextureView.getTextureFormat(), shaderSource.value().getString()};
+        Pipeline pipeline{*m_mainRenderPass.get(), colorFormat, SCENE_SHADER};
         m_mainRenderPass->addPipeline(pipeline);
     }
 
-    RenderTargetTextureView RenderManager::createMsaaTextureView()
+    void RenderManager::addRenderPasses(RenderGraph& renderGraph, RenderGraphResource surfaceTexture)
     {
-        auto& surface = Application::getSurface();
-
-        auto surfaceTexture = WGPU_SURFACE_TEXTURE_INIT;
-        wgpuSurfaceGetCurrentTexture(surface.get(), &surfaceTexture);
-        WGPUTextureFormat surfaceTextureFormat = wgpuTextureGetFormat(surfaceTexture.texture);
-        auto msaaTextureView = RenderTargetTextureView::create("msaa texture", surfaceTextureFormat, surface.getWidth(), surface.getHeight());
-        wgpuTextureRelease(surfaceTexture.texture);
-
-        return msaaTextureView;
+        // Neither the visible instances nor the lights are graph resources, so these rely on being added before the
+        // passes that draw and shade with them
+        if (InstanceCulling* instanceCulling = Application::getModelManager().getInstanceCulling())
+        {
+            renderGraph.addPass({
+                .name = "Instance culling",
+                .hasSideEffects = true,
+                .executeCommands = [instanceCulling](WGPUCommandEncoder commandEncoder, const WGPUPassTimestampWrites* timestampWrites) {
+                    instanceCulling->cull(commandEncoder, timestampWrites);
+                },
+            });
+        }
+        renderGraph.addPass({
+            .name = "Light culling",
+            .hasSideEffects = true,
+            .executeCommands = [this](WGPUCommandEncoder commandEncoder, const WGPUPassTimestampWrites* timestampWrites) {
+                m_lightManager.cullLights(commandEncoder, timestampWrites);
+            },
+        });
+
+        const WGPUTextureFormat colorFormat = Application::getSurface().getTextureFormat();
+        const auto msaaColor = renderGraph.createTexture({"MSAA color", colorFormat, Pipeline::SAMPLE_COUNT});
+        const auto depth = renderGraph.createTexture({"Depth", Pipeline::DEPTH_FORMAT, Pipeline::SAMPLE_COUNT});
+        if ((m_shadingPath == ShadingPath::DEFERRED) && m_deferredLighting.has_value())
+        {
+            // Single-sampled, and only read by the lighting pass, which copies the depth into the main pass's
+            const auto gBuffer = renderGraph.createTexture({"G-buffer", DeferredLighting::G_BUFFER_FORMAT});
+            const auto gBufferDepth = renderGraph.createTexture({"G-buffer depth", Pipeline::DEPTH_FORMAT});
+            renderGraph.addPass({
+                .name = "G-buffer",
+                .colorAttachments = {{gBuffer}},
+                .depthAttachment = gBufferDepth,
+                .execute = [this](WGPURenderPassEncoder renderPassEncoder) { m_gBufferRenderPass->runPass(renderPassEncoder); },
+            });
+            renderGraph.addPass({
+                .name = "Deferred lighting",
+                .colorAttachments = {{msaaColor}},
+                .depthAttachment = depth,
+                .reads = {gBuffer, gBufferDepth},
+                .execute = [this, &renderGraph, gBuffer, gBufferDepth](WGPURenderPassEncoder renderPassEncoder) {
+                    m_deferredLighting->run(renderPassEncoder, renderGraph.getTextureView(gBuffer), renderGraph.getTextureView(gBufferDepth));
+                },
+            });
+        }
+        else if (m_isDepthPrePassEnabled)
+        {
+            renderGraph.addPass({
+                .name = "Depth pre-pass",
+                .depthAttachment = depth,
+                .execute = [this](WGPURenderPassEncoder renderPassEncoder) { m_mainRenderPass->runDepthPrePass(renderPassEncoder); },
+            });
+        }
+        renderGraph.addPass({
+            .name = "Main",
+            .colorAttachments = {{msaaColor}},
+            .depthAttachment = depth,
+            .execute = [this](WGPURenderPassEncoder renderPassEncoder) { m_mainRenderPass->runPass(renderPassEncoder); },
+        });
+
+        // The console's pipeline has a depth attachment but ignores its contents, so it gets its own, which shares
+        // the scene's texture and lets the scene's depth be discarded
+        const auto consoleDepth = renderGraph.createTexture({"Console depth", Pipeline::DEPTH_FORMAT, Pipeline::SAMPLE_COUNT});
+        renderGraph.addPass({
+            .name = "Console",
+            .colorAttachments = {{msaaColor, surfaceTexture}},
+            .depthAttachment = consoleDepth,
+            .execute = [this](WGPURenderPassEncoder renderPassEncoder) { m_consoleRenderPass->runPass(renderPassEncoder); },
+        });
     }
 
-    RenderTargetTextureView RenderManager::createDepthTextureView()
+    int RenderManager::getFramesInFlight()
     {
-        auto& surface = Application::getSurface();
+        return std::clamp(Application::getSettings().getInt("render.framesInFlight").value_or(2), 2, 3);
+    }
 
-        WGPUTextureFormat depthFormat  = WGPUTextureFormat_Depth24Plus;
-        return RenderTargetTextureView::create("depth texture", depthFormat, surface.getWidth(), surface.getHeight());
+    ShadingPath RenderManager::getShadingPathSetting()
+    {
+        auto setting = Application::getSettings().getString("render.shadingPath").value_or("FORWARD");
+        std::transform(setting.begin(), setting.end(), setting.begin(), [](unsigned char c) { return std::toupper(c); });
+        return magic_enum::enum_cast<ShadingPath>(setting).value_or(ShadingPath::FORWARD);
     }
 
     bool RenderManager::run()
@@ -67,67 +167,80 @@ namespace webgpu
         auto& surface = Application::getSurface();
         auto& player = Application::getPlayer(); // TODO
 
+        surface.update();
+
         auto surfaceTexture = WGPU_SURFACE_TEXTURE_INIT;
         wgpuSurfaceGetCurrentTexture(surface.get(), &surfaceTexture);
         if (surfaceTexture.status != WGPUSurfaceGetCurrentTextureStatus_SuccessOptimal &&
             surfaceTexture.status != WGPUSurfaceGetCurrentTextureStatus_SuccessSuboptimal)
         {
+            // Where the swap chain can't be presented at its old size, a pending resize can't wait
+            if (surfaceTexture.status == WGPUSurfaceGetCurrentTextureStatus_Outdated)
+            {
+                surface.update(true);
+            }
             spdlog::info("Skipping draw");
             wgpuTextureRelease(surfaceTexture.texture);
             return true;
         }
 
         float aspect = static_cast<float>(surface.getWidth()) / static_cast<float>(surface.getHeight());
-        glm::mat4x4 projection = glm::perspectiveZO(45.0f * 3.14159f / 180.0f, aspect, 0.01f, 100.0f);
+        glm::mat4x4 projection = glm::perspectiveZO(FIELD_OF_VIEW, aspect, Z_NEAR, Z_FAR);
+
+        m_frameAllocator.beginFrame();
 
-        FrameUniform& frameUniform = m_frameUniform.getInstance();
+        FrameUniform frameUniform{};
         frameUniform.projection = projection;
         frameUniform.view = player.m_view;
+        frameUniform.inverseViewProjection = glm::inverse(projection * player.m_view);
         frameUniform.worldPosition = player.m_position;
         frameUniform.time = 1.0; // TODO
-        m_frameUniform.write(device.getQueue());
+        m_frameAllocator.write(frameUniform);
+
+        if (m_cameraLight.has_value())
+        {
+            m_lightManager.getLight(m_cameraLight.value()).position = player.m_position + glm::vec3{0.0f, -5.0f, 5.0f};
+        }
+        m_lightManager.update(projection, player.m_view, surface.getWidth(), surface.getHeight(), Z_NEAR, Z_FAR);
+        if (InstanceCulling* instanceCulling = Application::getModelManager().getInstanceCulling())
+        {
+            instanceCulling->update(projection * player.m_view);
+        }
+
+        Application::getModelManager().requestTextureMips(player.m_position, FIELD_OF_VIEW, surface.getHeight());
 
         auto canvasViewDescriptor = WGPU_TEXTURE_VIEW_DESCRIPTOR_INIT;
         canvasViewDescriptor.dimension = WGPUTextureViewDimension_2D;
         TextureView surfaceTextureView{surfaceTexture.texture, &canvasViewDescriptor};
 
-        auto colorAttachment = createColorAttachment(surface.getWidth(), surface.getHeight(), surfaceTextureView);
-        auto depthStencilAttachment = createDepthStencilAttachment(surface.getWidth(), surface.getHeight());
+        RenderGraph renderGraph;
+        addRenderPasses(renderGraph, renderGraph.importTexture("surface", surfaceTextureView.get()));
 
-        auto renderPassDesc = WGPU_RENDER_PASS_DESCRIPTOR_INIT;
-        renderPassDesc.colorAttachmentCount = 1;
-        renderPassDesc.colorAttachments = &colorAttachment;
-        renderPassDesc.depthStencilAttachment = &depthStencilAttachment;
+        std::string error;
+        if (!renderGraph.compile(error))
+        {
+            spdlog::error("Unable to compile the render graph: {}", error);
+            wgpuTextureRelease(surfaceTexture.texture);
+            return true;
+        }
 
+        m_gpuTimer.beginFrame();
         auto commandEncoder = device.createCommandEncoder();
-
-        WGPURenderPassEncoder renderPassEncoder = wgpuCommandEncoderBeginRenderPass(commandEncoder.get(), &renderPassDesc);
-        m_mainRenderPass->runPass(renderPassEncoder);
-        wgpuRenderPassEncoderEnd(renderPassEncoder);
-        wgpuRenderPassEncoderRelease(renderPassEncoder);
-
-        // TODO
-        auto colorAttachment2 = WGPU_RENDER_PASS_COLOR_ATTACHMENT_INIT;
-        colorAttachment2.view = m_msaaTextureView.update(surface.getWidth(), surface.getHeight()).get();
-        colorAttachment2.loadOp = WGPULoadOp_Load;
-        colorAttachment2.storeOp = WGPUStoreOp_Store;
-        colorAttachment2.clearValue = {1, 0, 0, 0};
-        colorAttachment2.resolveTarget = surfaceTextureView.get();
-        renderPassDesc.colorAttachments = &colorAttachment2;
-
-        WGPURenderPassEncoder renderPassEncoder2 = wgpuCommandEncoderBeginRenderPass(commandEncoder.get(), &renderPassDesc);
-        m_consoleRenderPass->runPass(renderPassEncoder2);
-        wgpuRenderPassEncoderEnd(renderPassEncoder2);
-        wgpuRenderPassEncoderRelease(renderPassEncoder2);
-
-        //m_msaaRenderPass.runPass(encoder, colorAttachment, depthStencilAttachment); // TODO
+        renderGraph.execute(commandEncoder.get(), m_renderTargetPool, surface.getWidth(), surface.getHeight(), &m_gpuTimer);
+        m_gpuTimer.resolve(commandEncoder.get());
 
         auto cmdBufferDescriptor = WGPU_COMMAND_BUFFER_DESCRIPTOR_INIT;
         cmdBufferDescriptor.label = StringView("Command buffer");
         WGPUCommandBuffer command = wgpuCommandEncoderFinish(commandEncoder.get(), &cmdBufferDescriptor);
 
+        m_frameAllocator.flush(device.getQueue());
         wgpuQueueSubmit(device.getQueue(), 1, &command);
         wgpuCommandBufferRelease(command);
+        m_frameAllocator.endFrame(device.getQueue());
+        m_gpuTimer.readTimings();
+        m_uniformBytesWritten = BaseUniform::takeBytesWritten();
+        m_frameAllocatorBytesUsed = m_frameAllocator.getUsedSize();
+        m_renderTargetPool.releaseAll();
 
         wgpuTextureRelease(surfaceTexture.texture);
 
@@ -139,9 +252,54 @@ namespace webgpu
         return true;
     }
 
-    Uniform<FrameUniform>& RenderManager::getFrameUniform()
+    FrameAllocator& RenderManager::getFrameAllocator()
+    {
+        return m_frameAllocator;
+    }
+
+    LightManager& RenderManager::getLightManager()
+    {
+        return m_lightManager;
+    }
+
+    uint64_t RenderManager::getUniformBytesWritten() const
+    {
+        return m_uniformBytesWritten;
+    }
+
+    uint64_t RenderManager::getFrameAllocatorBytesUsed() const
+    {
+        return m_frameAllocatorBytesUsed;
+    }
+
+    const RenderTargetPool& RenderManager::getRenderTargetPool() const
+    {
+        return m_renderTargetPool;
+    }
+
+    const GpuTimer& RenderManager::getGpuTimer() const
+    {
+        return m_gpuTimer;
+    }
+
+    bool RenderManager::isDepthPrePassEnabled() const
     {
-        return m_frameUniform;
+        return m_isDepthPrePassEnabled;
+    }
+
+    void RenderManager::setDepthPrePassEnabled(bool isEnabled)
+    {
+        m_isDepthPrePassEnabled = isEnabled;
+    }
+
+    ShadingPath RenderManager::getShadingPath() const
+    {
+        return m_shadingPath;
+    }
+
+    void RenderManager::setShadingPath(ShadingPath shadingPath)
+    {
+        m_shadingPath = shadingPath;
     }
 
     const BindGroupLayout& RenderManager::getFrameBindGroupLayout() const
@@ -151,31 +309,46 @@ namespace webgpu
 
     const BindGroup& RenderManager::getFrameBindGroup() const
     {
-        return m_frameBindGroup;
+        return m_frameBindGroups.at(m_frameAllocator.getFrameIndex());
     }
 
-    WGPURenderPassColorAttachment RenderManager::createColorAttachment(int width, int height, const TextureView& textureView)
+    PipelineCache& RenderManager::getPipelineCache()
     {
-        auto colorAttachment = WGPU_RENDER_PASS_COLOR_ATTACHMENT_INIT;
-        colorAttachment.view = m_msaaTextureView.update(width, height).get();
-        colorAttachment.loadOp = WGPULoadOp_Clear;
-        colorAttachment.storeOp = WGPUStoreOp_Store;
-        colorAttachment.clearValue = {0, 0, 0, 0};
-        colorAttachment.resolveTarget = textureView.get();
+        return m_pipelineCache;
+    }
 
-        return colorAttachment;
+    ShaderPreprocessor& RenderManager::getShaderPreprocessor()
+    {
+        return m_shaderPreprocessor;
     }
 
-    WGPURenderPassDepthStencilAttachment RenderManager::createDepthStencilAttachment(int width, int height)
+    const ShaderReflection* RenderManager::getShaderReflection(std::string_view shaderName, const ShaderDefines& defines)
     {
-        WGPURenderPassDepthStencilAttachment depthStencilAttachment = WGPU_RENDER_PASS_DEPTH_STENCIL_ATTACHMENT_INIT;
-        depthStencilAttachment.view = m_depthTextureView.update(width, height).get();
-        depthStencilAttachment.depthClearValue = 1.0f;
-        depthStencilAttachment.depthLoadOp = WGPULoadOp_Clear;
-        depthStencilAttachment.depthStoreOp = WGPUStoreOp_Store;
-        depthStencilAttachment.depthReadOnly = false;
+        std::string error;
+        const auto source = m_shaderPreprocessor.process(shaderName, defines, error);
+        if (!source.has_value())
+        {
+            spdlog::error("Unable to preprocess {}: {}", shaderName, error);
+            return nullptr;
+        }
 
-        return depthStencilAttachment;
+        const uint64_t sourceHash = Util::hashBytes(source->data(), source->size());
+        auto it = m_shaderReflections.find(sourceHash);
+        if (it == m_shaderReflections.end())
+        {
+            auto reflection = ShaderReflection::reflect(source.value(), error);
+            if (!reflection.has_value())
+            {
+                spdlog::error("Unable to reflect {}: {}", shaderName, error);
+            }
+            it = m_shaderReflections.emplace(sourceHash, std::move(reflection)).first;
+        }
+        return it->second.has_value() ? &it->second.value() : nullptr;
+    }
+
+    const ShaderReflection* RenderManager::getSceneReflection()
+    {
+        return getShaderReflection(SCENE_SHADER, Pipeline::getLayoutDefines());
     }
 
     WGPUCommandEncoder RenderManager::createCommandEncoder()
@@ -1,41 +1,93 @@
 #pragma once
+#include <optional>
+#include <unordered_map>
 
 #include "BindGroup.h"
 #include "BindGroupLayout.h"
+#include "DeferredLighting.h"
+#include "FrameAllocator.h"
+#include "GpuTimer.h"
+#include "LightManager.h"
+#include "PipelineCache.h"
+#include "RenderGraph.h"
 #include "RenderPass.h"
-#include "RenderTargetTextureView.h"
+#include "RenderTargetPool.h"
+#include "ShaderPreprocessor.h"
+#include "ShaderReflection.h"
 #include "Uniform.h"
 #include "UniformsAndAttributes.h"
 #include "webgpu/webgpu.h"
 
 namespace webgpu
 {
+    enum class ShadingPath
+    {
+        FORWARD,  // surfaces are lit as they're drawn
+        DEFERRED, // opaque and masked surfaces are drawn into a G-buffer and lit per pixel, see DeferredLighting
+    };
+
     class RenderManager
     {
     public:
+        static constexpr std::string_view SCENE_SHADER = "shader.wgsl";
+
         RenderManager();
 
         void createRenderPasses();
 
         bool run();
 
-        Uniform<FrameUniform>& getFrameUniform();
+        FrameAllocator& getFrameAllocator();
+        LightManager& getLightManager();
+        [[nodiscard]] uint64_t getUniformBytesWritten() const; // by Uniform writes, over the last frame
+        [[nodiscard]] uint64_t getFrameAllocatorBytesUsed() const; // over the last frame
+        [[nodiscard]] const RenderTargetPool& getRenderTargetPool() const;
+        [[nodiscard]] const GpuTimer& getGpuTimer() const;
+
+        // Takes effect from the next frame
+        [[nodiscard]] bool isDepthPrePassEnabled() const;
+        void setDepthPrePassEnabled(bool isEnabled);
+        [[nodiscard]] ShadingPath getShadingPath() const;
+        void setShadingPath(ShadingPath shadingPath);
         [[nodiscard]] const BindGroupLayout& getFrameBindGroupLayout() const;
-        [[nodiscard]] const BindGroup& getFrameBindGroup() const;
+        [[nodiscard]] const BindGroup& getFrameBindGroup() const; // of the current frame in flight
+        PipelineCache& getPipelineCache();
+        ShaderPreprocessor& getShaderPreprocessor();
+
+        // Of the preprocessed source, cached per source. nullptr if it can't be preprocessed or reflected.
+        const ShaderReflection* getShaderReflection(std::string_view shaderName, const ShaderDefines& defines);
+
+        // The scene shader with every feature on, whose bind group layouts all of its variants share
+        const ShaderReflection* getSceneReflection();
 
     private:
-        Uniform<FrameUniform> m_frameUniform;
+        static constexpr float FIELD_OF_VIEW = 45.0f * 3.14159f / 180.0f; // vertical, radians
+        static constexpr float Z_NEAR = 0.01f;
+        static constexpr float Z_FAR = 100.0f;
+        static constexpr uint64_t FRAME_ALLOCATOR_CAPACITY = 1024 * 1024; // per frame in flight
+
+        FrameAllocator m_frameAllocator;
         BindGroupLayout m_frameBindGroupLayout;
-        BindGroup m_frameBindGroup;
-        RenderTargetTextureView m_msaaTextureView;
-        RenderTargetTextureView m_depthTextureView;
+        std::vector<BindGroup> m_frameBindGroups; // per frame in flight, each over the start of its buffer
+        uint64_t m_uniformBytesWritten{0};
+        uint64_t m_frameAllocatorBytesUsed{0};
+        PipelineCache m_pipelineCache;
+        ShaderPreprocessor m_shaderPreprocessor;
+        std::unordered_map<uint64_t, std::optional<ShaderReflection>> m_shaderReflections; // by source hash
+        LightManager m_lightManager;
+        std::optional<int> m_cameraLight; // follows the player
+        RenderTargetPool m_renderTargetPool;
+        GpuTimer m_gpuTimer;
+        bool m_isDepthPrePassEnabled;
+        ShadingPath m_shadingPath;
+        std::shared_ptr<RenderPass> m_gBufferRenderPass;
+        std::optional<DeferredLighting> m_deferredLighting;
         std::shared_ptr<RenderPass> m_mainRenderPass;
         std::shared_ptr<RenderPass> m_consoleRenderPass;
 
-        static RenderTargetTextureView createMsaaTextureView();
-        static RenderTargetTextureView createDepthTextureView();
-        WGPURenderPassColorAttachment createColorAttachment(int width, int height, const TextureView& textureView);
-        WGPURenderPassDepthStencilAttachment createDepthStencilAttachment(int width, int height);
+        static int getFramesInFlight();
+        static ShadingPath getShadingPathSetting();
+        void addRenderPasses(RenderGraph& renderGraph, RenderGraphResource surfaceTexture);
         static WGPUCommandEncoder createCommandEncoder();
     };
 }
@@ -9,8 +9,8 @@
 
 namespace webgpu
 {
-    RenderPass::RenderPass(const std::string_view name, const RenderPassStage stage, const RenderTargetTextureView& canvasTextureView, const RenderTargetTextureView& depthTextureView)
-    : BasePass{name}, m_stage{stage}, m_canvasTextureView{canvasTextureView}, m_depthTextureView{depthTextureView}
+    RenderPass::RenderPass(const std::string_view name, const RenderPassStage stage, const WGPUTextureFormat colorFormat, const WGPUTextureFormat depthFormat)
+    : BasePass{name}, m_stage{stage}, m_colorFormat{colorFormat}, m_depthFormat{depthFormat}
     {
     }
 
@@ -19,15 +19,35 @@ namespace webgpu
         m_pipelines.push_back(pipeline);
     }
 
-    void RenderPass::runPass(const WGPURenderPassEncoder& renderPassEncoder)
+    RenderPassStage RenderPass::getStage() const
+    {
+        return m_stage;
+    }
+
+    WGPUTextureFormat RenderPass::getColorFormat() const
     {
-        const BindGroup& frameBindGroup = Application::getRenderManager().getFrameBindGroup();
-        wgpuRenderPassEncoderSetBindGroup(renderPassEncoder, 0, frameBindGroup.getBindGroup(), 0, nullptr);
+        return m_colorFormat;
+    }
+
+    WGPUTextureFormat RenderPass::getDepthFormat() const
+    {
+        return m_depthFormat;
+    }
 
+    void RenderPass::runPass(const WGPURenderPassEncoder& renderPassEncoder)
+    {
+        // Pipelines set their own variants and bind groups, since they may replay them from a render bundle
         for (Pipeline& pipeline : m_pipelines)
         {
-            wgpuRenderPassEncoderSetPipeline(renderPassEncoder, pipeline.get());
             pipeline.run(renderPassEncoder);
         }
     }
+
+    void RenderPass::runDepthPrePass(const WGPURenderPassEncoder& renderPassEncoder)
+    {
+        for (Pipeline& pipeline : m_pipelines)
+        {
+            pipeline.runDepthPrePass(renderPassEncoder);
+        }
+    }
 }
@@ -2,7 +2,6 @@
 #include <vector>
 #include "BasePass.h"
 #include "Pipeline.h"
-#include "RenderTargetTextureView.h"
 
 namespace webgpu
 {
@@ -18,18 +17,23 @@ namespace webgpu
     class RenderPass : public BasePass
     {
     public:
-        RenderPass(std::string_view name, RenderPassStage stage, const RenderTargetTextureView& canvasTextureView, const RenderTargetTextureView& depthTextureView);
+        RenderPass(std::string_view name, RenderPassStage stage, WGPUTextureFormat colorFormat, WGPUTextureFormat depthFormat);
 
         void addPipeline(const Pipeline& pipeline);
 
+        [[nodiscard]] RenderPassStage getStage() const;
+        [[nodiscard]] WGPUTextureFormat getColorFormat() const;
+        [[nodiscard]] WGPUTextureFormat getDepthFormat() const;
+
         virtual void runPass(const WGPURenderPassEncoder& renderPassEncoder);
 
+        // Depth only, into a pass before runPass()'s
+        void runDepthPrePass(const WGPURenderPassEncoder& renderPassEncoder);
+
     private:
         RenderPassStage m_stage;
+        WGPUTextureFormat m_colorFormat;
+        WGPUTextureFormat m_depthFormat;
         std::vector<Pipeline> m_pipelines;
-
-    protected:
-        const RenderTargetTextureView& m_canvasTextureView;
-        const RenderTargetTextureView& m_depthTextureView;
     };
 }
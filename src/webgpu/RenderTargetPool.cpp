@@ -0,0 +1,78 @@
+#include "RenderTargetPool.h"
+
+#include <algorithm>
+
+namespace webgpu
+{
+    RenderTargetTextureView RenderTargetPool::acquire(const RenderTargetDesc& desc, int width, int height)
+    {
+        // The smallest that fits, so that a target left over from a larger size doesn't hold on to a smaller request
+        auto it = m_targets.end();
+        for (auto candidate = m_targets.begin(); candidate != m_targets.end(); ++candidate)
+        {
+            const bool isSmaller = (it == m_targets.end()) ||
+                (candidate->view.getWidth() * candidate->view.getHeight() < it->view.getWidth() * it->view.getHeight());
+            if (isFitting(*candidate, desc, width, height) && isSmaller)
+            {
+                it = candidate;
+            }
+        }
+
+        if (it == m_targets.end())
+        {
+            const int allocatedWidth = desc.isExactSize ? width : getBucketSize(width);
+            const int allocatedHeight = desc.isExactSize ? height : getBucketSize(height);
+            auto view = RenderTargetTextureView::create("Render target", desc.format, allocatedWidth, allocatedHeight, desc.sampleCount, desc.usage);
+            it = m_targets.insert(m_targets.end(), Target{desc, std::move(view), false, m_frame});
+            m_createdCount++;
+        }
+
+        it->isAcquired = true;
+        it->lastAcquiredFrame = m_frame;
+        return it->view;
+    }
+
+    void RenderTargetPool::releaseAll()
+    {
+        std::erase_if(m_targets, [&](const Target& target) { return target.lastAcquiredFrame + MAX_UNUSED_FRAMES < m_frame; });
+        for (auto& target : m_targets)
+        {
+            target.isAcquired = false;
+        }
+        m_frame++;
+    }
+
+    int RenderTargetPool::getCount() const
+    {
+        return static_cast<int>(m_targets.size());
+    }
+
+    int RenderTargetPool::getCreatedCount() const
+    {
+        return m_createdCount;
+    }
+
+    int RenderTargetPool::getBucketSize(int size)
+    {
+        return std::max(1, (size + BUCKET_SIZE - 1) / BUCKET_SIZE) * BUCKET_SIZE;
+    }
+
+    bool RenderTargetPool::isFitting(const Target& target, const RenderTargetDesc& desc, int width, int height)
+    {
+        if (target.isAcquired || (target.desc != desc))
+        {
+            return false;
+        }
+
+        const int targetWidth = target.view.getWidth();
+        const int targetHeight = target.view.getHeight();
+        if (desc.isExactSize)
+        {
+            return (targetWidth == width) && (targetHeight == height);
+        }
+
+        // Up to a bucket of headroom, so that shrinking back and forth across a bucket boundary doesn't reallocate
+        return (targetWidth >= width) && (targetHeight >= height) &&
+            (targetWidth <= getBucketSize(width) + BUCKET_SIZE) && (targetHeight <= getBucketSize(height) + BUCKET_SIZE);
+    }
+}
@@ -0,0 +1,56 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include <webgpu/webgpu.h>
+
+#include "RenderTargetTextureView.h"
+
+namespace webgpu
+{
+    struct RenderTargetDesc
+    {
+        WGPUTextureFormat format{WGPUTextureFormat_Undefined};
+        uint32_t sampleCount{1};
+        WGPUTextureUsage usage{WGPUTextureUsage_RenderAttachment};
+        bool isExactSize{false}; // for attachments of passes that also render to, or resolve into, the surface
+
+        bool operator==(const RenderTargetDesc&) const = default;
+    };
+
+    // Render targets kept across frames, so that the render graph's transient textures aren't created every frame.
+    // Each target is handed out once per frame. Unless they must match the surface, targets are allocated in size
+    // buckets and reused while they're no more than a bucket larger than needed, so resizing the window only
+    // reallocates them now and then; passes render to the requested size with a viewport.
+    class RenderTargetPool
+    {
+    public:
+        static constexpr int BUCKET_SIZE = 256; // pixels
+        static constexpr int MAX_UNUSED_FRAMES = 8;
+
+        // May be larger than width x height
+        RenderTargetTextureView acquire(const RenderTargetDesc& desc, int width, int height);
+
+        // Makes every target available again, releasing those that haven't been acquired for a while
+        void releaseAll();
+
+        [[nodiscard]] int getCount() const;
+        [[nodiscard]] int getCreatedCount() const; // since startup
+
+        static int getBucketSize(int size);
+
+    private:
+        struct Target
+        {
+            RenderTargetDesc desc;
+            RenderTargetTextureView view;
+            bool isAcquired;
+            int lastAcquiredFrame;
+        };
+
+        std::vector<Target> m_targets;
+        int m_frame{0};
+        int m_createdCount{0};
+
+        [[nodiscard]] static bool isFitting(const Target& target, const RenderTargetDesc& desc, int width, int height);
+    };
+}
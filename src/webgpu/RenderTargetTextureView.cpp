@@ -1,5 +1,4 @@
 #include "RenderTargetTextureView.h"
-#include <spdlog/spdlog.h>
 
 #include "Application.h"
 #include "Device.h"
@@ -17,47 +16,39 @@ namespace webgpu
         m_texture = std::shared_ptr<WGPUTextureImpl>(texture, [](WGPUTexture t) { wgpuTextureRelease(t); });
     }
 
-    RenderTargetTextureView RenderTargetTextureView::create(std::string_view label, const WGPUTextureFormat& format, int width, int height)
+    RenderTargetTextureView RenderTargetTextureView::create(std::string_view label, const WGPUTextureFormat& format, int width, int height, uint32_t sampleCount,
+        WGPUTextureUsage usage)
     {
-        WGPUTextureDescriptor textureDescriptor = createTextureDescriptor(label, format, width, height);
+        WGPUTextureDescriptor textureDescriptor = createTextureDescriptor(label, format, width, height, sampleCount, usage);
         WGPUTexture texture = createTexture(textureDescriptor);
         return RenderTargetTextureView{textureDescriptor, texture};
     }
 
-    const RenderTargetTextureView& RenderTargetTextureView::update(const int width, const int height)
+    WGPUTextureFormat RenderTargetTextureView::getTextureFormat() const
     {
-        if ((width != m_descriptor.size.width) || (height != m_descriptor.size.height))
-        {
-            spdlog::info("Resizing");
-
-            m_descriptor.size.width = width;
-            m_descriptor.size.height = height;
-
-            auto& device = Application::getDevice();
-            WGPUTexture texture = wgpuDeviceCreateTexture(device.get(), &m_descriptor);
-            m_texture.reset(texture, [](WGPUTexture t) { wgpuTextureDestroy(t); });
-
-            WGPUTextureView textureView = wgpuTextureCreateView(texture, nullptr);
-            m_textureView.reset(textureView, [](WGPUTextureView t) { wgpuTextureViewRelease(t); });
-        }
+        return m_descriptor.format;
+    }
 
-        return *this;
+    int RenderTargetTextureView::getWidth() const
+    {
+        return static_cast<int>(m_descriptor.size.width);
     }
 
-    WGPUTextureFormat RenderTargetTextureView::getTextureFormat() const
+    int RenderTargetTextureView::getHeight() const
     {
-        return m_descriptor.format;
+        return static_cast<int>(m_descriptor.size.height);
     }
 
-    WGPUTextureDescriptor RenderTargetTextureView::createTextureDescriptor(std::string_view label, const WGPUTextureFormat& format, int width, int height)
+    WGPUTextureDescriptor RenderTargetTextureView::createTextureDescriptor(std::string_view label, const WGPUTextureFormat& format, int width, int height, uint32_t sampleCount,
+        WGPUTextureUsage usage)
     {
         WGPUTextureDescriptor descriptor{WGPU_TEXTURE_DESCRIPTOR_INIT};
         descriptor.label = StringView{label};
-        descriptor.usage = WGPUTextureUsage_RenderAttachment;
+        descriptor.usage = usage;
         descriptor.size.width = width;
         descriptor.size.height = height;
         descriptor.format = format;
-        descriptor.sampleCount = 4;
+        descriptor.sampleCount = sampleCount;
 
         return descriptor;
     }
@@ -16,16 +16,19 @@ namespace webgpu
         RenderTargetTextureView();
         RenderTargetTextureView(const WGPUTextureDescriptor& textureDescriptor, const WGPUTexture& texture);
 
-        static RenderTargetTextureView create(std::string_view label, const WGPUTextureFormat& format, int width, int height);
+        static RenderTargetTextureView create(std::string_view label, const WGPUTextureFormat& format, int width, int height, uint32_t sampleCount = 4,
+            WGPUTextureUsage usage = WGPUTextureUsage_RenderAttachment);
 
-        const RenderTargetTextureView& update(int width, int height);
         [[nodiscard]] WGPUTextureFormat getTextureFormat() const;
+        [[nodiscard]] int getWidth() const;
+        [[nodiscard]] int getHeight() const;
 
     private:
         WGPUTextureDescriptor m_descriptor;
         std::shared_ptr<WGPUTextureImpl> m_texture;
 
-        static WGPUTextureDescriptor createTextureDescriptor(std::string_view label, const WGPUTextureFormat& format, int width, int height);
+        static WGPUTextureDescriptor createTextureDescriptor(std::string_view label, const WGPUTextureFormat& format, int width, int height, uint32_t sampleCount,
+            WGPUTextureUsage usage);
         static WGPUTexture createTexture(const WGPUTextureDescriptor& textureDescriptor);
     };
 }
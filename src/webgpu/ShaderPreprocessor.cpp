@@ -0,0 +1,459 @@
+#include "ShaderPreprocessor.h"
+
+#include <cctype>
+#include <charconv>
+#include <vector>
+#include <fmt/format.h>
+
+#include "Util.h"
+
+namespace webgpu
+{
+    namespace
+    {
+        bool isIdentifierStart(char c)
+        {
+            return std::isalpha(static_cast<unsigned char>(c)) || (c == '_');
+        }
+
+        bool isIdentifierChar(char c)
+        {
+            return std::isalnum(static_cast<unsigned char>(c)) || (c == '_');
+        }
+
+        std::string_view trim(std::string_view text)
+        {
+            while (!text.empty() && std::isspace(static_cast<unsigned char>(text.front())))
+            {
+                text.remove_prefix(1);
+            }
+            while (!text.empty() && std::isspace(static_cast<unsigned char>(text.back())))
+            {
+                text.remove_suffix(1);
+            }
+            return text;
+        }
+
+        // Splits "word rest" at the first whitespace
+        std::pair<std::string_view, std::string_view> splitWord(std::string_view text)
+        {
+            text = trim(text);
+            size_t end = 0;
+            while ((end < text.size()) && !std::isspace(static_cast<unsigned char>(text.at(end))))
+            {
+                end++;
+            }
+            return {text.substr(0, end), trim(text.substr(end))};
+        }
+
+        // Recursive descent over #if expressions, lowest precedence first
+        class ExpressionParser
+        {
+        public:
+            ExpressionParser(std::string_view expression, const ShaderDefines& defines) : m_text{expression}, m_defines{defines}, m_position{0}
+            {
+            }
+
+            std::optional<int> parse(std::string& error)
+            {
+                auto value = parseOr();
+                skipSpace();
+                if (value.has_value() && (m_position != m_text.size()))
+                {
+                    m_error = fmt::format("unexpected '{}'", m_text.substr(m_position));
+                    value.reset();
+                }
+                if (!value.has_value())
+                {
+                    error = fmt::format("bad expression '{}': {}", m_text, m_error);
+                }
+                return value;
+            }
+
+        private:
+            std::string_view m_text;
+            const ShaderDefines& m_defines;
+            size_t m_position;
+            std::string m_error;
+
+            void skipSpace()
+            {
+                while ((m_position < m_text.size()) && std::isspace(static_cast<unsigned char>(m_text.at(m_position))))
+                {
+                    m_position++;
+                }
+            }
+
+            bool accept(std::string_view token)
+            {
+                skipSpace();
+                if (m_text.substr(m_position).starts_with(token))
+                {
+                    m_position += token.size();
+                    return true;
+                }
+                return false;
+            }
+
+            std::string_view identifier()
+            {
+                skipSpace();
+                const size_t start = m_position;
+                if ((m_position < m_text.size()) && isIdentifierStart(m_text.at(m_position)))
+                {
+                    while ((m_position < m_text.size()) && isIdentifierChar(m_text.at(m_position)))
+                    {
+                        m_position++;
+                    }
+                }
+                return m_text.substr(start, m_position - start);
+            }
+
+            std::optional<int> parseOr()
+            {
+                auto value = parseAnd();
+                while (value.has_value() && accept("||"))
+                {
+                    auto rhs = parseAnd();
+                    value = rhs.has_value() ? std::optional<int>{(*value != 0) || (*rhs != 0)} : std::nullopt;
+                }
+                return value;
+            }
+
+            std::optional<int> parseAnd()
+            {
+                auto value = parseComparison();
+                while (value.has_value() && accept("&&"))
+                {
+                    auto rhs = parseComparison();
+                    value = rhs.has_value() ? std::optional<int>{(*value != 0) && (*rhs != 0)} : std::nullopt;
+                }
+                return value;
+            }
+
+            std::optional<int> parseComparison()
+            {
+                auto value = parseUnary();
+                if (!value.has_value())
+                {
+                    return value;
+                }
+
+                // Two character operators first, so that "<=" isn't read as "<"
+                for (std::string_view op : {"==", "!=", "<=", ">=", "<", ">"})
+                {
+                    if (!accept(op))
+                    {
+                        continue;
+                    }
+                    auto rhs = parseUnary();
+                    if (!rhs.has_value())
+                    {
+                        return rhs;
+                    }
+                    if (op == "==") return *value == *rhs;
+                    if (op == "!=") return *value != *rhs;
+                    if (op == "<=") return *value <= *rhs;
+                    if (op == ">=") return *value >= *rhs;
+                    if (op == "<") return *value < *rhs;
+                    return *value > *rhs;
+                }
+                return value;
+            }
+
+            std::optional<int> parseUnary()
+            {
+                skipSpace();
+                // "!=" is only reached after an operand, so a leading '!' is always a not
+                if (accept("!"))
+                {
+                    auto value = parseUnary();
+                    return value.has_value() ? std::optional<int>{*value == 0} : std::nullopt;
+                }
+                return parsePrimary();
+            }
+
+            std::optional<int> parsePrimary()
+            {
+                if (accept("("))
+                {
+                    auto value = parseOr();
+                    if (value.has_value() && !accept(")"))
+                    {
+                        m_error = "missing ')'";
+                        return std::nullopt;
+                    }
+                    return value;
+                }
+
+                skipSpace();
+                if ((m_position < m_text.size()) && std::isdigit(static_cast<unsigned char>(m_text.at(m_position))))
+                {
+                    int value = 0;
+                    const auto [end, ec] = std::from_chars(m_text.data() + m_position, m_text.data() + m_text.size(), value);
+                    m_position = end - m_text.data();
+                    return value;
+                }
+
+                const auto name = identifier();
+                if (name.empty())
+                {
+                    m_error = (m_position < m_text.size()) ? fmt::format("unexpected '{}'", m_text.at(m_position)) : "missing operand";
+                    return std::nullopt;
+                }
+
+                if (name == "defined")
+                {
+                    const bool hasParenthesis = accept("(");
+                    const auto definedName = identifier();
+                    if (definedName.empty() || (hasParenthesis && !accept(")")))
+                    {
+                        m_error = "bad defined()";
+                        return std::nullopt;
+                    }
+                    return m_defines.contains(definedName) ? 1 : 0;
+                }
+
+                auto it = m_defines.find(name);
+                if (it == m_defines.end())
+                {
+                    return 0;
+                }
+                if (it->second.empty())
+                {
+                    return 1;
+                }
+
+                int value = 0;
+                const auto [end, ec] = std::from_chars(it->second.data(), it->second.data() + it->second.size(), value);
+                if ((ec != std::errc{}) || (end != it->second.data() + it->second.size()))
+                {
+                    m_error = fmt::format("{} is not an integer ({})", name, it->second);
+                    return std::nullopt;
+                }
+                return value;
+            }
+        };
+    }
+
+    ShaderPreprocessor::ShaderPreprocessor(SourceResolver resolver) : m_resolver{std::move(resolver)}
+    {
+    }
+
+    std::optional<std::string> ShaderPreprocessor::process(std::string_view name, const ShaderDefines& defines, std::string& error)
+    {
+        const auto source = m_resolver(name);
+        if (!source.has_value())
+        {
+            error = fmt::format("{} not found", name);
+            return std::nullopt;
+        }
+
+        std::string key{*source};
+        for (const auto& [defineName, value] : defines)
+        {
+            key += fmt::format("\n{}={}", defineName, value);
+        }
+        const uint64_t hash = Util::hashBytes(key.data(), key.size());
+        if (auto it = m_cache.find(hash); it != m_cache.end())
+        {
+            return it->second;
+        }
+
+        ShaderDefines processDefines = defines;
+        std::set<std::string> included{std::string{name}};
+        std::string output;
+        if (!processSource(name, *source, processDefines, included, 0, output, error))
+        {
+            return std::nullopt;
+        }
+
+        m_cache.emplace(hash, output);
+        return output;
+    }
+
+    int ShaderPreprocessor::getCachedCount() const
+    {
+        return static_cast<int>(m_cache.size());
+    }
+
+    bool ShaderPreprocessor::processSource(std::string_view name, std::string_view source, ShaderDefines& defines, std::set<std::string>& included, int depth, std::string& output, std::string& error) const
+    {
+        std::vector<Conditional> conditionals;
+        int lineNumber = 0;
+        auto fail = [&](std::string_view message) {
+            error = fmt::format("{}:{}: {}", name, lineNumber, message);
+            return false;
+        };
+
+        while (!source.empty())
+        {
+            const size_t lineEnd = source.find('\n');
+            const auto line = source.substr(0, lineEnd);
+            source.remove_prefix((lineEnd == std::string_view::npos) ? source.size() : lineEnd + 1);
+            lineNumber++;
+
+            const bool isActive = conditionals.empty() || conditionals.back().isActive;
+            const auto trimmed = trim(line);
+            if (!trimmed.starts_with('#'))
+            {
+                output += isActive ? substitute(line, defines) : std::string{};
+                output += '\n';
+                continue;
+            }
+
+            const auto [directive, argument] = splitWord(trimmed.substr(1));
+            if ((directive == "if") || (directive == "ifdef") || (directive == "ifndef"))
+            {
+                bool isTrue = false;
+                if (isActive)
+                {
+                    if (directive == "if")
+                    {
+                        auto value = evaluate(argument, defines, error);
+                        if (!value.has_value())
+                        {
+                            return fail(error);
+                        }
+                        isTrue = *value != 0;
+                    }
+                    else
+                    {
+                        isTrue = defines.contains(splitWord(argument).first) == (directive == "ifdef");
+                    }
+                }
+                conditionals.push_back({isActive, isActive && isTrue, isTrue, false});
+            }
+            else if (directive == "elif")
+            {
+                if (conditionals.empty() || conditionals.back().hasElse)
+                {
+                    return fail("#elif without #if");
+                }
+                auto& conditional = conditionals.back();
+                conditional.isActive = false;
+                if (conditional.isParentActive && !conditional.wasTaken)
+                {
+                    auto value = evaluate(argument, defines, error);
+                    if (!value.has_value())
+                    {
+                        return fail(error);
+                    }
+                    conditional.isActive = *value != 0;
+                    conditional.wasTaken = conditional.isActive;
+                }
+            }
+            else if (directive == "else")
+            {
+                if (conditionals.empty() || conditionals.back().hasElse)
+                {
+                    return fail("#else without #if");
+                }
+                auto& conditional = conditionals.back();
+                conditional.isActive = conditional.isParentActive && !conditional.wasTaken;
+                conditional.hasElse = true;
+            }
+            else if (directive == "endif")
+            {
+                if (conditionals.empty())
+                {
+                    return fail("#endif without #if");
+                }
+                conditionals.pop_back();
+            }
+            else if (!isActive)
+            {
+                // Other directives in skipped regions don't need to be valid
+            }
+            else if (directive == "define")
+            {
+                const auto [defineName, value] = splitWord(argument);
+                if (defineName.empty() || !isIdentifierStart(defineName.front()))
+                {
+                    return fail("#define without a name");
+                }
+                defines[std::string{defineName}] = std::string{value};
+            }
+            else if (directive == "undef")
+            {
+                defines.erase(std::string{splitWord(argument).first});
+            }
+            else if (directive == "include")
+            {
+                if ((argument.size() < 2) || (argument.front() != '"') || (argument.back() != '"'))
+                {
+                    return fail("#include needs a quoted name");
+                }
+                const std::string includeName{argument.substr(1, argument.size() - 2)};
+                if (depth >= MAX_INCLUDE_DEPTH)
+                {
+                    return fail(fmt::format("#include nested deeper than {}", MAX_INCLUDE_DEPTH));
+                }
+                if (!included.insert(includeName).second)
+                {
+                    output += '\n';
+                    continue;
+                }
+
+                const auto includeSource = m_resolver(includeName);
+                if (!includeSource.has_value())
+                {
+                    return fail(fmt::format("{} not found", includeName));
+                }
+                if (!processSource(includeName, *includeSource, defines, included, depth + 1, output, error))
+                {
+                    return false;
+                }
+                continue;
+            }
+            else
+            {
+                return fail(fmt::format("unknown directive #{}", directive));
+            }
+            output += '\n';
+        }
+
+        if (!conditionals.empty())
+        {
+            return fail("missing #endif");
+        }
+        return true;
+    }
+
+    std::string ShaderPreprocessor::substitute(std::string_view line, const ShaderDefines& defines)
+    {
+        std::string result;
+        result.reserve(line.size());
+        size_t position = 0;
+        while (position < line.size())
+        {
+            // Comments are left alone
+            if (line.substr(position).starts_with("//"))
+            {
+                result += line.substr(position);
+                break;
+            }
+
+            if (!isIdentifierStart(line.at(position)) || ((position > 0) && isIdentifierChar(line.at(position - 1))))
+            {
+                result += line.at(position++);
+                continue;
+            }
+
+            const size_t start = position;
+            while ((position < line.size()) && isIdentifierChar(line.at(position)))
+            {
+                position++;
+            }
+            const auto word = line.substr(start, position - start);
+            auto it = defines.find(word);
+            result += ((it != defines.end()) && !it->second.empty()) ? std::string_view{it->second} : word;
+        }
+        return result;
+    }
+
+    std::optional<int> ShaderPreprocessor::evaluate(std::string_view expression, const ShaderDefines& defines, std::string& error)
+    {
+        return ExpressionParser{expression, defines}.parse(error);
+    }
+}
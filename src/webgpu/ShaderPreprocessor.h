@@ -0,0 +1,55 @@
+#pragma once
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <optional>
+#include <set>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+namespace webgpu
+{
+    using ShaderDefines = std::map<std::string, std::string, std::less<>>;
+
+    // C-like preprocessing for WGSL, run before the source reaches the shader module:
+    //   #include "name"        pastes another source once per output, resolved by name
+    //   #define NAME [value]   defined names with values are replaced in the code that follows
+    //   #undef NAME
+    //   #if, #elif             integer expressions of literals, names, defined(NAME), ! && || == != < <= > >=
+    //   #ifdef, #ifndef, #else, #endif
+    // Names without a value count as 1 in expressions, undefined names as 0. Dropped lines are kept as blank lines,
+    // so that line numbers in compiler messages match a file without #include. Included text is pasted in place of
+    // its directive, which shifts the lines after it.
+    class ShaderPreprocessor
+    {
+    public:
+        using SourceResolver = std::function<std::optional<std::string>(std::string_view name)>;
+
+        explicit ShaderPreprocessor(SourceResolver resolver);
+
+        // Results are cached by a hash of the source and the defines, so each permutation is only built once
+        std::optional<std::string> process(std::string_view name, const ShaderDefines& defines, std::string& error);
+
+        [[nodiscard]] int getCachedCount() const;
+
+    private:
+        static constexpr int MAX_INCLUDE_DEPTH = 16;
+
+        struct Conditional
+        {
+            bool isParentActive;
+            bool isActive;
+            bool wasTaken;
+            bool hasElse;
+        };
+
+        SourceResolver m_resolver;
+        std::unordered_map<uint64_t, std::string> m_cache;
+
+        bool processSource(std::string_view name, std::string_view source, ShaderDefines& defines, std::set<std::string>& included, int depth, std::string& output, std::string& error) const;
+
+        static std::string substitute(std::string_view line, const ShaderDefines& defines);
+        static std::optional<int> evaluate(std::string_view expression, const ShaderDefines& defines, std::string& error);
+    };
+}
@@ -0,0 +1,730 @@
+#include "ShaderReflection.h"
+
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+#include <iterator>
+#include <ranges>
+#include <fmt/format.h>
+
+namespace webgpu
+{
+    namespace
+    {
+        constexpr int MAX_TYPE_DEPTH = 32;
+
+        bool isIdentifierStart(char c)
+        {
+            return std::isalpha(static_cast<unsigned char>(c)) || (c == '_');
+        }
+
+        bool isIdentifierChar(char c)
+        {
+            return std::isalnum(static_cast<unsigned char>(c)) || (c == '_');
+        }
+
+        uint32_t roundUp(uint32_t alignment, uint32_t value)
+        {
+            return (value + alignment - 1) / alignment * alignment;
+        }
+
+        // Integer literals, with or without an i/u suffix
+        std::optional<uint32_t> parseInteger(std::string_view text)
+        {
+            if (!text.empty() && ((text.back() == 'u') || (text.back() == 'i')))
+            {
+                text.remove_suffix(1);
+            }
+            uint32_t value = 0;
+            const auto [end, ec] = std::from_chars(text.data(), text.data() + text.size(), value);
+            if ((ec != std::errc{}) || (end != text.data() + text.size()))
+            {
+                return std::nullopt;
+            }
+            return value;
+        }
+
+        // Comments become spaces, so that they separate tokens like whitespace does. Block comments nest in WGSL.
+        std::string stripComments(std::string_view source)
+        {
+            std::string result{source};
+            size_t position = 0;
+            while (position < result.size())
+            {
+                if (result.compare(position, 2, "//") == 0)
+                {
+                    while ((position < result.size()) && (result.at(position) != '\n'))
+                    {
+                        result.at(position++) = ' ';
+                    }
+                }
+                else if (result.compare(position, 2, "/*") == 0)
+                {
+                    int depth = 0;
+                    do
+                    {
+                        if (result.compare(position, 2, "/*") == 0)
+                        {
+                            depth++;
+                            result.replace(position, 2, "  ");
+                            position += 2;
+                        }
+                        else if (result.compare(position, 2, "*/") == 0)
+                        {
+                            depth--;
+                            result.replace(position, 2, "  ");
+                            position += 2;
+                        }
+                        else
+                        {
+                            result.at(position++) = ' ';
+                        }
+                    } while ((depth > 0) && (position < result.size()));
+                }
+                else
+                {
+                    position++;
+                }
+            }
+            return result;
+        }
+
+        // Identifiers, numbers, and every other non-space character on its own
+        std::vector<std::string_view> tokenize(std::string_view text)
+        {
+            std::vector<std::string_view> tokens;
+            size_t position = 0;
+            while (position < text.size())
+            {
+                const char c = text.at(position);
+                if (std::isspace(static_cast<unsigned char>(c)))
+                {
+                    position++;
+                    continue;
+                }
+
+                const size_t start = position;
+                const bool isNumber = std::isdigit(static_cast<unsigned char>(c));
+                if (isIdentifierStart(c) || isNumber)
+                {
+                    while ((position < text.size()) && (isIdentifierChar(text.at(position)) || (isNumber && (text.at(position) == '.'))))
+                    {
+                        position++;
+                    }
+                }
+                else
+                {
+                    position++;
+                }
+                tokens.push_back(text.substr(start, position - start));
+            }
+            return tokens;
+        }
+
+        // Attribute name to its first argument, if any
+        using Attributes = std::map<std::string, std::string, std::less<>>;
+
+        std::optional<uint32_t> getStage(const Attributes& attributes)
+        {
+            if (attributes.contains("vertex"))
+            {
+                return ReflectedBinding::VERTEX;
+            }
+            if (attributes.contains("fragment"))
+            {
+                return ReflectedBinding::FRAGMENT;
+            }
+            if (attributes.contains("compute"))
+            {
+                return ReflectedBinding::COMPUTE;
+            }
+            return std::nullopt;
+        }
+    }
+
+    class ShaderReflection::Scanner
+    {
+    public:
+        explicit Scanner(std::vector<std::string_view> tokens) : m_tokens{std::move(tokens)}, m_position{0}
+        {
+        }
+
+        [[nodiscard]] bool isDone() const
+        {
+            return m_position >= m_tokens.size();
+        }
+
+        [[nodiscard]] std::string_view peek() const
+        {
+            return isDone() ? std::string_view{} : m_tokens.at(m_position);
+        }
+
+        std::string_view next()
+        {
+            return isDone() ? std::string_view{} : m_tokens.at(m_position++);
+        }
+
+        bool accept(std::string_view token)
+        {
+            if (peek() == token)
+            {
+                m_position++;
+                return true;
+            }
+            return false;
+        }
+
+        bool expect(std::string_view token, std::string& error)
+        {
+            if (accept(token))
+            {
+                return true;
+            }
+            error = fmt::format("expected '{}' but found '{}'", token, isDone() ? "end of source" : peek());
+            return false;
+        }
+
+        Attributes parseAttributes()
+        {
+            Attributes attributes;
+            while (accept("@"))
+            {
+                const auto name = next();
+                std::string argument;
+                if (accept("("))
+                {
+                    for (int depth = 1; !isDone() && (depth > 0);)
+                    {
+                        const auto token = next();
+                        depth += (token == "(") ? 1 : (token == ")") ? -1 : 0;
+                        if ((depth == 1) && argument.empty() && (token != ","))
+                        {
+                            argument = token;
+                        }
+                    }
+                }
+                attributes.emplace(name, std::move(argument));
+            }
+            return attributes;
+        }
+
+        // A name with optional template arguments, which can be types, counts or access modes
+        std::optional<Type> parseType(std::string& error)
+        {
+            const auto name = next();
+            if (name.empty() || !(isIdentifierStart(name.front()) || std::isdigit(static_cast<unsigned char>(name.front()))))
+            {
+                error = fmt::format("expected a type but found '{}'", name.empty() ? "end of source" : name);
+                return std::nullopt;
+            }
+
+            Type type{std::string{name}, {}};
+            if (accept("<"))
+            {
+                do
+                {
+                    auto argument = parseType(error);
+                    if (!argument.has_value())
+                    {
+                        return std::nullopt;
+                    }
+                    type.arguments.push_back(std::move(argument.value()));
+                } while (accept(",") && (peek() != ">"));
+                if (!expect(">", error))
+                {
+                    return std::nullopt;
+                }
+            }
+            return type;
+        }
+
+        // Past the next top level terminator, skipping over anything bracketed
+        void skipPast(std::string_view terminator)
+        {
+            int depth = 0;
+            while (!isDone())
+            {
+                const auto token = next();
+                if ((depth == 0) && (token == terminator))
+                {
+                    return;
+                }
+                if ((token == "(") || (token == "[") || (token == "{"))
+                {
+                    depth++;
+                }
+                else if ((token == ")") || (token == "]") || (token == "}"))
+                {
+                    depth--;
+                }
+            }
+        }
+
+        // The identifiers in a braced block, which must be next
+        std::set<std::string> collectBlockIdentifiers()
+        {
+            std::set<std::string> identifiers;
+            for (int depth = 0; !isDone();)
+            {
+                const auto token = next();
+                if (token == "{")
+                {
+                    depth++;
+                }
+                else if (token == "}")
+                {
+                    if (--depth == 0)
+                    {
+                        break;
+                    }
+                }
+                else if (isIdentifierStart(token.front()))
+                {
+                    identifiers.emplace(token);
+                }
+            }
+            return identifiers;
+        }
+
+    private:
+        std::vector<std::string_view> m_tokens;
+        size_t m_position;
+    };
+
+    std::optional<ShaderReflection> ShaderReflection::reflect(std::string_view source, std::string& error)
+    {
+        const auto text = stripComments(source);
+        Scanner scanner{tokenize(text)};
+
+        ShaderReflection reflection;
+        std::vector<Declaration> declarations;
+        std::map<std::string, Function, std::less<>> functions;
+        while (!scanner.isDone())
+        {
+            const auto attributes = scanner.parseAttributes();
+            const auto keyword = scanner.next();
+            if (keyword == "struct")
+            {
+                const std::string name{scanner.next()};
+                if (!scanner.expect("{", error))
+                {
+                    return std::nullopt;
+                }
+
+                std::vector<Member> members;
+                while (!scanner.accept("}"))
+                {
+                    const auto memberAttributes = scanner.parseAttributes();
+                    scanner.next(); // member name
+                    if (!scanner.expect(":", error))
+                    {
+                        return std::nullopt;
+                    }
+                    auto type = scanner.parseType(error);
+                    if (!type.has_value())
+                    {
+                        return std::nullopt;
+                    }
+
+                    Member member{std::move(type.value()), std::nullopt, std::nullopt};
+                    if (auto it = memberAttributes.find("align"); it != memberAttributes.end())
+                    {
+                        member.alignment = parseInteger(it->second);
+                    }
+                    if (auto it = memberAttributes.find("size"); it != memberAttributes.end())
+                    {
+                        member.size = parseInteger(it->second);
+                    }
+                    members.push_back(std::move(member));
+                    scanner.accept(",");
+                }
+                reflection.m_structs[name] = std::move(members);
+                scanner.accept(";");
+            }
+            else if (keyword == "var")
+            {
+                Declaration declaration{};
+                if (scanner.accept("<"))
+                {
+                    declaration.addressSpace = scanner.next();
+                    if (scanner.accept(","))
+                    {
+                        declaration.accessMode = scanner.next();
+                    }
+                    if (!scanner.expect(">", error))
+                    {
+                        return std::nullopt;
+                    }
+                }
+                declaration.name = scanner.next();
+
+                auto groupIt = attributes.find("group");
+                auto bindingIt = attributes.find("binding");
+                if ((groupIt != attributes.end()) && (bindingIt != attributes.end()))
+                {
+                    const auto group = parseInteger(groupIt->second);
+                    const auto binding = parseInteger(bindingIt->second);
+                    if (!group.has_value() || !binding.has_value())
+                    {
+                        error = fmt::format("{}: @group and @binding must be integer literals", declaration.name);
+                        return std::nullopt;
+                    }
+                    if (!scanner.expect(":", error))
+                    {
+                        return std::nullopt;
+                    }
+                    auto type = scanner.parseType(error);
+                    if (!type.has_value())
+                    {
+                        return std::nullopt;
+                    }
+                    declaration.group = static_cast<int>(group.value());
+                    declaration.binding = static_cast<int>(binding.value());
+                    declaration.type = std::move(type.value());
+                    declarations.push_back(std::move(declaration));
+                }
+                scanner.skipPast(";");
+            }
+            else if (keyword == "fn")
+            {
+                const std::string name{scanner.next()};
+                while (!scanner.isDone() && (scanner.peek() != "{"))
+                {
+                    scanner.next(); // parameters and return type
+                }
+                functions[name] = Function{getStage(attributes).value_or(0), scanner.collectBlockIdentifiers()};
+            }
+            else if (keyword == "alias")
+            {
+                const std::string name{scanner.next()};
+                if (!scanner.expect("=", error))
+                {
+                    return std::nullopt;
+                }
+                auto type = scanner.parseType(error);
+                if (!type.has_value())
+                {
+                    return std::nullopt;
+                }
+                reflection.m_aliases[name] = std::move(type.value());
+                scanner.skipPast(";");
+            }
+            else if (!keyword.empty() && (keyword != ";"))
+            {
+                // const, override, enable, requires, diagnostic, const_assert
+                scanner.skipPast(";");
+            }
+        }
+
+        // Types can be declared after their use, so bindings are only resolved once everything has been read
+        for (const auto& declaration : declarations)
+        {
+            if (!reflection.addBinding(declaration, error))
+            {
+                return std::nullopt;
+            }
+        }
+        std::ranges::sort(reflection.m_bindings, {}, [](const ReflectedBinding& b) { return std::pair{b.group, b.binding}; });
+        reflection.computeVisibility(functions);
+        return reflection;
+    }
+
+    const std::vector<ReflectedBinding>& ShaderReflection::getBindings() const
+    {
+        return m_bindings;
+    }
+
+    std::vector<ReflectedBinding> ShaderReflection::getBindings(int group) const
+    {
+        std::vector<ReflectedBinding> bindings;
+        std::ranges::copy_if(m_bindings, std::back_inserter(bindings), [group](const ReflectedBinding& b) { return b.group == group; });
+        return bindings;
+    }
+
+    const ReflectedBinding* ShaderReflection::findBinding(int group, int binding) const
+    {
+        auto it = std::ranges::find_if(m_bindings, [group, binding](const ReflectedBinding& b) { return (b.group == group) && (b.binding == binding); });
+        return (it != m_bindings.end()) ? &*it : nullptr;
+    }
+
+    std::optional<TypeLayout> ShaderReflection::getTypeLayout(std::string_view type) const
+    {
+        const std::string text{type};
+        Scanner scanner{tokenize(text)};
+        std::string error;
+        const auto parsedType = scanner.parseType(error);
+        return (parsedType.has_value() && scanner.isDone()) ? getLayout(parsedType.value(), 0) : std::nullopt;
+    }
+
+    bool ShaderReflection::validateBuffer(int group, int binding, uint64_t hostSize, bool isStorage, std::string& error) const
+    {
+        const auto* reflected = findBinding(group, binding);
+        if (reflected == nullptr)
+        {
+            error = fmt::format("nothing is bound at @group({}) @binding({})", group, binding);
+            return false;
+        }
+
+        const bool isReflectedStorage = (reflected->kind == BindingKind::STORAGE_BUFFER) || (reflected->kind == BindingKind::READ_ONLY_STORAGE_BUFFER);
+        if ((reflected->kind != BindingKind::UNIFORM_BUFFER) && !isReflectedStorage)
+        {
+            error = fmt::format("{} is not a buffer", reflected->name);
+            return false;
+        }
+        if (isReflectedStorage != isStorage)
+        {
+            error = fmt::format("{} is declared var<{}>", reflected->name, isReflectedStorage ? "storage" : "uniform");
+            return false;
+        }
+        if (reflected->minBindingSize != hostSize)
+        {
+            error = fmt::format("{} is {} bytes{} in the shader but {} on the host", reflected->name, reflected->minBindingSize,
+                reflected->isRuntimeArray ? " per element" : "", hostSize);
+            return false;
+        }
+        return true;
+    }
+
+    std::optional<TypeLayout> ShaderReflection::getLayout(const Type& type, int depth) const
+    {
+        if (depth > MAX_TYPE_DEPTH)
+        {
+            return std::nullopt;
+        }
+
+        if (auto it = m_aliases.find(type.name); it != m_aliases.end())
+        {
+            return getLayout(it->second, depth + 1);
+        }
+        if (auto it = m_structs.find(type.name); it != m_structs.end())
+        {
+            uint32_t offset = 0;
+            uint32_t alignment = 1;
+            for (const auto& member : it->second)
+            {
+                const auto memberLayout = getLayout(member.type, depth + 1);
+                if (!memberLayout.has_value())
+                {
+                    return std::nullopt;
+                }
+                const uint32_t memberAlignment = member.alignment.value_or(memberLayout->alignment);
+                offset = roundUp(memberAlignment, offset) + member.size.value_or(memberLayout->size);
+                alignment = std::max(alignment, memberAlignment);
+            }
+            return TypeLayout{roundUp(alignment, offset), alignment};
+        }
+
+        // Component size of vectors and matrices, from the shorthand suffix or the template argument
+        auto getComponentSize = [&type](std::string_view shorthand) -> std::optional<uint32_t> {
+            const std::string_view component = (shorthand.empty() && (type.arguments.size() == 1)) ? std::string_view{type.arguments.front().name} : shorthand;
+            if ((component == "f") || (component == "i") || (component == "u") || (component == "f32") || (component == "i32") || (component == "u32"))
+            {
+                return 4;
+            }
+            if ((component == "h") || (component == "f16"))
+            {
+                return 2;
+            }
+            return std::nullopt;
+        };
+
+        const std::string_view name{type.name};
+        if ((name == "f32") || (name == "i32") || (name == "u32"))
+        {
+            return TypeLayout{4, 4};
+        }
+        if (name == "f16")
+        {
+            return TypeLayout{2, 2};
+        }
+        if ((name == "atomic") && (type.arguments.size() == 1))
+        {
+            return getLayout(type.arguments.front(), depth + 1);
+        }
+        if ((name.size() >= 4) && name.starts_with("vec") && (name.at(3) >= '2') && (name.at(3) <= '4'))
+        {
+            const uint32_t count = name.at(3) - '0';
+            const auto componentSize = getComponentSize(name.substr(4));
+            if (!componentSize.has_value())
+            {
+                return std::nullopt;
+            }
+            return TypeLayout{count * componentSize.value(), ((count == 2) ? 2 : 4) * componentSize.value()};
+        }
+        if ((name.size() >= 6) && name.starts_with("mat") && (name.at(4) == 'x'))
+        {
+            const uint32_t columns = name.at(3) - '0';
+            const uint32_t rows = name.at(5) - '0';
+            const auto componentSize = getComponentSize(name.substr(6));
+            if ((columns < 2) || (columns > 4) || (rows < 2) || (rows > 4) || !componentSize.has_value())
+            {
+                return std::nullopt;
+            }
+            // Laid out as an array of column vectors
+            const uint32_t columnAlignment = ((rows == 2) ? 2 : 4) * componentSize.value();
+            return TypeLayout{columns * roundUp(columnAlignment, rows * componentSize.value()), columnAlignment};
+        }
+        if ((name == "array") && !type.arguments.empty())
+        {
+            const auto elementLayout = getLayout(type.arguments.front(), depth + 1);
+            if (!elementLayout.has_value())
+            {
+                return std::nullopt;
+            }
+            const uint32_t stride = roundUp(elementLayout->alignment, elementLayout->size);
+            if (type.arguments.size() == 1)
+            {
+                return TypeLayout{stride, elementLayout->alignment}; // runtime-sized, one element
+            }
+            const auto count = parseInteger(type.arguments.at(1).name);
+            if (!count.has_value())
+            {
+                return std::nullopt;
+            }
+            return TypeLayout{count.value() * stride, elementLayout->alignment};
+        }
+        return std::nullopt;
+    }
+
+    bool ShaderReflection::addBinding(const Declaration& declaration, std::string& error)
+    {
+        if (findBinding(declaration.group, declaration.binding) != nullptr)
+        {
+            error = fmt::format("{}: @group({}) @binding({}) is already used", declaration.name, declaration.group, declaration.binding);
+            return false;
+        }
+
+        ReflectedBinding binding;
+        binding.group = declaration.group;
+        binding.binding = declaration.binding;
+        binding.name = declaration.name;
+
+        const std::string_view typeName{declaration.type.name};
+        if (!declaration.addressSpace.empty())
+        {
+            if (declaration.addressSpace == "uniform")
+            {
+                binding.kind = BindingKind::UNIFORM_BUFFER;
+            }
+            else if (declaration.addressSpace == "storage")
+            {
+                binding.kind = (declaration.accessMode == "read_write") ? BindingKind::STORAGE_BUFFER : BindingKind::READ_ONLY_STORAGE_BUFFER;
+            }
+            else
+            {
+                error = fmt::format("{}: var<{}> can't be bound", declaration.name, declaration.addressSpace);
+                return false;
+            }
+
+            const auto layout = getLayout(declaration.type, 0);
+            if (!layout.has_value())
+            {
+                error = fmt::format("{}: no layout for {}", declaration.name, typeName);
+                return false;
+            }
+            binding.minBindingSize = layout->size;
+            binding.isRuntimeArray = (typeName == "array") && (declaration.type.arguments.size() == 1);
+        }
+        else if ((typeName == "sampler") || (typeName == "sampler_comparison"))
+        {
+            binding.kind = (typeName == "sampler") ? BindingKind::SAMPLER : BindingKind::COMPARISON_SAMPLER;
+        }
+        else if (typeName.starts_with("texture_"))
+        {
+            static const std::map<std::string_view, TextureDimension> dimensions{
+                {"1d", TextureDimension::D1},
+                {"2d", TextureDimension::D2},
+                {"2d_array", TextureDimension::D2_ARRAY},
+                {"3d", TextureDimension::D3},
+                {"cube", TextureDimension::CUBE},
+                {"cube_array", TextureDimension::CUBE_ARRAY}};
+
+            auto suffix = typeName.substr(std::string_view{"texture_"}.size());
+            if (suffix.starts_with("storage_"))
+            {
+                binding.kind = BindingKind::STORAGE_TEXTURE;
+                suffix.remove_prefix(std::string_view{"storage_"}.size());
+                if (declaration.type.arguments.size() != 2)
+                {
+                    error = fmt::format("{}: {} needs a format and an access mode", declaration.name, typeName);
+                    return false;
+                }
+                binding.storageFormat = declaration.type.arguments.at(0).name;
+                binding.storageAccess = declaration.type.arguments.at(1).name;
+            }
+            else
+            {
+                binding.kind = BindingKind::TEXTURE;
+                if (suffix.starts_with("depth_"))
+                {
+                    binding.sampleType = TextureSampleType::DEPTH;
+                    suffix.remove_prefix(std::string_view{"depth_"}.size());
+                }
+                else
+                {
+                    const std::string_view sampledType = declaration.type.arguments.empty() ? std::string_view{} : std::string_view{declaration.type.arguments.front().name};
+                    binding.sampleType = (sampledType == "i32") ? TextureSampleType::SINT : (sampledType == "u32") ? TextureSampleType::UINT : TextureSampleType::FLOAT;
+                }
+                if (suffix.starts_with("multisampled_"))
+                {
+                    binding.isMultisampled = true;
+                    suffix.remove_prefix(std::string_view{"multisampled_"}.size());
+                }
+            }
+
+            auto it = dimensions.find(suffix);
+            if (it == dimensions.end())
+            {
+                error = fmt::format("{}: {} isn't supported", declaration.name, typeName);
+                return false;
+            }
+            binding.textureDimension = it->second;
+        }
+        else
+        {
+            error = fmt::format("{}: {} can't be bound without an address space", declaration.name, typeName);
+            return false;
+        }
+
+        m_bindings.push_back(std::move(binding));
+        return true;
+    }
+
+    void ShaderReflection::computeVisibility(const std::map<std::string, Function, std::less<>>& functions)
+    {
+        for (const auto& function : functions | std::views::values)
+        {
+            if (function.stage == 0)
+            {
+                continue;
+            }
+
+            // Everything the entry point can reach through calls
+            std::set<std::string_view> visited;
+            std::vector<const Function*> pending{&function};
+            std::set<std::string_view> used;
+            while (!pending.empty())
+            {
+                const Function* current = pending.back();
+                pending.pop_back();
+                for (const auto& identifier : current->identifiers)
+                {
+                    used.insert(identifier);
+                    auto it = functions.find(identifier);
+                    if ((it != functions.end()) && visited.insert(it->first).second)
+                    {
+                        pending.push_back(&it->second);
+                    }
+                }
+            }
+
+            for (auto& binding : m_bindings)
+            {
+                if (used.contains(binding.name))
+                {
+                    binding.visibility |= function.stage;
+                }
+            }
+        }
+    }
+}
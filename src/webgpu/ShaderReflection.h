@@ -0,0 +1,129 @@
+#pragma once
+#include <cstdint>
+#include <map>
+#include <optional>
+#include <set>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace webgpu
+{
+    enum class BindingKind
+    {
+        UNIFORM_BUFFER,
+        STORAGE_BUFFER,
+        READ_ONLY_STORAGE_BUFFER,
+        SAMPLER,
+        COMPARISON_SAMPLER,
+        TEXTURE,
+        STORAGE_TEXTURE
+    };
+
+    enum class TextureDimension
+    {
+        D1,
+        D2,
+        D2_ARRAY,
+        CUBE,
+        CUBE_ARRAY,
+        D3
+    };
+
+    enum class TextureSampleType
+    {
+        FLOAT,
+        SINT,
+        UINT,
+        DEPTH
+    };
+
+    // One @group/@binding declaration. Visibility is the stages whose entry points use it, directly or through the
+    // functions they call.
+    struct ReflectedBinding
+    {
+        static constexpr uint32_t VERTEX = 1;
+        static constexpr uint32_t FRAGMENT = 2;
+        static constexpr uint32_t COMPUTE = 4;
+
+        int group{0};
+        int binding{0};
+        std::string name;
+        BindingKind kind{BindingKind::UNIFORM_BUFFER};
+        uint32_t visibility{0};
+        uint64_t minBindingSize{0}; // buffers: the type's size, or one element's stride for runtime-sized arrays
+        bool isRuntimeArray{false};
+        TextureDimension textureDimension{TextureDimension::D2};
+        TextureSampleType sampleType{TextureSampleType::FLOAT};
+        bool isMultisampled{false};
+        std::string storageFormat; // storage textures, as spelled in WGSL
+        std::string storageAccess; // "read", "write" or "read_write"
+    };
+
+    struct TypeLayout
+    {
+        uint32_t size;
+        uint32_t alignment;
+    };
+
+    // What a pipeline layout needs from WGSL, read from the (preprocessed) source rather than the compiler: resource
+    // bindings with their types and stage visibility, and host-shareable type layouts by the WGSL alignment rules.
+    // It's a declaration scanner, not a parser, and relies on the source being valid; the shader module compile is
+    // still what reports errors in the code.
+    class ShaderReflection
+    {
+    public:
+        static std::optional<ShaderReflection> reflect(std::string_view source, std::string& error);
+
+        [[nodiscard]] const std::vector<ReflectedBinding>& getBindings() const;
+        [[nodiscard]] std::vector<ReflectedBinding> getBindings(int group) const; // ordered by binding
+        [[nodiscard]] const ReflectedBinding* findBinding(int group, int binding) const;
+        [[nodiscard]] std::optional<TypeLayout> getTypeLayout(std::string_view type) const;
+
+        // Whether a host struct of hostSize bytes can back the buffer at (group, binding): as the whole binding, or
+        // as one element of a runtime-sized array
+        bool validateBuffer(int group, int binding, uint64_t hostSize, bool isStorage, std::string& error) const;
+
+    private:
+        struct Type
+        {
+            std::string name;
+            std::vector<Type> arguments; // template arguments, including array counts and access modes
+        };
+
+        struct Member
+        {
+            Type type;
+            std::optional<uint32_t> alignment; // @align
+            std::optional<uint32_t> size; // @size
+        };
+
+        struct Function
+        {
+            uint32_t stage{0}; // for entry points
+            std::set<std::string> identifiers;
+        };
+
+        struct Declaration
+        {
+            int group;
+            int binding;
+            std::string name;
+            std::string addressSpace;
+            std::string accessMode;
+            Type type;
+        };
+
+        class Scanner;
+
+        std::vector<ReflectedBinding> m_bindings;
+        std::map<std::string, std::vector<Member>, std::less<>> m_structs;
+        std::map<std::string, Type, std::less<>> m_aliases;
+
+        ShaderReflection() = default;
+
+        [[nodiscard]] std::optional<TypeLayout> getLayout(const Type& type, int depth) const;
+        bool addBinding(const Declaration& declaration, std::string& error);
+        void computeVisibility(const std::map<std::string, Function, std::less<>>& functions);
+    };
+}
@@ -34,6 +34,7 @@ namespace webgpu
 
         // will set in configureSurface() since we can't configure without Adapter and Device
         m_isConfigured = false;
+        m_config = WGPU_SURFACE_CONFIGURATION_INIT;
         m_surfaceFormat = {};
         m_width = -1;
         m_height = -1;
@@ -114,6 +115,7 @@ namespace webgpu
 
     void Surface::configureSurface(int width, int height)
     {
+        m_requestedSize.reset();
         if ((m_width == width) && (m_height == height))
         {
             return;
@@ -123,6 +125,15 @@ namespace webgpu
 
         spdlog::info("Resizing surface: {}x{}", width, height);
 
+        // Only the size changes after the first configuration
+        if (m_isConfigured)
+        {
+            m_config.width = width;
+            m_config.height = height;
+            wgpuSurfaceConfigure(m_surface.get(), &m_config);
+            return;
+        }
+
         // Configuration of the textures created for the underlying swap chain
         WGPUSurfaceConfiguration config = WGPU_SURFACE_CONFIGURATION_INIT;
         config.width = width;
@@ -156,13 +167,27 @@ namespace webgpu
         config.presentMode = WGPUPresentMode_Fifo;
         config.alphaMode = WGPUCompositeAlphaMode_Auto;
 
-        if (m_isConfigured)
+        wgpuSurfaceConfigure(m_surface.get(), &config);
+        m_config = config;
+        m_isConfigured = true;
+    }
+
+    void Surface::requestResize(int width, int height)
+    {
+        m_requestedSize = {width, height};
+        m_resizeRequestTime = std::chrono::steady_clock::now();
+    }
+
+    bool Surface::update(bool isForced)
+    {
+        if (!m_requestedSize.has_value() || (!isForced && (std::chrono::steady_clock::now() - m_resizeRequestTime < RESIZE_DEBOUNCE)))
         {
-            wgpuSurfaceUnconfigure(m_surface.get());
+            return false;
         }
 
-        wgpuSurfaceConfigure(m_surface.get(), &config);
-        m_isConfigured = true;
+        const auto [width, height] = m_requestedSize.value();
+        configureSurface(width, height);
+        return true;
     }
 
     void Surface::present() const
@@ -1,5 +1,8 @@
 #pragma once
+#include <chrono>
 #include <memory>
+#include <optional>
+#include <utility>
 #include <webgpu/webgpu.h>
 
 namespace webgpu
@@ -9,9 +12,13 @@ namespace webgpu
     class Window;
     class WebGpuInstance;
 
+    // Window resizes are debounced: a drag sends a size change every few milliseconds, and reconfiguring for each
+    // would reallocate the swap chain and everything sized like it each time
     class Surface
     {
     public:
+        static constexpr std::chrono::milliseconds RESIZE_DEBOUNCE{150};
+
         Surface();
 
         [[nodiscard]] WGPUSurface get() const;
@@ -21,15 +28,25 @@ namespace webgpu
 
         void configureSurface(int width, int height);
 
+        // Reconfigured by update() once the size has stopped changing
+        void requestResize(int width, int height);
+
+        // Applies a requested resize that has settled, or any requested resize if isForced. Returns whether the
+        // surface was reconfigured.
+        bool update(bool isForced = false);
+
         void present() const;
 
     private:
         std::shared_ptr<WGPUSurfaceImpl> m_surface;
 
         bool m_isConfigured;
+        WGPUSurfaceConfiguration m_config;
         WGPUTextureFormat m_surfaceFormat;
         int m_width;
         int m_height;
+        std::optional<std::pair<int, int>> m_requestedSize;
+        std::chrono::steady_clock::time_point m_resizeRequestTime;
 
         static WGPUSurface createSurface();
         static WGPUSurface createSurface(WGPUChainedStruct* surfaceSourceDesc);
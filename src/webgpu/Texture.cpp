@@ -2,40 +2,247 @@
 
 #include "Device.h"
 
+#include <algorithm>
+#include <iterator>
+#include <magic_enum/magic_enum.hpp>
+#include <spdlog/spdlog.h>
+
 #include "stb_image.h"
 #include "StringView.h"
 #include <webgpu/webgpu.h>
 
 #include "Application.h"
+#include "BlockDecoder.h"
+#include "MipGenerator.h"
+#include "TextureFormat.h"
+#include "resource/Ktx2.h"
 
 namespace webgpu
 {
-    Texture::Texture(const std::string_view name, bool isSrgb)
-    : GpuData{name}, m_texture{nullptr}, m_format{isSrgb ? WGPUTextureFormat_RGBA8UnormSrgb : WGPUTextureFormat_RGBA8Unorm}, m_width{}, m_height{}
+    Texture::Texture(const std::string_view name, TextureUsage usage)
+    : GpuData{name}, m_texture{nullptr}, m_format{(usage == TextureUsage::COLOR) ? WGPUTextureFormat_RGBA8UnormSrgb : WGPUTextureFormat_RGBA8Unorm},
+    m_usage{usage}, m_width{}, m_height{}
+    {
+    }
+
+    Texture::Texture(const std::string_view name, bool isSrgb, int width, int height, const std::vector<unsigned char>& pixels)
+    : GpuData{name}, m_texture{nullptr}, m_format{isSrgb ? WGPUTextureFormat_RGBA8UnormSrgb : WGPUTextureFormat_RGBA8Unorm},
+    m_usage{isSrgb ? TextureUsage::COLOR : TextureUsage::ORM}, m_width{width}, m_height{height}, m_pixels{pixels}
     {
     }
 
     void Texture::load()
     {
+        decode();
         createTexture();
         createTextureView();
     }
 
-    void Texture::createTexture()
+    void Texture::decode()
     {
-        auto& device = Application::getDevice();
+        if (!m_pixels.empty())
+        {
+            return;
+        }
 
+        const bool isDecoded = resource::Ktx2::isKtx2(m_tempData.data(), m_tempData.size()) ? decodeKtx2() : decodeImage();
+        if (!isDecoded)
+        {
+            m_format = TextureFormat::withSrgb(WGPUTextureFormat_RGBA8Unorm, TextureFormat::isSrgb(m_format));
+            m_width = 1;
+            m_height = 1;
+            m_pixels = {255, 0, 255, 255};
+            m_mipPixels.clear();
+        }
+
+        m_tempData.clear();
+        m_tempData.shrink_to_fit();
+    }
+
+    bool Texture::decodeImage()
+    {
         int channels;
         unsigned char* image = stbi_load_from_memory(reinterpret_cast<stbi_uc const*>(m_tempData.data()), static_cast<int>(m_tempData.size()), &m_width, &m_height, &channels, 4);
-        auto deleter = [](unsigned char* i) { stbi_image_free(i); };
-        std::unique_ptr<unsigned char, decltype(deleter)> imageData(image, deleter);
+        if (image == nullptr)
+        {
+            spdlog::error("Unable to decode {}: {}", m_name, stbi_failure_reason());
+            return false;
+        }
+
+        m_pixels.assign(image, image + (static_cast<size_t>(m_width) * m_height * 4));
+        stbi_image_free(image);
+        return true;
+    }
+
+    bool Texture::decodeKtx2()
+    {
+        std::string error;
+        auto ktx2 = resource::Ktx2::parse(m_tempData.data(), m_tempData.size(), error);
+        if (!ktx2.has_value())
+        {
+            spdlog::error("Unable to decode {}: {}", m_name, error);
+            return false;
+        }
+
+        // The material slot decides the color space, whatever the container says
+        auto format = getKtx2Format(ktx2->vkFormat);
+        if (!format.has_value())
+        {
+            spdlog::error("Unable to decode {}: unsupported VkFormat {}", m_name, ktx2->vkFormat);
+            return false;
+        }
+        const bool isSrgb = TextureFormat::isSrgb(m_format);
+        const WGPUTextureFormat ktx2Format = TextureFormat::withSrgb(format.value(), isSrgb);
+        const auto formatInfo = TextureFormat::getInfo(ktx2Format);
+
+        for (int iLevel = 0; iLevel < ktx2->levels.size(); iLevel++)
+        {
+            if (ktx2->levels.at(iLevel).size() < formatInfo.byteSize(std::max(1, ktx2->width >> iLevel), std::max(1, ktx2->height >> iLevel)))
+            {
+                spdlog::error("Unable to decode {}: level {} is too small", m_name, iLevel);
+                return false;
+            }
+        }
+
+        m_width = ktx2->width;
+        m_height = ktx2->height;
+
+        // Block-compressed textures must be whole blocks at level 0
+        const auto requiredFeature = TextureFormat::getRequiredFeature(ktx2Format);
+        const bool isBlockAligned = (m_width % formatInfo.blockWidth == 0) && (m_height % formatInfo.blockHeight == 0);
+        if (isBlockAligned && (!requiredFeature.has_value() || Application::getDevice().hasFeature(requiredFeature.value())))
+        {
+            m_format = ktx2Format;
+            m_pixels = std::move(ktx2->levels.at(0));
+            m_mipPixels.assign(std::make_move_iterator(ktx2->levels.begin() + 1), std::make_move_iterator(ktx2->levels.end()));
+            return true;
+        }
+
+        if (!BlockDecoder::canDecode(ktx2Format))
+        {
+            spdlog::error("Unable to decode {}: {} is not supported by the device and has no CPU fallback", m_name, magic_enum::enum_name(ktx2Format));
+            return false;
+        }
+
+        // BC4 and BC5 are already in the layout of their usage, so they only lose the unused channels
+        spdlog::debug("Transcoding {} from {} on the CPU", m_name, magic_enum::enum_name(ktx2Format));
+        const int channelCount = TextureFormat::getChannelCount(ktx2Format);
+        m_format = (channelCount == 1) ? WGPUTextureFormat_R8Unorm : (channelCount == 2) ? WGPUTextureFormat_RG8Unorm : TextureFormat::withSrgb(WGPUTextureFormat_RGBA8Unorm, isSrgb);
+        m_mipPixels.clear();
+        for (int iLevel = 0; iLevel < ktx2->levels.size(); iLevel++)
+        {
+            auto pixels = BlockDecoder::decode(ktx2Format, ktx2->levels.at(iLevel), std::max(1, m_width >> iLevel), std::max(1, m_height >> iLevel));
+            if (channelCount < 4)
+            {
+                pixels = TextureFormat::truncateChannels(pixels, channelCount);
+            }
+            if (iLevel == 0)
+            {
+                m_pixels = std::move(pixels);
+            }
+            else
+            {
+                m_mipPixels.push_back(std::move(pixels));
+            }
+        }
+        return true;
+    }
+
+    std::optional<WGPUTextureFormat> Texture::getKtx2Format(uint32_t vkFormat)
+    {
+        using resource::Ktx2;
+        switch (vkFormat)
+        {
+            case Ktx2::VK_FORMAT_R8G8B8A8_UNORM:
+            case Ktx2::VK_FORMAT_R8G8B8A8_SRGB:
+                return WGPUTextureFormat_RGBA8Unorm;
+            case Ktx2::VK_FORMAT_BC1_RGB_UNORM_BLOCK:
+            case Ktx2::VK_FORMAT_BC1_RGB_SRGB_BLOCK:
+            case Ktx2::VK_FORMAT_BC1_RGBA_UNORM_BLOCK:
+            case Ktx2::VK_FORMAT_BC1_RGBA_SRGB_BLOCK:
+                return WGPUTextureFormat_BC1RGBAUnorm;
+            case Ktx2::VK_FORMAT_BC3_UNORM_BLOCK:
+            case Ktx2::VK_FORMAT_BC3_SRGB_BLOCK:
+                return WGPUTextureFormat_BC3RGBAUnorm;
+            case Ktx2::VK_FORMAT_BC4_UNORM_BLOCK:
+                return WGPUTextureFormat_BC4RUnorm;
+            case Ktx2::VK_FORMAT_BC5_UNORM_BLOCK:
+                return WGPUTextureFormat_BC5RGUnorm;
+            case Ktx2::VK_FORMAT_BC7_UNORM_BLOCK:
+            case Ktx2::VK_FORMAT_BC7_SRGB_BLOCK:
+                return WGPUTextureFormat_BC7RGBAUnorm;
+            case Ktx2::VK_FORMAT_ETC2_R8G8B8_UNORM_BLOCK:
+            case Ktx2::VK_FORMAT_ETC2_R8G8B8_SRGB_BLOCK:
+                return WGPUTextureFormat_ETC2RGB8Unorm;
+            case Ktx2::VK_FORMAT_ETC2_R8G8B8A1_UNORM_BLOCK:
+            case Ktx2::VK_FORMAT_ETC2_R8G8B8A1_SRGB_BLOCK:
+                return WGPUTextureFormat_ETC2RGB8A1Unorm;
+            case Ktx2::VK_FORMAT_ETC2_R8G8B8A8_UNORM_BLOCK:
+            case Ktx2::VK_FORMAT_ETC2_R8G8B8A8_SRGB_BLOCK:
+                return WGPUTextureFormat_ETC2RGBA8Unorm;
+            case Ktx2::VK_FORMAT_ASTC_4x4_UNORM_BLOCK:
+            case Ktx2::VK_FORMAT_ASTC_4x4_SRGB_BLOCK:
+                return WGPUTextureFormat_ASTC4x4Unorm;
+            default:
+                return std::nullopt;
+        }
+    }
+
+    void Texture::generateMips()
+    {
+        // Compressed textures and KTX2 files bring their own mips
+        if (TextureFormat::getInfo(m_format).isCompressed() || (TextureFormat::getChannelCount(m_format) != 4) || !m_mipPixels.empty())
+        {
+            return;
+        }
+
+        const bool isSrgb = TextureFormat::isSrgb(m_format);
+        const int mipLevelCount = MipGenerator::getMipLevelCount(m_width, m_height);
+        for (int mipLevel = 1; mipLevel < mipLevelCount; mipLevel++)
+        {
+            const auto& srcPixels = getPixels(mipLevel - 1);
+            m_mipPixels.push_back(MipGenerator::downsample(srcPixels, std::max(1, m_width >> (mipLevel - 1)), std::max(1, m_height >> (mipLevel - 1)), isSrgb));
+        }
+    }
+
+    void Texture::convertChannels()
+    {
+        // RGBA8 pixels are in the glTF layout; anything else was laid out for its usage when it was cooked
+        const auto format = TextureFormat::getUncompressedFormat(m_usage);
+        if ((m_format != WGPUTextureFormat_RGBA8Unorm) || (format == m_format))
+        {
+            return;
+        }
+
+        const int channelCount = TextureFormat::getChannelCount(format);
+        TextureFormat::swizzleToUsage(m_pixels, m_usage);
+        m_pixels = TextureFormat::truncateChannels(m_pixels, channelCount);
+        for (auto& mipPixels : m_mipPixels)
+        {
+            TextureFormat::swizzleToUsage(mipPixels, m_usage);
+            mipPixels = TextureFormat::truncateChannels(mipPixels, channelCount);
+        }
+        m_format = format;
+    }
+
+    void Texture::releasePixels()
+    {
+        m_pixels.clear();
+        m_pixels.shrink_to_fit();
+        m_mipPixels.clear();
+        m_mipPixels.shrink_to_fit();
+    }
+
+    void Texture::createTexture()
+    {
+        auto& device = Application::getDevice();
 
         WGPUTextureDescriptor textureDesc{WGPU_TEXTURE_DESCRIPTOR_INIT};
         textureDesc.label = StringView(m_name);
         textureDesc.dimension = WGPUTextureDimension_2D;
         textureDesc.size.width = m_width;
         textureDesc.size.height = m_height;
-        textureDesc.mipLevelCount = 1; // TODO
+        textureDesc.mipLevelCount = getMipLevelCount();
         textureDesc.sampleCount = 1; // TODO?
         textureDesc.format = m_format;
 
@@ -46,23 +253,32 @@ namespace webgpu
         WGPUTexture texture = wgpuDeviceCreateTexture(device.get(), &textureDesc);
         m_texture = std::shared_ptr<WGPUTextureImpl>(texture, [](WGPUTexture t) { wgpuTextureRelease(t); });
 
-        WGPUTexelCopyTextureInfo dest{WGPU_TEXEL_COPY_TEXTURE_INFO_INIT};
-        dest.texture = texture;
-        dest.mipLevel = 0;
-        dest.origin = { 0, 0, 0 };
-        dest.aspect = WGPUTextureAspect_All;
+        const auto formatInfo = TextureFormat::getInfo(m_format);
+        for (int mipLevel = 0; mipLevel < getMipLevelCount(); mipLevel++)
+        {
+            const int width = std::max(1, m_width >> mipLevel);
+            const int height = std::max(1, m_height >> mipLevel);
 
-        WGPUTexelCopyBufferLayout dataLayout{WGPU_TEXEL_COPY_BUFFER_LAYOUT_INIT};
-        dataLayout.offset = 0;
-        dataLayout.bytesPerRow = m_width * 4;
-        dataLayout.rowsPerImage = m_height;
+            WGPUTexelCopyTextureInfo dest{WGPU_TEXEL_COPY_TEXTURE_INFO_INIT};
+            dest.texture = texture;
+            dest.mipLevel = mipLevel;
+            dest.origin = { 0, 0, 0 };
+            dest.aspect = WGPUTextureAspect_All;
 
-        WGPUExtent3D writeSize{WGPU_EXTENT_3D_INIT};
-        writeSize.width = m_width;
-        writeSize.height = m_height;
-        writeSize.depthOrArrayLayers = 1;
+            WGPUTexelCopyBufferLayout dataLayout{WGPU_TEXEL_COPY_BUFFER_LAYOUT_INIT};
+            dataLayout.offset = 0;
+            dataLayout.bytesPerRow = formatInfo.bytesPerRow(width);
+            dataLayout.rowsPerImage = formatInfo.rowCount(height);
 
-        wgpuQueueWriteTexture(device.getQueue(), &dest, imageData.get(), m_width * m_height * 4, &dataLayout, &writeSize);
+            // Compressed mips smaller than a block are still copied as whole blocks
+            WGPUExtent3D writeSize{WGPU_EXTENT_3D_INIT};
+            writeSize.width = (width + formatInfo.blockWidth - 1) / formatInfo.blockWidth * formatInfo.blockWidth;
+            writeSize.height = formatInfo.rowCount(height) * formatInfo.blockHeight;
+            writeSize.depthOrArrayLayers = 1;
+
+            const auto& pixels = getPixels(mipLevel);
+            wgpuQueueWriteTexture(device.getQueue(), &dest, pixels.data(), pixels.size(), &dataLayout, &writeSize);
+        }
     }
 
     void Texture::createTextureView()
@@ -72,7 +288,7 @@ namespace webgpu
         textureViewDesc.baseArrayLayer = 0;
         textureViewDesc.arrayLayerCount = 1;
         textureViewDesc.baseMipLevel = 0;
-        textureViewDesc.mipLevelCount = 1;
+        textureViewDesc.mipLevelCount = getMipLevelCount();
         textureViewDesc.dimension = WGPUTextureViewDimension_2D;
         textureViewDesc.format = m_format;
 
@@ -90,6 +306,36 @@ namespace webgpu
         return m_textureView.get();
     }
 
+    WGPUTextureFormat Texture::getFormat() const
+    {
+        return m_format;
+    }
+
+    TextureUsage Texture::getUsage() const
+    {
+        return m_usage;
+    }
+
+    int Texture::getWidth() const
+    {
+        return m_width;
+    }
+
+    int Texture::getHeight() const
+    {
+        return m_height;
+    }
+
+    int Texture::getMipLevelCount() const
+    {
+        return 1 + static_cast<int>(m_mipPixels.size());
+    }
+
+    const std::vector<unsigned char>& Texture::getPixels(int mipLevel) const
+    {
+        return (mipLevel == 0) ? m_pixels : m_mipPixels.at(mipLevel - 1);
+    }
+
     int Texture::alignment()
     {
         return 1; // TODO?
@@ -1,8 +1,10 @@
 #pragma once
 #include <memory>
+#include <optional>
 
 #include "GpuData.h"
 #include "RenderTargetTextureView.h"
+#include "TextureFormat.h"
 
 namespace webgpu
 {
@@ -11,11 +13,23 @@ namespace webgpu
     class Texture : public GpuData
     {
     public:
-        explicit Texture(std::string_view name, bool isSrgb);
+        Texture(std::string_view name, TextureUsage usage);
+        Texture(std::string_view name, bool isSrgb, int width, int height, const std::vector<unsigned char>& pixels);
 
         void load() override;
+        void decode();
+        void generateMips(); // on the CPU, from the decoded RGBA8 pixels
+        void convertChannels(); // RGBA8 in glTF layout to the format of the usage, after generateMips()
+        void releasePixels();
+
         [[nodiscard]] WGPUTexture getTexture() const;
         [[nodiscard]] WGPUTextureView getTextureView() const;
+        [[nodiscard]] WGPUTextureFormat getFormat() const;
+        [[nodiscard]] TextureUsage getUsage() const;
+        [[nodiscard]] int getWidth() const;
+        [[nodiscard]] int getHeight() const;
+        [[nodiscard]] int getMipLevelCount() const;
+        [[nodiscard]] const std::vector<unsigned char>& getPixels(int mipLevel = 0) const;
 
         static WGPUBindGroupLayoutEntry getBindGroupLayoutEntry(int index);
         [[nodiscard]] WGPUBindGroupEntry getBindGroupEntry(int index) const;
@@ -27,9 +41,15 @@ namespace webgpu
         std::shared_ptr<WGPUTextureImpl> m_texture;
         std::shared_ptr<WGPUTextureViewImpl> m_textureView;
         WGPUTextureFormat m_format;
+        TextureUsage m_usage;
         int m_width;
         int m_height;
+        std::vector<unsigned char> m_pixels; // decoded pixels or blocks of m_format
+        std::vector<std::vector<unsigned char>> m_mipPixels; // levels 1+
 
+        bool decodeImage();
+        bool decodeKtx2();
+        static std::optional<WGPUTextureFormat> getKtx2Format(uint32_t vkFormat);
         void createTexture();
         void createTextureView();
     };
@@ -0,0 +1,202 @@
+#include "TextureArray.h"
+
+#include <algorithm>
+#include <spdlog/spdlog.h>
+
+#include "Application.h"
+#include "Device.h"
+#include "StringView.h"
+#include "Texture.h"
+#include "TextureFormat.h"
+
+namespace webgpu
+{
+    TextureArray::TextureArray(const std::string_view name, const WGPUTextureFormat format, const int width, const int height, const int layerCount, const int mipLevelCount, const bool isStorageTarget)
+    : m_name{name}, m_format{format}, m_width{width}, m_height{height}, m_layerCount{layerCount}, m_mipLevelCount{mipLevelCount}, m_isStorageTarget{isStorageTarget}
+    {
+        auto& device = Application::getDevice();
+
+        WGPUTextureDescriptor textureDesc{WGPU_TEXTURE_DESCRIPTOR_INIT};
+        textureDesc.label = StringView(m_name);
+        textureDesc.dimension = WGPUTextureDimension_2D;
+        textureDesc.size.width = width;
+        textureDesc.size.height = height;
+        textureDesc.size.depthOrArrayLayers = layerCount;
+        textureDesc.mipLevelCount = mipLevelCount;
+        textureDesc.sampleCount = 1;
+        textureDesc.format = format;
+        textureDesc.usage = WGPUTextureUsage_TextureBinding | WGPUTextureUsage_CopyDst | WGPUTextureUsage_CopySrc; // copied when grown
+        if (isStorageTarget)
+        {
+            textureDesc.usage |= WGPUTextureUsage_StorageBinding;
+            if (format == WGPUTextureFormat_RGBA8UnormSrgb)
+            {
+                textureDesc.format = WGPUTextureFormat_RGBA8Unorm;
+                textureDesc.viewFormatCount = 1;
+                textureDesc.viewFormats = &m_format;
+            }
+        }
+
+        WGPUTexture texture = wgpuDeviceCreateTexture(device.get(), &textureDesc);
+        m_texture = std::shared_ptr<WGPUTextureImpl>(texture, [](WGPUTexture t) { wgpuTextureRelease(t); });
+
+        // Always view as an array, even with a single layer, so that it matches texture_2d_array in the shader
+        WGPUTextureViewDescriptor textureViewDesc{WGPU_TEXTURE_VIEW_DESCRIPTOR_INIT};
+        textureViewDesc.aspect = WGPUTextureAspect_All;
+        textureViewDesc.baseArrayLayer = 0;
+        textureViewDesc.arrayLayerCount = layerCount;
+        textureViewDesc.baseMipLevel = 0;
+        textureViewDesc.mipLevelCount = mipLevelCount;
+        textureViewDesc.dimension = WGPUTextureViewDimension_2DArray;
+        textureViewDesc.format = format;
+
+        WGPUTextureView textureView = wgpuTextureCreateView(texture, &textureViewDesc);
+        m_textureView = std::shared_ptr<WGPUTextureViewImpl>(textureView, [](WGPUTextureView t) { wgpuTextureViewRelease(t); });
+    }
+
+    void TextureArray::writeLayer(const int layer, const Texture& texture, const int baseMipLevel) const
+    {
+        if ((std::max(1, texture.getWidth() >> baseMipLevel) != m_width) || (std::max(1, texture.getHeight() >> baseMipLevel) != m_height) || (texture.getFormat() != m_format))
+        {
+            spdlog::error("{} does not fit texture array {}", texture.getName(), m_name);
+            return;
+        }
+
+        auto& device = Application::getDevice();
+
+        const auto formatInfo = TextureFormat::getInfo(m_format);
+        const int mipLevelCount = std::min(texture.getMipLevelCount() - baseMipLevel, m_mipLevelCount);
+        for (int mipLevel = 0; mipLevel < mipLevelCount; mipLevel++)
+        {
+            const int width = std::max(1, m_width >> mipLevel);
+            const int height = std::max(1, m_height >> mipLevel);
+
+            WGPUTexelCopyTextureInfo dest{WGPU_TEXEL_COPY_TEXTURE_INFO_INIT};
+            dest.texture = m_texture.get();
+            dest.mipLevel = mipLevel;
+            dest.origin = { 0, 0, static_cast<uint32_t>(layer) };
+            dest.aspect = WGPUTextureAspect_All;
+
+            WGPUTexelCopyBufferLayout dataLayout{WGPU_TEXEL_COPY_BUFFER_LAYOUT_INIT};
+            dataLayout.offset = 0;
+            dataLayout.bytesPerRow = formatInfo.bytesPerRow(width);
+            dataLayout.rowsPerImage = formatInfo.rowCount(height);
+
+            // Compressed mips smaller than a block are still copied as whole blocks
+            WGPUExtent3D writeSize{WGPU_EXTENT_3D_INIT};
+            writeSize.width = (width + formatInfo.blockWidth - 1) / formatInfo.blockWidth * formatInfo.blockWidth;
+            writeSize.height = formatInfo.rowCount(height) * formatInfo.blockHeight;
+            writeSize.depthOrArrayLayers = 1;
+
+            const auto& pixels = texture.getPixels(baseMipLevel + mipLevel);
+            wgpuQueueWriteTexture(device.getQueue(), &dest, pixels.data(), pixels.size(), &dataLayout, &writeSize);
+        }
+    }
+
+    void TextureArray::copyLayers(const TextureArray& source, const int layerCount) const
+    {
+        if ((source.m_width != m_width) || (source.m_height != m_height) || (source.m_format != m_format) || (layerCount > std::min(source.m_layerCount, m_layerCount)))
+        {
+            spdlog::error("{} can't be copied to texture array {}", source.m_name, m_name);
+            return;
+        }
+
+        auto& device = Application::getDevice();
+        auto commandEncoder = device.createCommandEncoder();
+
+        const auto formatInfo = TextureFormat::getInfo(m_format);
+        const int mipLevelCount = std::min(source.m_mipLevelCount, m_mipLevelCount);
+        for (int mipLevel = 0; mipLevel < mipLevelCount; mipLevel++)
+        {
+            WGPUTexelCopyTextureInfo src{WGPU_TEXEL_COPY_TEXTURE_INFO_INIT};
+            src.texture = source.m_texture.get();
+            src.mipLevel = mipLevel;
+            src.aspect = WGPUTextureAspect_All;
+
+            WGPUTexelCopyTextureInfo dest{WGPU_TEXEL_COPY_TEXTURE_INFO_INIT};
+            dest.texture = m_texture.get();
+            dest.mipLevel = mipLevel;
+            dest.aspect = WGPUTextureAspect_All;
+
+            // As in writeLayer, compressed mips are copied as whole blocks
+            const int width = std::max(1, m_width >> mipLevel);
+            const int height = std::max(1, m_height >> mipLevel);
+            WGPUExtent3D copySize{WGPU_EXTENT_3D_INIT};
+            copySize.width = (width + formatInfo.blockWidth - 1) / formatInfo.blockWidth * formatInfo.blockWidth;
+            copySize.height = formatInfo.rowCount(height) * formatInfo.blockHeight;
+            copySize.depthOrArrayLayers = layerCount;
+
+            wgpuCommandEncoderCopyTextureToTexture(commandEncoder.get(), &src, &dest, &copySize);
+        }
+
+        WGPUCommandBufferDescriptor cmdBufferDescriptor{WGPU_COMMAND_BUFFER_DESCRIPTOR_INIT};
+        cmdBufferDescriptor.label = StringView("Texture array copy");
+        WGPUCommandBuffer command = wgpuCommandEncoderFinish(commandEncoder.get(), &cmdBufferDescriptor);
+        wgpuQueueSubmit(device.getQueue(), 1, &command);
+        wgpuCommandBufferRelease(command);
+    }
+
+    WGPUTexture TextureArray::getTexture() const
+    {
+        return m_texture.get();
+    }
+
+    WGPUTextureView TextureArray::getTextureView() const
+    {
+        return m_textureView.get();
+    }
+
+    WGPUTextureFormat TextureArray::getFormat() const
+    {
+        return m_format;
+    }
+
+    int TextureArray::getWidth() const
+    {
+        return m_width;
+    }
+
+    int TextureArray::getHeight() const
+    {
+        return m_height;
+    }
+
+    int TextureArray::getLayerCount() const
+    {
+        return m_layerCount;
+    }
+
+    int TextureArray::getMipLevelCount() const
+    {
+        return m_mipLevelCount;
+    }
+
+    bool TextureArray::isStorageTarget() const
+    {
+        return m_isStorageTarget;
+    }
+
+    std::string_view TextureArray::getName() const
+    {
+        return m_name;
+    }
+
+    WGPUBindGroupLayoutEntry TextureArray::getBindGroupLayoutEntry(int index)
+    {
+        WGPUBindGroupLayoutEntry textureBindGroupLayoutEntry{WGPU_BIND_GROUP_LAYOUT_ENTRY_INIT};
+        textureBindGroupLayoutEntry.binding = index;
+        textureBindGroupLayoutEntry.visibility = WGPUShaderStage_Fragment;
+        textureBindGroupLayoutEntry.texture.sampleType = WGPUTextureSampleType_Float;
+        textureBindGroupLayoutEntry.texture.viewDimension = WGPUTextureViewDimension_2DArray;
+        return textureBindGroupLayoutEntry;
+    }
+
+    WGPUBindGroupEntry TextureArray::getBindGroupEntry(int index) const
+    {
+        WGPUBindGroupEntry textureBindGroupEntry{WGPU_BIND_GROUP_ENTRY_INIT};
+        textureBindGroupEntry.binding = index;
+        textureBindGroupEntry.textureView = getTextureView();
+
+        return textureBindGroupEntry;
+    }
+}
@@ -0,0 +1,48 @@
+#pragma once
+#include <memory>
+#include <string>
+#include <webgpu/webgpu.h>
+
+namespace webgpu
+{
+    class Texture;
+
+    // A texture_2d_array holding same-size, same-format textures, one per layer
+    class TextureArray
+    {
+    public:
+        // A storage target can have its mips generated by MipGenerator; sRGB arrays are then stored as unorm and
+        // viewed as sRGB, since sRGB formats can't be storage textures
+        TextureArray(std::string_view name, WGPUTextureFormat format, int width, int height, int layerCount, int mipLevelCount = 1, bool isStorageTarget = false);
+
+        // Writes as many mip levels as the texture has, from baseMipLevel of the texture to level 0 of the array
+        void writeLayer(int layer, const Texture& texture, int baseMipLevel = 0) const;
+
+        // Copies layers [0, layerCount) of every mip level from a smaller array of the same size and format, on the GPU
+        void copyLayers(const TextureArray& source, int layerCount) const;
+
+        [[nodiscard]] WGPUTexture getTexture() const;
+        [[nodiscard]] WGPUTextureView getTextureView() const;
+        [[nodiscard]] WGPUTextureFormat getFormat() const;
+        [[nodiscard]] int getWidth() const;
+        [[nodiscard]] int getHeight() const;
+        [[nodiscard]] int getLayerCount() const;
+        [[nodiscard]] int getMipLevelCount() const;
+        [[nodiscard]] bool isStorageTarget() const;
+        [[nodiscard]] std::string_view getName() const;
+
+        static WGPUBindGroupLayoutEntry getBindGroupLayoutEntry(int index);
+        [[nodiscard]] WGPUBindGroupEntry getBindGroupEntry(int index) const;
+
+    private:
+        std::string m_name;
+        std::shared_ptr<WGPUTextureImpl> m_texture;
+        std::shared_ptr<WGPUTextureViewImpl> m_textureView;
+        WGPUTextureFormat m_format;
+        int m_width;
+        int m_height;
+        int m_layerCount;
+        int m_mipLevelCount;
+        bool m_isStorageTarget;
+    };
+}
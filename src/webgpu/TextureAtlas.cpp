@@ -0,0 +1,124 @@
+#include "TextureAtlas.h"
+
+#include <algorithm>
+#include <magic_enum/magic_enum.hpp>
+#include <spdlog/spdlog.h>
+
+#include "MipGenerator.h"
+#include "Texture.h"
+#include "TextureFormat.h"
+
+namespace webgpu
+{
+    TextureAtlas::TextureAtlas(int maxArrayCount, const MipGenerator* mipGenerator) : m_maxArrayCount{maxArrayCount}, m_mipGenerator{mipGenerator}
+    {
+    }
+
+    std::optional<TextureAtlas::Location> TextureAtlas::add(const Texture& texture, int baseMipLevel, int mipLevelCount)
+    {
+        const ArrayKey key{std::max(1, texture.getWidth() >> baseMipLevel), std::max(1, texture.getHeight() >> baseMipLevel), texture.getFormat(), mipLevelCount};
+        const auto arrayIndex = findArray(key);
+        if (!arrayIndex.has_value())
+        {
+            const auto& [width, height, format, _] = key;
+            spdlog::error("Out of texture arrays, {}x{} {} textures will not be shown", width, height, magic_enum::enum_name(format));
+            return std::nullopt;
+        }
+
+        auto& atlasArray = m_arrays.at(arrayIndex.value());
+        auto layer = atlasArray.allocator.allocate();
+        if (!layer.has_value())
+        {
+            grow(atlasArray, arrayIndex.value());
+            layer = atlasArray.allocator.allocate();
+        }
+
+        atlasArray.textureArray.writeLayer(layer.value(), texture, baseMipLevel);
+        if (atlasArray.textureArray.isStorageTarget() && (texture.getMipLevelCount() - baseMipLevel < mipLevelCount))
+        {
+            atlasArray.isComputingMips = true;
+        }
+        return Location{arrayIndex.value(), layer.value()};
+    }
+
+    void TextureAtlas::remove(const Location& location)
+    {
+        m_arrays.at(location.arrayIndex).allocator.free(location.layer);
+    }
+
+    bool TextureAtlas::flush()
+    {
+        for (auto& atlasArray : m_arrays)
+        {
+            if (atlasArray.isComputingMips)
+            {
+                // Every layer is downsampled again, which is cheaper than a dispatch per layer
+                m_mipGenerator->generate(atlasArray.textureArray);
+                atlasArray.isComputingMips = false;
+            }
+        }
+
+        const bool isChanged = m_isChanged;
+        m_isChanged = false;
+        return isChanged;
+    }
+
+    int TextureAtlas::getArrayCount() const
+    {
+        return static_cast<int>(m_arrays.size());
+    }
+
+    const TextureArray& TextureAtlas::getArray(int arrayIndex) const
+    {
+        return m_arrays.at(arrayIndex).textureArray;
+    }
+
+    std::optional<int> TextureAtlas::findArray(const ArrayKey& key)
+    {
+        for (int iArray = 0; iArray < m_arrays.size(); iArray++)
+        {
+            if (m_arrays.at(iArray).key == key)
+            {
+                return iArray;
+            }
+        }
+
+        const auto& [width, height, format, mipLevelCount] = key;
+        const bool isStorageTarget = (m_mipGenerator != nullptr) && (mipLevelCount > 1) && !TextureFormat::getInfo(format).isCompressed() && (TextureFormat::getChannelCount(format) == 4);
+        auto createArray = [&](int arrayIndex) {
+            m_isChanged = true;
+            spdlog::info("Texture array {}: {}x{} {}, {} mips", arrayIndex, width, height, magic_enum::enum_name(format), mipLevelCount);
+            return AtlasArray{key, TextureArray{"Texture array " + std::to_string(arrayIndex), format, width, height, INITIAL_LAYER_COUNT, mipLevelCount, isStorageTarget}, LayerAllocator{INITIAL_LAYER_COUNT}};
+        };
+
+        if (m_arrays.size() < m_maxArrayCount)
+        {
+            m_arrays.push_back(createArray(static_cast<int>(m_arrays.size())));
+            return static_cast<int>(m_arrays.size()) - 1;
+        }
+
+        // Sizes that streaming moved every texture out of can be reused
+        for (int iArray = 0; iArray < m_arrays.size(); iArray++)
+        {
+            if (m_arrays.at(iArray).allocator.getUsedCount() == 0)
+            {
+                m_arrays.at(iArray) = createArray(iArray);
+                return iArray;
+            }
+        }
+        return std::nullopt;
+    }
+
+    void TextureAtlas::grow(AtlasArray& atlasArray, int arrayIndex)
+    {
+        const auto& oldArray = atlasArray.textureArray;
+        const int layerCount = oldArray.getLayerCount() * 2;
+        TextureArray textureArray{"Texture array " + std::to_string(arrayIndex), oldArray.getFormat(), oldArray.getWidth(), oldArray.getHeight(), layerCount, oldArray.getMipLevelCount(), oldArray.isStorageTarget()};
+        textureArray.copyLayers(oldArray, oldArray.getLayerCount());
+        spdlog::debug("Texture array {}: grown to {} layers", arrayIndex, layerCount);
+
+        atlasArray.textureArray = std::move(textureArray);
+        atlasArray.allocator.grow(layerCount);
+        m_isChanged = true;
+    }
+}
@@ -0,0 +1,62 @@
+#pragma once
+#include <optional>
+#include <tuple>
+#include <vector>
+#include <webgpu/webgpu.h>
+
+#include "LayerAllocator.h"
+#include "TextureArray.h"
+
+namespace webgpu
+{
+    class MipGenerator;
+    class Texture;
+
+    // Packs same-size, same-format textures into the layers of shared texture_2d_arrays, so that materials refer to
+    // textures by (array, layer) and all of them bind at once. Arrays start small and grow by reallocation plus a GPU
+    // copy, so textures can be added as they're decoded or streamed in, without uploading the others again.
+    class TextureAtlas
+    {
+    public:
+        static constexpr int INITIAL_LAYER_COUNT = 4;
+
+        struct Location
+        {
+            int arrayIndex{0};
+            int layer{0};
+        };
+
+        // mipGenerator may be null; otherwise 4 channel arrays are storage targets and have their mips computed
+        TextureAtlas(int maxArrayCount, const MipGenerator* mipGenerator);
+
+        // Writes the texture from baseMipLevel down into an array of mipLevelCount levels. nullopt when out of arrays.
+        std::optional<Location> add(const Texture& texture, int baseMipLevel, int mipLevelCount);
+        void remove(const Location& location);
+
+        // Computes the mips of layers added since the last call, for textures that don't carry them. Returns true when
+        // an array was created or reallocated since the last call, so bind groups must be created again.
+        bool flush();
+
+        [[nodiscard]] int getArrayCount() const;
+        [[nodiscard]] const TextureArray& getArray(int arrayIndex) const;
+
+    private:
+        using ArrayKey = std::tuple<int, int, WGPUTextureFormat, int>; // width, height, format, mip level count
+
+        struct AtlasArray
+        {
+            ArrayKey key;
+            TextureArray textureArray;
+            LayerAllocator allocator;
+            bool isComputingMips{false}; // layers were written without their mips
+        };
+
+        int m_maxArrayCount;
+        const MipGenerator* m_mipGenerator;
+        std::vector<AtlasArray> m_arrays;
+        bool m_isChanged{false};
+
+        std::optional<int> findArray(const ArrayKey& key);
+        void grow(AtlasArray& atlasArray, int arrayIndex);
+    };
+}
@@ -0,0 +1,214 @@
+#include "TextureCooker.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <fstream>
+#include <magic_enum/magic_enum.hpp>
+#include <spdlog/spdlog.h>
+
+#include "stb_image.h"
+
+#include "BlockEncoder.h"
+#include "MipGenerator.h"
+#include "TextureFormat.h"
+#include "Util.h"
+#include "job/JobSystem.h"
+#include "resource/Ktx2.h"
+
+namespace webgpu
+{
+    namespace
+    {
+        constexpr int BLOCK_ROWS_PER_JOB = 16;
+
+        uint32_t getVkFormat(WGPUTextureFormat format)
+        {
+            switch (format)
+            {
+                case WGPUTextureFormat_BC4RUnorm:
+                    return resource::Ktx2::VK_FORMAT_BC4_UNORM_BLOCK;
+                case WGPUTextureFormat_BC5RGUnorm:
+                    return resource::Ktx2::VK_FORMAT_BC5_UNORM_BLOCK;
+                case WGPUTextureFormat_BC7RGBAUnormSrgb:
+                    return resource::Ktx2::VK_FORMAT_BC7_SRGB_BLOCK;
+                default:
+                    return resource::Ktx2::VK_FORMAT_BC7_UNORM_BLOCK;
+            }
+        }
+
+        // Box filtered normals are shorter than 1, which would darken lighting at a distance
+        void renormalize(std::vector<unsigned char>& pixels)
+        {
+            for (size_t iPixel = 0; iPixel < pixels.size(); iPixel += 4)
+            {
+                float normal[3];
+                float length = 0;
+                for (int c = 0; c < 3; c++)
+                {
+                    normal[c] = pixels.at(iPixel + c) / 127.5f - 1.0f;
+                    length += normal[c] * normal[c];
+                }
+                length = std::sqrt(length);
+                if (length < 1e-4f)
+                {
+                    continue;
+                }
+                for (int c = 0; c < 3; c++)
+                {
+                    pixels.at(iPixel + c) = static_cast<unsigned char>(std::lround((normal[c] / length + 1.0f) * 127.5f));
+                }
+            }
+        }
+    }
+
+    std::string TextureCooker::getCookedName(uint64_t contentHash, TextureUsage usage)
+    {
+        std::string usageName{magic_enum::enum_name(usage)};
+        std::ranges::transform(usageName, usageName.begin(), [](unsigned char c) { return std::tolower(c); });
+        return fmt::format("cooked/{:016x}-{}.ktx2", contentHash, usageName);
+    }
+
+    WGPUTextureFormat TextureCooker::getCookedFormat(TextureUsage usage)
+    {
+        switch (usage)
+        {
+            case TextureUsage::COLOR:
+                return WGPUTextureFormat_BC7RGBAUnormSrgb;
+            case TextureUsage::NORMAL:
+            case TextureUsage::METALLIC_ROUGHNESS:
+                return WGPUTextureFormat_BC5RGUnorm;
+            case TextureUsage::OCCLUSION:
+                return WGPUTextureFormat_BC4RUnorm;
+            default:
+                return WGPUTextureFormat_BC7RGBAUnorm;
+        }
+    }
+
+    TextureCooker::TextureCooker(job::JobSystem& jobSystem) : m_jobSystem{jobSystem}
+    {
+    }
+
+    void TextureCooker::addImage(std::string_view name, const char* data, size_t size, TextureUsage usage)
+    {
+        auto cookedName = getCookedName(Util::hashBytes(data, size), usage);
+        if (!m_cookedNames.insert(cookedName).second)
+        {
+            return;
+        }
+
+        auto& image = m_images.emplace_back();
+        image.name = name;
+        image.cookedName = std::move(cookedName);
+        image.data.assign(data, data + size);
+        image.usage = usage;
+    }
+
+    int TextureCooker::cook(const std::filesystem::path& resourceDir)
+    {
+        // Content hash naming makes an existing file up to date
+        std::erase_if(m_images, [&resourceDir](const CookedImage& image) { return std::filesystem::exists(resourceDir / image.cookedName); });
+
+        for (auto& image : m_images)
+        {
+            m_jobSystem.submit([&image] { decode(image); });
+        }
+        m_jobSystem.wait();
+
+        for (auto& image : m_images)
+        {
+            if (!image.isDecoded)
+            {
+                continue;
+            }
+
+            const auto format = getCookedFormat(image.usage);
+            for (int iLevel = 0; iLevel < image.levelPixels.size(); iLevel++)
+            {
+                const int width = std::max(1, image.width >> iLevel);
+                const int height = std::max(1, image.height >> iLevel);
+                const int blockRowCount = static_cast<int>(TextureFormat::getInfo(format).rowCount(height));
+                for (int firstBlockRow = 0; firstBlockRow < blockRowCount; firstBlockRow += BLOCK_ROWS_PER_JOB)
+                {
+                    m_jobSystem.submit([&image, format, iLevel, width, height, firstBlockRow] {
+                        BlockEncoder::encode(format, image.levelPixels.at(iLevel), width, height, firstBlockRow, BLOCK_ROWS_PER_JOB, image.levelBlocks.at(iLevel));
+                    });
+                }
+            }
+        }
+        m_jobSystem.wait();
+
+        int writtenCount = 0;
+        for (auto& image : m_images)
+        {
+            if (!image.isDecoded)
+            {
+                continue;
+            }
+
+            resource::Ktx2 ktx2;
+            ktx2.vkFormat = getVkFormat(getCookedFormat(image.usage));
+            ktx2.width = image.width;
+            ktx2.height = image.height;
+            ktx2.levels = std::move(image.levelBlocks);
+
+            std::string error;
+            auto data = resource::Ktx2::write(ktx2, error);
+            if (!data.has_value())
+            {
+                spdlog::error("Unable to cook {}: {}", image.name, error);
+                continue;
+            }
+
+            const auto path = resourceDir / image.cookedName;
+            std::filesystem::create_directories(path.parent_path());
+            std::ofstream ofs(path, std::ios::binary);
+            if (!ofs.write(data->data(), static_cast<std::streamsize>(data->size())))
+            {
+                spdlog::error("Unable to write {}", path.string());
+                continue;
+            }
+
+            spdlog::info("Cooked {} to {}, {}x{}, {} mips", image.name, image.cookedName, image.width, image.height, ktx2.levels.size());
+            writtenCount++;
+        }
+
+        m_images.clear();
+        return writtenCount;
+    }
+
+    void TextureCooker::decode(CookedImage& image)
+    {
+        int channels;
+        unsigned char* pixels = stbi_load_from_memory(reinterpret_cast<stbi_uc const*>(image.data.data()), static_cast<int>(image.data.size()), &image.width, &image.height, &channels, 4);
+        if (pixels == nullptr)
+        {
+            spdlog::error("Unable to decode {}: {}", image.name, stbi_failure_reason());
+            return;
+        }
+
+        const bool isSrgb = image.usage == TextureUsage::COLOR;
+        const auto formatInfo = TextureFormat::getInfo(getCookedFormat(image.usage));
+        const int levelCount = MipGenerator::getMipLevelCount(image.width, image.height);
+        image.levelPixels.emplace_back(pixels, pixels + (static_cast<size_t>(image.width) * image.height * 4));
+        stbi_image_free(pixels);
+        for (int iLevel = 1; iLevel < levelCount; iLevel++)
+        {
+            auto level = MipGenerator::downsample(image.levelPixels.back(), std::max(1, image.width >> (iLevel - 1)), std::max(1, image.height >> (iLevel - 1)), isSrgb);
+            if (image.usage == TextureUsage::NORMAL)
+            {
+                renormalize(level);
+            }
+            image.levelPixels.push_back(std::move(level));
+        }
+
+        for (int iLevel = 0; iLevel < levelCount; iLevel++)
+        {
+            TextureFormat::swizzleToUsage(image.levelPixels.at(iLevel), image.usage);
+            image.levelBlocks.emplace_back(formatInfo.byteSize(std::max(1, image.width >> iLevel), std::max(1, image.height >> iLevel)));
+        }
+
+        image.data.clear();
+        image.isDecoded = true;
+    }
+}
@@ -0,0 +1,60 @@
+#pragma once
+#include <cstdint>
+#include <deque>
+#include <filesystem>
+#include <set>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <webgpu/webgpu.h>
+
+#include "TextureFormat.h"
+
+namespace job
+{
+    class JobSystem;
+}
+
+namespace webgpu
+{
+    // Converts PNG/JPEG images into KTX2 files with full mip chains, ahead of time. Channels are laid out per usage
+    // as at runtime (see TextureFormat::swizzleToUsage): BC7 for color and ORM, BC5 for normals and
+    // metallic-roughness, BC4 for occlusion. Images are decoded and downsampled in parallel, then encoded in
+    // parallel by bands of blocks.
+    class TextureCooker
+    {
+    public:
+        // Relative to the resource directory. Named by the content hash of the source image, so that Model finds the
+        // cooked variant without a manifest and a changed image is cooked again.
+        static std::string getCookedName(uint64_t contentHash, TextureUsage usage);
+        static WGPUTextureFormat getCookedFormat(TextureUsage usage);
+
+        explicit TextureCooker(job::JobSystem& jobSystem);
+
+        // Queues an encoded image; images that were added or cooked before are skipped
+        void addImage(std::string_view name, const char* data, size_t size, TextureUsage usage);
+
+        // Writes the queued images below resourceDir and returns how many files were written
+        int cook(const std::filesystem::path& resourceDir);
+
+    private:
+        struct CookedImage
+        {
+            std::string name;
+            std::string cookedName;
+            std::vector<char> data;
+            TextureUsage usage;
+            bool isDecoded{false};
+            int width{0};
+            int height{0};
+            std::vector<std::vector<unsigned char>> levelPixels;
+            std::vector<std::vector<unsigned char>> levelBlocks;
+        };
+
+        job::JobSystem& m_jobSystem;
+        std::deque<CookedImage> m_images;
+        std::set<std::string> m_cookedNames;
+
+        static void decode(CookedImage& image);
+    };
+}
@@ -0,0 +1,201 @@
+#include "TextureFormat.h"
+
+namespace webgpu
+{
+    bool TextureFormatInfo::isCompressed() const
+    {
+        return (blockWidth > 1) || (blockHeight > 1);
+    }
+
+    uint32_t TextureFormatInfo::bytesPerRow(int width) const
+    {
+        return ((width + blockWidth - 1) / blockWidth) * bytesPerBlock;
+    }
+
+    uint32_t TextureFormatInfo::rowCount(int height) const
+    {
+        return (height + blockHeight - 1) / blockHeight;
+    }
+
+    uint64_t TextureFormatInfo::byteSize(int width, int height) const
+    {
+        return static_cast<uint64_t>(bytesPerRow(width)) * rowCount(height);
+    }
+
+    TextureFormatInfo TextureFormat::getInfo(WGPUTextureFormat format)
+    {
+        switch (format)
+        {
+            case WGPUTextureFormat_R8Unorm:
+                return {1, 1, 1};
+
+            case WGPUTextureFormat_RG8Unorm:
+                return {1, 1, 2};
+
+            case WGPUTextureFormat_BC1RGBAUnorm:
+            case WGPUTextureFormat_BC1RGBAUnormSrgb:
+            case WGPUTextureFormat_BC4RUnorm:
+            case WGPUTextureFormat_ETC2RGB8Unorm:
+            case WGPUTextureFormat_ETC2RGB8UnormSrgb:
+            case WGPUTextureFormat_ETC2RGB8A1Unorm:
+            case WGPUTextureFormat_ETC2RGB8A1UnormSrgb:
+                return {4, 4, 8};
+
+            case WGPUTextureFormat_BC3RGBAUnorm:
+            case WGPUTextureFormat_BC3RGBAUnormSrgb:
+            case WGPUTextureFormat_BC5RGUnorm:
+            case WGPUTextureFormat_BC7RGBAUnorm:
+            case WGPUTextureFormat_BC7RGBAUnormSrgb:
+            case WGPUTextureFormat_ETC2RGBA8Unorm:
+            case WGPUTextureFormat_ETC2RGBA8UnormSrgb:
+            case WGPUTextureFormat_ASTC4x4Unorm:
+            case WGPUTextureFormat_ASTC4x4UnormSrgb:
+                return {4, 4, 16};
+
+            case WGPUTextureFormat_RGBA8Unorm:
+            case WGPUTextureFormat_RGBA8UnormSrgb:
+            default:
+                return {1, 1, 4};
+        }
+    }
+
+    std::optional<WGPUFeatureName> TextureFormat::getRequiredFeature(WGPUTextureFormat format)
+    {
+        switch (format)
+        {
+            case WGPUTextureFormat_BC1RGBAUnorm:
+            case WGPUTextureFormat_BC1RGBAUnormSrgb:
+            case WGPUTextureFormat_BC3RGBAUnorm:
+            case WGPUTextureFormat_BC3RGBAUnormSrgb:
+            case WGPUTextureFormat_BC4RUnorm:
+            case WGPUTextureFormat_BC5RGUnorm:
+            case WGPUTextureFormat_BC7RGBAUnorm:
+            case WGPUTextureFormat_BC7RGBAUnormSrgb:
+                return WGPUFeatureName_TextureCompressionBC;
+
+            case WGPUTextureFormat_ETC2RGB8Unorm:
+            case WGPUTextureFormat_ETC2RGB8UnormSrgb:
+            case WGPUTextureFormat_ETC2RGB8A1Unorm:
+            case WGPUTextureFormat_ETC2RGB8A1UnormSrgb:
+            case WGPUTextureFormat_ETC2RGBA8Unorm:
+            case WGPUTextureFormat_ETC2RGBA8UnormSrgb:
+                return WGPUFeatureName_TextureCompressionETC2;
+
+            case WGPUTextureFormat_ASTC4x4Unorm:
+            case WGPUTextureFormat_ASTC4x4UnormSrgb:
+                return WGPUFeatureName_TextureCompressionASTC;
+
+            default:
+                return std::nullopt;
+        }
+    }
+
+    WGPUTextureFormat TextureFormat::withSrgb(WGPUTextureFormat format, bool isSrgb)
+    {
+        switch (format)
+        {
+            case WGPUTextureFormat_RGBA8Unorm:
+            case WGPUTextureFormat_RGBA8UnormSrgb:
+                return isSrgb ? WGPUTextureFormat_RGBA8UnormSrgb : WGPUTextureFormat_RGBA8Unorm;
+            case WGPUTextureFormat_BC1RGBAUnorm:
+            case WGPUTextureFormat_BC1RGBAUnormSrgb:
+                return isSrgb ? WGPUTextureFormat_BC1RGBAUnormSrgb : WGPUTextureFormat_BC1RGBAUnorm;
+            case WGPUTextureFormat_BC3RGBAUnorm:
+            case WGPUTextureFormat_BC3RGBAUnormSrgb:
+                return isSrgb ? WGPUTextureFormat_BC3RGBAUnormSrgb : WGPUTextureFormat_BC3RGBAUnorm;
+            case WGPUTextureFormat_BC7RGBAUnorm:
+            case WGPUTextureFormat_BC7RGBAUnormSrgb:
+                return isSrgb ? WGPUTextureFormat_BC7RGBAUnormSrgb : WGPUTextureFormat_BC7RGBAUnorm;
+            case WGPUTextureFormat_ETC2RGB8Unorm:
+            case WGPUTextureFormat_ETC2RGB8UnormSrgb:
+                return isSrgb ? WGPUTextureFormat_ETC2RGB8UnormSrgb : WGPUTextureFormat_ETC2RGB8Unorm;
+            case WGPUTextureFormat_ETC2RGB8A1Unorm:
+            case WGPUTextureFormat_ETC2RGB8A1UnormSrgb:
+                return isSrgb ? WGPUTextureFormat_ETC2RGB8A1UnormSrgb : WGPUTextureFormat_ETC2RGB8A1Unorm;
+            case WGPUTextureFormat_ETC2RGBA8Unorm:
+            case WGPUTextureFormat_ETC2RGBA8UnormSrgb:
+                return isSrgb ? WGPUTextureFormat_ETC2RGBA8UnormSrgb : WGPUTextureFormat_ETC2RGBA8Unorm;
+            case WGPUTextureFormat_ASTC4x4Unorm:
+            case WGPUTextureFormat_ASTC4x4UnormSrgb:
+                return isSrgb ? WGPUTextureFormat_ASTC4x4UnormSrgb : WGPUTextureFormat_ASTC4x4Unorm;
+            default:
+                return format;
+        }
+    }
+
+    bool TextureFormat::isSrgb(WGPUTextureFormat format)
+    {
+        switch (format)
+        {
+            case WGPUTextureFormat_RGBA8UnormSrgb:
+            case WGPUTextureFormat_BC1RGBAUnormSrgb:
+            case WGPUTextureFormat_BC3RGBAUnormSrgb:
+            case WGPUTextureFormat_BC7RGBAUnormSrgb:
+            case WGPUTextureFormat_ETC2RGB8UnormSrgb:
+            case WGPUTextureFormat_ETC2RGB8A1UnormSrgb:
+            case WGPUTextureFormat_ETC2RGBA8UnormSrgb:
+            case WGPUTextureFormat_ASTC4x4UnormSrgb:
+                return true;
+            default:
+                return false;
+        }
+    }
+
+    int TextureFormat::getChannelCount(WGPUTextureFormat format)
+    {
+        switch (format)
+        {
+            case WGPUTextureFormat_R8Unorm:
+            case WGPUTextureFormat_BC4RUnorm:
+                return 1;
+            case WGPUTextureFormat_RG8Unorm:
+            case WGPUTextureFormat_BC5RGUnorm:
+                return 2;
+            default:
+                return 4;
+        }
+    }
+
+    WGPUTextureFormat TextureFormat::getUncompressedFormat(TextureUsage usage)
+    {
+        switch (usage)
+        {
+            case TextureUsage::COLOR:
+                return WGPUTextureFormat_RGBA8UnormSrgb;
+            case TextureUsage::NORMAL:
+            case TextureUsage::METALLIC_ROUGHNESS:
+                return WGPUTextureFormat_RG8Unorm;
+            case TextureUsage::OCCLUSION:
+                return WGPUTextureFormat_R8Unorm;
+            default:
+                return WGPUTextureFormat_RGBA8Unorm;
+        }
+    }
+
+    void TextureFormat::swizzleToUsage(std::vector<unsigned char>& rgbaPixels, TextureUsage usage)
+    {
+        if (usage != TextureUsage::METALLIC_ROUGHNESS)
+        {
+            return; // the other layouts keep their leading channels
+        }
+
+        for (size_t iPixel = 0; iPixel < rgbaPixels.size(); iPixel += 4)
+        {
+            rgbaPixels[iPixel + 0] = rgbaPixels[iPixel + 1];
+            rgbaPixels[iPixel + 1] = rgbaPixels[iPixel + 2];
+        }
+    }
+
+    std::vector<unsigned char> TextureFormat::truncateChannels(const std::vector<unsigned char>& rgbaPixels, int channelCount)
+    {
+        std::vector<unsigned char> pixels(rgbaPixels.size() / 4 * channelCount);
+        for (size_t iPixel = 0; iPixel < rgbaPixels.size() / 4; iPixel++)
+        {
+            for (int c = 0; c < channelCount; c++)
+            {
+                pixels[iPixel * channelCount + c] = rgbaPixels[iPixel * 4 + c];
+            }
+        }
+        return pixels;
+    }
+}
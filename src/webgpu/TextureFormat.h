@@ -0,0 +1,46 @@
+#pragma once
+#include <cstdint>
+#include <optional>
+#include <vector>
+#include <webgpu/webgpu.h>
+
+namespace webgpu
+{
+    // How a material slot uses its texture, which decides color space, channels and compressed format
+    enum class TextureUsage
+    {
+        COLOR,              // sRGB RGBA
+        NORMAL,             // xy of a tangent space normal, z is rebuilt in the shader
+        OCCLUSION,          // R of the glTF occlusion texture
+        METALLIC_ROUGHNESS, // roughness, metallic: G and B of the glTF metallic-roughness texture
+        ORM,                // occlusion, roughness, metallic in R, G and B, when glTF shares one image for both
+    };
+
+    // Layout of the texture formats used for material textures. Uncompressed formats are 1x1 blocks.
+    struct TextureFormatInfo
+    {
+        int blockWidth{1};
+        int blockHeight{1};
+        int bytesPerBlock{4};
+
+        [[nodiscard]] bool isCompressed() const;
+        [[nodiscard]] uint32_t bytesPerRow(int width) const;
+        [[nodiscard]] uint32_t rowCount(int height) const; // rows of blocks
+        [[nodiscard]] uint64_t byteSize(int width, int height) const;
+    };
+
+    class TextureFormat
+    {
+    public:
+        static TextureFormatInfo getInfo(WGPUTextureFormat format);
+        static std::optional<WGPUFeatureName> getRequiredFeature(WGPUTextureFormat format);
+        static WGPUTextureFormat withSrgb(WGPUTextureFormat format, bool isSrgb); // unchanged if there's no variant
+        static bool isSrgb(WGPUTextureFormat format);
+        static int getChannelCount(WGPUTextureFormat format);
+
+        // Format of a decoded PNG/JPEG for the usage, and the channel layout changes to get there
+        static WGPUTextureFormat getUncompressedFormat(TextureUsage usage);
+        static void swizzleToUsage(std::vector<unsigned char>& rgbaPixels, TextureUsage usage); // in place, RGBA8 stays
+        static std::vector<unsigned char> truncateChannels(const std::vector<unsigned char>& rgbaPixels, int channelCount);
+    };
+}
@@ -0,0 +1,51 @@
+#include "TileCooker.h"
+
+#include <algorithm>
+#include <cstring>
+#include <spdlog/spdlog.h>
+
+#include "MipGenerator.h"
+
+namespace webgpu
+{
+    TileCooker::TileCooker(const VirtualTextureLayout& layout, std::vector<unsigned char> pixels, bool isSrgb) : m_layout{layout}
+    {
+        m_levels.push_back(std::move(pixels));
+        for (int mipLevel = 1; mipLevel < m_layout.getMipLevelCount(); mipLevel++)
+        {
+            m_levels.push_back(MipGenerator::downsample(m_levels.back(), std::max(1, m_layout.width >> (mipLevel - 1)), std::max(1, m_layout.height >> (mipLevel - 1)), isSrgb));
+        }
+    }
+
+    const VirtualTextureLayout& TileCooker::getLayout() const
+    {
+        return m_layout;
+    }
+
+    std::vector<unsigned char> TileCooker::cookTile(const PageId& page) const
+    {
+        const int tileSize = m_layout.getTileSize();
+        std::vector<unsigned char> tile(static_cast<size_t>(tileSize) * tileSize * 4);
+        if (!m_layout.isValid(page))
+        {
+            spdlog::error("Page {},{} of level {} is outside the virtual texture", page.x, page.y, page.mipLevel);
+            return tile;
+        }
+
+        const int width = std::max(1, m_layout.width >> page.mipLevel);
+        const int height = std::max(1, m_layout.height >> page.mipLevel);
+        const auto& pixels = m_levels.at(page.mipLevel);
+        const int originX = static_cast<int>(page.x) * m_layout.pageSize - m_layout.borderSize;
+        const int originY = static_cast<int>(page.y) * m_layout.pageSize - m_layout.borderSize;
+        for (int y = 0; y < tileSize; y++)
+        {
+            const int sourceY = std::clamp(originY + y, 0, height - 1);
+            for (int x = 0; x < tileSize; x++)
+            {
+                const int sourceX = std::clamp(originX + x, 0, width - 1);
+                std::memcpy(tile.data() + (static_cast<size_t>(y) * tileSize + x) * 4, pixels.data() + (static_cast<size_t>(sourceY) * width + sourceX) * 4, 4);
+            }
+        }
+        return tile;
+    }
+}
@@ -0,0 +1,25 @@
+#pragma once
+#include <vector>
+
+#include "VirtualTextureLayout.h"
+
+namespace webgpu
+{
+    // Cuts the mip chain of a virtual texture into tiles: a page of texels plus a border copied from the neighbouring
+    // pages, clamped at the texture's edges, so that filtering across page edges reads the right texels.
+    class TileCooker
+    {
+    public:
+        // RGBA8 pixels of level 0; the coarser levels are downsampled here
+        TileCooker(const VirtualTextureLayout& layout, std::vector<unsigned char> pixels, bool isSrgb);
+
+        [[nodiscard]] const VirtualTextureLayout& getLayout() const;
+
+        // RGBA8, getTileSize() texels square. Safe to call from jobs.
+        [[nodiscard]] std::vector<unsigned char> cookTile(const PageId& page) const;
+
+    private:
+        VirtualTextureLayout m_layout;
+        std::vector<std::vector<unsigned char>> m_levels;
+    };
+}
@@ -1,8 +1,12 @@
 #pragma once
 #include "Application.h"
 #include "Device.h"
+#include "DirtyRanges.h"
+#include "ShaderReflection.h"
 #include "Util.h"
+#include <utility>
 #include <vector>
+#include <spdlog/spdlog.h>
 #include <webgpu/webgpu.h>
 
 namespace webgpu
@@ -15,8 +19,20 @@ namespace webgpu
 
         [[nodiscard]] virtual WGPUBindGroupLayoutEntry getBindGroupLayoutEntry(int index) const = 0;
         [[nodiscard]] virtual WGPUBindGroupEntry getBindGroupEntry(int bindGroupEntryIndex, int offset) const = 0;
+
+        // By every uniform's write() since the last call
+        static uint64_t takeBytesWritten()
+        {
+            return std::exchange(m_bytesWritten, 0);
+        }
+
+    protected:
+        static constexpr uint64_t DEFAULT_MERGE_BYTES = 4096;
+
+        inline static uint64_t m_bytesWritten{0};
     };
 
+    // Instances are marked dirty when they're handed out for writing, and write() uploads only the dirty ones
     template <typename T> class Uniform : public BaseUniform
     {
     public:
@@ -25,24 +41,31 @@ namespace webgpu
             m_instances.emplace_back();
         }
 
-        Uniform(int count)
+        explicit Uniform(int count, WGPUBufferBindingType bindingType = WGPUBufferBindingType_Uniform) : m_bindingType{bindingType}
         {
             m_instances.reserve(count);
 
             auto& device = Application::getDevice();
             WGPUBufferDescriptor uniformBufferDesc = WGPU_BUFFER_DESCRIPTOR_INIT;
             uniformBufferDesc.size = Util::nextPow2Multiple(sizeof(T) * count, 4);
-            uniformBufferDesc.usage = WGPUBufferUsage_CopyDst | WGPUBufferUsage_Uniform;
+            uniformBufferDesc.usage = WGPUBufferUsage_CopyDst | (isStorage() ? WGPUBufferUsage_Storage : WGPUBufferUsage_Uniform);
             WGPUBuffer buffer = wgpuDeviceCreateBuffer(device.get(), &uniformBufferDesc);
             m_buffer = std::shared_ptr<WGPUBufferImpl>(buffer, [](WGPUBuffer b) { wgpuBufferRelease(b); });
         }
 
         T& getInstance()
         {
-            return m_instances.at(0);
+            return getInstance(0);
         }
 
         T& getInstance(int index)
+        {
+            T& instance = m_instances.at(index);
+            m_dirtyRanges.mark(index);
+            return instance;
+        }
+
+        const T& getInstance(int index) const
         {
             return m_instances.at(index);
         }
@@ -51,25 +74,55 @@ namespace webgpu
         {
             int index = m_instances.size();
             m_instances.emplace_back();
+            m_dirtyRanges.mark(index);
             return index;
         }
 
-        int size()
+        // Dirty ranges closer than this are uploaded as one, clean instances between them included
+        void setMergeBytes(uint64_t mergeBytes)
+        {
+            m_mergeBytes = mergeBytes;
+        }
+
+        [[nodiscard]] int size() const
         {
             return m_instances.size();
         }
 
+        [[nodiscard]] int capacity() const
+        {
+            return m_instances.capacity();
+        }
+
+        // Storage variants are bound as a single array covering the whole buffer, indexed in the shader
+        [[nodiscard]] bool isStorage() const
+        {
+            return m_bindingType != WGPUBufferBindingType_Uniform;
+        }
+
         [[nodiscard]] WGPUBuffer getBuffer() const
         {
             return m_buffer.get();
         }
 
+        // Logs an error if the shader's buffer at (group, binding) isn't laid out like T
+        bool validate(const ShaderReflection& reflection, int group, int binding) const
+        {
+            std::string error;
+            if (!reflection.validateBuffer(group, binding, sizeof(T), isStorage(), error))
+            {
+                spdlog::error("Uniform doesn't match the shader: {}", error);
+                return false;
+            }
+            return true;
+        }
+
         [[nodiscard]] WGPUBindGroupLayoutEntry getBindGroupLayoutEntry(int index) const override
         {
             WGPUBindGroupLayoutEntry bindGroupLayoutEntry = WGPU_BIND_GROUP_LAYOUT_ENTRY_INIT;
             bindGroupLayoutEntry.binding = index;
             bindGroupLayoutEntry.visibility = WGPUShaderStage_Vertex | WGPUShaderStage_Fragment;
-            bindGroupLayoutEntry.buffer.type = WGPUBufferBindingType_Uniform;
+            bindGroupLayoutEntry.buffer.type = m_bindingType;
             bindGroupLayoutEntry.buffer.minBindingSize = sizeof(T);
 
             return bindGroupLayoutEntry;
@@ -81,18 +134,26 @@ namespace webgpu
             bindGroupEntry.binding = bindGroupEntryIndex;
             bindGroupEntry.buffer = m_buffer.get();
             bindGroupEntry.offset = sizeof(T) * offset;
-            bindGroupEntry.size = sizeof(T);
+            bindGroupEntry.size = isStorage() ? wgpuBufferGetSize(m_buffer.get()) - bindGroupEntry.offset : sizeof(T);
 
             return bindGroupEntry;
         }
 
-        void write(WGPUQueue queue) const
+        void write(WGPUQueue queue)
         {
-            wgpuQueueWriteBuffer(queue, m_buffer.get(), 0, m_instances.data(), sizeof(T) * m_instances.capacity());
+            for (const auto& range : m_dirtyRanges.take(static_cast<int>(m_mergeBytes / sizeof(T))))
+            {
+                const uint64_t size = sizeof(T) * range.count;
+                wgpuQueueWriteBuffer(queue, m_buffer.get(), sizeof(T) * range.first, &m_instances.at(range.first), size);
+                m_bytesWritten += size;
+            }
         }
 
     private:
+        WGPUBufferBindingType m_bindingType;
         std::vector<T> m_instances;
         std::shared_ptr<WGPUBufferImpl> m_buffer;
+        DirtyRanges m_dirtyRanges;
+        uint64_t m_mergeBytes{DEFAULT_MERGE_BYTES};
     };
 }
@@ -5,19 +5,85 @@ struct FrameUniform
 {
     glm::mat4x4 projection{1.0};
     glm::mat4x4 view{1.0};
+    glm::mat4x4 inverseViewProjection{1.0}; // for rebuilding positions from depth
     glm::vec3 worldPosition{0.0};
     float time{0.0};
 };
 
+// Texture references are (texture array binding, layer)
 struct MaterialUniform
 {
-    // TODO
+    glm::vec4 baseColorFactor{1.0};
+    glm::vec3 emissiveFactor{0.0};
+    float alphaCutoff{0.5};
+    float metallicFactor{1.0};
+    float roughnessFactor{1.0};
+    float normalScale{1.0};
+    float occlusionStrength{1.0};
+    glm::uvec2 baseColorTexture{0};
+    glm::uvec2 metallicRoughnessTexture{0};
+    glm::uvec2 emissiveTexture{0};
+    glm::uvec2 occlusionTexture{0};
+    glm::uvec2 normalTexture{0};
+    uint32_t metallicRoughnessChannel{1}; // roughness; metallic is the next channel
+    uint32_t padding{0}; // array stride of Material in shader.wgsl is 96
 };
 
 struct ModelUniform
 {
     glm::mat4x4 matrix{1.0};
     glm::mat4x4 normalMatrix{1.0};
+    uint32_t materialIndex{0};
+    uint32_t padding[3]{}; // array stride of Model in shader.wgsl is 144
+};
+
+// See lights.wgsl
+struct LightUniform
+{
+    glm::vec3 position{0.0};
+    float range{1.0}; // the light fades out before reaching it
+    glm::vec3 color{1.0};
+    float intensity{1.0};
+};
+
+struct ClusterUniform
+{
+    glm::mat4x4 view{1.0};
+    glm::mat4x4 inverseProjection{1.0};
+    glm::uvec3 gridSize{0};
+    uint32_t lightCount{0};
+    glm::vec2 screenSize{0.0};
+    float zNear{0.0};
+    float zFar{0.0};
+};
+
+// See culling.wgsl
+struct CullingUniform
+{
+    glm::vec4 planes[6]{}; // inward normal and distance, normalized
+    uint32_t instanceCount{0};
+    uint32_t padding[3]{};
+};
+
+struct CullingInstanceUniform
+{
+    glm::vec3 center{0.0}; // world space bounding sphere
+    float radius{0.0};
+    uint32_t batchIndex{0};
+    uint32_t padding[3]{};
+};
+
+// Sizes in texels; see virtual_texture.wgsl
+struct VirtualTextureUniform
+{
+    glm::vec2 virtualSize{0.0};
+    glm::vec2 physicalSize{0.0};
+    float pageSize{0.0};
+    float borderSize{0.0};
+    uint32_t mipLevelCount{0};
+    uint32_t feedbackWidth{0};
+    uint32_t feedbackHeight{0};
+    uint32_t feedbackScale{0}; // screen pixels per feedback sample, per side
 };
 
 struct VertexAttributes
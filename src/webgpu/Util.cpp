@@ -19,6 +19,17 @@ namespace webgpu
 #endif
     }
 
+    uint64_t Util::hashBytes(const char* data, size_t size)
+    {
+        uint64_t hash = 0xcbf29ce484222325ull;
+        for (size_t iByte = 0; iByte < size; iByte++)
+        {
+            hash ^= static_cast<unsigned char>(data[iByte]);
+            hash *= 0x100000001b3ull;
+        }
+        return hash;
+    }
+
     glm::mat4x4 Util::vectorToMatrix(const std::vector<float>& v)
     {
         return {
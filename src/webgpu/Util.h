@@ -1,4 +1,5 @@
 #pragma once
+#include <cstdint>
 #include <glm/mat4x4.hpp>
 #include <vector>
 
@@ -15,6 +16,9 @@ namespace webgpu
 
         static void sleep(int millis);
 
+        // FNV-1a, for content identity rather than security
+        static uint64_t hashBytes(const char* data, size_t size);
+
         static glm::mat4x4 vectorToMatrix(const std::vector<float>& v);
         static glm::mat4 modelToNormalMatrix(const glm::mat4& modelMatrix);
     };
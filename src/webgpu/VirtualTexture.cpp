@@ -0,0 +1,282 @@
+#include "VirtualTexture.h"
+
+#include <spdlog/spdlog.h>
+
+#include "Application.h"
+#include "Device.h"
+#include "Sampler.h"
+#include "ShaderPreprocessor.h"
+#include "ShaderReflection.h"
+#include "StringView.h"
+#include "WebGpuInstance.h"
+#include "job/JobSystem.h"
+#include "resource/GltfResource.h"
+
+namespace webgpu
+{
+    VirtualTexture::VirtualTexture(ShaderPreprocessor& shaderPreprocessor, std::string_view name, std::shared_ptr<const TileCooker> tileCooker, int physicalPageCountX, int physicalPageCountY,
+        int screenWidth, int screenHeight)
+    : m_name{name}, m_tileCooker{std::move(tileCooker)}, m_layout{m_tileCooker->getLayout()}, m_pageManager{m_layout, physicalPageCountX, physicalPageCountY},
+    m_physicalPageCountX{physicalPageCountX}, m_feedbackWidth{(screenWidth + FEEDBACK_SCALE - 1) / FEEDBACK_SCALE}, m_feedbackHeight{(screenHeight + FEEDBACK_SCALE - 1) / FEEDBACK_SCALE},
+    m_readback{std::make_shared<Readback>()}, m_loadedTiles{std::make_shared<LoadedTiles>()}
+    {
+        auto& device = Application::getDevice();
+        const int mipLevelCount = m_layout.getMipLevelCount();
+
+        // The page table has a texel per page, so its mips must have as many texels as the levels have pages
+        for (int mipLevel = 0; mipLevel < mipLevelCount; mipLevel++)
+        {
+            if ((m_layout.getPageCountX(mipLevel) != std::max(1, m_layout.getPageCountX(0) >> mipLevel)) ||
+                (m_layout.getPageCountY(mipLevel) != std::max(1, m_layout.getPageCountY(0) >> mipLevel)))
+            {
+                spdlog::error("{} is {}x{}, which does not halve into whole pages of {} texels", m_name, m_layout.width, m_layout.height, m_layout.pageSize);
+                break;
+            }
+        }
+
+        WGPUTextureDescriptor pageTableDesc{WGPU_TEXTURE_DESCRIPTOR_INIT};
+        const std::string pageTableLabel = m_name + " page table";
+        pageTableDesc.label = StringView(pageTableLabel);
+        pageTableDesc.dimension = WGPUTextureDimension_2D;
+        pageTableDesc.size = {static_cast<uint32_t>(m_layout.getPageCountX(0)), static_cast<uint32_t>(m_layout.getPageCountY(0)), 1};
+        pageTableDesc.mipLevelCount = mipLevelCount;
+        pageTableDesc.sampleCount = 1;
+        pageTableDesc.format = WGPUTextureFormat_RGBA8Uint;
+        pageTableDesc.usage = WGPUTextureUsage_TextureBinding | WGPUTextureUsage_CopyDst;
+        WGPUTexture pageTable = wgpuDeviceCreateTexture(device.get(), &pageTableDesc);
+        m_pageTable = std::shared_ptr<WGPUTextureImpl>(pageTable, [](WGPUTexture t) { wgpuTextureRelease(t); });
+        WGPUTextureView pageTableView = wgpuTextureCreateView(pageTable, nullptr);
+        m_pageTableView = std::shared_ptr<WGPUTextureViewImpl>(pageTableView, [](WGPUTextureView t) { wgpuTextureViewRelease(t); });
+
+        const int tileSize = m_layout.getTileSize();
+        WGPUTextureDescriptor physicalDesc{WGPU_TEXTURE_DESCRIPTOR_INIT};
+        const std::string physicalLabel = m_name + " physical pages";
+        physicalDesc.label = StringView(physicalLabel);
+        physicalDesc.dimension = WGPUTextureDimension_2D;
+        physicalDesc.size = {static_cast<uint32_t>(physicalPageCountX * tileSize), static_cast<uint32_t>(physicalPageCountY * tileSize), 1};
+        physicalDesc.mipLevelCount = 1;
+        physicalDesc.sampleCount = 1;
+        physicalDesc.format = WGPUTextureFormat_RGBA8Unorm;
+        physicalDesc.usage = WGPUTextureUsage_TextureBinding | WGPUTextureUsage_CopyDst;
+        WGPUTexture physicalTexture = wgpuDeviceCreateTexture(device.get(), &physicalDesc);
+        m_physicalTexture = std::shared_ptr<WGPUTextureImpl>(physicalTexture, [](WGPUTexture t) { wgpuTextureRelease(t); });
+        WGPUTextureView physicalTextureView = wgpuTextureCreateView(physicalTexture, nullptr);
+        m_physicalTextureView = std::shared_ptr<WGPUTextureViewImpl>(physicalTextureView, [](WGPUTextureView t) { wgpuTextureViewRelease(t); });
+
+        WGPUBufferDescriptor feedbackDesc{WGPU_BUFFER_DESCRIPTOR_INIT};
+        const std::string feedbackLabel = m_name + " feedback";
+        feedbackDesc.label = StringView(feedbackLabel);
+        feedbackDesc.size = getFeedbackSize();
+        feedbackDesc.usage = WGPUBufferUsage_Storage | WGPUBufferUsage_CopySrc | WGPUBufferUsage_CopyDst;
+        WGPUBuffer feedbackBuffer = wgpuDeviceCreateBuffer(device.get(), &feedbackDesc);
+        m_feedbackBuffer = std::shared_ptr<WGPUBufferImpl>(feedbackBuffer, [](WGPUBuffer b) { wgpuBufferDestroy(b); wgpuBufferRelease(b); });
+
+        const std::string readbackLabel = m_name + " feedback readback";
+        feedbackDesc.label = StringView(readbackLabel);
+        feedbackDesc.usage = WGPUBufferUsage_MapRead | WGPUBufferUsage_CopyDst;
+        WGPUBuffer readbackBuffer = wgpuDeviceCreateBuffer(device.get(), &feedbackDesc);
+        m_readbackBuffer = std::shared_ptr<WGPUBufferImpl>(readbackBuffer, [](WGPUBuffer b) { wgpuBufferDestroy(b); wgpuBufferRelease(b); });
+
+        VirtualTextureUniform& uniform = m_uniform.getInstance();
+        uniform.virtualSize = {m_layout.width, m_layout.height};
+        uniform.physicalSize = {physicalDesc.size.width, physicalDesc.size.height};
+        uniform.pageSize = static_cast<float>(m_layout.pageSize);
+        uniform.borderSize = static_cast<float>(m_layout.borderSize);
+        uniform.mipLevelCount = mipLevelCount;
+        uniform.feedbackWidth = m_feedbackWidth;
+        uniform.feedbackHeight = m_feedbackHeight;
+        uniform.feedbackScale = FEEDBACK_SCALE;
+        m_uniform.write(device.getQueue());
+
+        std::string error;
+        const auto shaderSource = shaderPreprocessor.process(SHADER, {}, error);
+        const auto reflection = shaderSource.has_value() ? ShaderReflection::reflect(shaderSource.value(), error) : std::nullopt;
+        if (!reflection.has_value())
+        {
+            spdlog::error("Unable to load the virtual texture shader: {}", error);
+            return;
+        }
+
+        // The shader is a library without entry points, and only fragment shaders have derivatives to sample it with
+        m_uniform.validate(reflection.value(), GROUP, 0);
+        m_bindGroupLayout.addBindings(reflection.value(), GROUP, WGPUShaderStage_Fragment);
+        m_bindGroupLayout.create(m_name + " BindGroupLayout");
+
+        // Tiles carry their own borders, so clamping only matters for the last texel of the cache
+        resource::JSampler jSampler{};
+        jSampler.wrapS = GLWrapMode::CLAMP_TO_EDGE;
+        jSampler.wrapT = GLWrapMode::CLAMP_TO_EDGE;
+
+        WGPUBindGroupEntry pageTableEntry{WGPU_BIND_GROUP_ENTRY_INIT};
+        pageTableEntry.textureView = m_pageTableView.get();
+        WGPUBindGroupEntry physicalTextureEntry{WGPU_BIND_GROUP_ENTRY_INIT};
+        physicalTextureEntry.textureView = m_physicalTextureView.get();
+        WGPUBindGroupEntry feedbackEntry{WGPU_BIND_GROUP_ENTRY_INIT};
+        feedbackEntry.buffer = m_feedbackBuffer.get();
+        feedbackEntry.size = getFeedbackSize();
+
+        m_bindGroup.addUniform(m_uniform, 0);
+        m_bindGroup.addEntry(pageTableEntry);
+        m_bindGroup.addEntry(physicalTextureEntry);
+        m_bindGroup.addSampler(Sampler::get(jSampler));
+        m_bindGroup.addEntry(feedbackEntry);
+        m_bindGroup.create(m_name + " BindGroup", m_bindGroupLayout);
+
+        writePageTable();
+        spdlog::info("{}: {}x{}, {} levels of {} texel pages, {} physical pages", m_name, m_layout.width, m_layout.height, mipLevelCount, m_layout.pageSize, physicalPageCountX * physicalPageCountY);
+    }
+
+    VirtualTexture::~VirtualTexture()
+    {
+        // Map callbacks and load jobs only hold the shared state
+        if (m_readback->state == ReadbackState::MAPPED)
+        {
+            wgpuBufferUnmap(m_readbackBuffer.get());
+        }
+    }
+
+    void VirtualTexture::resolveFeedback(WGPUCommandEncoder commandEncoder)
+    {
+        if (m_readback->state == ReadbackState::IDLE)
+        {
+            wgpuCommandEncoderCopyBufferToBuffer(commandEncoder, m_feedbackBuffer.get(), 0, m_readbackBuffer.get(), 0, getFeedbackSize());
+            m_readback->state = ReadbackState::COPIED;
+        }
+        wgpuCommandEncoderClearBuffer(commandEncoder, m_feedbackBuffer.get(), 0, getFeedbackSize());
+    }
+
+    void VirtualTexture::readFeedback()
+    {
+        if (m_readback->state != ReadbackState::COPIED)
+        {
+            return;
+        }
+
+        m_readback->state = ReadbackState::MAPPING;
+        WGPUBufferMapCallbackInfo callbackInfo{WGPU_BUFFER_MAP_CALLBACK_INFO_INIT};
+        callbackInfo.mode = WGPUCallbackMode_AllowProcessEvents;
+        callbackInfo.callback = [](WGPUMapAsyncStatus status, WGPUStringView message, void* userdata1, void*) {
+            std::unique_ptr<std::weak_ptr<Readback>> weakReadback{static_cast<std::weak_ptr<Readback>*>(userdata1)};
+            if (auto readback = weakReadback->lock())
+            {
+                if (status != WGPUMapAsyncStatus_Success)
+                {
+                    spdlog::error("Unable to read virtual texture feedback: {}", StringView(message).toString());
+                }
+                readback->state = (status == WGPUMapAsyncStatus_Success) ? ReadbackState::MAPPED : ReadbackState::IDLE;
+            }
+        };
+        callbackInfo.userdata1 = new std::weak_ptr<Readback>(m_readback);
+        wgpuBufferMapAsync(m_readbackBuffer.get(), WGPUMapMode_Read, 0, getFeedbackSize(), callbackInfo);
+    }
+
+    void VirtualTexture::update()
+    {
+        Application::getWebGpuInstance().processEvents();
+
+        if (m_readback->state == ReadbackState::MAPPED)
+        {
+            const auto* feedback = static_cast<const uint32_t*>(wgpuBufferGetConstMappedRange(m_readbackBuffer.get(), 0, getFeedbackSize()));
+            const auto requests = PageManager::analyzeFeedback({feedback, static_cast<size_t>(m_feedbackWidth) * m_feedbackHeight}, m_layout);
+            wgpuBufferUnmap(m_readbackBuffer.get());
+            m_readback->state = ReadbackState::IDLE;
+
+            loadTiles(m_pageManager.update(requests, MAX_LOADS_PER_UPDATE));
+        }
+
+        if (uploadLoadedTiles())
+        {
+            writePageTable();
+        }
+    }
+
+    const BindGroupLayout& VirtualTexture::getBindGroupLayout() const
+    {
+        return m_bindGroupLayout;
+    }
+
+    const BindGroup& VirtualTexture::getBindGroup() const
+    {
+        return m_bindGroup;
+    }
+
+    PageManagerStats VirtualTexture::getStats() const
+    {
+        return m_pageManager.getStats();
+    }
+
+    uint64_t VirtualTexture::getFeedbackSize() const
+    {
+        return static_cast<uint64_t>(m_feedbackWidth) * m_feedbackHeight * sizeof(uint32_t);
+    }
+
+    void VirtualTexture::loadTiles(const std::vector<PageId>& pages)
+    {
+        for (const auto& page : pages)
+        {
+            Application::getJobSystem().submit([tileCooker = m_tileCooker, loadedTiles = m_loadedTiles, page] {
+                auto tile = tileCooker->cookTile(page);
+                std::lock_guard lock{loadedTiles->mutex};
+                loadedTiles->tiles.emplace_back(page, std::move(tile));
+            });
+        }
+    }
+
+    bool VirtualTexture::uploadLoadedTiles()
+    {
+        std::vector<std::pair<PageId, std::vector<unsigned char>>> tiles;
+        {
+            std::lock_guard lock{m_loadedTiles->mutex};
+            tiles.swap(m_loadedTiles->tiles);
+        }
+
+        auto& device = Application::getDevice();
+        const auto tileSize = static_cast<uint32_t>(m_layout.getTileSize());
+        bool isChanged = false;
+        for (const auto& [page, tile] : tiles)
+        {
+            const auto physicalPage = m_pageManager.makeResident(page);
+            if (!physicalPage.has_value())
+            {
+                continue;
+            }
+
+            WGPUTexelCopyTextureInfo dest{WGPU_TEXEL_COPY_TEXTURE_INFO_INIT};
+            dest.texture = m_physicalTexture.get();
+            dest.origin = {(physicalPage.value() % m_physicalPageCountX) * tileSize, (physicalPage.value() / m_physicalPageCountX) * tileSize, 0};
+            dest.aspect = WGPUTextureAspect_All;
+
+            WGPUTexelCopyBufferLayout dataLayout{WGPU_TEXEL_COPY_BUFFER_LAYOUT_INIT};
+            dataLayout.bytesPerRow = tileSize * 4;
+            dataLayout.rowsPerImage = tileSize;
+
+            const WGPUExtent3D writeSize{tileSize, tileSize, 1};
+            wgpuQueueWriteTexture(device.getQueue(), &dest, tile.data(), tile.size(), &dataLayout, &writeSize);
+            isChanged = true;
+        }
+        return isChanged;
+    }
+
+    void VirtualTexture::writePageTable() const
+    {
+        auto& device = Application::getDevice();
+        for (int mipLevel = 0; mipLevel < m_layout.getMipLevelCount(); mipLevel++)
+        {
+            const auto pageTable = m_pageManager.buildPageTable(mipLevel);
+            const auto pageCountX = static_cast<uint32_t>(m_layout.getPageCountX(mipLevel));
+            const auto pageCountY = static_cast<uint32_t>(m_layout.getPageCountY(mipLevel));
+
+            WGPUTexelCopyTextureInfo dest{WGPU_TEXEL_COPY_TEXTURE_INFO_INIT};
+            dest.texture = m_pageTable.get();
+            dest.mipLevel = mipLevel;
+            dest.aspect = WGPUTextureAspect_All;
+
+            WGPUTexelCopyBufferLayout dataLayout{WGPU_TEXEL_COPY_BUFFER_LAYOUT_INIT};
+            dataLayout.bytesPerRow = pageCountX * sizeof(uint32_t);
+            dataLayout.rowsPerImage = pageCountY;
+
+            const WGPUExtent3D writeSize{pageCountX, pageCountY, 1};
+            wgpuQueueWriteTexture(device.getQueue(), &dest, pageTable.data(), pageTable.size() * sizeof(uint32_t), &dataLayout, &writeSize);
+        }
+    }
+}
@@ -0,0 +1,99 @@
+#pragma once
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <webgpu/webgpu.h>
+
+#include "BindGroup.h"
+#include "BindGroupLayout.h"
+#include "PageManager.h"
+#include "TileCooker.h"
+#include "Uniform.h"
+#include "UniformsAndAttributes.h"
+
+namespace webgpu
+{
+    class ShaderPreprocessor;
+
+    // A texture too large to be resident, sampled through a page table into a cache of physical pages (see
+    // virtual_texture.wgsl). Fragments record the pages they need in a low resolution feedback buffer, which is read
+    // back asynchronously; PageManager decides what to load and evict, and tiles are cooked on the job system.
+    class VirtualTexture
+    {
+    public:
+        static constexpr std::string_view SHADER = "virtual_texture.wgsl";
+        static constexpr int GROUP = 3; // where sampling shaders bind it
+        static constexpr int FEEDBACK_SCALE = 8;
+        static constexpr int MAX_LOADS_PER_UPDATE = 16;
+
+        // The bind group layout is reflected from SHADER
+        VirtualTexture(ShaderPreprocessor& shaderPreprocessor, std::string_view name, std::shared_ptr<const TileCooker> tileCooker, int physicalPageCountX, int physicalPageCountY,
+            int screenWidth, int screenHeight);
+        ~VirtualTexture();
+
+        VirtualTexture(const VirtualTexture&) = delete;
+        VirtualTexture& operator=(const VirtualTexture&) = delete;
+
+        // After the passes that sample the texture: copies the feedback for reading back, unless a read back is still
+        // in flight, and clears it for the next frame
+        void resolveFeedback(WGPUCommandEncoder commandEncoder);
+
+        // After the commands from resolveFeedback() were submitted
+        void readFeedback();
+
+        // Call once per frame. Turns feedback that has been read back into tile loads, and uploads loaded tiles.
+        void update();
+
+        [[nodiscard]] const BindGroupLayout& getBindGroupLayout() const;
+        [[nodiscard]] const BindGroup& getBindGroup() const;
+        [[nodiscard]] PageManagerStats getStats() const;
+
+    private:
+        enum class ReadbackState
+        {
+            IDLE,
+            COPIED,
+            MAPPING,
+            MAPPED,
+        };
+
+        // Shared with the map callback, which may outlive this
+        struct Readback
+        {
+            ReadbackState state{ReadbackState::IDLE};
+        };
+
+        // Shared with load jobs
+        struct LoadedTiles
+        {
+            std::mutex mutex;
+            std::vector<std::pair<PageId, std::vector<unsigned char>>> tiles;
+        };
+
+        std::string m_name;
+        std::shared_ptr<const TileCooker> m_tileCooker;
+        VirtualTextureLayout m_layout;
+        PageManager m_pageManager;
+        int m_physicalPageCountX;
+        int m_feedbackWidth;
+        int m_feedbackHeight;
+        std::shared_ptr<WGPUTextureImpl> m_pageTable;
+        std::shared_ptr<WGPUTextureViewImpl> m_pageTableView;
+        std::shared_ptr<WGPUTextureImpl> m_physicalTexture;
+        std::shared_ptr<WGPUTextureViewImpl> m_physicalTextureView;
+        std::shared_ptr<WGPUBufferImpl> m_feedbackBuffer;
+        std::shared_ptr<WGPUBufferImpl> m_readbackBuffer;
+        std::shared_ptr<Readback> m_readback;
+        std::shared_ptr<LoadedTiles> m_loadedTiles;
+        Uniform<VirtualTextureUniform> m_uniform;
+        BindGroupLayout m_bindGroupLayout;
+        BindGroup m_bindGroup;
+
+        [[nodiscard]] uint64_t getFeedbackSize() const;
+        void loadTiles(const std::vector<PageId>& pages);
+        bool uploadLoadedTiles();
+        void writePageTable() const;
+    };
+}
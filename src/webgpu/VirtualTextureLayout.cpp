@@ -0,0 +1,55 @@
+#include "VirtualTextureLayout.h"
+
+#include <algorithm>
+
+namespace webgpu
+{
+    uint32_t PageId::pack() const
+    {
+        return (1u << 31) | ((mipLevel & 0x7f) << 24) | ((y & 0xfff) << 12) | (x & 0xfff);
+    }
+
+    std::optional<PageId> PageId::unpack(uint32_t packed)
+    {
+        if ((packed & (1u << 31)) == 0)
+        {
+            return std::nullopt;
+        }
+        return PageId{packed & 0xfff, (packed >> 12) & 0xfff, (packed >> 24) & 0x7f};
+    }
+
+    PageId PageId::getParent() const
+    {
+        return {x / 2, y / 2, mipLevel + 1};
+    }
+
+    int VirtualTextureLayout::getMipLevelCount() const
+    {
+        int mipLevelCount = 1;
+        while ((getPageCountX(mipLevelCount - 1) > 1) || (getPageCountY(mipLevelCount - 1) > 1))
+        {
+            mipLevelCount++;
+        }
+        return mipLevelCount;
+    }
+
+    int VirtualTextureLayout::getPageCountX(int mipLevel) const
+    {
+        return (std::max(1, width >> mipLevel) + pageSize - 1) / pageSize;
+    }
+
+    int VirtualTextureLayout::getPageCountY(int mipLevel) const
+    {
+        return (std::max(1, height >> mipLevel) + pageSize - 1) / pageSize;
+    }
+
+    int VirtualTextureLayout::getTileSize() const
+    {
+        return pageSize + 2 * borderSize;
+    }
+
+    bool VirtualTextureLayout::isValid(const PageId& page) const
+    {
+        return (page.mipLevel < getMipLevelCount()) && (page.x < getPageCountX(static_cast<int>(page.mipLevel))) && (page.y < getPageCountY(static_cast<int>(page.mipLevel)));
+    }
+}
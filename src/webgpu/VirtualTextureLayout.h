@@ -0,0 +1,41 @@
+#pragma once
+#include <compare>
+#include <cstdint>
+#include <optional>
+
+namespace webgpu
+{
+    // A page of a virtual texture: pageSize x pageSize texels of one mip level
+    struct PageId
+    {
+        uint32_t x{0};
+        uint32_t y{0};
+        uint32_t mipLevel{0};
+
+        // As written by the feedback pass: bit 31 set, 7 bits of mip level, 12 bits each of y and x. 0 is no sample,
+        // so that the feedback buffer can be cleared with ClearBuffer.
+        [[nodiscard]] uint32_t pack() const;
+        static std::optional<PageId> unpack(uint32_t packed);
+
+        [[nodiscard]] PageId getParent() const;
+
+        auto operator<=>(const PageId&) const = default;
+    };
+
+    struct VirtualTextureLayout
+    {
+        static constexpr int MAX_PAGE_COUNT = 4096; // per side, from the packed page id
+
+        int width{0};  // texels at level 0
+        int height{0};
+        int pageSize{128}; // texels per page side, without borders
+        int borderSize{4}; // filtering and anisotropy margin on each side of a tile
+
+        // Down to the level that fits in a single page
+        [[nodiscard]] int getMipLevelCount() const;
+        [[nodiscard]] int getPageCountX(int mipLevel) const;
+        [[nodiscard]] int getPageCountY(int mipLevel) const;
+        [[nodiscard]] int getTileSize() const; // pageSize + 2 * borderSize
+        [[nodiscard]] bool isValid(const PageId& page) const;
+    };
+}
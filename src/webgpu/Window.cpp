@@ -81,7 +81,7 @@ namespace webgpu
             {
                 const int width = event.window.data1;
                 const int height = event.window.data2;
-                Application::getSurface().configureSurface(width, height);
+                Application::getSurface().requestResize(width, height);
                 break;
             }
 
@@ -0,0 +1,38 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <atomic>
+#include <vector>
+
+#include "job/JobSystem.h"
+
+TEST_CASE("parallelFor runs every item once before returning", "JobSystem")
+{
+    job::JobSystem jobSystem{3};
+    std::vector<std::atomic<int>> runCounts(1000);
+    jobSystem.parallelFor(static_cast<int>(runCounts.size()), [&runCounts](int iItem) { runCounts.at(iItem)++; });
+
+    for (const auto& runCount : runCounts)
+    {
+        REQUIRE(runCount == 1);
+    }
+}
+
+TEST_CASE("parallelFor doesn't wait for other jobs", "JobSystem")
+{
+    job::JobSystem jobSystem{1};
+    std::atomic<bool> isReleased{false};
+    jobSystem.submit([&isReleased] {
+        while (!isReleased)
+        {
+        }
+    });
+
+    // The only worker is busy, so the caller has to run the items itself
+    int sum = 0;
+    jobSystem.parallelFor(4, [&sum](int iItem) { sum += iItem; });
+    REQUIRE(sum == 6);
+
+    isReleased = true;
+    jobSystem.wait();
+    jobSystem.parallelFor(0, [](int) {});
+}
@@ -0,0 +1,33 @@
+#include <vector>
+#include <catch2/catch_test_macros.hpp>
+
+#include "resource/Ktx2.h"
+
+TEST_CASE("KTX2 write and parse round trip", "Ktx2")
+{
+    resource::Ktx2 ktx2;
+    ktx2.vkFormat = resource::Ktx2::VK_FORMAT_BC7_SRGB_BLOCK;
+    ktx2.width = 8;
+    ktx2.height = 4;
+    ktx2.levels = {std::vector<unsigned char>(32, 1), std::vector<unsigned char>(16, 2), std::vector<unsigned char>(16, 3), std::vector<unsigned char>(16, 4)};
+
+    std::string error;
+    auto data = resource::Ktx2::write(ktx2, error);
+    REQUIRE(data.has_value());
+    REQUIRE(resource::Ktx2::isKtx2(data->data(), data->size()));
+
+    auto parsed = resource::Ktx2::parse(data->data(), data->size(), error);
+    REQUIRE(parsed.has_value());
+    REQUIRE(parsed->vkFormat == ktx2.vkFormat);
+    REQUIRE(parsed->width == 8);
+    REQUIRE(parsed->height == 4);
+    REQUIRE(parsed->levels == ktx2.levels);
+}
+
+TEST_CASE("KTX2 parse rejects truncated files", "Ktx2")
+{
+    const std::vector<char> data{static_cast<char>(0xAB), 'K', 'T', 'X', ' ', '2', '0'};
+    std::string error;
+    REQUIRE_FALSE(resource::Ktx2::parse(data.data(), data.size(), error).has_value());
+    REQUIRE_FALSE(error.empty());
+}
@@ -0,0 +1,47 @@
+#include <vector>
+#include <catch2/catch_test_macros.hpp>
+
+#include "webgpu/BlockDecoder.h"
+
+TEST_CASE("BC1 solid block", "BlockDecoder")
+{
+    // color0 = pure red in RGB565, all indices 0
+    const std::vector<unsigned char> block{0x00, 0xF8, 0x00, 0x00, 0, 0, 0, 0};
+    std::vector<unsigned char> pixels(16 * 4);
+    webgpu::BlockDecoder::decodeBC1(block.data(), pixels.data());
+    for (int iPixel = 0; iPixel < 16; iPixel++)
+    {
+        REQUIRE(pixels.at(iPixel * 4 + 0) == 255);
+        REQUIRE(pixels.at(iPixel * 4 + 1) == 0);
+        REQUIRE(pixels.at(iPixel * 4 + 2) == 0);
+        REQUIRE(pixels.at(iPixel * 4 + 3) == 255);
+    }
+}
+
+TEST_CASE("BC4 interpolates between endpoints", "BlockDecoder")
+{
+    // First pixel uses endpoint 0, second endpoint 1, third the first interpolated value
+    const std::vector<unsigned char> block{210, 140, 0b10'001'000, 0, 0, 0, 0, 0};
+    std::vector<unsigned char> pixels(16 * 4);
+    webgpu::BlockDecoder::decodeBC4(block.data(), pixels.data(), 0);
+    REQUIRE(pixels.at(0) == 210);
+    REQUIRE(pixels.at(4) == 140);
+    REQUIRE(pixels.at(8) == 200);
+}
+
+TEST_CASE("BC7 mode 6 block", "BlockDecoder")
+{
+    // Every endpoint, p-bit and index bit set: all pixels are endpoint 1, which is 255
+    std::vector<unsigned char> block(16, 0xFF);
+    block.at(0) = 0xC0;
+    std::vector<unsigned char> pixels(16 * 4);
+    webgpu::BlockDecoder::decodeBC7(block.data(), pixels.data());
+    REQUIRE(pixels == std::vector<unsigned char>(16 * 4, 255));
+}
+
+TEST_CASE("Decode pads partial blocks", "BlockDecoder")
+{
+    const std::vector<unsigned char> blocks{0x00, 0xF8, 0x00, 0x00, 0, 0, 0, 0};
+    auto pixels = webgpu::BlockDecoder::decode(WGPUTextureFormat_BC1RGBAUnorm, blocks, 2, 2);
+    REQUIRE(pixels == std::vector<unsigned char>{255, 0, 0, 255, 255, 0, 0, 255, 255, 0, 0, 255, 255, 0, 0, 255});
+}
@@ -0,0 +1,65 @@
+#include <cstdlib>
+#include <vector>
+#include <catch2/catch_test_macros.hpp>
+
+#include "webgpu/BlockDecoder.h"
+#include "webgpu/BlockEncoder.h"
+
+namespace
+{
+    int maxError(const std::vector<unsigned char>& a, const std::vector<unsigned char>& b)
+    {
+        int error = 0;
+        for (size_t i = 0; i < a.size(); i++)
+        {
+            error = std::max(error, std::abs(a.at(i) - b.at(i)));
+        }
+        return error;
+    }
+}
+
+TEST_CASE("BC7 round trip of a gradient", "BlockEncoder")
+{
+    std::vector<unsigned char> pixels(16 * 4);
+    for (int iPixel = 0; iPixel < 16; iPixel++)
+    {
+        pixels.at(iPixel * 4 + 0) = static_cast<unsigned char>(200 - iPixel * 10);
+        pixels.at(iPixel * 4 + 1) = static_cast<unsigned char>(40 + iPixel * 5);
+        pixels.at(iPixel * 4 + 2) = 90;
+        pixels.at(iPixel * 4 + 3) = 255;
+    }
+
+    std::vector<unsigned char> block(16);
+    std::vector<unsigned char> decoded(16 * 4);
+    webgpu::BlockEncoder::encodeBC7(pixels.data(), block.data());
+    webgpu::BlockDecoder::decodeBC7(block.data(), decoded.data());
+    REQUIRE(maxError(pixels, decoded) <= 4);
+}
+
+TEST_CASE("BC5 round trip keeps two channels", "BlockEncoder")
+{
+    std::vector<unsigned char> pixels(16 * 4);
+    for (int iPixel = 0; iPixel < 16; iPixel++)
+    {
+        pixels.at(iPixel * 4 + 0) = static_cast<unsigned char>(iPixel * 16);
+        pixels.at(iPixel * 4 + 1) = static_cast<unsigned char>(128 + (iPixel % 4) * 20);
+    }
+
+    std::vector<unsigned char> block(16);
+    std::vector<unsigned char> decoded(16 * 4);
+    webgpu::BlockEncoder::encodeBC5(pixels.data(), block.data());
+    webgpu::BlockDecoder::decodeBC5(block.data(), decoded.data());
+    for (int iPixel = 0; iPixel < 16; iPixel++)
+    {
+        REQUIRE(std::abs(decoded.at(iPixel * 4 + 0) - pixels.at(iPixel * 4 + 0)) <= 18); // half a palette step
+        REQUIRE(std::abs(decoded.at(iPixel * 4 + 1) - pixels.at(iPixel * 4 + 1)) <= 5);
+    }
+}
+
+TEST_CASE("Encode covers partial blocks", "BlockEncoder")
+{
+    const std::vector<unsigned char> pixels(6 * 5 * 4, 77);
+    std::vector<unsigned char> blocks(4 * 16);
+    webgpu::BlockEncoder::encode(WGPUTextureFormat_BC7RGBAUnorm, pixels, 6, 5, 0, 2, blocks);
+    REQUIRE(webgpu::BlockDecoder::decode(WGPUTextureFormat_BC7RGBAUnorm, blocks, 6, 5) == pixels);
+}
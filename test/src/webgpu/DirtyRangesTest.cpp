@@ -0,0 +1,46 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include "webgpu/DirtyRanges.h"
+
+using webgpu::DirtyRange;
+
+TEST_CASE("Dirty elements are taken as contiguous ranges", "DirtyRanges")
+{
+    webgpu::DirtyRanges dirtyRanges;
+    REQUIRE(dirtyRanges.isEmpty());
+
+    dirtyRanges.mark(7);
+    dirtyRanges.mark(2, 3);
+    dirtyRanges.mark(3);
+    dirtyRanges.mark(8);
+    REQUIRE(!dirtyRanges.isEmpty());
+    REQUIRE(dirtyRanges.take(0) == std::vector<DirtyRange>{{2, 3}, {7, 2}});
+
+    REQUIRE(dirtyRanges.isEmpty());
+    REQUIRE(dirtyRanges.take(0).empty());
+}
+
+TEST_CASE("Ranges separated by small gaps are merged", "DirtyRanges")
+{
+    webgpu::DirtyRanges dirtyRanges;
+    auto markAll = [&]() {
+        dirtyRanges.mark(0);
+        dirtyRanges.mark(3);
+        dirtyRanges.mark(10, 2);
+    };
+
+    markAll();
+    REQUIRE(dirtyRanges.take(1) == std::vector<DirtyRange>{{0, 1}, {3, 1}, {10, 2}});
+    markAll();
+    REQUIRE(dirtyRanges.take(2) == std::vector<DirtyRange>{{0, 4}, {10, 2}});
+    markAll();
+    REQUIRE(dirtyRanges.take(6) == std::vector<DirtyRange>{{0, 12}});
+}
+
+TEST_CASE("Invalid marks are ignored", "DirtyRanges")
+{
+    webgpu::DirtyRanges dirtyRanges;
+    dirtyRanges.mark(-1);
+    dirtyRanges.mark(4, 0);
+    REQUIRE(dirtyRanges.isEmpty());
+}
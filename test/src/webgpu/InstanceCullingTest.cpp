@@ -0,0 +1,47 @@
+#include <cmath>
+#include <catch2/catch_test_macros.hpp>
+#include <glm/ext/matrix_clip_space.hpp>
+
+#include "webgpu/InstanceCulling.h"
+
+namespace
+{
+    // A camera at the origin looking down -z, 90 degrees wide, so the side planes are at |x| = -z and |y| = -z
+    const auto PLANES = webgpu::InstanceCulling::getFrustumPlanes(glm::perspectiveZO(glm::radians(90.0f), 1.0f, 1.0f, 100.0f));
+
+    bool isInside(const glm::vec3& point)
+    {
+        for (const auto& plane : PLANES)
+        {
+            if (glm::dot(glm::vec3{plane}, point) + plane.w < 0.0f)
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+}
+
+TEST_CASE("Frustum planes are unit inward normals and distances", "InstanceCulling")
+{
+    for (const auto& plane : PLANES)
+    {
+        REQUIRE(std::abs(glm::length(glm::vec3{plane}) - 1.0f) < 1e-5f);
+    }
+
+    // Normalized, so a sphere's center is its radius away from the near plane when it touches it
+    REQUIRE(std::abs(glm::dot(glm::vec3{PLANES[4]}, glm::vec3{0.0f, 0.0f, -3.0f}) + PLANES[4].w - 2.0f) < 1e-4f);
+}
+
+TEST_CASE("Frustum planes bound the view volume", "InstanceCulling")
+{
+    REQUIRE(isInside({0.0f, 0.0f, -5.0f}));
+    REQUIRE(isInside({-4.0f, 4.0f, -5.0f}));
+    REQUIRE(!isInside({-6.0f, 0.0f, -5.0f})); // left
+    REQUIRE(!isInside({6.0f, 0.0f, -5.0f})); // right
+    REQUIRE(!isInside({0.0f, -6.0f, -5.0f})); // bottom
+    REQUIRE(!isInside({0.0f, 6.0f, -5.0f})); // top
+    REQUIRE(!isInside({0.0f, 0.0f, -0.5f})); // near
+    REQUIRE(!isInside({0.0f, 0.0f, 5.0f})); // behind
+    REQUIRE(!isInside({0.0f, 0.0f, -101.0f})); // far
+}
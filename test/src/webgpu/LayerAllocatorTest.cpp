@@ -0,0 +1,51 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include "webgpu/LayerAllocator.h"
+
+TEST_CASE("Layers are allocated in order until full", "LayerAllocator")
+{
+    webgpu::LayerAllocator allocator{2};
+    REQUIRE(allocator.allocate() == 0);
+    REQUIRE(allocator.allocate() == 1);
+    REQUIRE(!allocator.allocate().has_value());
+    REQUIRE(allocator.getUsedCount() == 2);
+}
+
+TEST_CASE("Freed layers are reused lowest first", "LayerAllocator")
+{
+    webgpu::LayerAllocator allocator{4};
+    for (int i = 0; i < 4; i++)
+    {
+        allocator.allocate();
+    }
+    allocator.free(2);
+    allocator.free(1);
+    REQUIRE(!allocator.isUsed(1));
+    REQUIRE(allocator.getUsedCount() == 2);
+    REQUIRE(allocator.allocate() == 1);
+    REQUIRE(allocator.allocate() == 2);
+    REQUIRE(!allocator.allocate().has_value());
+}
+
+TEST_CASE("Growing keeps allocated layers", "LayerAllocator")
+{
+    webgpu::LayerAllocator allocator{1};
+    REQUIRE(allocator.allocate() == 0);
+    allocator.grow(3);
+    REQUIRE(allocator.getCapacity() == 3);
+    REQUIRE(allocator.isUsed(0));
+    REQUIRE(allocator.allocate() == 1);
+    REQUIRE(allocator.allocate() == 2);
+
+    allocator.grow(2); // never shrinks
+    REQUIRE(allocator.getCapacity() == 3);
+}
+
+TEST_CASE("Freeing an unallocated layer is ignored", "LayerAllocator")
+{
+    webgpu::LayerAllocator allocator{2};
+    allocator.free(0);
+    allocator.free(5);
+    REQUIRE(allocator.getUsedCount() == 0);
+    REQUIRE(allocator.allocate() == 0);
+}
@@ -0,0 +1,55 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include "resource/GltfResource.h"
+#include "webgpu/Material.h"
+
+TEST_CASE("Materials with different alpha modes get different feature keys", "Material")
+{
+    resource::JMaterial opaque;
+    resource::JMaterial blend;
+    blend.alphaMode = "BLEND";
+    resource::JMaterial mask;
+    mask.alphaMode = "MASK";
+
+    const auto opaqueKey = webgpu::Material::getFeatureKey(opaque);
+    const auto blendKey = webgpu::Material::getFeatureKey(blend);
+    const auto maskKey = webgpu::Material::getFeatureKey(mask);
+    REQUIRE(opaqueKey.alphaMode == webgpu::GLAlphaMode::OPAQUE);
+    REQUIRE(blendKey.alphaMode == webgpu::GLAlphaMode::BLEND);
+    REQUIRE(opaqueKey != blendKey);
+    REQUIRE(opaqueKey.pack() != blendKey.pack());
+
+    // Blended materials sort after opaque and masked ones
+    REQUIRE(opaqueKey < maskKey);
+    REQUIRE(maskKey < blendKey);
+}
+
+TEST_CASE("Feature keys record double-sidedness and texture slots", "Material")
+{
+    resource::JMaterial jMaterial;
+    jMaterial.doubleSided = true;
+    jMaterial.pbrMetallicRoughness.baseColorTexture.index = 0;
+    jMaterial.normalTexture.index = 1;
+
+    const auto key = webgpu::Material::getFeatureKey(jMaterial);
+    REQUIRE(key.isDoubleSided);
+    REQUIRE(key.textureSlots == (webgpu::MaterialFeatureKey::ALBEDO_TEXTURE | webgpu::MaterialFeatureKey::NORMAL_TEXTURE));
+
+    resource::JMaterial withoutNormal = jMaterial;
+    withoutNormal.normalTexture.index = -1;
+    REQUIRE(webgpu::Material::getFeatureKey(withoutNormal) != key);
+}
+
+TEST_CASE("Materials with the same features are shared", "Material")
+{
+    resource::JMaterial a;
+    a.name = "a";
+    a.pbrMetallicRoughness.metallicFactor = 0.25f;
+    resource::JMaterial b;
+    b.name = "b";
+    resource::JMaterial c;
+    c.alphaMode = "BLEND";
+
+    REQUIRE(&webgpu::Material::get(a) == &webgpu::Material::get(b));
+    REQUIRE(&webgpu::Material::get(a) != &webgpu::Material::get(c));
+}
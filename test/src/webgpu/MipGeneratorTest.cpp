@@ -0,0 +1,42 @@
+#include <vector>
+#include <catch2/catch_test_macros.hpp>
+
+#include "webgpu/MipGenerator.h"
+
+TEST_CASE("Mip level count", "MipGenerator")
+{
+    REQUIRE(webgpu::MipGenerator::getMipLevelCount(1, 1) == 1);
+    REQUIRE(webgpu::MipGenerator::getMipLevelCount(2, 2) == 2);
+    REQUIRE(webgpu::MipGenerator::getMipLevelCount(1024, 1024) == 11);
+    REQUIRE(webgpu::MipGenerator::getMipLevelCount(1024, 16) == 11);
+    REQUIRE(webgpu::MipGenerator::getMipLevelCount(5, 3) == 3);
+}
+
+TEST_CASE("Linear downsample averages 2x2 blocks", "MipGenerator")
+{
+    // 4x2, so that both destination pixels go through the same path
+    std::vector<unsigned char> pixels{
+        0, 10, 20, 255,   4, 14, 24, 255,   100, 0, 0, 0,   200, 0, 0, 0,
+        0, 10, 20, 255,   4, 14, 24, 255,   100, 0, 0, 0,   200, 0, 0, 0};
+    auto result = webgpu::MipGenerator::downsample(pixels, 4, 2, false);
+    REQUIRE(result == std::vector<unsigned char>{2, 12, 22, 255, 150, 0, 0, 0});
+}
+
+TEST_CASE("sRGB downsample is gamma correct", "MipGenerator")
+{
+    std::vector<unsigned char> pixels{
+        0, 0, 0, 0,         255, 255, 255, 255,
+        255, 255, 255, 255, 0, 0, 0, 0};
+    auto result = webgpu::MipGenerator::downsample(pixels, 2, 2, true);
+
+    // Linear 0.5 is sRGB 188, where a naive average would give 128. Alpha stays linear.
+    REQUIRE(result == std::vector<unsigned char>{188, 188, 188, 128});
+}
+
+TEST_CASE("Odd sizes clamp to the last row and column", "MipGenerator")
+{
+    std::vector<unsigned char> pixels{
+        10, 10, 10, 10,   20, 20, 20, 20,   90, 90, 90, 90};
+    auto result = webgpu::MipGenerator::downsample(pixels, 3, 1, false);
+    REQUIRE(result == std::vector<unsigned char>{15, 15, 15, 15});
+}
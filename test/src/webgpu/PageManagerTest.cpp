@@ -0,0 +1,123 @@
+#include <vector>
+#include <catch2/catch_test_macros.hpp>
+
+#include "webgpu/PageManager.h"
+
+namespace
+{
+    // 1024x1024 in 256 texel pages: 4x4, 2x2 and 1x1 pages
+    webgpu::VirtualTextureLayout createLayout()
+    {
+        return webgpu::VirtualTextureLayout{1024, 1024, 256, 4};
+    }
+}
+
+TEST_CASE("Page ids round trip through the feedback encoding", "PageManager")
+{
+    const webgpu::PageId page{4095, 17, 9};
+    REQUIRE(webgpu::PageId::unpack(page.pack()) == page);
+    REQUIRE(!webgpu::PageId::unpack(0).has_value());
+    REQUIRE(page.getParent() == webgpu::PageId{2047, 8, 10});
+}
+
+TEST_CASE("Layout levels go down to a single page", "PageManager")
+{
+    const auto layout = createLayout();
+    REQUIRE(layout.getMipLevelCount() == 3);
+    REQUIRE(layout.getPageCountX(0) == 4);
+    REQUIRE(layout.getPageCountY(1) == 2);
+    REQUIRE(layout.isValid({3, 3, 0}));
+    REQUIRE(!layout.isValid({2, 0, 1}));
+    REQUIRE(!layout.isValid({0, 0, 3}));
+
+    const webgpu::VirtualTextureLayout wide{1000, 100, 128, 4};
+    REQUIRE(wide.getPageCountX(0) == 8);
+    REQUIRE(wide.getPageCountY(0) == 1);
+    REQUIRE(wide.getMipLevelCount() == 4);
+}
+
+TEST_CASE("Feedback is counted, with ancestors, coarsest first", "PageManager")
+{
+    const auto layout = createLayout();
+    const std::vector<uint32_t> feedback{
+        0, webgpu::PageId{0, 0, 0}.pack(), webgpu::PageId{3, 3, 0}.pack(), webgpu::PageId{3, 3, 0}.pack(),
+        webgpu::PageId{9, 9, 0}.pack(), 0, webgpu::PageId{3, 3, 0}.pack(), 0};
+
+    const auto requests = webgpu::PageManager::analyzeFeedback(feedback, layout);
+    REQUIRE(requests.size() == 5);
+    REQUIRE(requests.at(0).page == webgpu::PageId{0, 0, 2});
+    REQUIRE(requests.at(0).sampleCount == 4);
+    REQUIRE(requests.at(1).page == webgpu::PageId{1, 1, 1});
+    REQUIRE(requests.at(1).sampleCount == 3);
+    REQUIRE(requests.at(2).page == webgpu::PageId{0, 0, 1});
+    REQUIRE(requests.at(3).page == webgpu::PageId{3, 3, 0});
+    REQUIRE(requests.at(3).sampleCount == 3);
+    REQUIRE(requests.at(4).page == webgpu::PageId{0, 0, 0});
+}
+
+TEST_CASE("Loads are limited per update and not requested twice", "PageManager")
+{
+    const auto layout = createLayout();
+    webgpu::PageManager pageManager{layout, 2, 2};
+    const std::vector<uint32_t> feedback{webgpu::PageId{0, 0, 0}.pack(), webgpu::PageId{3, 0, 0}.pack()};
+    const auto requests = webgpu::PageManager::analyzeFeedback(feedback, layout);
+
+    auto loads = pageManager.update(requests, 2);
+    REQUIRE(loads == std::vector<webgpu::PageId>{{0, 0, 2}, {0, 0, 1}});
+
+    loads = pageManager.update(requests, 8);
+    REQUIRE(loads == std::vector<webgpu::PageId>{{1, 0, 1}, {0, 0, 0}, {3, 0, 0}});
+    REQUIRE(pageManager.getStats().loadingPageCount == 5);
+}
+
+TEST_CASE("Least recently used pages are evicted, the coarsest level never", "PageManager")
+{
+    const auto layout = createLayout();
+    webgpu::PageManager pageManager{layout, 3, 1};
+
+    const std::vector<webgpu::PageRequest> first{{{0, 0, 2}, 1}, {{0, 0, 1}, 1}, {{1, 0, 1}, 1}};
+    for (const auto& page : pageManager.update(first, 8))
+    {
+        REQUIRE(pageManager.makeResident(page).has_value());
+    }
+    REQUIRE(pageManager.getStats().residentPageCount == 3);
+
+    // Everything is in use this frame, so nothing can make room
+    const std::vector<webgpu::PageRequest> second{{{0, 0, 2}, 1}, {{0, 0, 1}, 1}, {{1, 0, 1}, 1}, {{0, 1, 1}, 1}};
+    auto loads = pageManager.update(second, 8);
+    REQUIRE(loads == std::vector<webgpu::PageId>{{0, 1, 1}});
+    REQUIRE(!pageManager.makeResident(loads.at(0)).has_value());
+
+    // {1, 0, 1} was used longest ago; {0, 0, 2} is older still but pinned
+    const std::vector<webgpu::PageRequest> third{{{0, 0, 1}, 1}, {{0, 1, 1}, 1}};
+    loads = pageManager.update(third, 8);
+    REQUIRE(loads == std::vector<webgpu::PageId>{{0, 1, 1}});
+    const auto physicalPage = pageManager.makeResident(loads.at(0));
+    REQUIRE(physicalPage.has_value());
+    REQUIRE(!pageManager.getPhysicalPage({1, 0, 1}).has_value());
+    REQUIRE(pageManager.getPhysicalPage({0, 0, 2}).has_value());
+    REQUIRE(pageManager.getStats().evictionCount == 1);
+}
+
+TEST_CASE("Page tables fall back to the finest resident ancestor", "PageManager")
+{
+    const auto layout = createLayout();
+    webgpu::PageManager pageManager{layout, 2, 2};
+    const std::vector<webgpu::PageRequest> requests{{{0, 0, 2}, 1}, {{1, 1, 1}, 1}};
+    for (const auto& page : pageManager.update(requests, 8))
+    {
+        pageManager.makeResident(page);
+    }
+
+    const auto level0 = pageManager.buildPageTable(0);
+    REQUIRE(level0.size() == 16);
+    REQUIRE(level0.at(0) == (0u | (0u << 8) | (2u << 16) | (255u << 24))); // physical page 0, level 2
+    REQUIRE(level0.at(3 * 4 + 3) == (1u | (0u << 8) | (1u << 16) | (255u << 24))); // physical page 1, level 1
+
+    const auto level2 = pageManager.buildPageTable(2);
+    REQUIRE(level2.size() == 1);
+    REQUIRE(level2.at(0) == level0.at(0));
+
+    webgpu::PageManager emptyPageManager{layout, 2, 2};
+    REQUIRE(emptyPageManager.buildPageTable(1) == std::vector<uint32_t>(4, 0));
+}
@@ -0,0 +1,105 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include "webgpu/RenderGraph.h"
+
+using webgpu::RenderGraph;
+using webgpu::RenderGraphAttachmentOps;
+
+namespace
+{
+    bool compile(RenderGraph& graph)
+    {
+        std::string error;
+        return graph.compile(error);
+    }
+}
+
+TEST_CASE("Load and store ops follow how attachments are used", "RenderGraph")
+{
+    RenderGraph graph;
+    const auto surface = graph.importTexture("surface", nullptr);
+    const auto color = graph.createTexture({"color", WGPUTextureFormat_BGRA8Unorm, 4});
+    const auto depth = graph.createTexture({"depth", WGPUTextureFormat_Depth24Plus, 4});
+    const auto overlayDepth = graph.createTexture({"overlay depth", WGPUTextureFormat_Depth24Plus, 4});
+    graph.addPass({.name = "scene", .colorAttachments = {{color}}, .depthAttachment = depth});
+    graph.addPass({.name = "overlay", .colorAttachments = {{color, surface}}, .depthAttachment = overlayDepth});
+    REQUIRE(compile(graph));
+
+    const auto& passes = graph.getCompiledPasses();
+    REQUIRE(passes.size() == 2);
+    REQUIRE(passes.at(0).colorOps.at(0) == RenderGraphAttachmentOps{WGPULoadOp_Clear, WGPUStoreOp_Store});
+    REQUIRE(passes.at(0).depthOps.value() == RenderGraphAttachmentOps{WGPULoadOp_Clear, WGPUStoreOp_Discard});
+    REQUIRE(passes.at(1).colorOps.at(0) == RenderGraphAttachmentOps{WGPULoadOp_Load, WGPUStoreOp_Discard});
+
+    // The depth textures are never used at the same time
+    REQUIRE(graph.getPhysicalTextureCount() == 2);
+    REQUIRE(graph.getPhysicalTexture(depth) == graph.getPhysicalTexture(overlayDepth));
+    REQUIRE(graph.getPhysicalTexture(color) != graph.getPhysicalTexture(depth));
+    REQUIRE(!graph.getPhysicalTexture(surface).has_value());
+
+    // Sized like the surface, which the overlay resolves into, and so the scene's attachments too
+    REQUIRE(graph.getPhysicalTextureDesc(graph.getPhysicalTexture(color).value()).isExactSize);
+    REQUIRE(graph.getPhysicalTextureDesc(graph.getPhysicalTexture(depth).value()).isExactSize);
+}
+
+TEST_CASE("Passes whose results aren't used are culled", "RenderGraph")
+{
+    RenderGraph graph;
+    const auto surface = graph.importTexture("surface", nullptr);
+    const auto unused = graph.createTexture({"unused", WGPUTextureFormat_RGBA8Unorm});
+    graph.addPass({.name = "unused", .colorAttachments = {{unused}}});
+    graph.addPass({.name = "readback", .hasSideEffects = true});
+    graph.addPass({.name = "scene", .colorAttachments = {{surface}}});
+    REQUIRE(compile(graph));
+
+    const auto& passes = graph.getCompiledPasses();
+    REQUIRE(passes.size() == 2);
+    REQUIRE(passes.at(0).pass == 1);
+    REQUIRE(passes.at(1).pass == 2);
+    REQUIRE(!graph.getPhysicalTexture(unused).has_value());
+}
+
+TEST_CASE("Passes are ordered after what they read", "RenderGraph")
+{
+    RenderGraph graph;
+    const auto surface = graph.importTexture("surface", nullptr);
+    const auto hdr = graph.createTexture({"hdr", WGPUTextureFormat_RGBA16Float});
+    const auto bloom = graph.createTexture({"bloom", WGPUTextureFormat_RGBA16Float});
+    graph.addPass({.name = "tone map", .colorAttachments = {{surface}}, .reads = {hdr, bloom}});
+    graph.addPass({.name = "bloom", .colorAttachments = {{bloom}}, .reads = {hdr}});
+    graph.addPass({.name = "scene", .colorAttachments = {{hdr}}});
+    REQUIRE(compile(graph));
+
+    const auto& passes = graph.getCompiledPasses();
+    REQUIRE(passes.size() == 3);
+    REQUIRE(passes.at(0).pass == 2);
+    REQUIRE(passes.at(1).pass == 1);
+    REQUIRE(passes.at(2).pass == 0);
+    REQUIRE(passes.at(0).colorOps.at(0).storeOp == WGPUStoreOp_Store);
+    REQUIRE(graph.getPhysicalTexture(hdr) != graph.getPhysicalTexture(bloom));
+
+    // Only sampled by the pass that renders to the surface, so they can be larger than it
+    REQUIRE(!graph.getPhysicalTextureDesc(graph.getPhysicalTexture(hdr).value()).isExactSize);
+    REQUIRE(graph.getPhysicalTextureDesc(graph.getPhysicalTexture(hdr).value()).usage == (WGPUTextureUsage_RenderAttachment | WGPUTextureUsage_TextureBinding));
+}
+
+TEST_CASE("Bad graphs are errors", "RenderGraph")
+{
+    RenderGraph unwritten;
+    const auto surface = unwritten.importTexture("surface", nullptr);
+    const auto missing = unwritten.createTexture({"missing", WGPUTextureFormat_RGBA8Unorm});
+    unwritten.addPass({.name = "scene", .colorAttachments = {{surface}}, .reads = {missing}});
+    REQUIRE(!compile(unwritten));
+
+    RenderGraph cycle;
+    const auto output = cycle.importTexture("surface", nullptr);
+    const auto a = cycle.createTexture({"a", WGPUTextureFormat_RGBA8Unorm});
+    const auto b = cycle.createTexture({"b", WGPUTextureFormat_RGBA8Unorm});
+    cycle.addPass({.name = "first", .colorAttachments = {{a}, {output}}, .reads = {b}});
+    cycle.addPass({.name = "second", .colorAttachments = {{b}}, .reads = {a}});
+    REQUIRE(!compile(cycle));
+
+    RenderGraph invalid;
+    invalid.addPass({.name = "scene", .reads = {3}, .hasSideEffects = true});
+    REQUIRE(!compile(invalid));
+}
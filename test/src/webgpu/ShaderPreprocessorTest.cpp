@@ -0,0 +1,104 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include "webgpu/ShaderPreprocessor.h"
+
+namespace
+{
+    webgpu::ShaderPreprocessor makePreprocessor(std::map<std::string, std::string> sources)
+    {
+        return webgpu::ShaderPreprocessor{[sources = std::move(sources)](std::string_view name) -> std::optional<std::string> {
+            auto it = sources.find(std::string{name});
+            return (it != sources.end()) ? std::optional{it->second} : std::nullopt;
+        }};
+    }
+
+    // Non-blank lines only, since dropped lines are kept as blank ones
+    std::string compact(const std::string& text)
+    {
+        std::string result;
+        size_t start = 0;
+        while (start < text.size())
+        {
+            size_t end = text.find('\n', start);
+            end = (end == std::string::npos) ? text.size() : end;
+            if (end > start)
+            {
+                result += text.substr(start, end - start) + "|";
+            }
+            start = end + 1;
+        }
+        return result;
+    }
+}
+
+TEST_CASE("Conditionals select lines by defines", "ShaderPreprocessor")
+{
+    auto preprocessor = makePreprocessor({{"main.wgsl",
+        "a\n"
+        "#if HAS_NORMAL && !HAS_EMISSIVE\n"
+        "b\n"
+        "#elif ALPHA_MODE == 2\n"
+        "c\n"
+        "#else\n"
+        "d\n"
+        "#endif\n"
+        "#ifdef HAS_NORMAL\n"
+        "e\n"
+        "#endif\n"}});
+
+    std::string error;
+    REQUIRE(compact(preprocessor.process("main.wgsl", {{"HAS_NORMAL", "1"}}, error).value()) == "a|b|e|");
+    REQUIRE(compact(preprocessor.process("main.wgsl", {{"HAS_EMISSIVE", "1"}, {"ALPHA_MODE", "2"}}, error).value()) == "a|c|");
+    REQUIRE(compact(preprocessor.process("main.wgsl", {{"HAS_NORMAL", "0"}}, error).value()) == "a|d|e|");
+}
+
+TEST_CASE("Line numbers are kept", "ShaderPreprocessor")
+{
+    auto preprocessor = makePreprocessor({{"main.wgsl", "#if 0\nskipped\n#endif\nkept\n"}});
+    std::string error;
+    REQUIRE(preprocessor.process("main.wgsl", {}, error).value() == "\n\n\nkept\n");
+}
+
+TEST_CASE("Includes are pasted once", "ShaderPreprocessor")
+{
+    auto preprocessor = makePreprocessor({
+        {"main.wgsl", "#include \"a.wgsl\"\n#include \"b.wgsl\"\nmain\n"},
+        {"a.wgsl", "#include \"b.wgsl\"\na\n"},
+        {"b.wgsl", "b\n"}});
+
+    std::string error;
+    REQUIRE(compact(preprocessor.process("main.wgsl", {}, error).value()) == "b|a|main|");
+}
+
+TEST_CASE("Defines are substituted in code but not in comments", "ShaderPreprocessor")
+{
+    auto preprocessor = makePreprocessor({{"main.wgsl", "#define LIGHT_COUNT 4\nfor (var i = 0; i < LIGHT_COUNT; i++) {} // LIGHT_COUNT\nMY_LIGHT_COUNT\n"}});
+    std::string error;
+    REQUIRE(compact(preprocessor.process("main.wgsl", {}, error).value()) == "for (var i = 0; i < 4; i++) {} // LIGHT_COUNT|MY_LIGHT_COUNT|");
+}
+
+TEST_CASE("Errors name the file and line", "ShaderPreprocessor")
+{
+    auto preprocessor = makePreprocessor({
+        {"unterminated.wgsl", "#if 1\n"},
+        {"missing.wgsl", "a\n#include \"nothing.wgsl\"\n"},
+        {"badExpression.wgsl", "#if (1\n#endif\n"}});
+
+    std::string error;
+    REQUIRE(!preprocessor.process("unterminated.wgsl", {}, error).has_value());
+    REQUIRE(!preprocessor.process("missing.wgsl", {}, error).has_value());
+    REQUIRE(error.starts_with("missing.wgsl:2:"));
+    REQUIRE(!preprocessor.process("badExpression.wgsl", {}, error).has_value());
+    REQUIRE(!preprocessor.process("nothing.wgsl", {}, error).has_value());
+}
+
+TEST_CASE("Permutations are cached", "ShaderPreprocessor")
+{
+    auto preprocessor = makePreprocessor({{"main.wgsl", "#if A\na\n#endif\n"}});
+    std::string error;
+    preprocessor.process("main.wgsl", {{"A", "1"}}, error);
+    preprocessor.process("main.wgsl", {{"A", "1"}}, error);
+    REQUIRE(preprocessor.getCachedCount() == 1);
+    preprocessor.process("main.wgsl", {{"A", "0"}}, error);
+    REQUIRE(preprocessor.getCachedCount() == 2);
+}
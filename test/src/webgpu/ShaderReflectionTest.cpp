@@ -0,0 +1,129 @@
+#include <fstream>
+#include <sstream>
+#include <catch2/catch_test_macros.hpp>
+
+#include "webgpu/ShaderReflection.h"
+#include "webgpu/VirtualTexture.h"
+
+namespace
+{
+    webgpu::ShaderReflection reflect(std::string_view source)
+    {
+        std::string error;
+        auto reflection = webgpu::ShaderReflection::reflect(source, error);
+        REQUIRE(reflection.has_value());
+        return std::move(reflection.value());
+    }
+
+    std::string readResource(std::string_view name)
+    {
+        std::ifstream f{std::string{WEBGPU_RESOURCE_DIR} + "/" + std::string{name}};
+        REQUIRE(f.good());
+        std::stringstream source;
+        source << f.rdbuf();
+        return source.str();
+    }
+}
+
+TEST_CASE("Types are laid out by WGSL alignment rules", "ShaderReflection")
+{
+    auto reflection = reflect(
+        "struct Camera { projection : mat4x4f, view : mat4x4f, position : vec3f, time : f32 };\n"
+        "struct Padded { a : f32, b : vec3<f32>, c : vec2u, @align(16) d : u32, @size(12) e : f32 };\n"
+        "alias Lights = array<Padded, 4>;\n");
+
+    REQUIRE(reflection.getTypeLayout("Camera")->size == 144);
+    REQUIRE(reflection.getTypeLayout("Padded")->size == 64); // b at 16, c at 32, d at 48, e at 52
+    REQUIRE(reflection.getTypeLayout("Padded")->alignment == 16);
+    REQUIRE(reflection.getTypeLayout("Lights")->size == 256);
+    REQUIRE(reflection.getTypeLayout("mat3x3f")->size == 48);
+    REQUIRE(reflection.getTypeLayout("array<vec3f>")->size == 16);
+    REQUIRE(!reflection.getTypeLayout("Unknown").has_value());
+}
+
+TEST_CASE("Bindings are read with their kinds", "ShaderReflection")
+{
+    auto reflection = reflect(
+        "@group(1) @binding(1) var<storage, read> models : array<Model>; // declared before Model\n"
+        "struct Model { matrix : mat4x4f, materialIndex : u32 }\n"
+        "@group(0) @binding(0) var<uniform> camera : vec4f;\n"
+        "@group(1) @binding(0) var texSampler : sampler;\n"
+        "/* @group(1) @binding(5) var commented : sampler; */\n"
+        "@group(1) @binding(2) var textures : texture_2d_array<f32>;\n"
+        "@group(1) @binding(3) var pageTable : texture_2d<u32>;\n"
+        "@group(1) @binding(4) var output : texture_storage_2d_array<rgba8unorm, write>;\n");
+
+    REQUIRE(reflection.getBindings().size() == 6);
+    REQUIRE(reflection.getBindings(1).size() == 5);
+    REQUIRE(reflection.getBindings(1).front().name == "texSampler");
+
+    const auto* models = reflection.findBinding(1, 1);
+    REQUIRE(models->kind == webgpu::BindingKind::READ_ONLY_STORAGE_BUFFER);
+    REQUIRE(models->isRuntimeArray);
+    REQUIRE(models->minBindingSize == 80);
+
+    REQUIRE(reflection.findBinding(1, 2)->textureDimension == webgpu::TextureDimension::D2_ARRAY);
+    REQUIRE(reflection.findBinding(1, 3)->sampleType == webgpu::TextureSampleType::UINT);
+    REQUIRE(reflection.findBinding(1, 4)->kind == webgpu::BindingKind::STORAGE_TEXTURE);
+    REQUIRE(reflection.findBinding(1, 4)->storageFormat == "rgba8unorm");
+    REQUIRE(reflection.findBinding(1, 5) == nullptr);
+}
+
+TEST_CASE("Visibility follows calls from entry points", "ShaderReflection")
+{
+    auto reflection = reflect(
+        "@group(0) @binding(0) var<uniform> camera : mat4x4f;\n"
+        "@group(0) @binding(1) var<uniform> light : vec4f;\n"
+        "@group(0) @binding(2) var<uniform> unused : vec4f;\n"
+        "fn shade() -> vec4f { return light * camera[0]; }\n"
+        "fn lit() -> vec4f { return shade(); }\n"
+        "@vertex fn vs_main(@builtin(vertex_index) i : u32) -> @builtin(position) vec4f { return camera[i]; }\n"
+        "@fragment fn fs_main() -> @location(0) vec4f { return lit(); }\n");
+
+    using webgpu::ReflectedBinding;
+    REQUIRE(reflection.findBinding(0, 0)->visibility == (ReflectedBinding::VERTEX | ReflectedBinding::FRAGMENT));
+    REQUIRE(reflection.findBinding(0, 1)->visibility == ReflectedBinding::FRAGMENT);
+    REQUIRE(reflection.findBinding(0, 2)->visibility == 0);
+}
+
+TEST_CASE("Buffers are validated against host sizes", "ShaderReflection")
+{
+    auto reflection = reflect(
+        "struct Model { matrix : mat4x4f, normalMatrix : mat4x4f, materialIndex : u32 };\n"
+        "@group(2) @binding(0) var<storage, read> models : array<Model>;\n"
+        "@group(2) @binding(1) var<uniform> model : Model;\n"
+        "@group(2) @binding(2) var modelSampler : sampler;\n");
+
+    std::string error;
+    REQUIRE(reflection.validateBuffer(2, 0, 144, true, error));
+    REQUIRE(reflection.validateBuffer(2, 1, 144, false, error));
+    REQUIRE(!reflection.validateBuffer(2, 0, 132, true, error));
+    REQUIRE(error == "models is 144 bytes per element in the shader but 132 on the host");
+    REQUIRE(!reflection.validateBuffer(2, 0, 144, false, error));
+    REQUIRE(!reflection.validateBuffer(2, 2, 144, false, error));
+    REQUIRE(!reflection.validateBuffer(2, 3, 144, false, error));
+}
+
+TEST_CASE("Bad bindings are errors", "ShaderReflection")
+{
+    std::string error;
+    REQUIRE(!webgpu::ShaderReflection::reflect("@group(0) @binding(0) var a : sampler;\n@group(0) @binding(0) var b : sampler;\n", error).has_value());
+    REQUIRE(!webgpu::ShaderReflection::reflect("@group(0) @binding(0) var<uniform> a : Missing;\n", error).has_value());
+    REQUIRE(!webgpu::ShaderReflection::reflect("@group(0) @binding(0) var a : f32;\n", error).has_value());
+}
+
+TEST_CASE("The virtual texture shader binds what VirtualTexture creates", "ShaderReflection")
+{
+    // Nothing draws with a virtual texture yet, so this is where the shader is checked
+    auto reflection = reflect(readResource(webgpu::VirtualTexture::SHADER));
+    const int group = webgpu::VirtualTexture::GROUP;
+
+    std::string error;
+    REQUIRE(reflection.getBindings(group).size() == 5);
+    REQUIRE(reflection.validateBuffer(group, 0, sizeof(VirtualTextureUniform), false, error));
+    REQUIRE(reflection.findBinding(group, 1)->sampleType == webgpu::TextureSampleType::UINT); // page table
+    REQUIRE(reflection.findBinding(group, 2)->sampleType == webgpu::TextureSampleType::FLOAT); // physical pages
+    REQUIRE(reflection.findBinding(group, 3)->kind == webgpu::BindingKind::SAMPLER);
+    REQUIRE(reflection.findBinding(group, 4)->kind == webgpu::BindingKind::STORAGE_BUFFER); // feedback
+    REQUIRE(reflection.validateBuffer(group, 4, sizeof(uint32_t), true, error));
+}
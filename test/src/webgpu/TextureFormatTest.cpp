@@ -0,0 +1,20 @@
+#include <vector>
+#include <catch2/catch_test_macros.hpp>
+
+#include "webgpu/TextureFormat.h"
+
+TEST_CASE("Metallic-roughness moves to RG8", "TextureFormat")
+{
+    // glTF: roughness in G, metallic in B
+    std::vector<unsigned char> pixels{9, 100, 200, 255, 9, 50, 25, 255};
+    webgpu::TextureFormat::swizzleToUsage(pixels, webgpu::TextureUsage::METALLIC_ROUGHNESS);
+    REQUIRE(webgpu::TextureFormat::truncateChannels(pixels, 2) == std::vector<unsigned char>{100, 200, 50, 25});
+}
+
+TEST_CASE("Occlusion keeps R", "TextureFormat")
+{
+    std::vector<unsigned char> pixels{9, 100, 200, 255, 7, 50, 25, 255};
+    webgpu::TextureFormat::swizzleToUsage(pixels, webgpu::TextureUsage::OCCLUSION);
+    REQUIRE(webgpu::TextureFormat::truncateChannels(pixels, 1) == std::vector<unsigned char>{9, 7});
+    REQUIRE(webgpu::TextureFormat::getUncompressedFormat(webgpu::TextureUsage::OCCLUSION) == WGPUTextureFormat_R8Unorm);
+}
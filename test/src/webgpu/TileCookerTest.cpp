@@ -0,0 +1,73 @@
+#include <vector>
+#include <catch2/catch_test_macros.hpp>
+
+#include "webgpu/TileCooker.h"
+
+namespace
+{
+    // Each texel holds its own coordinates, so that tiles show where their texels came from
+    std::vector<unsigned char> createPixels(int width, int height)
+    {
+        std::vector<unsigned char> pixels;
+        for (int y = 0; y < height; y++)
+        {
+            for (int x = 0; x < width; x++)
+            {
+                pixels.insert(pixels.end(), {static_cast<unsigned char>(x), static_cast<unsigned char>(y), 0, 255});
+            }
+        }
+        return pixels;
+    }
+
+    std::pair<int, int> getTexel(const std::vector<unsigned char>& tile, int tileSize, int x, int y)
+    {
+        const size_t offset = (static_cast<size_t>(y) * tileSize + x) * 4;
+        return {tile.at(offset), tile.at(offset + 1)};
+    }
+}
+
+TEST_CASE("Tiles hold their page plus borders from the neighbours", "TileCooker")
+{
+    const webgpu::VirtualTextureLayout layout{32, 32, 8, 2};
+    const webgpu::TileCooker cooker{layout, createPixels(32, 32), false};
+    REQUIRE(layout.getTileSize() == 12);
+
+    const auto tile = cooker.cookTile({1, 2, 0});
+    REQUIRE(tile.size() == 12 * 12 * 4);
+    REQUIRE(getTexel(tile, 12, 2, 2) == std::pair{8, 16}); // first texel of the page
+    REQUIRE(getTexel(tile, 12, 9, 9) == std::pair{15, 23}); // last texel of the page
+    REQUIRE(getTexel(tile, 12, 0, 0) == std::pair{6, 14});
+    REQUIRE(getTexel(tile, 12, 11, 11) == std::pair{17, 25});
+}
+
+TEST_CASE("Tile borders are clamped at the texture edges", "TileCooker")
+{
+    const webgpu::VirtualTextureLayout layout{32, 32, 8, 2};
+    const webgpu::TileCooker cooker{layout, createPixels(32, 32), false};
+
+    const auto corner = cooker.cookTile({0, 0, 0});
+    REQUIRE(getTexel(corner, 12, 0, 0) == std::pair{0, 0});
+    REQUIRE(getTexel(corner, 12, 1, 5) == std::pair{0, 3});
+
+    const auto farCorner = cooker.cookTile({3, 3, 0});
+    REQUIRE(getTexel(farCorner, 12, 11, 11) == std::pair{31, 31});
+}
+
+TEST_CASE("Coarser levels are downsampled", "TileCooker")
+{
+    const webgpu::VirtualTextureLayout layout{32, 32, 8, 2};
+    const webgpu::TileCooker cooker{layout, createPixels(32, 32), false};
+
+    // Level 1 texel (0, 0) averages level 0 texels 0 and 1 in each direction
+    const auto tile = cooker.cookTile({0, 0, 1});
+    const auto [x, y] = getTexel(tile, 12, 2, 2);
+    REQUIRE(x <= 1);
+    REQUIRE(y <= 1);
+    const auto [lastX, lastY] = getTexel(tile, 12, 9, 9);
+    REQUIRE(lastX >= 14);
+    REQUIRE(lastX <= 15);
+    REQUIRE(lastY >= 14);
+
+    // Out of range pages give an empty tile rather than reading past the level
+    REQUIRE(cooker.cookTile({2, 0, 1}) == std::vector<unsigned char>(12 * 12 * 4, 0));
+}
@@ -0,0 +1,356 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include <spdlog/spdlog.h>
+#include <webgpu/webgpu.h>
+
+#include "job/JobSystem.h"
+#include "webgpu/StringView.h"
+
+namespace
+{
+    using webgpu::StringView;
+    using Clock = std::chrono::steady_clock;
+
+    constexpr uint32_t TARGET_SIZE = 256;
+    constexpr uint32_t PACKET_STRIDE = 256; // minUniformBufferOffsetAlignment
+
+    // One triangle per draw packet, placed by its own uniform slot
+    constexpr std::string_view SHADER = R"(
+struct Packet {
+  offset : vec4f
+};
+@group(0) @binding(0) var<uniform> packet : Packet;
+
+@vertex fn vs_main(@builtin(vertex_index) i : u32) -> @builtin(position) vec4f {
+  let corners = array(vec2f(-0.01, -0.01), vec2f(0.01, -0.01), vec2f(0.0, 0.01));
+  return vec4f(corners[i] + packet.offset.xy, 0.0, 1.0);
+}
+
+@fragment fn fs_main() -> @location(0) vec4f {
+  return vec4f(1.0);
+}
+)";
+
+    struct Context
+    {
+        WGPUInstance instance{nullptr};
+        WGPUDevice device{nullptr};
+        WGPUQueue queue{nullptr};
+        bool isSynchronized{false};
+    };
+
+    struct Scene
+    {
+        WGPURenderPipeline pipeline{nullptr};
+        WGPUBindGroup bindGroup{nullptr};
+        WGPUBuffer indexBuffer{nullptr};
+        WGPUTextureView targetView{nullptr};
+        int packetCount{0};
+    };
+
+    // A software adapter, so that results don't depend on the GPU driver's threading
+    bool createContext(Context& context)
+    {
+        WGPUInstanceDescriptor instanceDesc{};
+        context.instance = wgpuCreateInstance(&instanceDesc);
+
+        WGPUAdapter adapter = nullptr;
+        WGPURequestAdapterOptions adapterOptions{WGPU_REQUEST_ADAPTER_OPTIONS_INIT};
+        adapterOptions.forceFallbackAdapter = true;
+        WGPURequestAdapterCallbackInfo adapterCallback{WGPU_REQUEST_ADAPTER_CALLBACK_INFO_INIT};
+        adapterCallback.mode = WGPUCallbackMode_AllowProcessEvents;
+        adapterCallback.callback = [](WGPURequestAdapterStatus status, WGPUAdapter result, WGPUStringView message, void* userdata1, void*) {
+            if (status != WGPURequestAdapterStatus_Success)
+            {
+                spdlog::error("No software adapter: {}", StringView(message).toString());
+            }
+            *static_cast<WGPUAdapter*>(userdata1) = result;
+        };
+        adapterCallback.userdata1 = &adapter;
+        wgpuInstanceRequestAdapter(context.instance, &adapterOptions, adapterCallback);
+        for (int iPoll = 0; (adapter == nullptr) && (iPoll < 1000); iPoll++)
+        {
+            wgpuInstanceProcessEvents(context.instance);
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        if (adapter == nullptr)
+        {
+            return false;
+        }
+
+        std::vector<WGPUFeatureName> features;
+        context.isSynchronized = wgpuAdapterHasFeature(adapter, WGPUFeatureName_ImplicitDeviceSynchronization);
+        if (context.isSynchronized)
+        {
+            features.push_back(WGPUFeatureName_ImplicitDeviceSynchronization);
+        }
+
+        WGPUDeviceDescriptor deviceDesc{WGPU_DEVICE_DESCRIPTOR_INIT};
+        deviceDesc.label = StringView("Benchmark device");
+        deviceDesc.requiredFeatureCount = features.size();
+        deviceDesc.requiredFeatures = features.data();
+        deviceDesc.uncapturedErrorCallbackInfo.callback = [](const WGPUDevice*, WGPUErrorType type, WGPUStringView message, void*, void*) {
+            spdlog::error("Device error {}: {}", static_cast<int>(type), StringView(message).toString());
+        };
+
+        WGPURequestDeviceCallbackInfo deviceCallback{WGPU_REQUEST_DEVICE_CALLBACK_INFO_INIT};
+        deviceCallback.mode = WGPUCallbackMode_AllowProcessEvents;
+        deviceCallback.callback = [](WGPURequestDeviceStatus status, WGPUDevice result, WGPUStringView message, void* userdata1, void*) {
+            if (status != WGPURequestDeviceStatus_Success)
+            {
+                spdlog::error("No device: {}", StringView(message).toString());
+            }
+            *static_cast<WGPUDevice*>(userdata1) = result;
+        };
+        deviceCallback.userdata1 = &context.device;
+        wgpuAdapterRequestDevice(adapter, &deviceDesc, deviceCallback);
+        for (int iPoll = 0; (context.device == nullptr) && (iPoll < 1000); iPoll++)
+        {
+            wgpuInstanceProcessEvents(context.instance);
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        wgpuAdapterRelease(adapter);
+        if (context.device == nullptr)
+        {
+            return false;
+        }
+
+        context.queue = wgpuDeviceGetQueue(context.device);
+        return true;
+    }
+
+    Scene createScene(const Context& context, int packetCount)
+    {
+        Scene scene;
+        scene.packetCount = packetCount;
+
+        WGPUShaderSourceWGSL wgslDesc{WGPU_SHADER_SOURCE_WGSL_INIT};
+        wgslDesc.code = StringView(SHADER);
+        WGPUShaderModuleDescriptor shaderDesc{WGPU_SHADER_MODULE_DESCRIPTOR_INIT};
+        shaderDesc.nextInChain = &wgslDesc.chain;
+        WGPUShaderModule shaderModule = wgpuDeviceCreateShaderModule(context.device, &shaderDesc);
+
+        WGPUBindGroupLayoutEntry layoutEntry{WGPU_BIND_GROUP_LAYOUT_ENTRY_INIT};
+        layoutEntry.binding = 0;
+        layoutEntry.visibility = WGPUShaderStage_Vertex;
+        layoutEntry.buffer.type = WGPUBufferBindingType_Uniform;
+        layoutEntry.buffer.hasDynamicOffset = true;
+        layoutEntry.buffer.minBindingSize = 16;
+        WGPUBindGroupLayoutDescriptor bindGroupLayoutDesc{WGPU_BIND_GROUP_LAYOUT_DESCRIPTOR_INIT};
+        bindGroupLayoutDesc.entryCount = 1;
+        bindGroupLayoutDesc.entries = &layoutEntry;
+        WGPUBindGroupLayout bindGroupLayout = wgpuDeviceCreateBindGroupLayout(context.device, &bindGroupLayoutDesc);
+
+        WGPUPipelineLayoutDescriptor pipelineLayoutDesc{WGPU_PIPELINE_LAYOUT_DESCRIPTOR_INIT};
+        pipelineLayoutDesc.bindGroupLayoutCount = 1;
+        pipelineLayoutDesc.bindGroupLayouts = &bindGroupLayout;
+        WGPUPipelineLayout pipelineLayout = wgpuDeviceCreatePipelineLayout(context.device, &pipelineLayoutDesc);
+
+        WGPUColorTargetState colorTarget{WGPU_COLOR_TARGET_STATE_INIT};
+        colorTarget.format = WGPUTextureFormat_RGBA8Unorm;
+        WGPUFragmentState fragmentState{WGPU_FRAGMENT_STATE_INIT};
+        fragmentState.module = shaderModule;
+        fragmentState.entryPoint = StringView("fs_main");
+        fragmentState.targetCount = 1;
+        fragmentState.targets = &colorTarget;
+        WGPURenderPipelineDescriptor pipelineDesc{WGPU_RENDER_PIPELINE_DESCRIPTOR_INIT};
+        pipelineDesc.layout = pipelineLayout;
+        pipelineDesc.vertex.module = shaderModule;
+        pipelineDesc.vertex.entryPoint = StringView("vs_main");
+        pipelineDesc.fragment = &fragmentState;
+        scene.pipeline = wgpuDeviceCreateRenderPipeline(context.device, &pipelineDesc);
+
+        // Packets spread over the target, one uniform slot each
+        WGPUBufferDescriptor uniformDesc{WGPU_BUFFER_DESCRIPTOR_INIT};
+        uniformDesc.size = static_cast<uint64_t>(packetCount) * PACKET_STRIDE;
+        uniformDesc.usage = WGPUBufferUsage_Uniform | WGPUBufferUsage_CopyDst;
+        WGPUBuffer uniformBuffer = wgpuDeviceCreateBuffer(context.device, &uniformDesc);
+        std::vector<float> packets(uniformDesc.size / sizeof(float));
+        for (int iPacket = 0; iPacket < packetCount; iPacket++)
+        {
+            packets.at(iPacket * PACKET_STRIDE / sizeof(float)) = std::sin(static_cast<float>(iPacket) * 0.37f) * 0.9f;
+            packets.at(iPacket * PACKET_STRIDE / sizeof(float) + 1) = std::cos(static_cast<float>(iPacket) * 0.11f) * 0.9f;
+        }
+        wgpuQueueWriteBuffer(context.queue, uniformBuffer, 0, packets.data(), uniformDesc.size);
+
+        WGPUBindGroupEntry bindGroupEntry{WGPU_BIND_GROUP_ENTRY_INIT};
+        bindGroupEntry.binding = 0;
+        bindGroupEntry.buffer = uniformBuffer;
+        bindGroupEntry.size = 16;
+        WGPUBindGroupDescriptor bindGroupDesc{WGPU_BIND_GROUP_DESCRIPTOR_INIT};
+        bindGroupDesc.layout = bindGroupLayout;
+        bindGroupDesc.entryCount = 1;
+        bindGroupDesc.entries = &bindGroupEntry;
+        scene.bindGroup = wgpuDeviceCreateBindGroup(context.device, &bindGroupDesc);
+
+        const uint16_t indices[4]{0, 1, 2, 0};
+        WGPUBufferDescriptor indexDesc{WGPU_BUFFER_DESCRIPTOR_INIT};
+        indexDesc.size = sizeof(indices);
+        indexDesc.usage = WGPUBufferUsage_Index | WGPUBufferUsage_CopyDst;
+        scene.indexBuffer = wgpuDeviceCreateBuffer(context.device, &indexDesc);
+        wgpuQueueWriteBuffer(context.queue, scene.indexBuffer, 0, indices, sizeof(indices));
+
+        WGPUTextureDescriptor targetDesc{WGPU_TEXTURE_DESCRIPTOR_INIT};
+        targetDesc.size = {TARGET_SIZE, TARGET_SIZE, 1};
+        targetDesc.format = WGPUTextureFormat_RGBA8Unorm;
+        targetDesc.usage = WGPUTextureUsage_RenderAttachment;
+        WGPUTexture target = wgpuDeviceCreateTexture(context.device, &targetDesc);
+        scene.targetView = wgpuTextureCreateView(target, nullptr);
+
+        wgpuTextureRelease(target);
+        wgpuBufferRelease(uniformBuffer);
+        wgpuPipelineLayoutRelease(pipelineLayout);
+        wgpuBindGroupLayoutRelease(bindGroupLayout);
+        wgpuShaderModuleRelease(shaderModule);
+        return scene;
+    }
+
+    void releaseScene(Scene& scene)
+    {
+        wgpuTextureViewRelease(scene.targetView);
+        wgpuBufferRelease(scene.indexBuffer);
+        wgpuBindGroupRelease(scene.bindGroup);
+        wgpuRenderPipelineRelease(scene.pipeline);
+    }
+
+    // Packets [first, last) into one bundle, with a state change per draw like the scene's batches
+    WGPURenderBundle recordBundle(const Context& context, const Scene& scene, int first, int last)
+    {
+        const WGPUTextureFormat colorFormat = WGPUTextureFormat_RGBA8Unorm;
+        WGPURenderBundleEncoderDescriptor encoderDesc{WGPU_RENDER_BUNDLE_ENCODER_DESCRIPTOR_INIT};
+        encoderDesc.colorFormatCount = 1;
+        encoderDesc.colorFormats = &colorFormat;
+        WGPURenderBundleEncoder encoder = wgpuDeviceCreateRenderBundleEncoder(context.device, &encoderDesc);
+
+        wgpuRenderBundleEncoderSetPipeline(encoder, scene.pipeline);
+        wgpuRenderBundleEncoderSetIndexBuffer(encoder, scene.indexBuffer, WGPUIndexFormat_Uint16, 0, WGPU_WHOLE_SIZE);
+        for (int iPacket = first; iPacket < last; iPacket++)
+        {
+            const uint32_t offset = iPacket * PACKET_STRIDE;
+            wgpuRenderBundleEncoderSetBindGroup(encoder, 0, scene.bindGroup, 1, &offset);
+            wgpuRenderBundleEncoderDrawIndexed(encoder, 3, 1, 0, 0, 0);
+        }
+
+        WGPURenderBundleDescriptor bundleDesc{WGPU_RENDER_BUNDLE_DESCRIPTOR_INIT};
+        WGPURenderBundle bundle = wgpuRenderBundleEncoderFinish(encoder, &bundleDesc);
+        wgpuRenderBundleEncoderRelease(encoder);
+        return bundle;
+    }
+
+    void waitForQueue(const Context& context)
+    {
+        bool isDone = false;
+        WGPUQueueWorkDoneCallbackInfo callbackInfo{WGPU_QUEUE_WORK_DONE_CALLBACK_INFO_INIT};
+        callbackInfo.mode = WGPUCallbackMode_AllowProcessEvents;
+        callbackInfo.callback = [](WGPUQueueWorkDoneStatus, WGPUStringView, void* userdata1, void*) { *static_cast<bool*>(userdata1) = true; };
+        callbackInfo.userdata1 = &isDone;
+        wgpuQueueOnSubmittedWorkDone(context.queue, callbackInfo);
+        while (!isDone)
+        {
+            wgpuInstanceProcessEvents(context.instance);
+        }
+    }
+
+    struct Timing
+    {
+        double recordMillis;
+        double frameMillis; // recording, executing and waiting for the queue
+    };
+
+    // Records the packets into bundleCount bundles across the job system, then executes them in order in a single
+    // pass and submits that once, as Pipeline does
+    Timing runFrame(const Context& context, const Scene& scene, job::JobSystem& jobSystem, int bundleCount)
+    {
+        const auto start = Clock::now();
+        std::vector<WGPURenderBundle> bundles(bundleCount, nullptr);
+        jobSystem.parallelFor(bundleCount, [&](int iBundle) {
+            bundles.at(iBundle) = recordBundle(context, scene, scene.packetCount * iBundle / bundleCount, scene.packetCount * (iBundle + 1) / bundleCount);
+        });
+        const auto recorded = Clock::now();
+
+        WGPURenderPassColorAttachment colorAttachment{WGPU_RENDER_PASS_COLOR_ATTACHMENT_INIT};
+        colorAttachment.view = scene.targetView;
+        colorAttachment.loadOp = WGPULoadOp_Clear;
+        colorAttachment.storeOp = WGPUStoreOp_Store;
+        WGPURenderPassDescriptor passDesc{WGPU_RENDER_PASS_DESCRIPTOR_INIT};
+        passDesc.colorAttachmentCount = 1;
+        passDesc.colorAttachments = &colorAttachment;
+
+        WGPUCommandEncoderDescriptor encoderDesc{WGPU_COMMAND_ENCODER_DESCRIPTOR_INIT};
+        WGPUCommandEncoder commandEncoder = wgpuDeviceCreateCommandEncoder(context.device, &encoderDesc);
+        WGPURenderPassEncoder passEncoder = wgpuCommandEncoderBeginRenderPass(commandEncoder, &passDesc);
+        wgpuRenderPassEncoderExecuteBundles(passEncoder, bundles.size(), bundles.data());
+        wgpuRenderPassEncoderEnd(passEncoder);
+        wgpuRenderPassEncoderRelease(passEncoder);
+
+        WGPUCommandBufferDescriptor commandBufferDesc{WGPU_COMMAND_BUFFER_DESCRIPTOR_INIT};
+        WGPUCommandBuffer commandBuffer = wgpuCommandEncoderFinish(commandEncoder, &commandBufferDesc);
+        wgpuQueueSubmit(context.queue, 1, &commandBuffer);
+        wgpuCommandBufferRelease(commandBuffer);
+        wgpuCommandEncoderRelease(commandEncoder);
+        waitForQueue(context);
+
+        for (WGPURenderBundle bundle : bundles)
+        {
+            wgpuRenderBundleRelease(bundle);
+        }
+
+        const auto end = Clock::now();
+        return {std::chrono::duration<double, std::milli>(recorded - start).count(), std::chrono::duration<double, std::milli>(end - start).count()};
+    }
+}
+
+// Measures recording draw packets into render bundles on 1..N threads against a software adapter, without a window
+// Usage: encode-benchmark [packet count] [frames per thread count]
+int main(int argc, char** argv)
+{
+    const int packetCount = std::max(1, (argc > 1) ? std::stoi(argv[1]) : 20000);
+    const int frameCount = std::max(1, (argc > 2) ? std::stoi(argv[2]) : 10);
+
+    Context context;
+    if (!createContext(context))
+    {
+        spdlog::error("Unable to create a headless device");
+        return 1;
+    }
+
+    const int maxThreadCount = std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+    job::JobSystem jobSystem{maxThreadCount - 1};
+    if (!context.isSynchronized)
+    {
+        spdlog::warn("The adapter lacks implicit device synchronization, so recording stays on one thread");
+    }
+
+    Scene scene = createScene(context, packetCount);
+    runFrame(context, scene, jobSystem, 1); // warm up
+
+    spdlog::info("{} packets, best of {} frames", packetCount, frameCount);
+    double singleThreadMillis = 0.0;
+    for (int threadCount = 1; threadCount <= (context.isSynchronized ? maxThreadCount : 1); threadCount *= 2)
+    {
+        Timing best{1e30, 1e30};
+        for (int iFrame = 0; iFrame < frameCount; iFrame++)
+        {
+            const auto timing = runFrame(context, scene, jobSystem, threadCount);
+            best.recordMillis = std::min(best.recordMillis, timing.recordMillis);
+            best.frameMillis = std::min(best.frameMillis, timing.frameMillis);
+        }
+
+        if (threadCount == 1)
+        {
+            singleThreadMillis = best.recordMillis;
+        }
+        spdlog::info("{:2} threads: record {:8.3f} ms ({:4.2f}x), frame {:8.3f} ms", threadCount, best.recordMillis, singleThreadMillis / best.recordMillis, best.frameMillis);
+    }
+
+    releaseScene(scene);
+    wgpuQueueRelease(context.queue);
+    wgpuDeviceRelease(context.device);
+    wgpuInstanceRelease(context.instance);
+    return 0;
+}
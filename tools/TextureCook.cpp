@@ -0,0 +1,70 @@
+#include <filesystem>
+#include <thread>
+#include <spdlog/spdlog.h>
+
+#include "job/JobSystem.h"
+#include "resource/Loader.h"
+#include "resource/Settings.h"
+#include "webgpu/TextureCooker.h"
+
+namespace
+{
+    void addTexture(webgpu::TextureCooker& cooker, const resource::GltfResource& gltfRes, const resource::JTextureInfo& textureInfo, webgpu::TextureUsage usage)
+    {
+        if (textureInfo.index == -1)
+        {
+            return;
+        }
+
+        const auto& gltf = gltfRes.getGltf();
+        const auto& jImage = gltf.images.at(gltf.textures.at(textureInfo.index).source);
+        const auto imageBytes = gltfRes.getImageBytes(jImage);
+        if (imageBytes.empty())
+        {
+            spdlog::warn("{}: no data for image {}, skipped", gltfRes.getName(), jImage.name.empty() ? jImage.uri : jImage.name);
+            return;
+        }
+
+        cooker.addImage(gltfRes.getName() + ": " + jImage.name, imageBytes.data(), imageBytes.size(), usage);
+    }
+}
+
+// Cooks the textures of every glTF model below the resource directory into <resource directory>/cooked
+// Usage: texture-cook [resource directory]
+int main(int argc, char** argv)
+{
+    const auto resourceDir = std::filesystem::absolute((argc > 1) ? argv[1] : "resources");
+    resource::Loader loader{resourceDir};
+    job::JobSystem jobSystem{static_cast<int>(std::thread::hardware_concurrency())};
+    webgpu::TextureCooker cooker{jobSystem};
+
+    // Cook the variants Model will ask for, which depend on render.packOrm
+    bool isPackingOrm = true;
+    if (auto config = loader.getConfig("settings.config"))
+    {
+        isPackingOrm = resource::Settings{nlohmann::json::parse(config->getString())}.getBool("render.packOrm").value_or(true);
+    }
+
+    for (const auto& gltfRes : loader.getGltfs())
+    {
+        for (const auto& jMaterial : gltfRes.getGltf().materials)
+        {
+            addTexture(cooker, gltfRes, jMaterial.pbrMetallicRoughness.baseColorTexture, webgpu::TextureUsage::COLOR);
+            addTexture(cooker, gltfRes, jMaterial.emissiveTexture, webgpu::TextureUsage::COLOR);
+            addTexture(cooker, gltfRes, jMaterial.normalTexture, webgpu::TextureUsage::NORMAL);
+            if (isPackingOrm && gltfRes.hasOrmImage(jMaterial))
+            {
+                addTexture(cooker, gltfRes, jMaterial.occlusionTexture, webgpu::TextureUsage::ORM);
+            }
+            else
+            {
+                addTexture(cooker, gltfRes, jMaterial.pbrMetallicRoughness.metallicRoughnessTexture, webgpu::TextureUsage::METALLIC_ROUGHNESS);
+                addTexture(cooker, gltfRes, jMaterial.occlusionTexture, webgpu::TextureUsage::OCCLUSION);
+            }
+        }
+    }
+
+    const int cookedCount = cooker.cook(resourceDir);
+    spdlog::info("Cooked {} textures", cookedCount);
+    return 0;
+}